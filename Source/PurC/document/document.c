@@ -303,6 +303,7 @@ pcdoc_element_children_count(purc_document_t doc, pcdoc_element_t elem,
                 *nr_text_nodes = nrs[PCDOC_NODE_TEXT];
             if (nr_data_nodes)
                 *nr_data_nodes = nrs[PCDOC_NODE_DATA];
+            return 0;
         }
         else {
             return -1;
@@ -361,6 +362,28 @@ pcdoc_element_get_child_data_node(purc_document_t doc, pcdoc_element_t elem,
     return NULL;
 }
 
+pcdoc_node
+pcdoc_element_first_child(purc_document_t doc, pcdoc_element_t elem)
+{
+    if (doc->ops->first_child) {
+        return doc->ops->first_child(doc, elem);
+    }
+
+    pcdoc_node node = { PCDOC_NODE_VOID, { NULL } };
+    return node;
+}
+
+pcdoc_node
+pcdoc_node_next_sibling(purc_document_t doc, pcdoc_node node)
+{
+    if (doc->ops->first_child && node.type != PCDOC_NODE_VOID) {
+        return doc->ops->next_sibling(doc, node);
+    }
+
+    pcdoc_node void_node = { PCDOC_NODE_VOID, { NULL } };
+    return void_node;
+}
+
 pcdoc_element_t
 pcdoc_node_get_parent(purc_document_t doc, pcdoc_node node)
 {
@@ -536,7 +559,7 @@ pcdoc_elem_coll_new_from_descendants(purc_document_t doc,
                     PCDOC_SPECIAL_ELEM_ROOT);
         }
 
-        if (!doc->ops->elem_coll_select(doc, coll, ancestor, selector)) {
+        if (doc->ops->elem_coll_select(doc, coll, ancestor, selector) < 0) {
             pcdoc_elem_coll_delete(doc, coll);
             coll = NULL;
         }
@@ -546,14 +569,14 @@ pcdoc_elem_coll_new_from_descendants(purc_document_t doc,
 }
 
 pcdoc_elem_coll_t
-pcdoc_elem_coll_filter(purc_document_t doc,
+pcdoc_elem_coll_select(purc_document_t doc,
         pcdoc_elem_coll_t elem_coll, const char *selector)
 {
     pcdoc_elem_coll_t dst_coll = element_collection_new(selector);
 
     if (doc->ops->elem_coll_filter) {
-        if (!doc->ops->elem_coll_filter(doc, dst_coll,
-                elem_coll, selector)) {
+        if (doc->ops->elem_coll_filter(doc, dst_coll,
+                elem_coll, selector) < 0) {
             pcdoc_elem_coll_delete(doc, dst_coll);
             dst_coll = NULL;
         }
@@ -568,6 +591,7 @@ pcdoc_elem_coll_delete(purc_document_t doc,
 {
     UNUSED_PARAM(doc);
 
+    free(elem_coll->selector);
     pcutils_arrlist_free(elem_coll->elems);
     return free(elem_coll);
 }
@@ -31,6 +31,8 @@
 #include "private/document.h"
 #include "private/debug.h"
 
+#include "internal.h"
+
 static purc_document_t create(const char *content, size_t length)
 {
     pchtml_html_document_t *html_doc;
@@ -72,9 +74,44 @@ static purc_document_t create(const char *content, size_t length)
     return doc;
 }
 
+/* The children of one element grouped by the node type, so that
+   `get_child()` costs O(1) when the caller loops over the children. */
+struct pcdoc_child_index {
+    pcdom_node_t       *parent;     /* NULL if invalid */
+
+    size_t              nrs[PCDOC_NODE_OTHERS + 1];
+    size_t              offs[PCDOC_NODE_OTHERS + 1];
+
+    size_t              sz_nodes;
+    pcdom_node_t      **nodes;
+};
+
+/* the index is only built for the children not near the first one */
+#define MIN_IDX_TO_BUILD_CHILD_INDEX    16
+
+static void
+child_index_invalidate(purc_document_t doc)
+{
+    if (doc->child_index)
+        doc->child_index->parent = NULL;
+}
+
+static void
+child_index_destroy(purc_document_t doc)
+{
+    if (doc->child_index) {
+        free(doc->child_index->nodes);
+        free(doc->child_index);
+        doc->child_index = NULL;
+    }
+}
+
 static void destroy(purc_document_t doc)
 {
     assert(doc->impl);
+    pcdoc_html_index_destroy(doc);
+    pcdoc_release_selectors(doc);
+    child_index_destroy(doc);
     pchtml_html_document_destroy(doc->impl);
     free(doc);
 }
@@ -157,11 +194,14 @@ static pcdoc_element_t operate_element(purc_document_t doc,
 {
     UNUSED_PARAM(self_close);
 
+    child_index_invalidate(doc);
     if (op == PCDOC_OP_ERASE) {
+        pcdoc_html_index_remove(doc, elem, true, true);
         dom_erase_element(pcdom_interface_element(elem));
         return NULL;
     }
     else if (op == PCDOC_OP_CLEAR) {
+        pcdoc_html_index_remove(doc, elem, false, true);
         dom_clear_element(pcdom_interface_element(elem));
         return elem;
     }
@@ -171,6 +211,9 @@ static pcdoc_element_t operate_element(purc_document_t doc,
         return NULL;
     }
 
+    if (op == PCDOC_OP_DISPLACE)
+        pcdoc_html_index_remove(doc, elem, false, true);
+
     pcdom_element_t *dom_elem = pcdom_interface_element(elem);
     pcdom_document_t *dom_doc = pcdom_interface_document(doc->impl);
     pcdom_element_t *new_elem;
@@ -203,6 +246,9 @@ static pcdoc_text_node_t new_text_content(purc_document_t doc,
     text_node = pcdom_document_create_text_node(dom_doc,
             (const unsigned char *)text, length ? length : strlen(text));
     if (text_node) {
+        child_index_invalidate(doc);
+        if (op == PCDOC_OP_DISPLACE)
+            pcdoc_html_index_remove(doc, elem, false, true);
         dom_node_ops[op](dom_elem, pcdom_interface_node(text_node));
     }
     else {
@@ -366,6 +412,32 @@ static const dom_subtree_op dom_subtree_ops[] = {
     dom_displace_content_by_subtree,
 };
 
+/* Indexes the nodes inserted from a fragment: they are contiguous siblings
+   from `first` to `last`, or in the reverse order. */
+static void index_inserted_nodes(purc_document_t doc,
+        pcdom_node_t *first, pcdom_node_t *last)
+{
+    pcdom_node_t *next = first, *prev = first;
+    while (next != last && prev != last) {
+        if (next)
+            next = next->next;
+        if (prev)
+            prev = prev->prev;
+    }
+
+    if (next != last) {
+        prev = first;
+        first = last;
+        last = prev;
+    }
+
+    for (pcdom_node_t *node = first; node; node = node->next) {
+        pcdoc_html_index_add(doc, (pcdoc_element_t)node, true);
+        if (node == last)
+            break;
+    }
+}
+
 static pcdoc_node new_content(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_operation op,
             const char *content, size_t length)
@@ -387,7 +459,17 @@ static pcdoc_node new_content(purc_document_t doc,
     pcdom_node_t *dom_node = subtree->first_child->first_child;
 
     if (subtree) {
+        child_index_invalidate(doc);
+        if (op == PCDOC_OP_DISPLACE)
+            pcdoc_html_index_remove(doc, elem, false, true);
+
+        /* the index keeps the document order, so the nodes are indexed
+           after they are in the document */
+        pcdom_node_t *first = subtree->first_child->first_child;
+        pcdom_node_t *last = subtree->first_child->last_child;
         dom_subtree_ops[op](dom_elem, subtree);
+        if (first)
+            index_inserted_nodes(doc, first, last);
     }
     else {
         purc_set_error(PURC_ERROR_INVALID_VALUE);
@@ -427,24 +509,32 @@ static int set_attribute(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_operation op,
             const char *name, const char *val, size_t len)
 {
-    UNUSED_PARAM(doc);
-
     pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+    bool indexed = doc->elem_index &&
+        (strcasecmp(name, "id") == 0 || strcasecmp(name, "class") == 0);
+    int retv = -1;
+
+    if (indexed)
+        pcdoc_html_index_remove(doc, elem, true, false);
+
     if (op == PCDOC_OP_ERASE) {
-        return dom_remove_element_attr(dom_elem, name);
+        retv = dom_remove_element_attr(dom_elem, name);
     }
     else if (op == PCDOC_OP_CLEAR) {
-        return dom_set_element_attribute(dom_elem, name, "", 0);
+        retv = dom_set_element_attribute(dom_elem, name, "", 0);
     }
     else if (op == PCDOC_OP_DISPLACE) {
-        return dom_set_element_attribute(dom_elem, name,
+        retv = dom_set_element_attribute(dom_elem, name,
                 val, len ? len : strlen(val));
     }
     else {
         purc_set_error(PURC_ERROR_INVALID_VALUE);
     }
 
-    return -1;
+    if (indexed)
+        pcdoc_html_index_add(doc, elem, false);
+
+    return retv;
 }
 
 static pcdoc_element_t special_elem(purc_document_t doc,
@@ -479,12 +569,81 @@ static pcdoc_element_t get_parent(purc_document_t doc, pcdoc_node node)
     return (pcdoc_element_t)dom_node->parent;
 }
 
+static inline pcdoc_node_type
+node_type(pcdom_node_type_t type)
+{
+    switch (type) {
+        case PCDOM_NODE_TYPE_ELEMENT:
+            return PCDOC_NODE_ELEMENT;
+        case PCDOM_NODE_TYPE_TEXT:
+            return PCDOC_NODE_TEXT;
+        case PCDOM_NODE_TYPE_CDATA_SECTION:
+            return PCDOC_NODE_CDATA_SECTION;
+        case PCDOM_NODE_TYPE_COMMENT:
+        default:
+            break;
+    }
+
+    return PCDOC_NODE_OTHERS;
+}
+
+static struct pcdoc_child_index *
+child_index_build(purc_document_t doc, pcdom_node_t *parent)
+{
+    struct pcdoc_child_index *index = doc->child_index;
+    if (index == NULL) {
+        index = calloc(1, sizeof(*index));
+        if (index == NULL)
+            return NULL;
+        doc->child_index = index;
+    }
+
+    index->parent = NULL;
+    memset(index->nrs, 0, sizeof(index->nrs));
+
+    size_t total = 0;
+    pcdom_node_t *child;
+    for (child = parent->first_child; child; child = child->next) {
+        index->nrs[node_type(child->type)]++;
+        total++;
+    }
+
+    if (total > index->sz_nodes) {
+        pcdom_node_t **nodes;
+        nodes = realloc(index->nodes, sizeof(pcdom_node_t *) * total);
+        if (nodes == NULL)
+            return NULL;
+        index->nodes = nodes;
+        index->sz_nodes = total;
+    }
+
+    size_t off = 0;
+    for (size_t i = 0; i <= PCDOC_NODE_OTHERS; i++) {
+        index->offs[i] = off;
+        off += index->nrs[i];
+    }
+
+    size_t cursors[PCDOC_NODE_OTHERS + 1];
+    memcpy(cursors, index->offs, sizeof(cursors));
+    for (child = parent->first_child; child; child = child->next) {
+        index->nodes[cursors[node_type(child->type)]++] = child;
+    }
+
+    index->parent = parent;
+    return index;
+}
+
 static int children_count(purc_document_t doc, pcdoc_element_t elem,
         size_t *nrs)
 {
-    UNUSED_PARAM(doc);
-
     pcdom_node_t *dom_node = pcdom_interface_node(elem);
+    if (doc->child_index && doc->child_index->parent == dom_node) {
+        for (size_t i = 0; i <= PCDOC_NODE_OTHERS; i++) {
+            nrs[i] += doc->child_index->nrs[i];
+        }
+        return 0;
+    }
+
     pcdom_node_t *child = dom_node->first_child;
     while (child) {
         if (child->type == PCDOM_NODE_TYPE_ELEMENT) {
@@ -506,35 +665,33 @@ static int children_count(purc_document_t doc, pcdoc_element_t elem,
     return 0;
 }
 
-static inline pcdoc_node_type
-node_type(pcdom_node_type_t type)
-{
-    switch (type) {
-        case PCDOM_NODE_TYPE_ELEMENT:
-            return PCDOC_NODE_ELEMENT;
-        case PCDOM_NODE_TYPE_TEXT:
-            return PCDOC_NODE_TEXT;
-        case PCDOM_NODE_TYPE_CDATA_SECTION:
-            return PCDOC_NODE_CDATA_SECTION;
-        case PCDOM_NODE_TYPE_COMMENT:
-        default:
-            break;
-    }
-
-    return PCDOC_NODE_OTHERS;
-}
-
 static pcdoc_node get_child(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_node_type type, size_t idx)
 {
-    UNUSED_PARAM(doc);
-
     pcdoc_node node;
     node.type = PCDOC_NODE_VOID;
     node.elem = NULL;
 
-    size_t i = 0;
+    if (type > PCDOC_NODE_OTHERS)
+        return node;
+
     pcdom_node_t *dom_node = pcdom_interface_node(elem);
+    struct pcdoc_child_index *index = doc->child_index;
+    if ((index == NULL || index->parent != dom_node) &&
+            idx >= MIN_IDX_TO_BUILD_CHILD_INDEX) {
+        index = child_index_build(doc, dom_node);
+    }
+
+    if (index && index->parent == dom_node) {
+        if (idx < index->nrs[type]) {
+            node.type = type;
+            node.elem = (pcdoc_element_t)index->nodes[index->offs[type] + idx];
+        }
+        return node;
+    }
+
+    /* fall back to walking the sibling list */
+    size_t i = 0;
     pcdom_node_t *child = dom_node->first_child;
     while (child) {
         if (node_type(child->type) == type) {
@@ -553,6 +710,38 @@ static pcdoc_node get_child(purc_document_t doc,
     return node;
 }
 
+static inline pcdoc_node
+make_doc_node(pcdom_node_t *dom_node)
+{
+    pcdoc_node node;
+    if (dom_node) {
+        node.type = node_type(dom_node->type);
+        node.elem = (pcdoc_element_t)dom_node;
+    }
+    else {
+        node.type = PCDOC_NODE_VOID;
+        node.elem = NULL;
+    }
+
+    return node;
+}
+
+static pcdoc_node first_child(purc_document_t doc, pcdoc_element_t elem)
+{
+    UNUSED_PARAM(doc);
+
+    pcdom_node_t *dom_node = pcdom_interface_node(elem);
+    return make_doc_node(dom_node->first_child);
+}
+
+static pcdoc_node next_sibling(purc_document_t doc, pcdoc_node node)
+{
+    UNUSED_PARAM(doc);
+
+    pcdom_node_t *dom_node = pcdom_interface_node(node.elem);
+    return make_doc_node(dom_node->next);
+}
+
 static int get_attribute(purc_document_t doc, pcdoc_element_t elem,
             const char *name, const char **val, size_t *len)
 {
@@ -679,13 +868,16 @@ struct purc_document_ops _pcdoc_html_ops = {
     .get_parent = get_parent,
     .children_count = children_count,
     .get_child = get_child,
+    .first_child = first_child,
+    .next_sibling = next_sibling,
     .get_attribute = get_attribute,
     .get_special_attr = get_special_attr,
     .get_text = get_text,
     .get_data = NULL,
     .travel = travel,
     .serialize = serialize,
-    .elem_coll_select = NULL,
-    .elem_coll_filter = NULL,
+    .find_elem = pcdoc_html_find,
+    .elem_coll_select = pcdoc_html_select,
+    .elem_coll_filter = pcdoc_html_filter,
 };
 
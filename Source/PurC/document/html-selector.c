@@ -0,0 +1,933 @@
+/**
+ * @file html-selector.c
+ * @brief The CSS selector engine and the element index of html document.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc-document.h"
+#include "purc-errors.h"
+#include "purc-html.h"
+
+#include "private/document.h"
+#include "private/hashtable.h"
+#include "private/debug.h"
+
+#include "internal.h"
+
+/*
+ * The index maps the identifiers and the class names to the elements
+ * having them. It is built on the first query which can use it, and then
+ * kept up to date by the operations of html document. The elements in
+ * a bucket are kept in the document order.
+ */
+
+/* the flag of DOM node used to mark the elements temporarily */
+#define NODE_FLAG_MARKED        0x01
+
+struct elem_bucket {
+    char                *key;
+    struct pchash_table *table;
+
+    pcdom_element_t    **elems;
+    size_t               nr_elems;
+    size_t               sz_elems;
+
+    bool                 dirty;
+};
+
+struct pcdoc_elem_index {
+    struct pchash_table *ids;
+    struct pchash_table *classes;
+
+    /* the buckets having marked elements */
+    struct pcutils_arrlist *dirty_buckets;
+};
+
+static pcdom_node_t *
+next_node(pcdom_node_t *node, pcdom_node_t *root)
+{
+    if (node->first_child)
+        return node->first_child;
+
+    while (node != root) {
+        if (node->next)
+            return node->next;
+        node = node->parent;
+    }
+
+    return NULL;
+}
+
+static inline pcdom_element_t *
+root_element(purc_document_t doc)
+{
+    return pchtml_doc_get_document((pchtml_html_document_t *)doc->impl)->
+        element;
+}
+
+static inline bool
+is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\f' || c == '\r';
+}
+
+/* Gets the next token in a space-separated list like the class names. */
+static const char *
+next_token(const char **s, const char *end, size_t *len)
+{
+    const char *p = *s;
+    while (p < end && is_space(*p))
+        p++;
+
+    const char *token = p;
+    while (p < end && !is_space(*p))
+        p++;
+
+    *s = p;
+    *len = p - token;
+    return (*len > 0) ? token : NULL;
+}
+
+static void
+bucket_free(struct pchash_entry *entry)
+{
+    /* the key is owned by the bucket */
+    struct elem_bucket *bucket = pchash_entry_v(entry);
+    free(bucket->elems);
+    free(bucket->key);
+    free(bucket);
+}
+
+static struct elem_bucket *
+bucket_lookup(struct pchash_table *table, const char *key, size_t len)
+{
+    char buf[64];
+    char *k = buf;
+    if (len >= sizeof(buf)) {
+        k = malloc(len + 1);
+        if (k == NULL)
+            return NULL;
+    }
+
+    memcpy(k, key, len);
+    k[len] = '\0';
+
+    struct elem_bucket *bucket = NULL;
+    pchash_table_lookup_ex(table, k, (void **)&bucket);
+
+    if (k != buf)
+        free(k);
+    return bucket;
+}
+
+/*
+ * Compares the positions of two nodes in the document order. The cost is
+ * the depth of the nodes plus the distance between the children of their
+ * closest common ancestor, not the size of the document.
+ */
+static int
+compare_positions(pcdom_node_t *a, pcdom_node_t *b)
+{
+    if (a == b)
+        return 0;
+
+    size_t depth_a = 0, depth_b = 0;
+    for (pcdom_node_t *node = a->parent; node; node = node->parent)
+        depth_a++;
+    for (pcdom_node_t *node = b->parent; node; node = node->parent)
+        depth_b++;
+
+    /* an ancestor precedes its descendants */
+    for (; depth_a > depth_b; depth_a--) {
+        a = a->parent;
+        if (a == b)
+            return 1;
+    }
+    for (; depth_b > depth_a; depth_b--) {
+        b = b->parent;
+        if (b == a)
+            return -1;
+    }
+
+    while (a->parent != b->parent) {
+        a = a->parent;
+        b = b->parent;
+    }
+
+    /* look for `b` in both directions from its sibling `a` */
+    pcdom_node_t *next = a->next, *prev = a->prev;
+    while (next || prev) {
+        if (next) {
+            if (next == b)
+                return -1;
+            next = next->next;
+        }
+        if (prev) {
+            if (prev == b)
+                return 1;
+            prev = prev->prev;
+        }
+    }
+
+    /* not in the same tree */
+    return 0;
+}
+
+/* Finds the position to insert `elem` in the bucket by the document order;
+ * returns -1 if it is in the bucket already. */
+static ssize_t
+bucket_position(struct elem_bucket *bucket, pcdom_element_t *elem)
+{
+    size_t lo = 0, hi = bucket->nr_elems;
+
+    /* the element appended to the document usually goes to the end */
+    if (hi > 0) {
+        int r = compare_positions(&bucket->elems[hi - 1]->node, &elem->node);
+        if (r < 0)
+            return hi;
+        if (r == 0)
+            return -1;
+        hi--;
+    }
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int r = compare_positions(&bucket->elems[mid]->node, &elem->node);
+        if (r == 0)
+            return -1;
+        if (r < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static int
+bucket_add(struct pchash_table *table, const char *key, size_t len,
+        pcdom_element_t *elem, bool in_order)
+{
+    struct elem_bucket *bucket = bucket_lookup(table, key, len);
+
+    if (bucket == NULL) {
+        bucket = calloc(1, sizeof(*bucket));
+        if (bucket == NULL)
+            goto failed;
+
+        bucket->key = strndup(key, len);
+        bucket->table = table;
+        if (bucket->key == NULL ||
+                pchash_table_insert(table, bucket->key, bucket)) {
+            free(bucket->key);
+            free(bucket);
+            goto failed;
+        }
+    }
+
+    size_t pos = bucket->nr_elems;
+    if (!in_order) {
+        ssize_t r = bucket_position(bucket, elem);
+        if (r < 0)
+            return 0;
+        pos = r;
+    }
+    else if (pos > 0 && bucket->elems[pos - 1] == elem) {
+        /* a class name given twice */
+        return 0;
+    }
+
+    if (bucket->nr_elems == bucket->sz_elems) {
+        size_t sz = bucket->sz_elems ? bucket->sz_elems * 2 : 1;
+        pcdom_element_t **elems;
+        elems = realloc(bucket->elems, sizeof(elems[0]) * sz);
+        if (elems == NULL)
+            goto failed;
+
+        bucket->elems = elems;
+        bucket->sz_elems = sz;
+    }
+
+    memmove(bucket->elems + pos + 1, bucket->elems + pos,
+            sizeof(bucket->elems[0]) * (bucket->nr_elems - pos));
+    bucket->elems[pos] = elem;
+    bucket->nr_elems++;
+    return 0;
+
+failed:
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return -1;
+}
+
+static int
+index_element(struct pcdoc_elem_index *index, pcdom_element_t *elem,
+        bool in_order)
+{
+    const char *s;
+    size_t len;
+
+    s = (const char *)pcdom_element_id(elem, &len);
+    if (s && len > 0) {
+        if (bucket_add(index->ids, s, len, elem, in_order))
+            return -1;
+    }
+
+    s = (const char *)pcdom_element_class(elem, &len);
+    if (s && len > 0) {
+        const char *end = s + len;
+        const char *token;
+        while ((token = next_token(&s, end, &len))) {
+            if (bucket_add(index->classes, token, len, elem, in_order))
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int
+index_subtree(struct pcdoc_elem_index *index, pcdom_node_t *root,
+        bool in_order)
+{
+    for (pcdom_node_t *node = root; node; node = next_node(node, root)) {
+        if (node->type != PCDOM_NODE_TYPE_ELEMENT)
+            continue;
+
+        if (index_element(index, (pcdom_element_t *)node, in_order))
+            return -1;
+    }
+
+    return 0;
+}
+
+static int
+mark_in_bucket(struct pcdoc_elem_index *index, struct elem_bucket *bucket)
+{
+    if (bucket && !bucket->dirty) {
+        if (pcutils_arrlist_append(index->dirty_buckets, bucket))
+            return -1;
+        bucket->dirty = true;
+    }
+
+    return 0;
+}
+
+static int
+mark_element(struct pcdoc_elem_index *index, pcdom_element_t *elem)
+{
+    const char *s;
+    size_t len;
+
+    elem->node.flags |= NODE_FLAG_MARKED;
+
+    s = (const char *)pcdom_element_id(elem, &len);
+    if (s && len > 0) {
+        if (mark_in_bucket(index, bucket_lookup(index->ids, s, len)))
+            return -1;
+    }
+
+    s = (const char *)pcdom_element_class(elem, &len);
+    if (s && len > 0) {
+        const char *end = s + len;
+        const char *token;
+        while ((token = next_token(&s, end, &len))) {
+            if (mark_in_bucket(index,
+                        bucket_lookup(index->classes, token, len)))
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* Removes the marked elements from the dirty buckets. */
+static void
+sweep_marked_elements(struct pcdoc_elem_index *index)
+{
+    size_t nr = pcutils_arrlist_length(index->dirty_buckets);
+
+    for (size_t i = 0; i < nr; i++) {
+        struct elem_bucket *bucket;
+        bucket = pcutils_arrlist_get_idx(index->dirty_buckets, i);
+
+        size_t n = 0;
+        for (size_t j = 0; j < bucket->nr_elems; j++) {
+            if (!(bucket->elems[j]->node.flags & NODE_FLAG_MARKED))
+                bucket->elems[n++] = bucket->elems[j];
+        }
+        bucket->nr_elems = n;
+        bucket->dirty = false;
+
+        if (n == 0)
+            pchash_table_delete(bucket->table, bucket->key);
+    }
+
+    pcutils_arrlist_del_idx(index->dirty_buckets, 0, nr);
+}
+
+static struct pcdoc_elem_index *
+index_new(void)
+{
+    struct pcdoc_elem_index *index = calloc(1, sizeof(*index));
+    if (index == NULL)
+        goto failed;
+
+    index->ids = pchash_kstr_table_new(HASHTABLE_DEFAULT_SIZE, bucket_free);
+    index->classes = pchash_kstr_table_new(HASHTABLE_DEFAULT_SIZE, bucket_free);
+    index->dirty_buckets = pcutils_arrlist_new_ex(NULL, 4);
+    if (index->ids == NULL || index->classes == NULL ||
+            index->dirty_buckets == NULL)
+        goto failed;
+
+    return index;
+
+failed:
+    if (index) {
+        if (index->ids)
+            pchash_table_free(index->ids);
+        if (index->classes)
+            pchash_table_free(index->classes);
+        if (index->dirty_buckets)
+            pcutils_arrlist_free(index->dirty_buckets);
+        free(index);
+    }
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return NULL;
+}
+
+static void
+index_delete(struct pcdoc_elem_index *index)
+{
+    pchash_table_free(index->ids);
+    pchash_table_free(index->classes);
+    pcutils_arrlist_free(index->dirty_buckets);
+    free(index);
+}
+
+/* Gets the index of the document; builds it on the first call. */
+static struct pcdoc_elem_index *
+get_index(purc_document_t doc)
+{
+    if (doc->elem_index)
+        return doc->elem_index;
+
+    struct pcdoc_elem_index *index = index_new();
+    if (index == NULL)
+        return NULL;
+
+    if (index_subtree(index, pcdom_interface_node(root_element(doc)), true)) {
+        index_delete(index);
+        return NULL;
+    }
+
+    doc->elem_index = index;
+    return index;
+}
+
+void
+pcdoc_html_index_destroy(purc_document_t doc)
+{
+    if (doc->elem_index) {
+        index_delete(doc->elem_index);
+        doc->elem_index = NULL;
+    }
+}
+
+void
+pcdoc_html_index_add(purc_document_t doc, pcdoc_element_t elem,
+        bool descendants)
+{
+    struct pcdoc_elem_index *index = doc->elem_index;
+    if (index == NULL)
+        return;
+
+    int r;
+    if (descendants)
+        r = index_subtree(index, pcdom_interface_node(elem), false);
+    else
+        r = index_element(index, pcdom_interface_element(elem), false);
+
+    if (r) {
+        /* give up the index; it will be built again on demand */
+        PC_WARN("failed to update the element index\n");
+        pcdoc_html_index_destroy(doc);
+    }
+}
+
+void
+pcdoc_html_index_remove(purc_document_t doc, pcdoc_element_t elem,
+        bool self, bool descendants)
+{
+    struct pcdoc_elem_index *index = doc->elem_index;
+    if (index == NULL)
+        return;
+
+    pcdom_node_t *root = pcdom_interface_node(elem);
+    pcdom_node_t *node;
+    int r = 0;
+
+    if (self)
+        r = mark_element(index, pcdom_interface_element(elem));
+
+    if (descendants) {
+        for (node = root->first_child; node && r == 0;
+                node = next_node(node, root)) {
+            if (node->type == PCDOM_NODE_TYPE_ELEMENT)
+                r = mark_element(index, (pcdom_element_t *)node);
+        }
+    }
+
+    if (r == 0)
+        sweep_marked_elements(index);
+
+    root->flags &= ~NODE_FLAG_MARKED;
+    if (descendants) {
+        for (node = root->first_child; node; node = next_node(node, root))
+            node->flags &= ~NODE_FLAG_MARKED;
+    }
+
+    if (r) {
+        PC_WARN("failed to update the element index\n");
+        pcdoc_html_index_destroy(doc);
+    }
+}
+
+struct select_ctxt {
+    pcdom_element_t     *root;
+    pcdom_element_t     *scope;
+};
+
+static inline pcdom_element_t *
+parent_element(pcdom_element_t *elem)
+{
+    pcdom_node_t *parent = elem->node.parent;
+    if (parent && parent->type == PCDOM_NODE_TYPE_ELEMENT)
+        return (pcdom_element_t *)parent;
+    return NULL;
+}
+
+static inline pcdom_element_t *
+prev_element(pcdom_element_t *elem)
+{
+    pcdom_node_t *node = elem->node.prev;
+    while (node && node->type != PCDOM_NODE_TYPE_ELEMENT)
+        node = node->prev;
+    return (pcdom_element_t *)node;
+}
+
+static inline pcdom_element_t *
+next_element(pcdom_element_t *elem)
+{
+    pcdom_node_t *node = elem->node.next;
+    while (node && node->type != PCDOM_NODE_TYPE_ELEMENT)
+        node = node->next;
+    return (pcdom_element_t *)node;
+}
+
+static inline bool
+str_equal(const char *s1, const char *s2, size_t len, bool icase)
+{
+    return (icase ? strncasecmp(s1, s2, len) : memcmp(s1, s2, len)) == 0;
+}
+
+static bool
+has_token(const char *s, size_t len, const char *name, size_t name_len,
+        bool icase)
+{
+    const char *end = s + len;
+    const char *token;
+    size_t token_len;
+
+    while ((token = next_token(&s, end, &token_len))) {
+        if (token_len == name_len && str_equal(token, name, name_len, icase))
+            return true;
+    }
+
+    return false;
+}
+
+static bool
+match_attr(pcdom_element_t *elem, const struct pcdoc_sel_simple *simple)
+{
+    pcdom_attr_t *attr;
+    attr = pcdom_element_attr_by_name(elem,
+            (const unsigned char *)simple->name, strlen(simple->name));
+    if (attr == NULL)
+        return false;
+
+    if (simple->op == PCDOC_SEL_ATTR_EXISTS)
+        return true;
+
+    size_t len;
+    const char *val = (const char *)pcdom_attr_value(attr, &len);
+    if (val == NULL) {
+        val = "";
+        len = 0;
+    }
+
+    const char *v = simple->value;
+    size_t vlen = simple->value_len;
+    bool icase = simple->icase;
+
+    switch (simple->op) {
+    case PCDOC_SEL_ATTR_EQUAL:
+        return len == vlen && str_equal(val, v, len, icase);
+
+    case PCDOC_SEL_ATTR_INCLUDE:
+        return vlen > 0 && has_token(val, len, v, vlen, icase);
+
+    case PCDOC_SEL_ATTR_DASH:
+        return len >= vlen && str_equal(val, v, vlen, icase) &&
+            (len == vlen || val[vlen] == '-');
+
+    case PCDOC_SEL_ATTR_PREFIX:
+        return vlen > 0 && len >= vlen && str_equal(val, v, vlen, icase);
+
+    case PCDOC_SEL_ATTR_SUFFIX:
+        return vlen > 0 && len >= vlen &&
+            str_equal(val + len - vlen, v, vlen, icase);
+
+    case PCDOC_SEL_ATTR_SUBSTR:
+        if (vlen == 0)
+            return false;
+        for (size_t i = 0; i + vlen <= len; i++) {
+            if (str_equal(val + i, v, vlen, icase))
+                return true;
+        }
+        return false;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+static inline bool
+match_nth(long a, long b, long pos)
+{
+    if (a == 0)
+        return pos == b;
+
+    long d = pos - b;
+    return (d % a) == 0 && (d / a) >= 0;
+}
+
+static bool
+match_simple(struct select_ctxt *ctxt, pcdom_element_t *elem,
+        const struct pcdoc_sel_simple *simple)
+{
+    const char *s;
+    size_t len;
+    long pos;
+
+    switch (simple->type) {
+    case PCDOC_SEL_ID:
+        s = (const char *)pcdom_element_id(elem, &len);
+        return s && len == strlen(simple->name) &&
+            memcmp(s, simple->name, len) == 0;
+
+    case PCDOC_SEL_CLASS:
+        s = (const char *)pcdom_element_class(elem, &len);
+        return s && has_token(s, len, simple->name, strlen(simple->name),
+                false);
+
+    case PCDOC_SEL_ATTR:
+        return match_attr(elem, simple);
+
+    case PCDOC_SEL_NTH_CHILD:
+        pos = 1;
+        for (pcdom_element_t *e = prev_element(elem); e; e = prev_element(e))
+            pos++;
+        return match_nth(simple->a, simple->b, pos);
+
+    case PCDOC_SEL_NTH_LAST_CHILD:
+        pos = 1;
+        for (pcdom_element_t *e = next_element(elem); e; e = next_element(e))
+            pos++;
+        return match_nth(simple->a, simple->b, pos);
+
+    case PCDOC_SEL_ONLY_CHILD:
+        return prev_element(elem) == NULL && next_element(elem) == NULL;
+
+    case PCDOC_SEL_ROOT:
+        return elem == ctxt->root;
+
+    case PCDOC_SEL_SCOPE:
+        return elem == ctxt->scope;
+    }
+
+    return false;
+}
+
+static bool
+match_compound(struct select_ctxt *ctxt, pcdom_element_t *elem,
+        const struct pcdoc_sel_compound *compound)
+{
+    if (compound->tag) {
+        size_t len;
+        const char *name;
+        name = (const char *)pcdom_element_local_name(elem, &len);
+        if (name == NULL || len != strlen(compound->tag) ||
+                strncasecmp(name, compound->tag, len))
+            return false;
+    }
+
+    for (size_t i = 0; i < compound->nr_simples; i++) {
+        if (!match_simple(ctxt, elem, compound->simples + i))
+            return false;
+    }
+
+    return true;
+}
+
+/* Matches the compounds from the right to the left. */
+static bool
+match_complex(struct select_ctxt *ctxt, pcdom_element_t *elem,
+        const struct pcdoc_sel_complex *complex, size_t idx)
+{
+    const struct pcdoc_sel_compound *compound = complex->compounds + idx;
+
+    if (!match_compound(ctxt, elem, compound))
+        return false;
+
+    if (idx == 0)
+        return true;
+
+    pcdom_element_t *e;
+    switch (compound->combinator) {
+    case PCDOC_SEL_COMB_CHILD:
+        e = parent_element(elem);
+        return e && match_complex(ctxt, e, complex, idx - 1);
+
+    case PCDOC_SEL_COMB_DESCENDANT:
+        for (e = parent_element(elem); e; e = parent_element(e)) {
+            if (match_complex(ctxt, e, complex, idx - 1))
+                return true;
+        }
+        break;
+
+    case PCDOC_SEL_COMB_ADJACENT:
+        e = prev_element(elem);
+        return e && match_complex(ctxt, e, complex, idx - 1);
+
+    case PCDOC_SEL_COMB_SIBLING:
+        for (e = prev_element(elem); e; e = prev_element(e)) {
+            if (match_complex(ctxt, e, complex, idx - 1))
+                return true;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+static bool
+match_selector(struct select_ctxt *ctxt, pcdom_element_t *elem,
+        const struct pcdoc_selector *sel)
+{
+    for (size_t i = 0; i < sel->nr_complexes; i++) {
+        const struct pcdoc_sel_complex *complex = sel->complexes + i;
+        if (match_complex(ctxt, elem, complex, complex->nr_compounds - 1))
+            return true;
+    }
+
+    return false;
+}
+
+static bool
+in_scope(struct select_ctxt *ctxt, pcdom_element_t *elem)
+{
+    if (ctxt->scope == ctxt->root)
+        return true;
+
+    for (pcdom_node_t *node = &elem->node; node; node = node->parent) {
+        if (node == &ctxt->scope->node)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * Finds the bucket of the candidates for the rightmost compound selector.
+ * Returns false if the index can not be used; `*bucket` is NULL if
+ * no element can match.
+ */
+static bool
+find_candidates(purc_document_t doc, const struct pcdoc_sel_compound *key,
+        struct elem_bucket **bucket)
+{
+    struct pcdoc_elem_index *index = NULL;
+    bool usable = false;
+
+    *bucket = NULL;
+    for (size_t i = 0; i < key->nr_simples; i++) {
+        const struct pcdoc_sel_simple *simple = key->simples + i;
+
+        if (simple->type == PCDOC_SEL_ID) {
+            if (index == NULL && (index = get_index(doc)) == NULL)
+                return false;
+
+            *bucket = bucket_lookup(index->ids, simple->name,
+                    strlen(simple->name));
+            return true;
+        }
+    }
+
+    for (size_t i = 0; i < key->nr_simples; i++) {
+        const struct pcdoc_sel_simple *simple = key->simples + i;
+
+        if (simple->type == PCDOC_SEL_CLASS) {
+            if (index == NULL && (index = get_index(doc)) == NULL)
+                return false;
+
+            /* use the smallest bucket among the class names */
+            struct elem_bucket *b = bucket_lookup(index->classes,
+                    simple->name, strlen(simple->name));
+            if (b == NULL) {
+                *bucket = NULL;
+                return true;
+            }
+
+            if (!usable || b->nr_elems < (*bucket)->nr_elems)
+                *bucket = b;
+            usable = true;
+        }
+    }
+
+    return usable;
+}
+
+/*
+ * Selects the elements matching the selector in the scope; stops after
+ * the first one if `max` is 1. Returns the number of the selected elements,
+ * or -1 on failure.
+ */
+static ssize_t
+select_elements(purc_document_t doc, pcdom_element_t *scope,
+        const char *selector, struct pcutils_arrlist *result, size_t max)
+{
+    struct pcdoc_selector *sel = pcdoc_get_selector(doc, selector);
+    if (sel == NULL)
+        return -1;
+
+    struct select_ctxt ctxt = { root_element(doc), scope };
+    size_t nr = 0;
+
+    if (sel->nr_complexes == 1) {
+        const struct pcdoc_sel_complex *complex = sel->complexes;
+        const struct pcdoc_sel_compound *key;
+        struct elem_bucket *bucket;
+
+        key = complex->compounds + complex->nr_compounds - 1;
+        if (find_candidates(doc, key, &bucket)) {
+            if (bucket == NULL)
+                return 0;
+
+            for (size_t i = 0; i < bucket->nr_elems && nr < max; i++) {
+                pcdom_element_t *elem = bucket->elems[i];
+                if (in_scope(&ctxt, elem) && match_complex(&ctxt, elem,
+                            complex, complex->nr_compounds - 1)) {
+                    if (pcutils_arrlist_append(result, elem))
+                        goto failed;
+                    nr++;
+                }
+            }
+
+            return nr;
+        }
+    }
+
+    pcdom_node_t *root = pcdom_interface_node(scope);
+    for (pcdom_node_t *node = root; node && nr < max;
+            node = next_node(node, root)) {
+        if (node->type != PCDOM_NODE_TYPE_ELEMENT)
+            continue;
+
+        pcdom_element_t *elem = (pcdom_element_t *)node;
+        if (match_selector(&ctxt, elem, sel)) {
+            if (pcutils_arrlist_append(result, elem))
+                goto failed;
+            nr++;
+        }
+    }
+
+    return nr;
+
+failed:
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return -1;
+}
+
+int
+pcdoc_html_select(purc_document_t doc, pcdoc_elem_coll_t coll,
+        pcdoc_element_t scope, const char *selector)
+{
+    return (int)select_elements(doc, pcdom_interface_element(scope),
+            selector, coll->elems, SIZE_MAX);
+}
+
+pcdoc_element_t
+pcdoc_html_find(purc_document_t doc, pcdoc_element_t scope,
+        const char *selector)
+{
+    struct pcutils_arrlist *found = pcutils_arrlist_new_ex(NULL, 1);
+    if (found == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    pcdoc_element_t elem = NULL;
+    if (select_elements(doc, pcdom_interface_element(scope),
+                selector, found, 1) > 0)
+        elem = pcutils_arrlist_get_idx(found, 0);
+
+    pcutils_arrlist_free(found);
+    return elem;
+}
+
+int
+pcdoc_html_filter(purc_document_t doc, pcdoc_elem_coll_t dst_coll,
+        pcdoc_elem_coll_t src_coll, const char *selector)
+{
+    struct pcdoc_selector *sel = pcdoc_get_selector(doc, selector);
+    if (sel == NULL)
+        return -1;
+
+    struct select_ctxt ctxt = { root_element(doc), root_element(doc) };
+    size_t nr = pcutils_arrlist_length(src_coll->elems);
+    int n = 0;
+
+    for (size_t i = 0; i < nr; i++) {
+        pcdom_element_t *elem = pcutils_arrlist_get_idx(src_coll->elems, i);
+        if (match_selector(&ctxt, elem, sel)) {
+            if (pcutils_arrlist_append(dst_coll->elems, elem)) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return -1;
+            }
+            n++;
+        }
+    }
+
+    return n;
+}
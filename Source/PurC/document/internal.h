@@ -0,0 +1,147 @@
+/**
+ * @file internal.h
+ * @brief The internal interfaces shared by the document implementations.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_DOCUMENT_INTERNAL_H
+#define PURC_DOCUMENT_INTERNAL_H
+
+#include "config.h"
+
+#include "private/document.h"
+
+/* the maximal number of compiled selectors cached by a document */
+#define PCDOC_MAX_CACHED_SELECTORS  64
+
+enum pcdoc_sel_combinator {
+    PCDOC_SEL_COMB_NONE = 0,    /* the leftmost compound selector */
+    PCDOC_SEL_COMB_DESCENDANT,  /* A B */
+    PCDOC_SEL_COMB_CHILD,       /* A > B */
+    PCDOC_SEL_COMB_ADJACENT,    /* A + B */
+    PCDOC_SEL_COMB_SIBLING,     /* A ~ B */
+};
+
+enum pcdoc_sel_simple_type {
+    PCDOC_SEL_ID = 0,           /* #id */
+    PCDOC_SEL_CLASS,            /* .class */
+    PCDOC_SEL_ATTR,             /* [attr], [attr=value], ... */
+    PCDOC_SEL_NTH_CHILD,        /* :nth-child(an+b), :first-child */
+    PCDOC_SEL_NTH_LAST_CHILD,   /* :nth-last-child(an+b), :last-child */
+    PCDOC_SEL_ONLY_CHILD,       /* :only-child */
+    PCDOC_SEL_ROOT,             /* :root */
+    PCDOC_SEL_SCOPE,            /* :scope */
+};
+
+enum pcdoc_sel_attr_op {
+    PCDOC_SEL_ATTR_EXISTS = 0,  /* [attr] */
+    PCDOC_SEL_ATTR_EQUAL,       /* [attr=value] */
+    PCDOC_SEL_ATTR_INCLUDE,     /* [attr~=value] */
+    PCDOC_SEL_ATTR_DASH,        /* [attr|=value] */
+    PCDOC_SEL_ATTR_PREFIX,      /* [attr^=value] */
+    PCDOC_SEL_ATTR_SUFFIX,      /* [attr$=value] */
+    PCDOC_SEL_ATTR_SUBSTR,      /* [attr*=value] */
+};
+
+struct pcdoc_sel_simple {
+    enum pcdoc_sel_simple_type  type;
+
+    /* the identifier, the class name, or the attribute name */
+    char                       *name;
+
+    /* for attribute selectors */
+    enum pcdoc_sel_attr_op      op;
+    bool                        icase;
+    char                       *value;
+    size_t                      value_len;
+
+    /* for :nth-child() and :nth-last-child(): an+b */
+    long                        a, b;
+};
+
+struct pcdoc_sel_compound {
+    /* the combinator between this compound and the one on its left */
+    enum pcdoc_sel_combinator   combinator;
+
+    /* the lowercase tag name; NULL for the universal selector */
+    char                       *tag;
+
+    size_t                      nr_simples;
+    struct pcdoc_sel_simple    *simples;
+};
+
+struct pcdoc_sel_complex {
+    size_t                      nr_compounds;
+    struct pcdoc_sel_compound  *compounds;
+};
+
+struct pcdoc_selector {
+    char                       *source;
+
+    size_t                      nr_complexes;
+    struct pcdoc_sel_complex   *complexes;
+};
+
+PCA_EXTERN_C_BEGIN
+
+/* Compiles a selector list; sets PURC_ERROR_INVALID_VALUE on bad syntax. */
+struct pcdoc_selector *
+pcdoc_selector_new(const char *selector) WTF_INTERNAL;
+
+void
+pcdoc_selector_delete(struct pcdoc_selector *sel) WTF_INTERNAL;
+
+/* Returns the compiled selector cached by the document (compiling it
+   on the first use). The selector is owned by the cache. */
+struct pcdoc_selector *
+pcdoc_get_selector(purc_document_t doc, const char *selector) WTF_INTERNAL;
+
+/* Releases all selectors cached by the document. */
+void
+pcdoc_release_selectors(purc_document_t doc) WTF_INTERNAL;
+
+/* The selector engine of html document (html-selector.c) */
+int
+pcdoc_html_select(purc_document_t doc, pcdoc_elem_coll_t coll,
+        pcdoc_element_t scope, const char *selector) WTF_INTERNAL;
+
+int
+pcdoc_html_filter(purc_document_t doc, pcdoc_elem_coll_t dst_coll,
+        pcdoc_elem_coll_t src_coll, const char *selector) WTF_INTERNAL;
+
+pcdoc_element_t
+pcdoc_html_find(purc_document_t doc, pcdoc_element_t scope,
+        const char *selector) WTF_INTERNAL;
+
+/* Updates the element index (if built) for the element (and/or its
+   descendants) to be inserted, removed, or changed. */
+void
+pcdoc_html_index_add(purc_document_t doc, pcdoc_element_t elem,
+        bool descendants) WTF_INTERNAL;
+
+void
+pcdoc_html_index_remove(purc_document_t doc, pcdoc_element_t elem,
+        bool self, bool descendants) WTF_INTERNAL;
+
+void
+pcdoc_html_index_destroy(purc_document_t doc) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+#endif  /* PURC_DOCUMENT_INTERNAL_H */
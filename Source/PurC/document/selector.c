@@ -0,0 +1,602 @@
+/**
+ * @file selector.c
+ * @brief The compiler of CSS selectors and the per-document selector cache.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc-document.h"
+#include "purc-errors.h"
+#include "purc-utils.h"
+
+#include "private/document.h"
+#include "private/hashtable.h"
+
+#include "internal.h"
+
+/*
+ * The supported syntax is a subset of Selectors Level 3:
+ *
+ *  - selector lists separated by `,`;
+ *  - the descendant (` `), child (`>`), next-sibling (`+`) and
+ *    subsequent-sibling (`~`) combinators; a selector may start with
+ *    a combinator, which is then relative to the scope element;
+ *  - type and universal selectors, `#id`, `.class`;
+ *  - attribute selectors `[a]`, `[a=v]`, `[a~=v]`, `[a|=v]`, `[a^=v]`,
+ *    `[a$=v]` and `[a*=v]`, with an optional `i` flag;
+ *  - the pseudo-classes `:nth-child()`, `:nth-last-child()`,
+ *    `:first-child`, `:last-child`, `:only-child`, `:root` and `:scope`.
+ */
+
+struct sel_parser {
+    const char *p;
+};
+
+static inline bool
+is_ident_char(int c)
+{
+    return purc_isalnum(c) || c == '-' || c == '_' || c == '\\' ||
+        (unsigned char)c >= 0x80;
+}
+
+static inline void
+skip_spaces(struct sel_parser *parser)
+{
+    while (purc_isspace(*parser->p))
+        parser->p++;
+}
+
+/* Parses an identifier; the escaped characters are taken literally. */
+static char *
+parse_ident(struct sel_parser *parser, bool lower)
+{
+    const char *start = parser->p;
+    size_t len = 0;
+
+    while (is_ident_char(*parser->p)) {
+        if (*parser->p == '\\') {
+            if (parser->p[1] == '\0')
+                break;
+            parser->p++;
+        }
+        parser->p++;
+        len++;
+    }
+
+    if (len == 0) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    char *ident = malloc(len + 1);
+    if (ident == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    size_t i = 0;
+    for (const char *s = start; s < parser->p; s++) {
+        if (*s == '\\')
+            s++;
+        ident[i++] = lower ? purc_tolower(*s) : *s;
+    }
+    ident[i] = '\0';
+    return ident;
+}
+
+static char *
+parse_string(struct sel_parser *parser, size_t *len)
+{
+    char quote = *parser->p++;
+    const char *start = parser->p;
+
+    while (*parser->p && *parser->p != quote) {
+        if (*parser->p == '\\' && parser->p[1])
+            parser->p++;
+        parser->p++;
+    }
+
+    if (*parser->p != quote) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    char *str = malloc(parser->p - start + 1);
+    if (str == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    size_t i = 0;
+    for (const char *s = start; s < parser->p; s++) {
+        if (*s == '\\')
+            s++;
+        str[i++] = *s;
+    }
+    str[i] = '\0';
+    *len = i;
+
+    parser->p++;
+    return str;
+}
+
+static int
+parse_nth(struct sel_parser *parser, struct pcdoc_sel_simple *simple)
+{
+    skip_spaces(parser);
+
+    if (strncasecmp(parser->p, "odd", 3) == 0) {
+        parser->p += 3;
+        simple->a = 2;
+        simple->b = 1;
+        goto done;
+    }
+    else if (strncasecmp(parser->p, "even", 4) == 0) {
+        parser->p += 4;
+        simple->a = 2;
+        simple->b = 0;
+        goto done;
+    }
+
+    long sign = 1;
+    if (*parser->p == '+' || *parser->p == '-') {
+        sign = (*parser->p == '-') ? -1 : 1;
+        parser->p++;
+    }
+
+    bool has_digits = purc_isdigit(*parser->p);
+    long num = has_digits ? strtol(parser->p, (char **)&parser->p, 10) : 1;
+
+    if (*parser->p == 'n' || *parser->p == 'N') {
+        parser->p++;
+        simple->a = sign * num;
+        simple->b = 0;
+
+        skip_spaces(parser);
+        if (*parser->p == '+' || *parser->p == '-') {
+            sign = (*parser->p == '-') ? -1 : 1;
+            parser->p++;
+            skip_spaces(parser);
+            if (!purc_isdigit(*parser->p))
+                goto failed;
+            simple->b = sign * strtol(parser->p, (char **)&parser->p, 10);
+        }
+    }
+    else if (has_digits) {
+        simple->a = 0;
+        simple->b = sign * num;
+    }
+    else {
+        goto failed;
+    }
+
+done:
+    skip_spaces(parser);
+    if (*parser->p != ')')
+        goto failed;
+    parser->p++;
+    return 0;
+
+failed:
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+    return -1;
+}
+
+static int
+parse_attr(struct sel_parser *parser, struct pcdoc_sel_simple *simple)
+{
+    simple->type = PCDOC_SEL_ATTR;
+
+    skip_spaces(parser);
+    simple->name = parse_ident(parser, true);
+    if (simple->name == NULL)
+        return -1;
+    skip_spaces(parser);
+
+    if (*parser->p == ']') {
+        simple->op = PCDOC_SEL_ATTR_EXISTS;
+        parser->p++;
+        return 0;
+    }
+
+    if (*parser->p == '=') {
+        simple->op = PCDOC_SEL_ATTR_EQUAL;
+        parser->p++;
+        goto value;
+    }
+
+    switch (*parser->p) {
+    case '~':
+        simple->op = PCDOC_SEL_ATTR_INCLUDE;
+        break;
+    case '|':
+        simple->op = PCDOC_SEL_ATTR_DASH;
+        break;
+    case '^':
+        simple->op = PCDOC_SEL_ATTR_PREFIX;
+        break;
+    case '$':
+        simple->op = PCDOC_SEL_ATTR_SUFFIX;
+        break;
+    case '*':
+        simple->op = PCDOC_SEL_ATTR_SUBSTR;
+        break;
+    default:
+        goto failed;
+    }
+
+    if (parser->p[1] != '=')
+        goto failed;
+    parser->p += 2;
+
+value:
+    skip_spaces(parser);
+    if (*parser->p == '"' || *parser->p == '\'') {
+        simple->value = parse_string(parser, &simple->value_len);
+    }
+    else {
+        simple->value = parse_ident(parser, false);
+        if (simple->value)
+            simple->value_len = strlen(simple->value);
+    }
+    if (simple->value == NULL)
+        return -1;
+
+    skip_spaces(parser);
+    if (*parser->p == 'i' || *parser->p == 'I') {
+        simple->icase = true;
+        parser->p++;
+        skip_spaces(parser);
+    }
+    else if (*parser->p == 's' || *parser->p == 'S') {
+        parser->p++;
+        skip_spaces(parser);
+    }
+
+    if (*parser->p != ']')
+        goto failed;
+    parser->p++;
+    return 0;
+
+failed:
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+    return -1;
+}
+
+static int
+parse_pseudo_class(struct sel_parser *parser, struct pcdoc_sel_simple *simple)
+{
+    char *name = parse_ident(parser, true);
+    if (name == NULL)
+        return -1;
+
+    int retv = 0;
+    if (*parser->p == '(') {
+        parser->p++;
+        if (strcmp(name, "nth-child") == 0) {
+            simple->type = PCDOC_SEL_NTH_CHILD;
+            retv = parse_nth(parser, simple);
+        }
+        else if (strcmp(name, "nth-last-child") == 0) {
+            simple->type = PCDOC_SEL_NTH_LAST_CHILD;
+            retv = parse_nth(parser, simple);
+        }
+        else {
+            purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+            retv = -1;
+        }
+    }
+    else if (strcmp(name, "first-child") == 0) {
+        simple->type = PCDOC_SEL_NTH_CHILD;
+        simple->b = 1;
+    }
+    else if (strcmp(name, "last-child") == 0) {
+        simple->type = PCDOC_SEL_NTH_LAST_CHILD;
+        simple->b = 1;
+    }
+    else if (strcmp(name, "only-child") == 0) {
+        simple->type = PCDOC_SEL_ONLY_CHILD;
+    }
+    else if (strcmp(name, "root") == 0) {
+        simple->type = PCDOC_SEL_ROOT;
+    }
+    else if (strcmp(name, "scope") == 0) {
+        simple->type = PCDOC_SEL_SCOPE;
+    }
+    else {
+        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+        retv = -1;
+    }
+
+    free(name);
+    return retv;
+}
+
+static struct pcdoc_sel_simple *
+new_simple(struct pcdoc_sel_compound *compound)
+{
+    struct pcdoc_sel_simple *simples;
+    simples = realloc(compound->simples,
+            sizeof(*simples) * (compound->nr_simples + 1));
+    if (simples == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    compound->simples = simples;
+    memset(simples + compound->nr_simples, 0, sizeof(*simples));
+    return simples + compound->nr_simples++;
+}
+
+static int
+parse_compound(struct sel_parser *parser, struct pcdoc_sel_compound *compound)
+{
+    const char *start = parser->p;
+
+    if (*parser->p == '*') {
+        parser->p++;
+    }
+    else if (is_ident_char(*parser->p)) {
+        compound->tag = parse_ident(parser, true);
+        if (compound->tag == NULL)
+            return -1;
+    }
+
+    for (;;) {
+        struct pcdoc_sel_simple *simple;
+        char c = *parser->p;
+
+        if (c != '#' && c != '.' && c != '[' && c != ':')
+            break;
+
+        simple = new_simple(compound);
+        if (simple == NULL)
+            return -1;
+
+        parser->p++;
+        if (c == '#') {
+            simple->type = PCDOC_SEL_ID;
+            simple->name = parse_ident(parser, false);
+            if (simple->name == NULL)
+                return -1;
+        }
+        else if (c == '.') {
+            simple->type = PCDOC_SEL_CLASS;
+            simple->name = parse_ident(parser, false);
+            if (simple->name == NULL)
+                return -1;
+        }
+        else if (c == '[') {
+            if (parse_attr(parser, simple))
+                return -1;
+        }
+        else {
+            if (parse_pseudo_class(parser, simple))
+                return -1;
+        }
+    }
+
+    if (parser->p == start) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    return 0;
+}
+
+static struct pcdoc_sel_compound *
+new_compound(struct pcdoc_sel_complex *complex)
+{
+    struct pcdoc_sel_compound *compounds;
+    compounds = realloc(complex->compounds,
+            sizeof(*compounds) * (complex->nr_compounds + 1));
+    if (compounds == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    complex->compounds = compounds;
+    memset(compounds + complex->nr_compounds, 0, sizeof(*compounds));
+    return compounds + complex->nr_compounds++;
+}
+
+static enum pcdoc_sel_combinator
+parse_combinator(struct sel_parser *parser)
+{
+    switch (*parser->p) {
+    case '>':
+        parser->p++;
+        return PCDOC_SEL_COMB_CHILD;
+    case '+':
+        parser->p++;
+        return PCDOC_SEL_COMB_ADJACENT;
+    case '~':
+        parser->p++;
+        return PCDOC_SEL_COMB_SIBLING;
+    }
+
+    return PCDOC_SEL_COMB_NONE;
+}
+
+static int
+parse_complex(struct sel_parser *parser, struct pcdoc_sel_complex *complex)
+{
+    struct pcdoc_sel_compound *compound;
+    enum pcdoc_sel_combinator comb;
+
+    skip_spaces(parser);
+    comb = parse_combinator(parser);
+    if (comb != PCDOC_SEL_COMB_NONE) {
+        /* a relative selector like `> li`: anchor it at the scope */
+        struct pcdoc_sel_simple *simple;
+        if ((compound = new_compound(complex)) == NULL ||
+                (simple = new_simple(compound)) == NULL)
+            return -1;
+        simple->type = PCDOC_SEL_SCOPE;
+        skip_spaces(parser);
+    }
+
+    for (;;) {
+        compound = new_compound(complex);
+        if (compound == NULL)
+            return -1;
+        compound->combinator = comb;
+        if (parse_compound(parser, compound))
+            return -1;
+
+        const char *before_spaces = parser->p;
+        skip_spaces(parser);
+        if (*parser->p == '\0' || *parser->p == ',')
+            break;
+
+        comb = parse_combinator(parser);
+        if (comb == PCDOC_SEL_COMB_NONE) {
+            if (parser->p == before_spaces) {
+                purc_set_error(PURC_ERROR_INVALID_VALUE);
+                return -1;
+            }
+            comb = PCDOC_SEL_COMB_DESCENDANT;
+        }
+        skip_spaces(parser);
+    }
+
+    return 0;
+}
+
+static void
+release_complex(struct pcdoc_sel_complex *complex)
+{
+    for (size_t i = 0; i < complex->nr_compounds; i++) {
+        struct pcdoc_sel_compound *compound = complex->compounds + i;
+
+        for (size_t j = 0; j < compound->nr_simples; j++) {
+            free(compound->simples[j].name);
+            free(compound->simples[j].value);
+        }
+        free(compound->simples);
+        free(compound->tag);
+    }
+
+    free(complex->compounds);
+}
+
+void
+pcdoc_selector_delete(struct pcdoc_selector *sel)
+{
+    for (size_t i = 0; i < sel->nr_complexes; i++) {
+        release_complex(sel->complexes + i);
+    }
+
+    free(sel->complexes);
+    free(sel->source);
+    free(sel);
+}
+
+struct pcdoc_selector *
+pcdoc_selector_new(const char *selector)
+{
+    struct pcdoc_selector *sel = calloc(1, sizeof(*sel));
+    if (sel == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    sel->source = strdup(selector);
+    if (sel->source == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    struct sel_parser parser = { selector };
+    for (;;) {
+        struct pcdoc_sel_complex *complexes;
+        complexes = realloc(sel->complexes,
+                sizeof(*complexes) * (sel->nr_complexes + 1));
+        if (complexes == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto failed;
+        }
+
+        sel->complexes = complexes;
+        memset(complexes + sel->nr_complexes, 0, sizeof(*complexes));
+        if (parse_complex(&parser, complexes + sel->nr_complexes++))
+            goto failed;
+
+        if (*parser.p == '\0')
+            break;
+
+        assert(*parser.p == ',');
+        parser.p++;
+    }
+
+    return sel;
+
+failed:
+    pcdoc_selector_delete(sel);
+    return NULL;
+}
+
+static void
+selector_entry_free(struct pchash_entry *entry)
+{
+    /* the key is the source string owned by the selector */
+    pcdoc_selector_delete(pchash_entry_v(entry));
+}
+
+struct pcdoc_selector *
+pcdoc_get_selector(purc_document_t doc, const char *selector)
+{
+    struct pcdoc_selector *sel;
+
+    if (doc->selectors == NULL) {
+        doc->selectors = pchash_kstr_table_new(PCDOC_MAX_CACHED_SELECTORS,
+                selector_entry_free);
+        if (doc->selectors == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
+    }
+    else if (pchash_table_lookup_ex(doc->selectors, selector, (void **)&sel)) {
+        return sel;
+    }
+
+    sel = pcdoc_selector_new(selector);
+    if (sel == NULL)
+        return NULL;
+
+    /* evict the oldest one; the table keeps the entries in insertion order */
+    if (doc->selectors->count >= PCDOC_MAX_CACHED_SELECTORS)
+        pchash_table_delete_entry(doc->selectors, doc->selectors->head);
+
+    if (pchash_table_insert(doc->selectors, sel->source, sel)) {
+        pcdoc_selector_delete(sel);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    return sel;
+}
+
+void
+pcdoc_release_selectors(purc_document_t doc)
+{
+    if (doc->selectors) {
+        pchash_table_free(doc->selectors);
+        doc->selectors = NULL;
+    }
+}
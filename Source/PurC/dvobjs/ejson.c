@@ -1937,9 +1937,7 @@ shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         ssize_t sz = purc_variant_array_get_size(argv[0]);
 
         if (sz > 1) {
-            struct pcutils_array_list *al = variant_array_get_data(argv[0]);
-            struct pcutils_array_list_node *p;
-            array_list_for_each(al, p) {
+            for (size_t idx = 0; idx < (size_t)sz; idx++) {
 
                 size_t new_idx;
                 if (sz < RAND_MAX) {
@@ -1950,8 +1948,8 @@ shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
                     new_idx = new_idx * sz / RAND_MAX;
                 }
 
-                if (new_idx != p->idx)
-                    pcutils_array_list_swap(al, p->idx, new_idx);
+                if (new_idx != idx)
+                    pcvariant_array_swap(argv[0], idx, new_idx);
             }
         }
     }
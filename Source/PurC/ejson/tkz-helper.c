@@ -31,6 +31,7 @@
 #include "purc-utils.h"
 #include "purc-errors.h"
 #include "private/errors.h"
+#include "private/rwstream.h"
 #include "private/tkz-helper.h"
 
 #if HAVE(GLIB)
@@ -42,6 +43,17 @@
 #define NR_CONSUMED_LIST_LIMIT   10
 #define MIN_BUFFER_CAPACITY      32
 
+/*
+ * The capacity of the ring of consumed characters. The consumed and the
+ * reconsumed characters never exceed NR_CONSUMED_LIST_LIMIT in total,
+ * so a power of two above the limit is enough.
+ */
+#define NR_CONSUMED_RING         16
+#define CONSUMED_RING_MASK       (NR_CONSUMED_RING - 1)
+
+/* the size of the window refilled by one read of the rwstream */
+#define TKZ_READER_WINDOW_SIZE   (64 * 1024)
+
 #if HAVE(GLIB)
 #define    PCHVML_ALLOC(sz)   g_slice_alloc0(sz)
 #define    PCHVML_FREE(p)     g_slice_free1(sizeof(*p), (gpointer)p)
@@ -52,9 +64,29 @@
 
 struct tkz_reader {
     purc_rwstream_t rws;
-    struct list_head reconsume_list;
-    struct list_head consumed_list;
-    size_t nr_consumed_list;
+
+    /*
+     * The undecoded bytes: [rd, end). They point to the content of
+     * a memory-backed rwstream when the reader decodes it in place
+     * (in_place is true), or to the window buffer refilled by block reads.
+     */
+    const uint8_t *rd;
+    const uint8_t *end;
+    uint8_t *window;
+    bool in_place;
+    bool eof;
+    bool io_error;
+
+    /*
+     * The ring of the recent characters. The slot of the next character
+     * read from the stream is `ring_top & CONSUMED_RING_MASK`;
+     * the last `nr_reconsume` characters before it are to be reconsumed,
+     * and the `nr_consumed` characters before those can be rewound.
+     */
+    struct tkz_uc ring[NR_CONSUMED_RING];
+    size_t ring_top;
+    size_t nr_consumed;
+    size_t nr_reconsume;
 
     struct tkz_uc curr_uc;
     int line;
@@ -90,16 +122,22 @@ bool is_unihan(uint32_t uc)
     return false;
 }
 
-struct tkz_uc *tkz_uc_new(void)
+static uint32_t utf8_to_uint32_t(const unsigned char *utf8_char,
+        int utf8_char_len)
 {
-    return PCHVML_ALLOC(sizeof(struct tkz_uc));
-}
+    uint32_t wc = *((unsigned char *)(utf8_char++));
+    int n = utf8_char_len;
+    int t = 0;
 
-void tkz_uc_destroy(struct tkz_uc *uc)
-{
-    if (uc) {
-        PCHVML_FREE(uc);
+    if (wc & 0x80) {
+        wc &= (1 <<(8-n)) - 1;
+        while (--n > 0) {
+            t = *((unsigned char *)(utf8_char++));
+            wc = (wc << 6) | (t & 0x3F);
+        }
     }
+
+    return wc;
 }
 
 struct tkz_reader *tkz_reader_new(void)
@@ -108,138 +146,225 @@ struct tkz_reader *tkz_reader_new(void)
     if (!reader) {
         return NULL;
     }
-    INIT_LIST_HEAD(&reader->reconsume_list);
-    INIT_LIST_HEAD(&reader->consumed_list);
     reader->line = 1;
     reader->column = 0;
     reader->consumed = 0;
     return reader;
 }
 
+/*
+ * Gives the bytes decoded in place back to the memory-backed rwstream,
+ * so that the position of the stream reflects what the reader consumed.
+ * The bytes read ahead from other streams can not be given back.
+ */
+static void
+tkz_reader_detach_rwstream(struct tkz_reader *reader)
+{
+    if (reader->rws && reader->in_place) {
+        const uint8_t *start;
+        size_t nr_bytes;
+        start = pcrwstream_get_readable_mem(reader->rws, &nr_bytes);
+        if (start && reader->rd > start) {
+            purc_rwstream_seek(reader->rws, reader->rd - start, SEEK_CUR);
+        }
+    }
+
+    reader->rws = NULL;
+    reader->rd = NULL;
+    reader->end = NULL;
+    reader->in_place = false;
+    reader->eof = false;
+    reader->io_error = false;
+}
+
 void tkz_reader_set_rwstream(struct tkz_reader *reader,
         purc_rwstream_t rws)
 {
+    /* the HVML tokenizer sets the same stream before every token */
+    if (reader->rws == rws) {
+        return;
+    }
+
+    tkz_reader_detach_rwstream(reader);
     reader->rws = rws;
+    if (rws == NULL) {
+        return;
+    }
+
+    size_t nr_bytes;
+    const uint8_t *mem = pcrwstream_get_readable_mem(rws, &nr_bytes);
+    if (mem) {
+        reader->rd = mem;
+        reader->end = mem + nr_bytes;
+        reader->in_place = true;
+        reader->eof = true;     /* no more bytes than the memory */
+    }
 }
 
-static struct tkz_uc*
-tkz_reader_read_from_rwstream(struct tkz_reader *reader)
+/*
+ * Moves the undecoded bytes to the head of the window and fills the rest
+ * of the window with one read of the rwstream.
+ */
+static void
+tkz_reader_refill(struct tkz_reader *reader)
 {
-    char c[8] = {0};
-    uint32_t uc = 0;
-    int nr_c = purc_rwstream_read_utf8_char(reader->rws, c, &uc);
-    if (nr_c < 0) {
-        uc = TKZ_INVALID_CHARACTER;
+    if (reader->window == NULL) {
+        reader->window = malloc(TKZ_READER_WINDOW_SIZE);
+        if (reader->window == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            reader->eof = true;
+            reader->io_error = true;
+            return;
+        }
+        reader->rd = reader->window;
+        reader->end = reader->window;
     }
-    reader->column++;
-    reader->consumed++;
 
-    reader->curr_uc.character = uc;
-    reader->curr_uc.line = reader->line;
-    reader->curr_uc.column = reader->column;
-    reader->curr_uc.position = reader->consumed;
-    if (uc == '\n') {
-        reader->line++;
-        reader->column = 0;
+    size_t left = reader->end - reader->rd;
+    if (left && reader->rd != reader->window) {
+        memmove(reader->window, reader->rd, left);
+    }
+    reader->rd = reader->window;
+    reader->end = reader->window + left;
+
+    ssize_t ret = purc_rwstream_read(reader->rws, reader->window + left,
+            TKZ_READER_WINDOW_SIZE - left);
+    if (ret > 0) {
+        reader->end += ret;
+    }
+    else {
+        reader->eof = true;
+        reader->io_error = (ret < 0);
     }
-    return &reader->curr_uc;
 }
 
-static struct tkz_uc*
-tkz_reader_read_from_reconsume_list(struct tkz_reader *reader)
+/*
+ * Decodes the next character from the window. The rules are the same as
+ * purc_rwstream_read_utf8_char(): returns 0 on the end of the stream and
+ * TKZ_INVALID_CHARACTER on an I/O error or a bad encoding.
+ */
+static uint32_t
+tkz_reader_decode_char(struct tkz_reader *reader)
 {
-    struct tkz_uc *puc = list_entry(reader->reconsume_list.next,
-            struct tkz_uc, list);
-    reader->curr_uc = *puc;
-    list_del_init(&puc->list);
-    tkz_uc_destroy(puc);
-    return &reader->curr_uc;
-}
+    if (reader->rd == reader->end) {
+        if (!reader->eof) {
+            tkz_reader_refill(reader);
+        }
+        if (reader->rd == reader->end) {
+            return reader->io_error ? TKZ_INVALID_CHARACTER : 0;
+        }
+    }
 
-#define print_uc_list(uc_list, tag)                                         \
-    do {                                                                    \
-        PC_DEBUG("begin print %s list\n|", tag);                            \
-        struct list_head *p, *n;                                            \
-        list_for_each_safe(p, n, uc_list) {                                 \
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);        \
-            PC_DEBUG("%c", puc->character);                                 \
-        }                                                                   \
-        PC_DEBUG("|\nend print %s list\n", tag);                            \
-    } while(0)
+    /* fast path for ASCII characters */
+    uint8_t c = *reader->rd;
+    if (c < 0x80) {
+        reader->rd++;
+        return c;
+    }
 
-#define PRINT_CONSUMED_LIST(reader)    \
-        print_uc_list(&reader->consumed_list, "consumed")
+    if (c > 0xFD) {
+        reader->rd++;
+        pcinst_set_error(PCRWSTREAM_ERROR_IO);
+        return TKZ_INVALID_CHARACTER;
+    }
 
-#define PRINT_RECONSUM_LIST(reader)    \
-        print_uc_list(&reader->reconsume_list, "reconsume")
+    size_t ch_len = 1;
+    while (c & (0x80 >> ch_len))
+        ch_len++;
+    if (ch_len < 2) {
+        reader->rd++;
+        pcinst_set_error(PURC_ERROR_BAD_ENCODING);
+        return TKZ_INVALID_CHARACTER;
+    }
 
-static bool
-tkz_reader_add_consumed(struct tkz_reader *reader, struct tkz_uc *uc)
-{
-    struct tkz_uc *p = tkz_uc_new();
-    if (!p) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return false;
+    /* a short read may return a part of the character */
+    while ((size_t)(reader->end - reader->rd) < ch_len && !reader->eof) {
+        tkz_reader_refill(reader);
+    }
+
+    const uint8_t *p = reader->rd + 1;
+    for (size_t i = 1; i < ch_len; i++, p++) {
+        if (p == reader->end || (*p & 0xC0) != 0x80) {
+            /* the bad byte is consumed as well */
+            reader->rd = (p == reader->end) ? p : p + 1;
+            pcinst_set_error(PCRWSTREAM_ERROR_IO);
+            return TKZ_INVALID_CHARACTER;
+        }
     }
 
-    *p = *uc;
-    list_add_tail(&p->list, &reader->consumed_list);
-    reader->nr_consumed_list++;
+    const uint8_t *utf8 = reader->rd;
+    reader->rd = p;
 
-    if (reader->nr_consumed_list > NR_CONSUMED_LIST_LIMIT) {
-        struct tkz_uc *first = list_first_entry(
-                &reader->consumed_list, struct tkz_uc, list);
-        list_del_init(&first->list);
-        tkz_uc_destroy(first);
-        reader->nr_consumed_list--;
+    /* characters longer than three bytes are rejected like
+       purc_rwstream_read_utf8_char() does */
+    if (ch_len > 3) {
+        pcinst_set_error(PURC_ERROR_BAD_ENCODING);
+        return TKZ_INVALID_CHARACTER;
     }
-    return true;
+
+    size_t nr_chars;
+    if (!pcutils_string_check_utf8_len((const char *)utf8, ch_len,
+                &nr_chars, NULL)) {
+        pcinst_set_error(PURC_ERROR_BAD_ENCODING);
+        return TKZ_INVALID_CHARACTER;
+    }
+
+    return utf8_to_uint32_t(utf8, ch_len);
 }
 
-bool tkz_reader_reconsume_last_char(struct tkz_reader *reader)
+static void
+tkz_reader_read_from_rwstream(struct tkz_reader *reader, struct tkz_uc *uc)
 {
-    if (!reader->nr_consumed_list) {
-        return true;
-    }
+    uc->character = tkz_reader_decode_char(reader);
+    reader->column++;
+    reader->consumed++;
 
-    struct tkz_uc *last = list_last_entry(
-            &reader->consumed_list, struct tkz_uc, list);
-    list_del_init(&last->list);
-    reader->nr_consumed_list--;
+    uc->line = reader->line;
+    uc->column = reader->column;
+    uc->position = reader->consumed;
+    if (uc->character == '\n') {
+        reader->line++;
+        reader->column = 0;
+    }
+}
 
-    list_add(&last->list, &reader->reconsume_list);
+bool tkz_reader_reconsume_last_char(struct tkz_reader *reader)
+{
+    if (reader->nr_consumed) {
+        reader->nr_consumed--;
+        reader->nr_reconsume++;
+    }
     return true;
 }
 
 struct tkz_uc *tkz_reader_next_char(struct tkz_reader *reader)
 {
-    struct tkz_uc *ret = NULL;
-    if (list_empty(&reader->reconsume_list)) {
-        ret = tkz_reader_read_from_rwstream(reader);
+    struct tkz_uc *uc;
+    if (reader->nr_reconsume) {
+        uc = reader->ring + ((reader->ring_top - reader->nr_reconsume)
+                & CONSUMED_RING_MASK);
+        reader->nr_reconsume--;
     }
     else {
-        ret = tkz_reader_read_from_reconsume_list(reader);
+        uc = reader->ring + (reader->ring_top & CONSUMED_RING_MASK);
+        reader->ring_top++;
+        tkz_reader_read_from_rwstream(reader, uc);
     }
 
-    if (tkz_reader_add_consumed(reader, ret)) {
-        return ret;
+    if (reader->nr_consumed < NR_CONSUMED_LIST_LIMIT) {
+        reader->nr_consumed++;
     }
-    return NULL;
+
+    reader->curr_uc = *uc;
+    return &reader->curr_uc;
 }
 
 void tkz_reader_destroy(struct tkz_reader *reader)
 {
     if (reader) {
-        struct list_head *p, *n;
-        list_for_each_safe(p, n, &reader->reconsume_list) {
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);
-            list_del_init(&puc->list);
-            tkz_uc_destroy(puc);
-        }
-        list_for_each_safe(p, n, &reader->consumed_list) {
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);
-            list_del_init(&puc->list);
-            tkz_uc_destroy(puc);
+        tkz_reader_detach_rwstream(reader);
+        if (reader->window) {
+            free(reader->window);
         }
         PCHVML_FREE(reader);
     }
@@ -270,24 +395,6 @@ static bool is_utf8_leading_byte(char c)
     return (c & 0xC0) != 0x80;
 }
 
-static uint32_t utf8_to_uint32_t(const unsigned char *utf8_char,
-        int utf8_char_len)
-{
-    uint32_t wc = *((unsigned char *)(utf8_char++));
-    int n = utf8_char_len;
-    int t = 0;
-
-    if (wc & 0x80) {
-        wc &= (1 <<(8-n)) - 1;
-        while (--n > 0) {
-            t = *((unsigned char *)(utf8_char++));
-            wc = (wc << 6) | (t & 0x3F);
-        }
-    }
-
-    return wc;
-}
-
 static void tkz_buffer_append_inner(struct tkz_buffer *buffer,
         const char *bytes, size_t nr_bytes)
 {
@@ -31,10 +31,13 @@
 
 #include <math.h>
 
+PCEXE_DEFINE_RULE_CACHE_OPS(add)
+
 struct pcexec_exe_add_inst {
     struct purc_exec_inst       super;
 
     struct exe_add_param        param;
+    struct pcexec_cached_rule *cached_rule;
 
     double                      curr;
 };
@@ -44,6 +47,10 @@ static inline void
 reset(struct pcexec_exe_add_inst *exe_add_inst)
 {
     struct exe_add_param *param = &exe_add_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_add_inst->cached_rule);
+    exe_add_inst->cached_rule = NULL;
     exe_add_param_reset(param);
     pcexecutor_inst_reset(&exe_add_inst->super);
 }
@@ -54,21 +61,21 @@ parse_rule(struct pcexec_exe_add_inst *exe_add_inst,
 {
     purc_exec_inst_t inst = &exe_add_inst->super;
 
-    struct exe_add_param param = {0};
-    int r = exe_add_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
-
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("ADD", rule, parse_add_rule,
+            free_add_rule, &inst->err_msg);
+    if (!cached)
         return false;
+
+    if (cached == exe_add_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
     }
 
-    exe_add_param_reset(&exe_add_inst->param);
-    exe_add_inst->param = param;
+    pcexecutor_release_rule(exe_add_inst->cached_rule);
+    exe_add_inst->cached_rule = cached;
+    exe_add_inst->param.rule = *(struct add_rule *)cached->parsed;
 
     return true;
 }
@@ -34,10 +34,13 @@
 
 #include <math.h>
 
+PCEXE_DEFINE_RULE_CACHE_OPS(char)
+
 struct pcexec_exe_char_inst {
     struct purc_exec_inst       super;
 
     struct exe_char_param      param;
+    struct pcexec_cached_rule *cached_rule;
 
     wchar_t                   *result_set;
 };
@@ -47,6 +50,10 @@ static inline void
 reset(struct pcexec_exe_char_inst *exe_char_inst)
 {
     struct exe_char_param *param = &exe_char_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_char_inst->cached_rule);
+    exe_char_inst->cached_rule = NULL;
     exe_char_param_reset(param);
     pcexecutor_inst_reset(&exe_char_inst->super);
     PCEXE_FREE(exe_char_inst->result_set);
@@ -78,21 +85,21 @@ parse_rule(struct pcexec_exe_char_inst *exe_char_inst,
 {
     purc_exec_inst_t inst = &exe_char_inst->super;
 
-    struct exe_char_param param = {0};
-    int r = exe_char_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
-
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("CHAR", rule, parse_char_rule,
+            free_char_rule, &inst->err_msg);
+    if (!cached)
         return false;
+
+    if (cached == exe_char_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
     }
 
-    exe_char_param_reset(&exe_char_inst->param);
-    exe_char_inst->param = param;
+    pcexecutor_release_rule(exe_char_inst->cached_rule);
+    exe_char_inst->cached_rule = cached;
+    exe_char_inst->param.rule = *(struct char_rule *)cached->parsed;
 
     return prepare_result_set(exe_char_inst);
 }
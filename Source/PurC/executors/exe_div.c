@@ -31,10 +31,13 @@
 
 #include <math.h>
 
+PCEXE_DEFINE_RULE_CACHE_OPS(div)
+
 struct pcexec_exe_div_inst {
     struct purc_exec_inst       super;
 
     struct exe_div_param        param;
+    struct pcexec_cached_rule *cached_rule;
 
     double                      curr;
 };
@@ -44,6 +47,10 @@ static inline void
 reset(struct pcexec_exe_div_inst *exe_div_inst)
 {
     struct exe_div_param *param = &exe_div_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_div_inst->cached_rule);
+    exe_div_inst->cached_rule = NULL;
     exe_div_param_reset(param);
     pcexecutor_inst_reset(&exe_div_inst->super);
 }
@@ -54,21 +61,21 @@ parse_rule(struct pcexec_exe_div_inst *exe_div_inst,
 {
     purc_exec_inst_t inst = &exe_div_inst->super;
 
-    struct exe_div_param param = {0};
-    int r = exe_div_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
-
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("DIV", rule, parse_div_rule,
+            free_div_rule, &inst->err_msg);
+    if (!cached)
         return false;
+
+    if (cached == exe_div_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
     }
 
-    exe_div_param_reset(&exe_div_inst->param);
-    exe_div_inst->param = param;
+    pcexecutor_release_rule(exe_div_inst->cached_rule);
+    exe_div_inst->cached_rule = cached;
+    exe_div_inst->param.rule = *(struct div_rule *)cached->parsed;
 
     return true;
 }
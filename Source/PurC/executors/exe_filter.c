@@ -34,10 +34,13 @@
 
 #include <math.h>
 
+PCEXE_DEFINE_RULE_CACHE_OPS(filter)
+
 struct pcexec_exe_filter_inst {
     struct purc_exec_inst       super;
 
     struct exe_filter_param        param;
+    struct pcexec_cached_rule *cached_rule;
 
     purc_variant_t              result_set;
 };
@@ -47,6 +50,10 @@ static inline void
 reset(struct pcexec_exe_filter_inst *exe_filter_inst)
 {
     struct exe_filter_param *param = &exe_filter_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_filter_inst->cached_rule);
+    exe_filter_inst->cached_rule = NULL;
     exe_filter_param_reset(param);
     pcexecutor_inst_reset(&exe_filter_inst->super);
     PCEXE_CLR_VAR(exe_filter_inst->result_set);
@@ -197,21 +204,21 @@ parse_rule(struct pcexec_exe_filter_inst *exe_filter_inst,
 {
     purc_exec_inst_t inst = &exe_filter_inst->super;
 
-    struct exe_filter_param param = {0};
-    int r = exe_filter_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
-
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("FILTER", rule, parse_filter_rule,
+            free_filter_rule, &inst->err_msg);
+    if (!cached)
         return false;
+
+    if (cached == exe_filter_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
     }
 
-    exe_filter_param_reset(&exe_filter_inst->param);
-    exe_filter_inst->param = param;
+    pcexecutor_release_rule(exe_filter_inst->cached_rule);
+    exe_filter_inst->cached_rule = cached;
+    exe_filter_inst->param.rule = *(struct filter_rule *)cached->parsed;
 
     return prepare_result_set(exe_filter_inst);
 }
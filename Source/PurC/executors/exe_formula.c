@@ -31,10 +31,13 @@
 
 #include <math.h>
 
+PCEXE_DEFINE_RULE_CACHE_OPS(formula)
+
 struct pcexec_exe_formula_inst {
     struct purc_exec_inst       super;
 
     struct exe_formula_param        param;
+    struct pcexec_cached_rule *cached_rule;
 
     purc_variant_t              curr;
 };
@@ -44,6 +47,10 @@ static inline void
 reset(struct pcexec_exe_formula_inst *exe_formula_inst)
 {
     struct exe_formula_param *param = &exe_formula_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_formula_inst->cached_rule);
+    exe_formula_inst->cached_rule = NULL;
     exe_formula_param_reset(param);
     pcexecutor_inst_reset(&exe_formula_inst->super);
     PCEXE_CLR_VAR(exe_formula_inst->curr);
@@ -55,21 +62,21 @@ parse_rule(struct pcexec_exe_formula_inst *exe_formula_inst,
 {
     purc_exec_inst_t inst = &exe_formula_inst->super;
 
-    struct exe_formula_param param = {0};
-    int r = exe_formula_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
-
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("FORMULA", rule, parse_formula_rule,
+            free_formula_rule, &inst->err_msg);
+    if (!cached)
         return false;
+
+    if (cached == exe_formula_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
     }
 
-    exe_formula_param_reset(&exe_formula_inst->param);
-    exe_formula_inst->param = param;
+    pcexecutor_release_rule(exe_formula_inst->cached_rule);
+    exe_formula_inst->cached_rule = cached;
+    exe_formula_inst->param.rule = *(struct formula_rule *)cached->parsed;
 
     return true;
 }
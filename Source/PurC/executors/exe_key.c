@@ -34,10 +34,13 @@
 
 #include <math.h>
 
+PCEXE_DEFINE_RULE_CACHE_OPS(key)
+
 struct pcexec_exe_key_inst {
     struct purc_exec_inst       super;
 
     struct exe_key_param        param;
+    struct pcexec_cached_rule *cached_rule;
 
     purc_variant_t              result_set;
 };
@@ -47,6 +50,10 @@ static inline void
 reset(struct pcexec_exe_key_inst *exe_key_inst)
 {
     struct exe_key_param *param = &exe_key_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_key_inst->cached_rule);
+    exe_key_inst->cached_rule = NULL;
     exe_key_param_reset(param);
     pcexecutor_inst_reset(&exe_key_inst->super);
     PCEXE_CLR_VAR(exe_key_inst->result_set);
@@ -102,21 +109,21 @@ parse_rule(struct pcexec_exe_key_inst *exe_key_inst,
 {
     purc_exec_inst_t inst = &exe_key_inst->super;
 
-    struct exe_key_param param = {0};
-    int r = exe_key_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
-
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("KEY", rule, parse_key_rule,
+            free_key_rule, &inst->err_msg);
+    if (!cached)
         return false;
+
+    if (cached == exe_key_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
     }
 
-    exe_key_param_reset(&exe_key_inst->param);
-    exe_key_inst->param = param;
+    pcexecutor_release_rule(exe_key_inst->cached_rule);
+    exe_key_inst->cached_rule = cached;
+    exe_key_inst->param.rule = *(struct key_rule *)cached->parsed;
 
     return prepare_result_set(exe_key_inst);
 }
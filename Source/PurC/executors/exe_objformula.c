@@ -32,10 +32,13 @@
 
 #include <math.h>
 
+PCEXE_DEFINE_RULE_CACHE_OPS(objformula)
+
 struct pcexec_exe_objformula_inst {
     struct purc_exec_inst       super;
 
     struct exe_objformula_param        param;
+    struct pcexec_cached_rule *cached_rule;
 
     purc_variant_t               curr;
 };
@@ -45,6 +48,10 @@ static inline void
 reset(struct pcexec_exe_objformula_inst *exe_objformula_inst)
 {
     struct exe_objformula_param *param = &exe_objformula_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_objformula_inst->cached_rule);
+    exe_objformula_inst->cached_rule = NULL;
     exe_objformula_param_reset(param);
     pcexecutor_inst_reset(&exe_objformula_inst->super);
     PCEXE_CLR_VAR(exe_objformula_inst->curr);
@@ -56,23 +63,23 @@ parse_rule(struct pcexec_exe_objformula_inst *exe_objformula_inst,
 {
     purc_exec_inst_t inst = &exe_objformula_inst->super;
 
-    struct exe_objformula_param param = {0};
-    int r = exe_objformula_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
-
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("OBJFORMULA", rule, parse_objformula_rule,
+            free_objformula_rule, &inst->err_msg);
+    if (!cached)
         return false;
+
+    if (cached == exe_objformula_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
     }
 
-    exe_objformula_param_reset(&exe_objformula_inst->param);
-    exe_objformula_inst->param = param;
+    pcexecutor_release_rule(exe_objformula_inst->cached_rule);
+    exe_objformula_inst->cached_rule = cached;
+    exe_objformula_inst->param.rule =
+        *(struct objformula_rule *)cached->parsed;
 
-    PC_ASSERT(param.rule.vncle);
     PC_ASSERT(exe_objformula_inst->param.rule.vncle);
 
     return true;
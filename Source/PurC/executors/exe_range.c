@@ -36,10 +36,13 @@
 
 #include <math.h>
 
+PCEXE_DEFINE_RULE_CACHE_OPS(range)
+
 struct pcexec_exe_range_inst {
     struct purc_exec_inst       super;
 
     struct exe_range_param        param;
+    struct pcexec_cached_rule *cached_rule;
 
     purc_variant_t              result_set;
 };
@@ -49,6 +52,10 @@ static inline void
 reset(struct pcexec_exe_range_inst *exe_range_inst)
 {
     struct exe_range_param *param = &exe_range_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_range_inst->cached_rule);
+    exe_range_inst->cached_rule = NULL;
     exe_range_param_reset(param);
     pcexecutor_inst_reset(&exe_range_inst->super);
     PCEXE_CLR_VAR(exe_range_inst->result_set);
@@ -166,21 +173,21 @@ parse_rule(struct pcexec_exe_range_inst *exe_range_inst,
 {
     purc_exec_inst_t inst = &exe_range_inst->super;
 
-    struct exe_range_param param = {0};
-    int r = exe_range_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
-
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("RANGE", rule, parse_range_rule,
+            free_range_rule, &inst->err_msg);
+    if (!cached)
         return false;
+
+    if (cached == exe_range_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
     }
 
-    exe_range_param_reset(&exe_range_inst->param);
-    exe_range_inst->param = param;
+    pcexecutor_release_rule(exe_range_inst->cached_rule);
+    exe_range_inst->cached_rule = cached;
+    exe_range_inst->param.rule = *(struct range_rule *)cached->parsed;
 
     return prepare_result_set(exe_range_inst);
 }
@@ -24,59 +24,1760 @@
 
 #include "exe_sql.h"
 
+#include "pcexe-helper.h"
+
 #include "private/executor.h"
+#include "private/hashtable.h"
+#include "private/variant.h"
+
+#include "private/debug.h"
+#include "private/errors.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <strings.h>
+
+#if HAVE(GLIB)
+#include <glib.h>
+#endif // HAVE(GLIB)
+
+PCEXE_DEFINE_RULE_CACHE_OPS(sql)
+
+// the rows less than this are scanned instead of indexed
+#define MIN_ROWS_TO_BUILD_INDEX     16
+
+static char *
+format_str(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0)
+        return NULL;
+
+    char *str = (char*)malloc(n + 1);
+    if (!str)
+        return NULL;
+
+    va_start(ap, fmt);
+    vsnprintf(str, n + 1, fmt, ap);
+    va_end(ap);
+    return str;
+}
+
+struct sql_exp *
+sql_exp_create(enum sql_exp_type type)
+{
+    struct sql_exp *exp = (struct sql_exp*)calloc(1, sizeof(*exp));
+    if (!exp)
+        return NULL;
+
+    exp->type = type;
+    return exp;
+}
+
+void
+sql_exp_destroy(struct sql_exp *exp)
+{
+    while (exp) {
+        struct sql_exp *next = exp->next;
+
+        sql_exp_destroy(exp->left);
+        sql_exp_destroy(exp->right);
+        free(exp->str);
+        free(exp->sub);
+#if HAVE(GLIB)
+        if (exp->pattern_spec)
+            g_pattern_spec_free((GPatternSpec*)exp->pattern_spec);
+#endif
+        free(exp);
+
+        exp = next;
+    }
+}
+
+struct sql_exp *
+sql_exp_binary(enum sql_exp_type type,
+        struct sql_exp *left, struct sql_exp *right)
+{
+    struct sql_exp *exp = sql_exp_create(type);
+    if (!exp) {
+        sql_exp_destroy(left);
+        sql_exp_destroy(right);
+        return NULL;
+    }
+
+    exp->left = left;
+    exp->right = right;
+
+#if HAVE(GLIB)
+    if (type == SQL_EXP_LIKE && right->type == SQL_EXP_STRING) {
+        // compile the pattern once for the rule
+        exp->pattern_spec = g_pattern_spec_new(right->str ? right->str : "");
+        if (!exp->pattern_spec) {
+            sql_exp_destroy(exp);
+            return NULL;
+        }
+    }
+#endif
+
+    return exp;
+}
+
+static const struct {
+    const char                 *name;
+    enum sql_aggregate_func     func;
+} aggregate_funcs[] = {
+    { "COUNT",  SQL_AGGREGATE_COUNT },
+    { "SUM",    SQL_AGGREGATE_SUM },
+    { "AVG",    SQL_AGGREGATE_AVG },
+    { "MIN",    SQL_AGGREGATE_MIN },
+    { "MAX",    SQL_AGGREGATE_MAX },
+};
+
+static bool
+exp_has_type(struct sql_exp *exp, enum sql_exp_type type)
+{
+    if (!exp)
+        return false;
+
+    if (exp->type == type || exp_has_type(exp->left, type))
+        return true;
+
+    // the operands of IN are linked by `next`
+    for (struct sql_exp *p = exp->right; p; p = p->next) {
+        if (exp_has_type(p, type))
+            return true;
+    }
+
+    return false;
+}
+
+struct sql_exp *
+sql_exp_aggregate(const char *func, size_t len,
+        struct sql_exp *arg, char **err_msg)
+{
+    size_t i;
+    for (i = 0; i < PCA_TABLESIZE(aggregate_funcs); i++) {
+        if (strlen(aggregate_funcs[i].name) == len &&
+                strncasecmp(aggregate_funcs[i].name, func, len) == 0)
+            break;
+    }
+
+    const char *err = NULL;
+    if (i == PCA_TABLESIZE(aggregate_funcs))
+        err = "unknown function";
+    else if (arg->type == SQL_EXP_ALL &&
+            aggregate_funcs[i].func != SQL_AGGREGATE_COUNT)
+        err = "only COUNT accepts *";
+    else if (exp_has_type(arg, SQL_EXP_AGGREGATE))
+        err = "nested aggregate function";
+
+    if (err) {
+        if (err_msg)
+            *err_msg = format_str("%s: %.*s", err, (int)len, func);
+        sql_exp_destroy(arg);
+        return NULL;
+    }
+
+    struct sql_exp *exp = sql_exp_binary(SQL_EXP_AGGREGATE, arg, NULL);
+    if (exp)
+        exp->func = aggregate_funcs[i].func;
+    return exp;
+}
+
+struct sql_select_item *
+sql_select_item_create(struct sql_exp *exp, char *alias)
+{
+    struct sql_select_item *item;
+    item = (struct sql_select_item*)calloc(1, sizeof(*item));
+    if (!item) {
+        sql_exp_destroy(exp);
+        free(alias);
+        return NULL;
+    }
+
+    item->exp = exp;
+    item->name = alias;
+    return item;
+}
+
+void
+sql_select_item_destroy(struct sql_select_item *item)
+{
+    while (item) {
+        struct sql_select_item *next = item->next;
+        sql_exp_destroy(item->exp);
+        free(item->name);
+        free(item);
+        item = next;
+    }
+}
+
+struct sql_order_item *
+sql_order_item_create(struct sql_exp *exp, bool desc)
+{
+    struct sql_order_item *item;
+    item = (struct sql_order_item*)calloc(1, sizeof(*item));
+    if (!item) {
+        sql_exp_destroy(exp);
+        return NULL;
+    }
+
+    item->exp = exp;
+    item->desc = desc;
+    return item;
+}
+
+void
+sql_order_item_destroy(struct sql_order_item *item)
+{
+    while (item) {
+        struct sql_order_item *next = item->next;
+        sql_exp_destroy(item->exp);
+        free(item);
+        item = next;
+    }
+}
+
+void
+sql_select_destroy(struct sql_select *select)
+{
+    while (select) {
+        struct sql_select *next = select->next;
+        sql_select_item_destroy(select->items);
+        sql_exp_destroy(select->where);
+        sql_exp_destroy(select->group_by);
+        sql_order_item_destroy(select->order_by);
+        free(select);
+        select = next;
+    }
+}
+
+static void
+assign_aggregate_slots(struct sql_exp *exp, size_t *nr_aggregates)
+{
+    if (!exp)
+        return;
+
+    if (exp->type == SQL_EXP_AGGREGATE)
+        exp->slot = (*nr_aggregates)++;
+
+    assign_aggregate_slots(exp->left, nr_aggregates);
+    for (struct sql_exp *p = exp->right; p; p = p->next)
+        assign_aggregate_slots(p, nr_aggregates);
+}
+
+static char *
+make_item_name(struct sql_exp *exp, size_t idx)
+{
+    switch (exp->type) {
+    case SQL_EXP_FIELD:
+        return strdup(exp->sub ? exp->sub : exp->str);
+
+    case SQL_EXP_ALL:
+        return strdup("*");
+
+    case SQL_EXP_SELF:
+        return strdup("&");
+
+    case SQL_EXP_AGGREGATE:
+        for (size_t i = 0; i < PCA_TABLESIZE(aggregate_funcs); i++) {
+            if (aggregate_funcs[i].func != exp->func)
+                continue;
+
+            struct sql_exp *arg = exp->left;
+            if (arg->type == SQL_EXP_ALL)
+                return format_str("%s(*)", aggregate_funcs[i].name);
+            else if (arg->type == SQL_EXP_FIELD && arg->sub)
+                return format_str("%s(%s.%s)", aggregate_funcs[i].name,
+                        arg->str, arg->sub);
+            else if (arg->type == SQL_EXP_FIELD)
+                return format_str("%s(%s)", aggregate_funcs[i].name,
+                        arg->str);
+            break;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    // other expressions are named by their positions: _1, _2, ...
+    return format_str("_%zu", idx + 1);
+}
+
+int
+sql_select_prepare(struct sql_select *select, char **err_msg)
+{
+    const char *err = NULL;
+
+    if (exp_has_type(select->where, SQL_EXP_AGGREGATE))
+        err = "aggregate functions are not allowed in WHERE";
+
+    size_t idx = 0;
+    for (struct sql_select_item *item = select->items; item && !err;
+            item = item->next, idx++) {
+        assign_aggregate_slots(item->exp, &select->nr_aggregates);
+        if (!item->name) {
+            item->name = make_item_name(item->exp, idx);
+            if (!item->name)
+                return -1;
+        }
+    }
+
+    for (struct sql_order_item *item = select->order_by; item && !err;
+            item = item->next) {
+        if (exp_has_type(item->exp, SQL_EXP_AGGREGATE))
+            err = "aggregate functions are not allowed in ORDER BY, "
+                "use an alias instead";
+    }
+
+    if (err) {
+        if (err_msg)
+            *err_msg = strdup(err);
+        return -1;
+    }
+
+    struct sql_select_item *item = select->items;
+    select->select_all = item->next == NULL &&
+        (item->exp->type == SQL_EXP_ALL || item->exp->type == SQL_EXP_SELF) &&
+        select->group_by == NULL && select->nr_aggregates == 0;
+    return 0;
+}
+
+enum sql_value_type {
+    SQL_VALUE_NULL,
+    SQL_VALUE_BOOLEAN,
+    SQL_VALUE_NUMBER,
+    SQL_VALUE_STRING,
+    SQL_VALUE_OTHER,
+};
+
+/* A value evaluated for a row; it refers to the strings and the variants of
+ * the row or the rule, so it lives as long as they are not released. */
+struct sql_value {
+    enum sql_value_type         type;
+    double                      num;
+    const char                 *str;
+    size_t                      len;
+    purc_variant_t              v;      // the variant if any, not referenced
+};
+
+static inline void
+value_set_null(struct sql_value *val)
+{
+    memset(val, 0, sizeof(*val));
+}
+
+static inline void
+value_set_boolean(struct sql_value *val, bool b)
+{
+    memset(val, 0, sizeof(*val));
+    val->type = SQL_VALUE_BOOLEAN;
+    val->num = b ? 1 : 0;
+}
+
+static inline void
+value_set_number(struct sql_value *val, double d)
+{
+    memset(val, 0, sizeof(*val));
+    val->type = SQL_VALUE_NUMBER;
+    val->num = d;
+}
+
+static void
+value_from_variant(purc_variant_t v, struct sql_value *val)
+{
+    memset(val, 0, sizeof(*val));
+    if (v == PURC_VARIANT_INVALID)
+        return;
+
+    val->v = v;
+    switch (purc_variant_get_type(v)) {
+    case PURC_VARIANT_TYPE_UNDEFINED:
+    case PURC_VARIANT_TYPE_NULL:
+        val->type = SQL_VALUE_NULL;
+        break;
+
+    case PURC_VARIANT_TYPE_BOOLEAN:
+        val->type = SQL_VALUE_BOOLEAN;
+        val->num = purc_variant_is_true(v) ? 1 : 0;
+        break;
+
+    case PURC_VARIANT_TYPE_NUMBER:
+    case PURC_VARIANT_TYPE_LONGINT:
+    case PURC_VARIANT_TYPE_ULONGINT:
+    case PURC_VARIANT_TYPE_LONGDOUBLE:
+        val->type = SQL_VALUE_NUMBER;
+        purc_variant_cast_to_number(v, &val->num, false);
+        break;
+
+    case PURC_VARIANT_TYPE_STRING:
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+        val->type = SQL_VALUE_STRING;
+        val->str = purc_variant_get_string_const_ex(v, &val->len);
+        break;
+
+    default:
+        val->type = SQL_VALUE_OTHER;
+        break;
+    }
+}
+
+static purc_variant_t
+value_to_variant(const struct sql_value *val)
+{
+    if (val->v != PURC_VARIANT_INVALID)
+        return purc_variant_ref(val->v);
+
+    switch (val->type) {
+    case SQL_VALUE_BOOLEAN:
+        return purc_variant_make_boolean(val->num != 0);
+    case SQL_VALUE_NUMBER:
+        return purc_variant_make_number(val->num);
+    case SQL_VALUE_STRING:
+        return purc_variant_make_string_ex(val->str, val->len, false);
+    default:
+        return purc_variant_make_null();
+    }
+}
+
+// -1 for NULL (unknown), otherwise 0 or 1
+static int
+value_truth(const struct sql_value *val)
+{
+    switch (val->type) {
+    case SQL_VALUE_NULL:
+        return -1;
+    case SQL_VALUE_BOOLEAN:
+    case SQL_VALUE_NUMBER:
+        return (val->num != 0 && !isnan(val->num)) ? 1 : 0;
+    case SQL_VALUE_STRING:
+        return val->len > 0 ? 1 : 0;
+    default:
+        return purc_variant_booleanize(val->v) ? 1 : 0;
+    }
+}
+
+static double
+value_to_number(const struct sql_value *val)
+{
+    switch (val->type) {
+    case SQL_VALUE_BOOLEAN:
+    case SQL_VALUE_NUMBER:
+        return val->num;
+    case SQL_VALUE_STRING:
+        return strtod(val->str, NULL);
+    case SQL_VALUE_OTHER:
+        return purc_variant_numberify(val->v);
+    default:
+        return NAN;
+    }
+}
+
+// values of different types are ordered as: null, numbers, strings, others
+static inline int
+value_rank(const struct sql_value *val)
+{
+    switch (val->type) {
+    case SQL_VALUE_NULL:
+        return 0;
+    case SQL_VALUE_BOOLEAN:
+    case SQL_VALUE_NUMBER:
+        return 1;
+    case SQL_VALUE_STRING:
+        return 2;
+    default:
+        return 3;
+    }
+}
+
+static int
+value_compare(const struct sql_value *a, const struct sql_value *b)
+{
+    int ra = value_rank(a), rb = value_rank(b);
+    if (ra != rb)
+        return ra < rb ? -1 : 1;
+
+    int r;
+    switch (ra) {
+    case 0:
+        return 0;
+
+    case 1:
+        if (isnan(a->num) || isnan(b->num)) {
+            bool na = isnan(a->num), nb = isnan(b->num);
+            return na == nb ? 0 : (na ? -1 : 1);
+        }
+        return a->num < b->num ? -1 : (a->num > b->num ? 1 : 0);
+
+    case 2:
+        r = memcmp(a->str, b->str, a->len < b->len ? a->len : b->len);
+        if (r == 0)
+            return a->len < b->len ? -1 : (a->len > b->len ? 1 : 0);
+        return r < 0 ? -1 : 1;
+
+    default:
+        r = purc_variant_compare_ex(a->v, b->v, PCVARIANT_COMPARE_OPT_AUTO);
+        return r < 0 ? -1 : (r > 0 ? 1 : 0);
+    }
+}
+
+// the same test as the hash indexes do: only the values of a same type equal
+static bool
+value_equal(const struct sql_value *a, const struct sql_value *b)
+{
+    int ra = value_rank(a);
+    if (ra != value_rank(b))
+        return false;
+
+    switch (ra) {
+    case 0:
+        return true;
+    case 1:
+        return a->num == b->num;
+    case 2:
+        return a->len == b->len && memcmp(a->str, b->str, a->len) == 0;
+    default:
+        return purc_variant_is_equal_to(a->v, b->v);
+    }
+}
+
+static unsigned long
+value_hash(const struct sql_value *val)
+{
+    uint64_t h = UINT64_C(14695981039346656037);
+    const unsigned char *p;
+    size_t len;
+    double d;
+
+    switch (value_rank(val)) {
+    case 1:
+        d = (val->num == 0) ? 0 : val->num;    // -0 == 0
+        p = (const unsigned char *)&d;
+        len = sizeof(d);
+        break;
+    case 2:
+        p = (const unsigned char *)val->str;
+        len = val->len;
+        break;
+    default:
+        // nulls and others are told apart by value_equal()
+        return value_rank(val);
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= UINT64_C(1099511628211);
+    }
+    return (unsigned long)h;
+}
+
+struct sql_aggregate {
+    size_t                      count;
+    size_t                      nr_numbers;
+    double                      sum;
+    struct sql_value            value;  // the current MIN or MAX
+};
+
+static purc_variant_t
+get_field(purc_variant_t row, struct sql_exp *field)
+{
+    if (row == PURC_VARIANT_INVALID || !purc_variant_is_object(row))
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t v = purc_variant_object_get_by_ckey(row, field->str);
+    if (v == PURC_VARIANT_INVALID || !field->sub)
+        return v;
+
+    if (!purc_variant_is_object(v))
+        return PURC_VARIANT_INVALID;
+    return purc_variant_object_get_by_ckey(v, field->sub);
+}
+
+static void
+aggregate_value(struct sql_exp *exp, struct sql_aggregate *agg,
+        struct sql_value *val)
+{
+    switch (exp->func) {
+    case SQL_AGGREGATE_COUNT:
+        value_set_number(val, agg->count);
+        break;
+    case SQL_AGGREGATE_SUM:
+        if (agg->nr_numbers)
+            value_set_number(val, agg->sum);
+        else
+            value_set_null(val);
+        break;
+    case SQL_AGGREGATE_AVG:
+        if (agg->nr_numbers)
+            value_set_number(val, agg->sum / agg->nr_numbers);
+        else
+            value_set_null(val);
+        break;
+    case SQL_AGGREGATE_MIN:
+    case SQL_AGGREGATE_MAX:
+        *val = agg->value;
+        break;
+    }
+}
+
+/* Evaluate `exp` for `row`; `aggs` holds the aggregates of the group which
+ * the row represents, or NULL when not grouping. */
+static int
+eval_exp(struct sql_exp *exp, purc_variant_t row, struct sql_aggregate *aggs,
+        struct sql_value *val)
+{
+    struct sql_value l, r;
+    int tl, tr;
+
+    switch (exp->type) {
+    case SQL_EXP_NUMBER:
+        value_set_number(val, exp->num);
+        return 0;
+
+    case SQL_EXP_STRING:
+        value_set_null(val);
+        val->type = SQL_VALUE_STRING;
+        val->str = exp->str ? exp->str : "";
+        val->len = exp->len;
+        return 0;
+
+    case SQL_EXP_FIELD:
+        value_from_variant(get_field(row, exp), val);
+        return 0;
+
+    case SQL_EXP_ALL:
+    case SQL_EXP_SELF:
+        value_from_variant(row, val);
+        return 0;
+
+    case SQL_EXP_ATTR:
+        // @__depth and the like are only known when traveling a tree
+        pcinst_set_error(PCEXECUTOR_ERROR_NOT_IMPLEMENTED);
+        return -1;
+
+    case SQL_EXP_AGGREGATE:
+        PC_ASSERT(aggs);
+        aggregate_value(exp, &aggs[exp->slot], val);
+        return 0;
+
+    case SQL_EXP_NEG:
+        if (eval_exp(exp->left, row, aggs, &l))
+            return -1;
+        if (l.type == SQL_VALUE_NULL)
+            value_set_null(val);
+        else
+            value_set_number(val, -value_to_number(&l));
+        return 0;
+
+    case SQL_EXP_NOT:
+        if (eval_exp(exp->left, row, aggs, &l))
+            return -1;
+        tl = value_truth(&l);
+        if (tl < 0)
+            value_set_null(val);
+        else
+            value_set_boolean(val, !tl);
+        return 0;
+
+    case SQL_EXP_AND:
+    case SQL_EXP_OR:
+        if (eval_exp(exp->left, row, aggs, &l))
+            return -1;
+        tl = value_truth(&l);
+        // short-circuit: FALSE AND ..., TRUE OR ...
+        if (tl == (exp->type == SQL_EXP_OR)) {
+            value_set_boolean(val, tl);
+            return 0;
+        }
+        if (eval_exp(exp->right, row, aggs, &r))
+            return -1;
+        tr = value_truth(&r);
+        if (tr == (exp->type == SQL_EXP_OR))
+            value_set_boolean(val, tr);
+        else if (tl < 0 || tr < 0)
+            value_set_null(val);
+        else
+            value_set_boolean(val, tr);
+        return 0;
+
+    case SQL_EXP_LIKE:
+        if (eval_exp(exp->left, row, aggs, &l) ||
+                eval_exp(exp->right, row, aggs, &r))
+            return -1;
+        if (l.type == SQL_VALUE_NULL || r.type == SQL_VALUE_NULL) {
+            value_set_null(val);
+        }
+        else if (l.type != SQL_VALUE_STRING || r.type != SQL_VALUE_STRING) {
+            value_set_boolean(val, false);
+        }
+        else {
+#if HAVE(GLIB)
+            GPatternSpec *ps = (GPatternSpec*)exp->pattern_spec;
+            if (!ps)
+                ps = g_pattern_spec_new(r.str);
+#if HAVE(GLIB_LESS_2_70)
+            bool matched = g_pattern_match(ps, l.len, l.str, NULL);
+#else
+            bool matched = g_pattern_spec_match(ps, l.len, l.str, NULL);
+#endif
+            if (ps != exp->pattern_spec)
+                g_pattern_spec_free(ps);
+            value_set_boolean(val, matched);
+#else
+            pcinst_set_error(PCEXECUTOR_ERROR_NOT_IMPLEMENTED);
+            return -1;
+#endif
+        }
+        return 0;
+
+    case SQL_EXP_IN:
+        if (eval_exp(exp->left, row, aggs, &l))
+            return -1;
+        if (l.type == SQL_VALUE_NULL) {
+            value_set_null(val);
+            return 0;
+        }
+        for (struct sql_exp *p = exp->right; p; p = p->next) {
+            if (eval_exp(p, row, aggs, &r))
+                return -1;
+            if (value_equal(&l, &r)) {
+                value_set_boolean(val, true);
+                return 0;
+            }
+        }
+        value_set_boolean(val, false);
+        return 0;
+
+    default:
+        break;
+    }
+
+    // the binary operators on two operands
+    if (eval_exp(exp->left, row, aggs, &l) ||
+            eval_exp(exp->right, row, aggs, &r))
+        return -1;
+    if (l.type == SQL_VALUE_NULL || r.type == SQL_VALUE_NULL) {
+        value_set_null(val);
+        return 0;
+    }
+
+    double dl, dr;
+    switch (exp->type) {
+    case SQL_EXP_EQ:
+        value_set_boolean(val, value_equal(&l, &r));
+        break;
+    case SQL_EXP_NE:
+        value_set_boolean(val, !value_equal(&l, &r));
+        break;
+    case SQL_EXP_LT:
+        value_set_boolean(val, value_compare(&l, &r) < 0);
+        break;
+    case SQL_EXP_GT:
+        value_set_boolean(val, value_compare(&l, &r) > 0);
+        break;
+    case SQL_EXP_LE:
+        value_set_boolean(val, value_compare(&l, &r) <= 0);
+        break;
+    case SQL_EXP_GE:
+        value_set_boolean(val, value_compare(&l, &r) >= 0);
+        break;
+
+    default:
+        dl = value_to_number(&l);
+        dr = value_to_number(&r);
+        if (exp->type == SQL_EXP_ADD)
+            value_set_number(val, dl + dr);
+        else if (exp->type == SQL_EXP_SUB)
+            value_set_number(val, dl - dr);
+        else if (exp->type == SQL_EXP_MUL)
+            value_set_number(val, dl * dr);
+        else if (dr == 0)
+            value_set_null(val);
+        else
+            value_set_number(val, dl / dr);
+        break;
+    }
+
+    return 0;
+}
+
+static int
+aggregate_row(struct sql_exp *exp, struct sql_aggregate *agg,
+        purc_variant_t row)
+{
+    struct sql_value val;
+
+    if (exp->left->type == SQL_EXP_ALL) {
+        agg->count++;
+        return 0;
+    }
+
+    if (eval_exp(exp->left, row, NULL, &val))
+        return -1;
+    if (val.type == SQL_VALUE_NULL)
+        return 0;
+
+    agg->count++;
+    switch (exp->func) {
+    case SQL_AGGREGATE_SUM:
+    case SQL_AGGREGATE_AVG:
+        if (val.type == SQL_VALUE_NUMBER || val.type == SQL_VALUE_BOOLEAN) {
+            agg->nr_numbers++;
+            agg->sum += val.num;
+        }
+        break;
+    case SQL_AGGREGATE_MIN:
+        if (agg->count == 1 || value_compare(&val, &agg->value) < 0)
+            agg->value = val;
+        break;
+    case SQL_AGGREGATE_MAX:
+        if (agg->count == 1 || value_compare(&val, &agg->value) > 0)
+            agg->value = val;
+        break;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+/* The transient index of the rows by the value of a field, built by the
+ * planner for the equality predicates; only numbers and strings are keyed,
+ * other values never equal to a literal. */
+struct sql_index_entry {
+    struct sql_value            key;    // holds a reference of `key.v`
+    size_t                     *rows;
+    size_t                      nr_rows;
+    size_t                      sz_rows;
+};
+
+static unsigned long
+index_entry_hash(const void *k)
+{
+    return value_hash(&((const struct sql_index_entry *)k)->key);
+}
+
+static int
+index_entry_equal(const void *k1, const void *k2)
+{
+    return value_equal(&((const struct sql_index_entry *)k1)->key,
+            &((const struct sql_index_entry *)k2)->key);
+}
+
+static void
+index_entry_free(struct pchash_entry *e)
+{
+    struct sql_index_entry *entry;
+    entry = (struct sql_index_entry *)pchash_entry_v(e);
+    purc_variant_unref(entry->key.v);
+    free(entry->rows);
+    free(entry);
+}
+
+static void
+index_free(struct pchash_entry *e)
+{
+    free(pchash_entry_k(e));
+    if (pchash_entry_v(e))
+        pchash_table_free((struct pchash_table *)pchash_entry_v(e));
+}
+
+struct pcexec_exe_sql_inst {
+    struct purc_exec_inst       super;
+
+    struct exe_sql_param        param;
+    struct pcexec_cached_rule  *cached_rule;
+
+    // the rows of the input, and the indexes built for them by field names
+    // while running a rule; a field looked up only once so far is mapped
+    // to NULL
+    purc_variant_t             *rows;
+    size_t                      nr_rows;
+    struct pchash_table        *indexes;
+
+    purc_variant_t              result_set;
+};
+
+static struct pchash_table *
+build_index(struct pcexec_exe_sql_inst *exe_sql_inst, struct sql_exp *field)
+{
+    struct pchash_table *index;
+    index = pchash_table_new(HASHTABLE_DEFAULT_SIZE, index_entry_free,
+            index_entry_hash, index_entry_equal);
+    if (!index)
+        return NULL;
+
+    for (size_t i = 0; i < exe_sql_inst->nr_rows; i++) {
+        struct sql_index_entry probe, *entry;
+        value_from_variant(get_field(exe_sql_inst->rows[i], field),
+                &probe.key);
+        if (probe.key.type == SQL_VALUE_BOOLEAN)
+            probe.key.type = SQL_VALUE_NUMBER;
+        else if (probe.key.type != SQL_VALUE_NUMBER &&
+                probe.key.type != SQL_VALUE_STRING)
+            continue;
+        if (probe.key.type == SQL_VALUE_NUMBER && isnan(probe.key.num))
+            continue;
+
+        void *v;
+        if (pchash_table_lookup_ex(index, &probe, &v)) {
+            entry = (struct sql_index_entry *)v;
+        }
+        else {
+            entry = (struct sql_index_entry *)calloc(1, sizeof(*entry));
+            if (!entry)
+                goto failed;
+            entry->key = probe.key;
+            if (pchash_table_insert(index, entry, entry)) {
+                free(entry);
+                goto failed;
+            }
+            // `key.str` points into the string of the field
+            purc_variant_ref(entry->key.v);
+        }
+
+        if (entry->nr_rows == entry->sz_rows) {
+            size_t sz = entry->sz_rows ? entry->sz_rows * 2 : 4;
+            size_t *rows = (size_t *)realloc(entry->rows, sz * sizeof(*rows));
+            if (!rows)
+                goto failed;
+            entry->rows = rows;
+            entry->sz_rows = sz;
+        }
+        entry->rows[entry->nr_rows++] = i;
+    }
+
+    return index;
+
+failed:
+    pchash_table_free(index);
+    return NULL;
+}
+
+/* Building an index costs as much as a scan of the rows, so it is only built
+ * for a field looked up the second time, by another SELECT of the UNION;
+ * returns NULL with `*error` unset to scan this time. */
+static struct pchash_table *
+get_index(struct pcexec_exe_sql_inst *exe_sql_inst, struct sql_exp *field,
+        bool *error)
+{
+    *error = true;
+
+    char *name;
+    if (field->sub)
+        name = format_str("%s.%s", field->str, field->sub);
+    else
+        name = strdup(field->str);
+    if (!name)
+        return NULL;
+
+    if (!exe_sql_inst->indexes) {
+        exe_sql_inst->indexes = pchash_kstr_table_new(HASHTABLE_DEFAULT_SIZE,
+                index_free);
+        if (!exe_sql_inst->indexes) {
+            free(name);
+            return NULL;
+        }
+    }
+
+    struct pchash_entry *e;
+    e = pchash_table_lookup_entry(exe_sql_inst->indexes, name);
+    if (!e) {
+        if (pchash_table_insert(exe_sql_inst->indexes, name, NULL)) {
+            free(name);
+            return NULL;
+        }
+        *error = false;
+        return NULL;
+    }
+
+    free(name);
+    if (!pchash_entry_v(e)) {
+        struct pchash_table *index = build_index(exe_sql_inst, field);
+        if (!index)
+            return NULL;
+        e->v = index;
+    }
+
+    *error = false;
+    return (struct pchash_table *)pchash_entry_v(e);
+}
+
+/* The query plan: scan all rows, or look up the rows with the index on
+ * `field` by the literals in `keys` (linked by `next` for IN). */
+struct sql_plan {
+    struct sql_exp             *field;
+    struct sql_exp             *keys;
+    size_t                      nr_keys;
+};
+
+static inline bool
+is_literal(struct sql_exp *exp)
+{
+    return exp->type == SQL_EXP_NUMBER || exp->type == SQL_EXP_STRING;
+}
+
+// choose the equality predicate with the fewest keys among the conjuncts
+static void
+plan_conjuncts(struct sql_exp *exp, struct sql_plan *plan)
+{
+    struct sql_exp *field = NULL, *keys = NULL;
+    size_t nr_keys = 0;
+
+    switch (exp->type) {
+    case SQL_EXP_AND:
+        plan_conjuncts(exp->left, plan);
+        plan_conjuncts(exp->right, plan);
+        return;
+
+    case SQL_EXP_EQ:
+        if (exp->left->type == SQL_EXP_FIELD && is_literal(exp->right)) {
+            field = exp->left;
+            keys = exp->right;
+        }
+        else if (exp->right->type == SQL_EXP_FIELD && is_literal(exp->left)) {
+            field = exp->right;
+            keys = exp->left;
+        }
+        nr_keys = 1;
+        break;
+
+    case SQL_EXP_IN:
+        if (exp->left->type != SQL_EXP_FIELD)
+            return;
+        for (struct sql_exp *p = exp->right; p; p = p->next, nr_keys++) {
+            if (!is_literal(p))
+                return;
+        }
+        field = exp->left;
+        keys = exp->right;
+        break;
 
-#include "private/debug.h"
-#include "private/errors.h"
+    default:
+        return;
+    }
 
-struct pcexec_exe_sql_inst {
-    struct purc_exec_inst       super;
+    if (field && (plan->field == NULL || nr_keys < plan->nr_keys)) {
+        plan->field = field;
+        plan->keys = keys;
+        plan->nr_keys = nr_keys;
+    }
+}
+
+static int
+compare_row_idx(const void *a, const void *b)
+{
+    size_t l = *(const size_t *)a, r = *(const size_t *)b;
+    return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+/* Find the candidate rows of `where` in the input order: `*cands` is set to
+ * NULL to scan all rows; otherwise it should be freed if `*to_free`. */
+static int
+find_candidates(struct pcexec_exe_sql_inst *exe_sql_inst,
+        struct sql_exp *where, size_t **cands, size_t *nr_cands, bool *to_free)
+{
+    struct sql_plan plan = { NULL, NULL, 0 };
+
+    *cands = NULL;
+    *nr_cands = 0;
+    *to_free = false;
+
+    if (where && exe_sql_inst->nr_rows >= MIN_ROWS_TO_BUILD_INDEX)
+        plan_conjuncts(where, &plan);
+    if (!plan.field)
+        return 0;
+
+    bool error;
+    struct pchash_table *index = get_index(exe_sql_inst, plan.field, &error);
+    if (!index) {
+        if (!error)
+            return 0;
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
+
+    static size_t no_rows[1];
+    *cands = no_rows;
+
+    size_t n = 0;
+    struct sql_exp *p = plan.keys;
+    for (size_t i = 0; i < plan.nr_keys; i++, p = p->next) {
+        struct sql_index_entry probe;
+        void *v;
+
+        eval_exp(p, PURC_VARIANT_INVALID, NULL, &probe.key);
+        if (!pchash_table_lookup_ex(index, &probe, &v))
+            continue;
+
+        struct sql_index_entry *entry = (struct sql_index_entry *)v;
+        if (plan.nr_keys == 1) {
+            *cands = entry->rows;
+            *nr_cands = entry->nr_rows;
+            return 0;
+        }
+
+        size_t *rows = (size_t *)realloc(*to_free ? *cands : NULL,
+                (n + entry->nr_rows) * sizeof(*rows));
+        if (!rows) {
+            if (*to_free)
+                free(*cands);
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            return -1;
+        }
+        memcpy(rows + n, entry->rows, entry->nr_rows * sizeof(*rows));
+        n += entry->nr_rows;
+        *cands = rows;
+        *to_free = true;
+    }
+
+    // keep the input order and drop the duplicates of IN (1, 1)
+    if (n > 0) {
+        size_t *rows = *cands, nr = 1;
+        qsort(rows, n, sizeof(*rows), compare_row_idx);
+        for (size_t i = 1; i < n; i++) {
+            if (rows[i] != rows[nr - 1])
+                rows[nr++] = rows[i];
+        }
+        n = nr;
+    }
+    *nr_cands = n;
+    return 0;
+}
+
+struct sql_group {
+    size_t                      row;    // the first row in the group
+    size_t                      nr_keys;
+    struct sql_value           *keys;   // the values of GROUP BY
+    struct sql_aggregate       *aggs;
 };
 
+static unsigned long
+group_hash(const void *k)
+{
+    const struct sql_group *group = (const struct sql_group *)k;
+    unsigned long h = 0;
+    for (size_t i = 0; i < group->nr_keys; i++)
+        h = h * 31 + value_hash(&group->keys[i]);
+    return h;
+}
+
+static int
+group_equal(const void *k1, const void *k2)
+{
+    const struct sql_group *g1 = (const struct sql_group *)k1;
+    const struct sql_group *g2 = (const struct sql_group *)k2;
+    for (size_t i = 0; i < g1->nr_keys; i++) {
+        if (!value_equal(&g1->keys[i], &g2->keys[i]))
+            return 0;
+    }
+    return 1;
+}
+
+struct sql_record {
+    size_t                      seq;
+    purc_variant_t              value;
+    struct sql_value           *keys;   // the values of ORDER BY
+    struct sql_order_item      *order_by;
+};
+
+static int
+compare_records(const void *a, const void *b)
+{
+    const struct sql_record *l = (const struct sql_record *)a;
+    const struct sql_record *r = (const struct sql_record *)b;
+
+    size_t i = 0;
+    for (struct sql_order_item *item = l->order_by; item;
+            item = item->next, i++) {
+        int d = value_compare(&l->keys[i], &r->keys[i]);
+        if (d)
+            return item->desc ? -d : d;
+    }
+
+    // keep the input order of the equal ones
+    return l->seq < r->seq ? -1 : 1;
+}
+
+struct sql_query {
+    struct pcexec_exe_sql_inst *inst;
+    struct sql_select          *select;
+
+    size_t                      nr_items;
+    purc_variant_t             *names;  // the keys of the selected items
+    struct sql_value           *vals;   // the values of the selected items
+    struct sql_exp            **aggregates;
+
+    size_t                      nr_order_items;
+    int                        *order_item_idx; // the selected item ordered
+
+    struct sql_record          *records;
+    size_t                      nr_records;
+    struct sql_value           *keys;
+};
+
+static void
+collect_aggregates(struct sql_exp *exp, struct sql_exp **aggregates)
+{
+    if (!exp)
+        return;
+
+    if (exp->type == SQL_EXP_AGGREGATE)
+        aggregates[exp->slot] = exp;
+
+    collect_aggregates(exp->left, aggregates);
+    for (struct sql_exp *p = exp->right; p; p = p->next)
+        collect_aggregates(p, aggregates);
+}
+
+static void
+query_release(struct sql_query *query)
+{
+    for (size_t i = 0; i < query->nr_items; i++)
+        PCEXE_CLR_VAR(query->names[i]);
+    for (size_t i = 0; i < query->nr_records; i++)
+        PCEXE_CLR_VAR(query->records[i].value);
+
+    free(query->names);
+    free(query->vals);
+    free(query->aggregates);
+    free(query->order_item_idx);
+    free(query->records);
+    free(query->keys);
+}
+
+static int
+query_init(struct sql_query *query, struct pcexec_exe_sql_inst *exe_sql_inst,
+        struct sql_select *select, size_t nr_records)
+{
+    memset(query, 0, sizeof(*query));
+    query->inst = exe_sql_inst;
+    query->select = select;
+
+    struct sql_select_item *item;
+    for (item = select->items; item; item = item->next)
+        query->nr_items++;
+    for (struct sql_order_item *p = select->order_by; p; p = p->next)
+        query->nr_order_items++;
+
+    query->names = (purc_variant_t *)calloc(query->nr_items,
+            sizeof(purc_variant_t));
+    query->vals = (struct sql_value *)calloc(query->nr_items,
+            sizeof(struct sql_value));
+    query->aggregates = (struct sql_exp **)calloc(select->nr_aggregates + 1,
+            sizeof(struct sql_exp *));
+    query->order_item_idx = (int *)calloc(query->nr_order_items + 1,
+            sizeof(int));
+    query->records = (struct sql_record *)calloc(nr_records + 1,
+            sizeof(struct sql_record));
+    query->keys = (struct sql_value *)calloc(
+            nr_records * query->nr_order_items + 1, sizeof(struct sql_value));
+    if (!query->names || !query->vals || !query->aggregates ||
+            !query->order_item_idx || !query->records || !query->keys)
+        goto failed;
+
+    size_t i = 0;
+    for (item = select->items; item; item = item->next, i++) {
+        query->names[i] = purc_variant_make_string(item->name, false);
+        if (query->names[i] == PURC_VARIANT_INVALID)
+            goto failed;
+        collect_aggregates(item->exp, query->aggregates);
+    }
+
+    // ORDER BY an alias or a name of the selected items first
+    i = 0;
+    for (struct sql_order_item *p = select->order_by; p; p = p->next, i++) {
+        query->order_item_idx[i] = -1;
+        if (p->exp->sub)
+            continue;
+
+        int idx = 0;
+        for (item = select->items; item; item = item->next, idx++) {
+            if (item->exp->type != SQL_EXP_ALL &&
+                    strcmp(item->name, p->exp->str) == 0) {
+                query->order_item_idx[i] = idx;
+                break;
+            }
+        }
+    }
+
+    return 0;
+
+failed:
+    query_release(query);
+    pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+    return -1;
+}
+
+// project a row, or the first row of a group, to a record
+static int
+query_add_record(struct sql_query *query, purc_variant_t row,
+        struct sql_aggregate *aggs)
+{
+    struct sql_select *select = query->select;
+    struct sql_record *record = query->records + query->nr_records;
+    purc_variant_t value;
+
+    if (select->select_all) {
+        value = purc_variant_ref(row);
+    }
+    else {
+        value = purc_variant_make_object(0, PURC_VARIANT_INVALID,
+                PURC_VARIANT_INVALID);
+        if (value == PURC_VARIANT_INVALID)
+            return -1;
+
+        size_t i = 0;
+        for (struct sql_select_item *item = select->items; item;
+                item = item->next, i++) {
+            if (item->exp->type == SQL_EXP_ALL) {
+                if (row == PURC_VARIANT_INVALID ||
+                        !purc_variant_is_object(row))
+                    continue;
+
+                purc_variant_t k, v;
+                foreach_key_value_in_variant_object(row, k, v)
+                    if (!purc_variant_object_set(value, k, v))
+                        goto failed;
+                end_foreach;
+                continue;
+            }
+
+            if (eval_exp(item->exp, row, aggs, &query->vals[i]))
+                goto failed;
+
+            purc_variant_t v = value_to_variant(&query->vals[i]);
+            if (v == PURC_VARIANT_INVALID)
+                goto failed;
+            bool ok = purc_variant_object_set(value, query->names[i], v);
+            purc_variant_unref(v);
+            if (!ok)
+                goto failed;
+        }
+    }
+
+    record->seq = query->nr_records;
+    record->value = value;
+    record->order_by = select->order_by;
+    record->keys = query->keys + query->nr_records * query->nr_order_items;
+    query->nr_records++;
+
+    size_t i = 0;
+    for (struct sql_order_item *p = select->order_by; p; p = p->next, i++) {
+        int idx = query->order_item_idx[i];
+        if (idx >= 0)
+            record->keys[i] = query->vals[idx];
+        else if (eval_exp(p->exp, row, aggs, &record->keys[i]))
+            return -1;
+    }
+
+    return 0;
+
+failed:
+    purc_variant_unref(value);
+    return -1;
+}
+
+static int
+query_group_rows(struct sql_query *query, size_t *matched, size_t nr_matched)
+{
+    struct sql_select *select = query->select;
+    purc_variant_t *rows = query->inst->rows;
+    size_t nr_aggs = select->nr_aggregates;
+    size_t nr_keys = 0;
+    for (struct sql_exp *p = select->group_by; p; p = p->next)
+        nr_keys++;
+
+    // without GROUP BY, all rows are in one group even if there is no row
+    size_t sz_groups = select->group_by ? nr_matched : 1;
+    struct sql_group *groups = (struct sql_group *)calloc(sz_groups + 1,
+            sizeof(*groups));
+    struct sql_value *keys = (struct sql_value *)calloc(
+            nr_matched * nr_keys + 1, sizeof(*keys));
+    struct sql_aggregate *aggs = (struct sql_aggregate *)calloc(
+            sz_groups * nr_aggs + 1, sizeof(*aggs));
+    struct pchash_table *table = NULL;
+    size_t nr_groups = 0;
+    int ret = -1;
+
+    if (!groups || !keys || !aggs)
+        goto done;
+
+    if (select->group_by) {
+        table = pchash_table_new(HASHTABLE_DEFAULT_SIZE, NULL,
+                group_hash, group_equal);
+        if (!table)
+            goto done;
+    }
+    else {
+        groups[0].row = nr_matched ? matched[0] : (size_t)-1;
+        groups[0].aggs = aggs;
+        nr_groups = 1;
+    }
+
+    for (size_t i = 0; i < nr_matched; i++) {
+        purc_variant_t row = rows[matched[i]];
+        struct sql_group *group = groups;
+
+        if (table) {
+            struct sql_group *probe = groups + nr_groups;
+            probe->row = matched[i];
+            probe->nr_keys = nr_keys;
+            probe->keys = keys + nr_groups * nr_keys;
+            size_t k = 0;
+            for (struct sql_exp *p = select->group_by; p; p = p->next, k++) {
+                if (eval_exp(p, row, NULL, &probe->keys[k]))
+                    goto done;
+            }
+
+            void *v;
+            if (pchash_table_lookup_ex(table, probe, &v)) {
+                group = (struct sql_group *)v;
+            }
+            else {
+                if (pchash_table_insert(table, probe, probe))
+                    goto done;
+                probe->aggs = aggs + nr_groups * nr_aggs;
+                group = probe;
+                nr_groups++;
+            }
+        }
+
+        for (size_t k = 0; k < nr_aggs; k++) {
+            if (aggregate_row(query->aggregates[k], group->aggs + k, row))
+                goto done;
+        }
+    }
+
+    for (size_t i = 0; i < nr_groups; i++) {
+        purc_variant_t row = groups[i].row == (size_t)-1 ?
+            PURC_VARIANT_INVALID : rows[groups[i].row];
+        if (query_add_record(query, row, groups[i].aggs))
+            goto done;
+    }
+    ret = 0;
+
+done:
+    if (table)
+        pchash_table_free(table);
+    free(groups);
+    free(keys);
+    free(aggs);
+    if (ret && purc_get_last_error() == PURC_ERROR_OK)
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+    return ret;
+}
+
+static bool
+contains_value(purc_variant_t arr, size_t nr, purc_variant_t v)
+{
+    for (size_t i = 0; i < nr; i++) {
+        if (purc_variant_is_equal_to(purc_variant_array_get(arr, i), v))
+            return true;
+    }
+    return false;
+}
+
+// run a SELECT and append the resulting rows to `result_set`
+static int
+run_select(struct pcexec_exe_sql_inst *exe_sql_inst,
+        struct sql_select *select, purc_variant_t result_set, bool is_union)
+{
+    if (select->travel != SQL_TRAVEL_NONE) {
+        // TRAVEL IN is for the trees of documents
+        pcinst_set_error(PCEXECUTOR_ERROR_NOT_IMPLEMENTED);
+        return -1;
+    }
+
+    size_t *cands, nr_cands;
+    bool to_free;
+    if (find_candidates(exe_sql_inst, select->where, &cands, &nr_cands,
+                &to_free))
+        return -1;
+    if (!cands)
+        nr_cands = exe_sql_inst->nr_rows;
+
+    bool grouping = select->group_by || select->nr_aggregates;
+    size_t limit = (size_t)select->limit;
+    if (grouping || select->order_by || select->limit < 0)
+        limit = nr_cands;
+
+    struct sql_query query;
+    size_t *matched = (size_t *)malloc((nr_cands + 1) * sizeof(size_t));
+    size_t nr_matched = 0;
+    int ret = -1;
+
+    if (!matched) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        goto free_cands;
+    }
+
+    for (size_t i = 0; i < nr_cands && nr_matched < limit; i++) {
+        size_t idx = cands ? cands[i] : i;
+        if (select->where) {
+            struct sql_value val;
+            if (eval_exp(select->where, exe_sql_inst->rows[idx], NULL, &val))
+                goto free_matched;
+            if (value_truth(&val) != 1)
+                continue;
+        }
+        matched[nr_matched++] = idx;
+    }
+
+    if (query_init(&query, exe_sql_inst, select,
+                grouping && !select->group_by ? 1 : nr_matched))
+        goto free_matched;
+
+    if (grouping) {
+        if (query_group_rows(&query, matched, nr_matched))
+            goto release_query;
+    }
+    else {
+        for (size_t i = 0; i < nr_matched; i++) {
+            if (query_add_record(&query, exe_sql_inst->rows[matched[i]],
+                        NULL))
+                goto release_query;
+        }
+    }
+
+    if (select->order_by)
+        qsort(query.records, query.nr_records, sizeof(struct sql_record),
+                compare_records);
+
+    size_t nr = query.nr_records;
+    if (select->limit >= 0 && (size_t)select->limit < nr)
+        nr = (size_t)select->limit;
+
+    size_t nr_before = purc_variant_array_get_size(result_set);
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t v = query.records[i].value;
+        // UNION drops the rows already selected
+        if (is_union && contains_value(result_set, nr_before, v))
+            continue;
+        if (!purc_variant_array_append(result_set, v))
+            goto release_query;
+    }
+    ret = 0;
+
+release_query:
+    query_release(&query);
+free_matched:
+    free(matched);
+free_cands:
+    if (to_free)
+        free(cands);
+    return ret;
+}
+
+/* The records may be changed between the rules, for example by the body of
+ * <iterate>, so the indexes only live while running a rule. */
+static void
+drop_indexes(struct pcexec_exe_sql_inst *exe_sql_inst)
+{
+    if (exe_sql_inst->indexes) {
+        pchash_table_free(exe_sql_inst->indexes);
+        exe_sql_inst->indexes = NULL;
+    }
+}
+
+static int
+run_rule(struct pcexec_exe_sql_inst *exe_sql_inst)
+{
+    purc_variant_t result_set;
+    result_set = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (result_set == PURC_VARIANT_INVALID)
+        return -1;
+
+    bool is_union = false;
+    for (struct sql_select *select = exe_sql_inst->param.rule.select; select;
+            select = select->next) {
+        if (run_select(exe_sql_inst, select, result_set, is_union)) {
+            drop_indexes(exe_sql_inst);
+            purc_variant_unref(result_set);
+            return -1;
+        }
+        is_union = true;
+    }
+
+    drop_indexes(exe_sql_inst);
+    PCEXE_CLR_VAR(exe_sql_inst->result_set);
+    exe_sql_inst->result_set = result_set;
+    return 0;
+}
+
+// clear internal data except `input`
+static inline void
+reset(struct pcexec_exe_sql_inst *exe_sql_inst)
+{
+    struct exe_sql_param *param = &exe_sql_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_sql_inst->cached_rule);
+    exe_sql_inst->cached_rule = NULL;
+    exe_sql_param_reset(param);
+    pcexecutor_inst_reset(&exe_sql_inst->super);
+    PCEXE_CLR_VAR(exe_sql_inst->result_set);
+}
+
+static inline bool
+parse_rule(struct pcexec_exe_sql_inst *exe_sql_inst, const char* rule)
+{
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("SQL", rule, parse_sql_rule,
+            free_sql_rule, &inst->err_msg);
+    if (!cached)
+        return false;
+
+    if (cached == exe_sql_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
+    }
+
+    pcexecutor_release_rule(exe_sql_inst->cached_rule);
+    exe_sql_inst->cached_rule = cached;
+    exe_sql_inst->param.rule = *(struct sql_rule *)cached->parsed;
+
+    if (run_rule(exe_sql_inst)) {
+        reset(exe_sql_inst);
+        return false;
+    }
+
+    return true;
+}
+
+static inline void
+destroy(struct pcexec_exe_sql_inst *exe_sql_inst)
+{
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+
+    reset(exe_sql_inst);
+
+    for (size_t i = 0; i < exe_sql_inst->nr_rows; i++)
+        purc_variant_unref(exe_sql_inst->rows[i]);
+    free(exe_sql_inst->rows);
+
+    PCEXE_CLR_VAR(inst->input);
+    PCEXE_CLR_VAR(inst->value);
+
+    free(exe_sql_inst);
+}
+
+static bool
+take_rows(struct pcexec_exe_sql_inst *exe_sql_inst, purc_variant_t input)
+{
+    size_t nr;
+    if (purc_variant_is_array(input))
+        nr = purc_variant_array_get_size(input);
+    else
+        nr = purc_variant_set_get_size(input);
+
+    exe_sql_inst->rows = (purc_variant_t *)malloc((nr + 1) *
+            sizeof(purc_variant_t));
+    if (!exe_sql_inst->rows)
+        return false;
+
+    purc_variant_t v;
+    if (purc_variant_is_array(input)) {
+        size_t idx;
+        foreach_value_in_variant_array(input, v, idx)
+            (void)idx;
+            exe_sql_inst->rows[exe_sql_inst->nr_rows++] = purc_variant_ref(v);
+        end_foreach;
+    }
+    else {
+        foreach_value_in_variant_set(input, v)
+            exe_sql_inst->rows[exe_sql_inst->nr_rows++] = purc_variant_ref(v);
+        end_foreach;
+    }
+
+    return true;
+}
+
 // 创建一个执行器实例
 static purc_exec_inst_t
 exe_sql_create(enum purc_exec_type type,
         purc_variant_t input, bool asc_desc)
 {
-    if (!purc_variant_is_object(input))
+    if (!purc_variant_is_array(input) && !purc_variant_is_set(input)) {
+        pcinst_set_error(PCEXECUTOR_ERROR_BAD_ARG);
         return NULL;
+    }
 
-    struct pcexec_exe_sql_inst *inst;
-    inst = calloc(1, sizeof(*inst));
-    if (!inst) {
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = calloc(1, sizeof(*exe_sql_inst));
+    if (!exe_sql_inst) {
         pcinst_set_error(PCEXECUTOR_ERROR_OOM);
         return NULL;
     }
 
-    inst->super.type        = type;
-    inst->super.input       = input;
-    inst->super.asc_desc    = asc_desc;
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+
+    inst->type        = type;
+    inst->asc_desc    = asc_desc;
+    inst->input       = purc_variant_ref(input);
 
-    purc_variant_ref(input);
+    int debug_flex, debug_bison;
+    pcexecutor_get_debug(&debug_flex, &debug_bison);
+    exe_sql_inst->param.debug_flex  = debug_flex;
+    exe_sql_inst->param.debug_bison = debug_bison;
+
+    if (!take_rows(exe_sql_inst, input)) {
+        destroy(exe_sql_inst);
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return NULL;
+    }
 
-    return &inst->super;
+    return inst;
 }
 
-static inline bool
-exe_sql_parse_rule(purc_exec_inst_t inst, const char* rule)
+static inline purc_exec_iter_t
+fetch_curr(struct pcexec_exe_sql_inst *exe_sql_inst)
 {
-    // parse and fill the internal fields from rule
-    // for example, generating the `selected_keys` which contains all
-    // selected keys.
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+    purc_exec_iter_t it = &inst->it;
 
-    // clear previously-selected-keys
-    if (inst->selected_keys) {
-        purc_variant_unref(inst->selected_keys);
-        inst->selected_keys = PURC_VARIANT_INVALID;
+    size_t nr = purc_variant_array_get_size(exe_sql_inst->result_set);
+    if (it->curr >= nr) {
+        it->curr = nr;
+        pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
+        return NULL;
     }
 
-    // TODO: parse rule and eval to selected_keys
+    PCEXE_CLR_VAR(inst->value);
+    inst->value = purc_variant_array_get(exe_sql_inst->result_set, it->curr);
+    purc_variant_ref(inst->value);
+    return it;
+}
+
+static inline purc_exec_iter_t
+it_begin(struct pcexec_exe_sql_inst *exe_sql_inst, const char *rule)
+{
+    if (!parse_rule(exe_sql_inst, rule))
+        return NULL;
 
-    UNUSED_PARAM(inst);
-    UNUSED_PARAM(rule);
+    exe_sql_inst->super.it.curr = 0;
+    return fetch_curr(exe_sql_inst);
+}
 
-    pcinst_set_error(PCEXECUTOR_ERROR_NOT_IMPLEMENTED);
-    return false;
+static inline purc_exec_iter_t
+it_next(struct pcexec_exe_sql_inst *exe_sql_inst, const char *rule)
+{
+    if (rule) {
+        if (!parse_rule(exe_sql_inst, rule))
+            return NULL;
+    }
+
+    exe_sql_inst->super.it.curr++;
+    return fetch_curr(exe_sql_inst);
 }
 
 // 用于执行选择
@@ -88,48 +1789,17 @@ exe_sql_choose(purc_exec_inst_t inst, const char* rule)
         return PURC_VARIANT_INVALID;
     }
 
-    if (!exe_sql_parse_rule(inst, rule))
-        return PURC_VARIANT_INVALID;
-
-    size_t sz = purc_variant_array_get_size(inst->selected_keys);
-
-    purc_variant_t vals = purc_variant_make_array(0, PURC_VARIANT_INVALID);
-    if (vals == PURC_VARIANT_INVALID) {
-        return vals;
-    }
-
-    bool ok = true;
-
-    for (size_t i=0; i<sz; ++i) {
-        purc_variant_t k;
-        k = purc_variant_array_get(inst->selected_keys, i);
-        purc_variant_t v;
-        v = purc_variant_object_get(inst->input, k);
-        if (v==PURC_VARIANT_INVALID)
-            continue;
-        ok = purc_variant_array_append(vals, v);
-        if (!ok)
-            break;
-    }
-
-    PC_ASSERT(0); // Not tested yet!!!
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
 
-    if (ok) {
-        size_t n;
-        purc_variant_array_size(vals, &n);
-        if (n == 1) {
-            purc_variant_t v = purc_variant_array_get(vals, 0);
-            purc_variant_ref(v);
-            purc_variant_unref(vals);
-            vals = v;
-        }
-    }
+    if (!parse_rule(exe_sql_inst, rule))
+        return PURC_VARIANT_INVALID;
 
-    if (ok)
-        return vals;
+    purc_variant_t vals = exe_sql_inst->result_set;
+    if (purc_variant_array_get_size(vals) == 1)
+        return purc_variant_ref(purc_variant_array_get(vals, 0));
 
-    purc_variant_unref(vals);
-    return PURC_VARIANT_INVALID;
+    return purc_variant_ref(vals);
 }
 
 // 获得用于迭代的初始迭代子
@@ -141,17 +1811,15 @@ exe_sql_it_begin(purc_exec_inst_t inst, const char* rule)
         return NULL;
     }
 
-    inst->it.curr = 0;
-    if (!exe_sql_parse_rule(inst, rule))
-        return NULL;
-
-    size_t sz = purc_variant_array_get_size(inst->selected_keys);
-    if (sz<=0) {
-        pcinst_set_error(PCEXECUTOR_ERROR_NO_KEYS_SELECTED);
+    if (inst->type != PURC_EXEC_TYPE_ITERATE) {
+        pcinst_set_error(PCEXECUTOR_ERROR_NOT_ALLOWED);
         return NULL;
     }
 
-    return &inst->it;
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
+
+    return it_begin(exe_sql_inst, rule);
 }
 
 // 根据迭代子获得对应的变体值
@@ -160,19 +1828,13 @@ exe_sql_it_value(purc_exec_inst_t inst, purc_exec_iter_t it)
 {
     if (!inst || !it) {
         pcinst_set_error(PCEXECUTOR_ERROR_BAD_ARG);
-        return NULL;
+        return PURC_VARIANT_INVALID;
     }
 
     PC_ASSERT(&inst->it == it);
-    PC_ASSERT(inst->selected_keys != PURC_VARIANT_INVALID);
-    PC_ASSERT(inst->input != PURC_VARIANT_INVALID);
-
-    purc_variant_t k;
-    k = purc_variant_array_get(inst->selected_keys, it->curr);
-    purc_variant_t v;
-    v = purc_variant_object_get(inst->input, k);
+    PC_ASSERT(inst->value != PURC_VARIANT_INVALID);
 
-    return v;
+    return inst->value;
 }
 
 // 获得下一个迭代子
@@ -188,29 +1850,16 @@ exe_sql_it_next(purc_exec_inst_t inst, purc_exec_iter_t it, const char* rule)
 
     PC_ASSERT(&inst->it == it);
 
-    if (rule) {
-        // clear previously-selected-keys
-        if (inst->selected_keys) {
-            purc_variant_unref(inst->selected_keys);
-            inst->selected_keys = PURC_VARIANT_INVALID;
-        }
-
-        if (!exe_sql_parse_rule(inst, rule))
-            return NULL;
-    }
-
-    ++it->curr;
-
-    size_t sz = purc_variant_array_get_size(inst->selected_keys);
-    if (it->curr >= sz) {
-        it->curr = sz;
-        return NULL;
-    }
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
 
-    return it;
+    return it_next(exe_sql_inst, rule);
 }
 
 // 用于执行规约
+// The aggregates are computed by the rule itself: a query aggregating all
+// rows, like `SELECT COUNT(*), AVG(x)`, reduces to its only row; the other
+// queries reduce to the array of the rows.
 static purc_variant_t
 exe_sql_reduce(purc_exec_inst_t inst, const char* rule)
 {
@@ -219,37 +1868,20 @@ exe_sql_reduce(purc_exec_inst_t inst, const char* rule)
         return PURC_VARIANT_INVALID;
     }
 
-    if (!exe_sql_parse_rule(inst, rule))
-        return PURC_VARIANT_INVALID;
-
-    size_t sz = purc_variant_array_get_size(inst->selected_keys);
-
-    purc_variant_t objs;
-    objs = purc_variant_make_object(0,
-                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
-    if (objs == PURC_VARIANT_INVALID) {
-        return objs;
-    }
-
-    bool ok = false;
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
 
-    for (size_t i=0; i<sz; ++i) {
-        purc_variant_t k;
-        k = purc_variant_array_get(inst->selected_keys, i);
-        purc_variant_t v;
-        v = purc_variant_object_get(inst->input, k);
-        if (v==PURC_VARIANT_INVALID)
-            continue;
-        ok = purc_variant_object_set(objs, k, v);
-        if (!ok)
-            break;
-    }
+    if (!parse_rule(exe_sql_inst, rule))
+        return PURC_VARIANT_INVALID;
 
-    if (ok)
-        return objs;
+    struct sql_select *select = exe_sql_inst->param.rule.select;
+    purc_variant_t vals = exe_sql_inst->result_set;
+    if (select->next == NULL && select->group_by == NULL &&
+            select->nr_aggregates > 0 &&
+            purc_variant_array_get_size(vals) == 1)
+        return purc_variant_ref(purc_variant_array_get(vals, 0));
 
-    purc_variant_unref(objs);
-    return PURC_VARIANT_INVALID;
+    return purc_variant_ref(vals);
 }
 
 // 销毁一个执行器实例
@@ -261,18 +1893,10 @@ exe_sql_destroy(purc_exec_inst_t inst)
         return false;
     }
 
-    struct pcexec_exe_sql_inst *exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
-
-    if (exe_sql_inst->super.input) {
-        purc_variant_unref(exe_sql_inst->super.input);
-        exe_sql_inst->super.input = PURC_VARIANT_INVALID;
-    }
-    if (exe_sql_inst->super.selected_keys) {
-        purc_variant_unref(exe_sql_inst->super.selected_keys);
-        exe_sql_inst->super.selected_keys = PURC_VARIANT_INVALID;
-    }
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
 
-    free(exe_sql_inst);
+    destroy(exe_sql_inst);
     return true;
 }
 
@@ -291,4 +1915,3 @@ int pcexec_exe_sql_register(void)
     bool ok = purc_register_executor("SQL", &exe_sql_ops);
     return ok ? 0 : -1;
 }
-
@@ -30,10 +30,156 @@
 
 #include "purc-macros.h"
 
+#include "private/debug.h"
+
+#include "pcexe-helper.h"
+
+enum sql_exp_type {
+    SQL_EXP_NUMBER,
+    SQL_EXP_STRING,
+    SQL_EXP_FIELD,          // ID or ID.ID
+    SQL_EXP_ALL,            // *
+    SQL_EXP_SELF,           // &
+    SQL_EXP_ATTR,           // @ID
+    SQL_EXP_AGGREGATE,      // COUNT(...), SUM(...), ...
+    SQL_EXP_NEG,
+    SQL_EXP_NOT,
+    SQL_EXP_AND,
+    SQL_EXP_OR,
+    SQL_EXP_EQ,
+    SQL_EXP_NE,
+    SQL_EXP_LT,
+    SQL_EXP_GT,
+    SQL_EXP_LE,
+    SQL_EXP_GE,
+    SQL_EXP_ADD,
+    SQL_EXP_SUB,
+    SQL_EXP_MUL,
+    SQL_EXP_DIV,
+    SQL_EXP_LIKE,
+    SQL_EXP_IN,
+};
+
+enum sql_aggregate_func {
+    SQL_AGGREGATE_COUNT,
+    SQL_AGGREGATE_SUM,
+    SQL_AGGREGATE_AVG,
+    SQL_AGGREGATE_MIN,
+    SQL_AGGREGATE_MAX,
+};
+
+enum sql_travel_type {
+    SQL_TRAVEL_NONE,
+    SQL_TRAVEL_SIBLINGS,
+    SQL_TRAVEL_DEPTH,
+    SQL_TRAVEL_BREADTH,
+    SQL_TRAVEL_LEAVES,
+};
+
+struct sql_exp {
+    enum sql_exp_type           type;
+
+    struct sql_exp             *left;   // the operand, or the argument
+    struct sql_exp             *right;  // the second operand, or the IN list
+    struct sql_exp             *next;   // the next one in a list
+
+    double                      num;
+    char                       *str;    // string, field or attribute name
+    size_t                      len;
+    char                       *sub;    // the member name of `ID.ID`
+
+    enum sql_aggregate_func     func;
+    size_t                      slot;   // the aggregate slot in a group
+
+    void                       *pattern_spec; // GPatternSpec of LIKE 'literal'
+};
+
+struct sql_select_item {
+    struct sql_exp             *exp;
+    char                       *name;   // the alias or a generated name
+    struct sql_select_item     *next;
+};
+
+struct sql_order_item {
+    struct sql_exp             *exp;
+    bool                        desc;
+    struct sql_order_item      *next;
+};
+
+struct sql_select {
+    struct sql_select_item     *items;
+    struct sql_exp             *where;
+    struct sql_exp             *group_by;   // linked by `next`
+    struct sql_order_item      *order_by;
+    long int                    limit;      // -1 for no LIMIT
+    enum sql_travel_type        travel;
+
+    size_t                      nr_aggregates;
+    bool                        select_all; // only `*` or `&` is selected
+
+    struct sql_select          *next;       // the next one of UNION
+};
+
+struct sql_rule {
+    struct sql_select          *select;
+};
+
+struct exe_sql_param {
+    char *err_msg;
+    int debug_flex;
+    int debug_bison;
+
+    struct sql_rule             rule;
+};
+
 PCA_EXTERN_C_BEGIN
 
 int pcexec_exe_sql_register(void);
 
+struct sql_exp *sql_exp_create(enum sql_exp_type type);
+struct sql_exp *sql_exp_binary(enum sql_exp_type type,
+        struct sql_exp *left, struct sql_exp *right);
+struct sql_exp *sql_exp_aggregate(const char *func, size_t len,
+        struct sql_exp *arg, char **err_msg);
+void sql_exp_destroy(struct sql_exp *exp);
+
+struct sql_select_item *sql_select_item_create(struct sql_exp *exp,
+        char *alias);
+void sql_select_item_destroy(struct sql_select_item *item);
+
+struct sql_order_item *sql_order_item_create(struct sql_exp *exp, bool desc);
+void sql_order_item_destroy(struct sql_order_item *item);
+
+// check the clauses and prepare the names of the selected items
+int sql_select_prepare(struct sql_select *select, char **err_msg);
+void sql_select_destroy(struct sql_select *select);
+
+static inline void
+sql_rule_release(struct sql_rule *rule)
+{
+    if (rule->select) {
+        sql_select_destroy(rule->select);
+        rule->select = NULL;
+    }
+}
+
+int exe_sql_parse(const char *input, size_t len,
+        struct exe_sql_param *param);
+
+static inline void
+exe_sql_param_reset(struct exe_sql_param *param)
+{
+    if (!param)
+        return;
+
+    if (param->err_msg) {
+        free(param->err_msg);
+        param->err_msg = NULL;
+    }
+
+    sql_rule_release(&param->rule);
+}
+
 PCA_EXTERN_C_END
 
 #endif // PURC_EXECUTOR_SQL_H
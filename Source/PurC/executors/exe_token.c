@@ -34,10 +34,13 @@
 
 #include <math.h>
 
+PCEXE_DEFINE_RULE_CACHE_OPS(token)
+
 struct pcexec_exe_token_inst {
     struct purc_exec_inst       super;
 
     struct exe_token_param      param;
+    struct pcexec_cached_rule *cached_rule;
 
     purc_variant_t              result_set;
 };
@@ -47,6 +50,10 @@ static inline void
 reset(struct pcexec_exe_token_inst *exe_token_inst)
 {
     struct exe_token_param *param = &exe_token_inst->param;
+    // the rule is owned by the cache of parsed rules
+    memset(&param->rule, 0, sizeof(param->rule));
+    pcexecutor_release_rule(exe_token_inst->cached_rule);
+    exe_token_inst->cached_rule = NULL;
     exe_token_param_reset(param);
     pcexecutor_inst_reset(&exe_token_inst->super);
     PCEXE_CLR_VAR(exe_token_inst->result_set);
@@ -163,21 +170,21 @@ parse_rule(struct pcexec_exe_token_inst *exe_token_inst,
 {
     purc_exec_inst_t inst = &exe_token_inst->super;
 
-    struct exe_token_param param = {0};
-    int r = exe_token_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
-
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct pcexec_cached_rule *cached;
+    cached = pcexecutor_get_rule("TOKEN", rule, parse_token_rule,
+            free_token_rule, &inst->err_msg);
+    if (!cached)
         return false;
+
+    if (cached == exe_token_inst->cached_rule) {
+        // the rule is not changed
+        pcexecutor_release_rule(cached);
+        return true;
     }
 
-    exe_token_param_reset(&exe_token_inst->param);
-    exe_token_inst->param = param;
+    pcexecutor_release_rule(exe_token_inst->cached_rule);
+    exe_token_inst->cached_rule = cached;
+    exe_token_inst->param.rule = *(struct token_rule *)cached->parsed;
 
     return prepare_result_set(exe_token_inst);
 }
@@ -26,6 +26,7 @@
 #include "private/debug.h"
 #include "private/errors.h"
 #include "private/instance.h"
+#include "private/hashtable.h"
 #include "keywords.h"
 
 #include "purc-utils.h"
@@ -179,16 +180,43 @@ static int _init_instance(struct pcinst *inst,
 
     inst->executor_heap->debug_flex = 0;
     inst->executor_heap->debug_bison = 0;
+    list_head_init(&inst->executor_heap->lru_rules);
 
     PC_ASSERT(purc_get_last_error() == 0);
     return 0;
 }
 
+static void
+cached_rule_destroy(struct pcexec_cached_rule *cached)
+{
+    cached->free_fn(cached->parsed);
+    free(cached->key);
+    free(cached);
+}
+
+static void
+rule_entry_free(struct pchash_entry *e)
+{
+    struct pcexec_cached_rule *cached;
+    cached = (struct pcexec_cached_rule *)pchash_entry_v(e);
+
+    list_del(&cached->ln);
+    cached->cached = 0;
+    // the rule will be destroyed when the last executor releases it
+    if (cached->refc == 0)
+        cached_rule_destroy(cached);
+}
+
 static void _cleanup_instance(struct pcinst *inst)
 {
     if (!inst->executor_heap)
         return;
 
+    if (inst->executor_heap->rules) {
+        pchash_table_free(inst->executor_heap->rules);
+        inst->executor_heap->rules = NULL;
+    }
+
     free(inst->executor_heap);
     inst->executor_heap = NULL;
 }
@@ -424,4 +452,90 @@ pcexecutor_get_rule_name(const char *rule)
     return atom;
 }
 
+struct pcexec_cached_rule *
+pcexecutor_get_rule(const char *name, const char *rule,
+        pcexec_rule_parse_fn parse_fn, pcexec_rule_free_fn free_fn,
+        char **err_msg)
+{
+    if (*err_msg) {
+        free(*err_msg);
+        *err_msg = NULL;
+    }
+
+    struct pcexecutor_heap *heap = pcinst_current()->executor_heap;
+    if (heap->rules == NULL) {
+        heap->rules = pchash_kstr_table_new(PCEXECUTOR_MAX_CACHED_RULES,
+                rule_entry_free);
+        if (heap->rules == NULL) {
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            return NULL;
+        }
+    }
+
+    // the same rule string may be parsed differently by other executors
+    char buf[128];
+    char *key = buf;
+    size_t len = strlen(name) + strlen(rule) + 2;
+    if (len > sizeof(buf)) {
+        key = malloc(len);
+        if (key == NULL) {
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            return NULL;
+        }
+    }
+    snprintf(key, len, "%s\n%s", name, rule);
+
+    struct pcexec_cached_rule *cached = NULL;
+    if (pchash_table_lookup_ex(heap->rules, key, (void **)&cached)) {
+        list_move_tail(&cached->ln, &heap->lru_rules);
+        cached->refc++;
+        goto done;
+    }
 
+    void *parsed = parse_fn(rule, err_msg);
+    if (parsed == NULL)
+        goto done;
+
+    cached = calloc(1, sizeof(*cached));
+    if (cached == NULL || (cached->key = strdup(key)) == NULL) {
+        free(cached);
+        free_fn(parsed);
+        cached = NULL;
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        goto done;
+    }
+
+    cached->parsed = parsed;
+    cached->free_fn = free_fn;
+    cached->refc = 1;
+
+    if (heap->rules->count >= PCEXECUTOR_MAX_CACHED_RULES) {
+        struct pcexec_cached_rule *lru;
+        lru = list_first_entry(&heap->lru_rules,
+                struct pcexec_cached_rule, ln);
+        pchash_table_delete(heap->rules, lru->key);
+    }
+
+    // keep the rule uncached (but usable) if failed to insert it
+    if (pchash_table_insert(heap->rules, cached->key, cached) == 0) {
+        list_add_tail(&cached->ln, &heap->lru_rules);
+        cached->cached = 1;
+    }
+
+done:
+    if (key != buf)
+        free(key);
+    return cached;
+}
+
+void
+pcexecutor_release_rule(struct pcexec_cached_rule *cached)
+{
+    if (cached == NULL)
+        return;
+
+    PC_ASSERT(cached->refc > 0);
+    cached->refc--;
+    if (cached->refc == 0 && !cached->cached)
+        cached_rule_destroy(cached);
+}
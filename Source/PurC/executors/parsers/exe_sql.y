@@ -30,12 +30,6 @@
 }
 
 %code requires {
-    struct exe_sql_param {
-        char *err_msg;
-        int debug_flex;
-        int debug_bison;
-    };
-
     struct exe_sql_token {
         const char      *text;
         size_t           leng;
@@ -47,9 +41,6 @@
     #define YY_TYPEDEF_YY_SCANNER_T
     typedef void* yyscan_t;
     #endif
-
-    int exe_sql_parse(const char *input, size_t len,
-            struct exe_sql_param *param);
 }
 
 %code provides {
@@ -65,22 +56,131 @@
         const char *errsg
     );
 
-    #define SET_ARGS(_r, _a) do {              \
-        _r = strndup(_a.text, _a.leng);        \
-        if (!_r)                               \
-            YYABORT;                           \
+    #define SET_RULE(_rule) do {                            \
+        if (param) {                                        \
+            param->rule = _rule;                            \
+        } else {                                            \
+            sql_rule_release(&_rule);                       \
+        }                                                   \
+    } while (0)
+
+    #define ERR_MSG()   (param ? &param->err_msg : NULL)
+
+    #define EXP_INIT(_exp, _type) do {                      \
+        _exp = sql_exp_create(_type);                       \
+        if (!_exp)                                          \
+            YYABORT;                                        \
+    } while (0)
+
+    #define EXP_INIT_NUMBER(_exp, _n) do {                  \
+        double d;                                           \
+        STRTOD(d, _n);                                      \
+        EXP_INIT(_exp, SQL_EXP_NUMBER);                     \
+        _exp->num = d;                                      \
+    } while (0)
+
+    #define EXP_INIT_STRING(_exp, _slist) do {              \
+        _exp = sql_exp_create(SQL_EXP_STRING);              \
+        if (!_exp) {                                        \
+            pcexe_strlist_reset(&_slist);                   \
+            YYABORT;                                        \
+        }                                                   \
+        _exp->str = pcexe_strlist_to_str(&_slist);          \
+        pcexe_strlist_reset(&_slist);                       \
+        if (!_exp->str) {                                   \
+            sql_exp_destroy(_exp);                          \
+            YYABORT;                                        \
+        }                                                   \
+        _exp->len = strlen(_exp->str);                      \
+    } while (0)
+
+    #define EXP_INIT_NAME(_exp, _type, _id) do {            \
+        EXP_INIT(_exp, _type);                              \
+        _exp->str = strndup(_id.text, _id.leng);            \
+        _exp->len = _id.leng;                               \
+        if (!_exp->str) {                                   \
+            sql_exp_destroy(_exp);                          \
+            YYABORT;                                        \
+        }                                                   \
+    } while (0)
+
+    #define EXP_INIT_MEMBER(_exp, _id, _sub) do {           \
+        EXP_INIT_NAME(_exp, SQL_EXP_FIELD, _id);            \
+        _exp->sub = strndup(_sub.text, _sub.leng);          \
+        if (!_exp->sub) {                                   \
+            sql_exp_destroy(_exp);                          \
+            YYABORT;                                        \
+        }                                                   \
+    } while (0)
+
+    #define EXP_UNARY(_exp, _type, _l) do {                 \
+        _exp = sql_exp_binary(_type, _l, NULL);             \
+        if (!_exp)                                          \
+            YYABORT;                                        \
+    } while (0)
+
+    #define EXP_BINARY(_exp, _type, _l, _r) do {            \
+        _exp = sql_exp_binary(_type, _l, _r);               \
+        if (!_exp)                                          \
+            YYABORT;                                        \
+    } while (0)
+
+    #define EXP_AGGREGATE(_exp, _func, _arg) do {           \
+        _exp = sql_exp_aggregate(_func.text, _func.leng,    \
+                _arg, ERR_MSG());                           \
+        if (!_exp)                                          \
+            YYABORT;                                        \
+    } while (0)
+
+    #define LIST_APPEND(_type, _head, _node) do {           \
+        _type *p = _head;                                   \
+        while (p->next)                                     \
+            p = p->next;                                    \
+        p->next = _node;                                    \
+    } while (0)
+
+    #define SELECT_ITEM_INIT(_item, _exp, _alias) do {      \
+        _item = sql_select_item_create(_exp, _alias);       \
+        if (!_item)                                         \
+            YYABORT;                                        \
     } while (0)
 
-    #define APPEND_ARGS(_r, _a, _b) do {       \
-        size_t len = strlen(_a);               \
-        size_t n   = len + _b.leng;            \
-        char *s = (char*)realloc(_a, n+1);     \
-        if (!s) {                              \
-            free(_r);                          \
-            YYABORT;                           \
-        }                                      \
-        memcpy(s+len, _b.text, _b.leng);       \
-        _r = s;                                \
+    #define SELECT_ITEM_INIT_ALIAS(_item, _exp, _id) do {   \
+        char *alias = strndup(_id.text, _id.leng);          \
+        if (!alias) {                                       \
+            sql_exp_destroy(_exp);                          \
+            YYABORT;                                        \
+        }                                                   \
+        SELECT_ITEM_INIT(_item, _exp, alias);               \
+    } while (0)
+
+    #define ORDER_ITEM_INIT(_item, _exp, _desc) do {        \
+        _item = sql_order_item_create(_exp, _desc);         \
+        if (!_item)                                         \
+            YYABORT;                                        \
+    } while (0)
+
+    #define SELECT_INIT(_select, _items, _where, _group_by, \
+            _order_by, _travel, _limit) do {                \
+        _select = (struct sql_select*)calloc(1,             \
+                sizeof(*_select));                          \
+        if (!_select) {                                     \
+            sql_select_item_destroy(_items);                \
+            sql_exp_destroy(_where);                        \
+            sql_exp_destroy(_group_by);                     \
+            sql_order_item_destroy(_order_by);              \
+            YYABORT;                                        \
+        }                                                   \
+        _select->items = _items;                            \
+        _select->where = _where;                            \
+        _select->group_by = _group_by;                      \
+        _select->order_by = _order_by;                      \
+        _select->travel = _travel;                          \
+        _select->limit = _limit;                            \
+        if (sql_select_prepare(_select, ERR_MSG())) {       \
+            sql_select_destroy(_select);                    \
+            YYABORT;                                        \
+        }                                                   \
     } while (0)
 }
 
@@ -100,138 +200,169 @@
 
 // union members
 %union { struct exe_sql_token token; }
-%union { char *str; }
 %union { char c; }
-
-    /* %destructor { free($$); } <str> */ // destructor for `str`
-
-%token SQL SELECT WHERE GROUP BY ORDER TRAVEL IN LIKE UNION AS ASC DESC
+%union { struct pcexe_strlist slist; }
+%union { struct sql_exp *exp; }
+%union { struct sql_select_item *item; }
+%union { struct sql_order_item *order; }
+%union { struct sql_select *select; }
+%union { struct sql_rule rule; }
+%union { enum sql_travel_type travel; }
+%union { long int limit; }
+
+%destructor { pcexe_strlist_reset(&$$); } <slist>
+%destructor { sql_exp_destroy($$); } <exp>
+%destructor { sql_select_item_destroy($$); } <item>
+%destructor { sql_order_item_destroy($$); } <order>
+%destructor { sql_select_destroy($$); } <select>
+%destructor { sql_rule_release(&$$); } <rule>
+
+%token SQL SELECT WHERE GROUP BY ORDER LIMIT TRAVEL IN LIKE UNION AS ASC DESC
 %token SIBLINGS DEPTH BREADTH LEAVES
 %token NOT GE LE NE AT
-%token <c> CHR UNI
-%token <token> STR INTERIOR
+%token <c> CHR
+%token <token> STR UNI INTERIOR
 %token <token> INTEGER NUMBER ID
 
 %left UNION
-%left IN LIKE
-%left AND OR
-%right '=' '<' '>' GE LE NE
+%left OR
+%left AND
+%precedence NOT
+%nonassoc '=' '<' '>' GE LE NE LIKE IN
 %left '-' '+'
 %left '*' '/'
 %precedence UMINUS
-%precedence NEG
 
- /* %nterm <str>   args */ // non-terminal `input` use `str` to store
-                           // token value as well
+%nterm <rule>   rule
+%nterm <select> select_clause union_clause
+%nterm <item>   select_list select_item
+%nterm <exp>    exp exp_list var var_list where_clause group_by_clause
+%nterm <order>  order_list order_item order_by_clause
+%nterm <travel> travel_in_clause
+%nterm <limit>  limit_clause
+%nterm <slist>  str
 
 %% /* The grammar follows. */
 
 input:
-  rule
+  rule          { SET_RULE($1); }
 ;
 
 rule:
-  sql_rule
-;
-
-sql_rule:
-  SQL ':' union_clause
+  SQL ':' union_clause  { $$.select = $3; }
 ;
 
 select_clause:
-  SELECT select_list where_clause group_by_clause order_by_clause travel_in_clause
+  SELECT select_list where_clause group_by_clause order_by_clause travel_in_clause limit_clause
+      { SELECT_INIT($$, $2, $3, $4, $5, $6, $7); }
 ;
 
 union_clause:
-  select_clause
-| '(' union_clause ')'
-| union_clause UNION union_clause
+  select_clause                     { $$ = $1; }
+| '(' union_clause ')'              { $$ = $2; }
+| union_clause UNION union_clause   { LIST_APPEND(struct sql_select, $1, $3); $$ = $1; }
 ;
 
 select_list:
-  select_item
-| select_list ',' select_item
+  select_item                   { $$ = $1; }
+| select_list ',' select_item   { LIST_APPEND(struct sql_select_item, $1, $3); $$ = $1; }
 ;
 
 select_item:
-  exp
-| exp AS ID
+  exp           { SELECT_ITEM_INIT($$, $1, NULL); }
+| exp AS ID     { SELECT_ITEM_INIT_ALIAS($$, $1, $3); }
 ;
 
 var:
-  ID
-| ID '.' ID
+  ID            { EXP_INIT_NAME($$, SQL_EXP_FIELD, $1); }
+| ID '.' ID     { EXP_INIT_MEMBER($$, $1, $3); }
 ;
 
 var_list:
-  var
-| var_list ',' var
+  var                   { $$ = $1; }
+| var_list ',' var      { LIST_APPEND(struct sql_exp, $1, $3); $$ = $1; }
 ;
 
 where_clause:
-  %empty
-| WHERE exp
+  %empty        { $$ = NULL; }
+| WHERE exp     { $$ = $2; }
 ;
 
 group_by_clause:
-  %empty
-| GROUP BY var_list
+  %empty            { $$ = NULL; }
+| GROUP BY var_list { $$ = $3; }
 ;
 
 order_by_clause:
-  %empty
-| ORDER BY var_list
-| ORDER BY var_list ASC
-| ORDER BY var_list DESC
+  %empty                { $$ = NULL; }
+| ORDER BY order_list   { $$ = $3; }
+;
+
+order_list:
+  order_item                { $$ = $1; }
+| order_list ',' order_item { LIST_APPEND(struct sql_order_item, $1, $3); $$ = $1; }
+;
+
+order_item:
+  var           { ORDER_ITEM_INIT($$, $1, false); }
+| var ASC       { ORDER_ITEM_INIT($$, $1, false); }
+| var DESC      { ORDER_ITEM_INIT($$, $1, true); }
 ;
 
 travel_in_clause:
-  %empty
-| TRAVEL IN SIBLINGS
-| TRAVEL IN DEPTH
-| TRAVEL IN BREADTH
-| TRAVEL IN LEAVES
+  %empty                { $$ = SQL_TRAVEL_NONE; }
+| TRAVEL IN SIBLINGS    { $$ = SQL_TRAVEL_SIBLINGS; }
+| TRAVEL IN DEPTH       { $$ = SQL_TRAVEL_DEPTH; }
+| TRAVEL IN BREADTH     { $$ = SQL_TRAVEL_BREADTH; }
+| TRAVEL IN LEAVES      { $$ = SQL_TRAVEL_LEAVES; }
+;
+
+limit_clause:
+  %empty            { $$ = -1; }
+| LIMIT INTEGER     { STRTOL($$, $2); }
 ;
 
 exp:
-  INTEGER
-| NUMBER
-| var
-| '*'
-| '&'
-| '"' str '"'
-| AT ID
-| exp LIKE exp
-| exp IN '(' exp_list ')'
-| exp AND exp
-| exp OR exp
-| NOT exp %prec NEG
-| exp '=' exp
-| exp NE exp
-| exp LE exp
-| exp GE exp
-| exp '>' exp
-| exp '<' exp
-| exp '+' exp
-| exp '-' exp
-| exp '*' exp
-| exp '/' exp
-| '-' exp %prec UMINUS
-| '(' exp ')'
+  INTEGER               { EXP_INIT_NUMBER($$, $1); }
+| NUMBER                { EXP_INIT_NUMBER($$, $1); }
+| var                   { $$ = $1; }
+| '*'                   { EXP_INIT($$, SQL_EXP_ALL); }
+| '&'                   { EXP_INIT($$, SQL_EXP_SELF); }
+| '"' str '"'           { EXP_INIT_STRING($$, $2); }
+| '"' '"'               { EXP_INIT($$, SQL_EXP_STRING); }
+| AT ID                 { EXP_INIT_NAME($$, SQL_EXP_ATTR, $2); }
+| ID '(' exp ')'        { EXP_AGGREGATE($$, $1, $3); }
+| exp LIKE exp          { EXP_BINARY($$, SQL_EXP_LIKE, $1, $3); }
+| exp IN '(' exp_list ')'   { EXP_BINARY($$, SQL_EXP_IN, $1, $4); }
+| exp AND exp           { EXP_BINARY($$, SQL_EXP_AND, $1, $3); }
+| exp OR exp            { EXP_BINARY($$, SQL_EXP_OR, $1, $3); }
+| NOT exp               { EXP_UNARY($$, SQL_EXP_NOT, $2); }
+| exp '=' exp           { EXP_BINARY($$, SQL_EXP_EQ, $1, $3); }
+| exp NE exp            { EXP_BINARY($$, SQL_EXP_NE, $1, $3); }
+| exp LE exp            { EXP_BINARY($$, SQL_EXP_LE, $1, $3); }
+| exp GE exp            { EXP_BINARY($$, SQL_EXP_GE, $1, $3); }
+| exp '>' exp           { EXP_BINARY($$, SQL_EXP_GT, $1, $3); }
+| exp '<' exp           { EXP_BINARY($$, SQL_EXP_LT, $1, $3); }
+| exp '+' exp           { EXP_BINARY($$, SQL_EXP_ADD, $1, $3); }
+| exp '-' exp           { EXP_BINARY($$, SQL_EXP_SUB, $1, $3); }
+| exp '*' exp           { EXP_BINARY($$, SQL_EXP_MUL, $1, $3); }
+| exp '/' exp           { EXP_BINARY($$, SQL_EXP_DIV, $1, $3); }
+| '-' exp %prec UMINUS  { EXP_UNARY($$, SQL_EXP_NEG, $2); }
+| '(' exp ')'           { $$ = $2; }
 ;
 
 exp_list:
-  exp
-| exp ',' exp
+  exp                   { $$ = $1; }
+| exp_list ',' exp      { LIST_APPEND(struct sql_exp, $1, $3); $$ = $1; }
 ;
 
 str:
-  STR
-| CHR
-| UNI
-| str STR
-| str CHR
-| str UNI
+  STR           { STRLIST_INIT_STR($$, $1); }
+| CHR           { STRLIST_INIT_CHR($$, $1); }
+| UNI           { STRLIST_INIT_UNI($$, $1); }
+| str STR       { STRLIST_APPEND_STR($1, $2); $$ = $1; }
+| str CHR       { STRLIST_APPEND_CHR($1, $2); $$ = $1; }
+| str UNI       { STRLIST_APPEND_UNI($1, $2); $$ = $1; }
 ;
 
 %%
@@ -52,6 +52,37 @@
     }                                             \
 } while (0)
 
+// Define `parse_<name>_rule()` and `free_<name>_rule()` to cache the
+// `struct <name>_rule` parsed by `exe_<name>_parse()`, see
+// pcexecutor_get_rule().
+#define PCEXE_DEFINE_RULE_CACHE_OPS(_name)                                  \
+static void                                                                 \
+free_##_name##_rule(void *parsed)                                           \
+{                                                                           \
+    _name##_rule_release((struct _name##_rule *)parsed);                    \
+    free(parsed);                                                           \
+}                                                                           \
+                                                                            \
+static void *                                                               \
+parse_##_name##_rule(const char *rule, char **err_msg)                      \
+{                                                                           \
+    struct exe_##_name##_param param = {0};                                 \
+    if (exe_##_name##_parse(rule, strlen(rule), &param)) {                  \
+        *err_msg = param.err_msg;                                           \
+        return NULL;                                                        \
+    }                                                                       \
+    PCEXE_FREE(param.err_msg);                                              \
+                                                                            \
+    struct _name##_rule *parsed = malloc(sizeof(*parsed));                  \
+    if (parsed == NULL) {                                                   \
+        _name##_rule_release(&param.rule);                                  \
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);                             \
+        return NULL;                                                        \
+    }                                                                       \
+    *parsed = param.rule;                                                   \
+    return parsed;                                                          \
+}
+
 PCA_EXTERN_C_BEGIN
 
 int pcexe_ucs2utf8(char *utf, const char *uni, size_t n);
@@ -1531,6 +1531,10 @@ static ssize_t combined_stream_read(void *ctxt, void *buf, size_t count)
     struct combined_stream *rs = (struct combined_stream*)ctxt;
     purc_rwstream_t in;
 
+    /* all the streams are exhausted */
+    if (rs->idx == 3)
+        return 0;
+
 again:
 
     switch (rs->idx) {
@@ -1552,7 +1556,7 @@ again:
     if (n == 0) {
         rs->idx += 1;
         if (rs->idx == 3)
-            return count;
+            return 0;
         goto again;
     }
 
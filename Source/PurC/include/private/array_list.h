@@ -30,7 +30,6 @@
 #include "private/list.h"
 
 struct pcutils_array_list_node {
-    struct list_head             node;
     size_t                       idx;
 };
 
@@ -40,8 +39,6 @@ struct pcutils_array_list {
     struct pcutils_array_list_node          **nodes;
     size_t                                    sz;
     size_t                                    nr;
-
-    struct list_head                          list;
 };
 
 #define safe_container_of(_ptr, _type, _member)                 \
@@ -173,9 +170,15 @@ pcutils_array_list_remove(struct pcutils_array_list *al,
         size_t idx,
         struct pcutils_array_list_node **old);
 
-struct pcutils_array_list_node*
+static inline struct pcutils_array_list_node*
 pcutils_array_list_get(struct pcutils_array_list *al,
-        size_t idx);
+        size_t idx)
+{
+    if (idx < al->nr)
+        return al->nodes[idx];
+
+    return NULL;
+}
 
 static inline struct pcutils_array_list_node*
 pcutils_array_list_get_first(struct pcutils_array_list *al)
@@ -194,6 +197,8 @@ int
 pcutils_array_list_swap(struct pcutils_array_list *al,
         size_t i, size_t j);
 
+// stable merge sort; the `idx` of the nodes keeps the positions before the
+// sort until it finishes, so `cmp` can use them to look up precomputed keys
 void
 pcutils_array_list_sort(struct pcutils_array_list *al,
         void *ud, int (*cmp)(struct pcutils_array_list_node *l,
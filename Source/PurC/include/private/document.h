@@ -80,6 +80,11 @@ struct purc_document_ops {
     pcdoc_node (*get_child)(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_node_type type, size_t idx);
 
+    // nullable; the cursor to iterate over the children of an element
+    pcdoc_node (*first_child)(purc_document_t doc, pcdoc_element_t elem);
+    // null if `first_child` is null
+    pcdoc_node (*next_sibling)(purc_document_t doc, pcdoc_node node);
+
     int (*get_attribute)(purc_document_t doc, pcdoc_element_t elem,
             const char *name, const char **val, size_t *len);
     int (*get_special_attr)(purc_document_t doc, pcdoc_element_t elem,
@@ -99,6 +104,7 @@ struct purc_document_ops {
     pcdoc_element_t (*find_elem)(purc_document_t doc, pcdoc_element_t scope,
             const char *selector);
 
+    // return the number of selected elements, or -1 on failure
     int (*elem_coll_select)(purc_document_t doc,
             pcdoc_elem_coll_t coll, pcdoc_element_t scope,
             const char *selector);
@@ -121,6 +127,17 @@ struct purc_document {
     struct purc_document_ops *ops;
 
     void *impl;
+
+    /* the index of elements by identifier and class; built on demand
+       and maintained by the implementation (nullable) */
+    struct pcdoc_elem_index *elem_index;
+
+    /* the compiled CSS selectors keyed by their source strings */
+    struct pchash_table *selectors;
+
+    /* the children of the element visited last by index; dropped
+       by the implementation on any mutation (nullable) */
+    struct pcdoc_child_index *child_index;
 };
 
 struct pcdoc_elem_coll {
@@ -32,6 +32,7 @@
 #include "purc-executor.h"
 
 #include "private/map.h"
+#include "private/list.h"
 
 PCA_EXTERN_C_BEGIN
 
@@ -98,9 +99,30 @@ int pcexec_register_ops(pcexec_ops_t ops);
 int pcexec_get_by_rule(const char *rule, pcexec_ops_t ops);
 
 
+/* the maximal number of parsed rules cached by an instance */
+#define PCEXECUTOR_MAX_CACHED_RULES     64
+
 struct pcexecutor_heap {
     unsigned int       debug_flex:1;
     unsigned int       debug_bison:1;
+
+    /* the parsed rules keyed by the executor name and the rule string */
+    struct pchash_table    *rules;
+    /* the cached rules, the least recently used one first */
+    struct list_head        lru_rules;
+};
+
+typedef void *(*pcexec_rule_parse_fn)(const char *rule, char **err_msg);
+typedef void (*pcexec_rule_free_fn)(void *parsed);
+
+// 缓存的已解析规则；由缓存和使用它的执行器实例共享
+struct pcexec_cached_rule {
+    struct list_head            ln;
+    char                       *key;
+    void                       *parsed;
+    pcexec_rule_free_fn         free_fn;
+    unsigned int                refc;
+    unsigned int                cached:1;
 };
 
 // 用于迭代的迭代器
@@ -140,6 +162,19 @@ int pcexecutor_get_by_rule(const char *rule, pcexec_ops_t ops);
 purc_atom_t
 pcexecutor_get_rule_name(const char *rule);
 
+/* Returns the parsed rule for the rule string of the executor `name`,
+   parsing it with `parse_fn` only if it is not in the cache yet.
+   The caller owns a reference of the returned rule; on failure, returns
+   NULL and sets the error message of the parser to `err_msg`. */
+struct pcexec_cached_rule *
+pcexecutor_get_rule(const char *name, const char *rule,
+        pcexec_rule_parse_fn parse_fn, pcexec_rule_free_fn free_fn,
+        char **err_msg);
+
+/* Releases a reference of the rule returned by pcexecutor_get_rule(). */
+void
+pcexecutor_release_rule(struct pcexec_cached_rule *cached);
+
 
 PCA_EXTERN_C_END
 
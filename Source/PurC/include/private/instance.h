@@ -45,6 +45,7 @@ typedef struct pcmodule pcmodule;
 typedef struct pcmodule *pcmodule_t;
 
 struct pcinst_msg_queue;
+struct pcslab_cache;
 
 typedef int (*module_init_once_f)(void);
 typedef int (*module_init_instance_f)(struct pcinst *curr_inst,
@@ -91,6 +92,9 @@ struct pcinst {
        number generator */
     pcutils_map            *local_data_map;
 
+    /* the free objects of the slab allocator cached by this instance */
+    struct pcslab_cache    *slab_cache;
+
     struct pcvariant_heap  *variant_heap;
     struct pcvariant_heap  *org_vrt_heap;
 
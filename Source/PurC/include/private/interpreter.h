@@ -117,7 +117,20 @@ struct pcintr_heap {
 
     struct list_head    crtns;
     struct list_head    stopped_crtns;
-    struct sorted_array *wait_timeout_crtns;
+
+    // the coroutines in READY state, in the order they became ready.
+    struct list_head    ready_crtns;
+    // the coroutines which may have messages or tasks to dispatch.
+    struct list_head    pending_crtns;
+
+    // min-heap of the stopped coroutines waiting with a timeout,
+    // ordered by pcintr_coroutine::stopped_timeout.
+    pcintr_coroutine_t *timeout_crtns;
+    size_t              nr_timeout_crtns;
+    size_t              sz_timeout_crtns;
+
+    // the number of coroutines observing the idle event.
+    size_t              nr_idle_observers;
 
     pcutils_map        *name_chan_map;  // name to channel map.
 
@@ -126,7 +139,20 @@ struct pcintr_heap {
 
     purc_cond_handler   cond_handler;
     unsigned int        keep_alive:1;
+    // the scheduler has suspended the idle function of the runloop;
+    // see pcintr_wakeup_scheduler().
+    unsigned int        suspended:1;
     double              timestamp;
+
+    // the fd of the connection to the renderer watched by the scheduler.
+    int                 rdr_fd;
+    uintptr_t           rdr_fd_monitor;
+
+    // bumped whenever a named variable is bound, rebound or unbound;
+    // see pcintr_find_named_var_cached().
+    uint64_t            var_epoch;
+    // the serial number given to the last pushed stack frame.
+    uint64_t            frame_serial;
 };
 
 struct pcintr_stack_frame;
@@ -289,6 +315,8 @@ struct pcintr_coroutine {
 
     struct rb_node              node;     /* heap::coroutines */
     struct list_head            ln;       /* heap::crtns, stopped_crtns */
+    struct list_head            ln_ready;   /* heap::ready_crtns */
+    struct list_head            ln_pending; /* heap::pending_crtns */
 
     struct list_head            children; /* struct pcintr_coroutine_child */
 
@@ -336,6 +364,7 @@ struct pcintr_coroutine {
     void                       *user_data;
     unsigned long               run_idx;
     time_t                      stopped_timeout;
+    size_t                      timeout_idx;    /* in heap::timeout_crtns */
 };
 
 enum purc_symbol_var {
@@ -395,6 +424,10 @@ struct pcintr_stack_frame {
     enum pcintr_stack_frame_type             type;
     // pointers to sibling frames.
     struct list_head node;
+    // unique in the heap, unlike the address of the frame.
+    uint64_t serial;
+    // the listener on the temporary variables ($!) of the frame.
+    struct pcvar_listener *temp_vars_listener;
     // the current scope.
     pcvdom_element_t scope;
 
@@ -623,6 +656,30 @@ pcintr_get_scope_variable(purc_coroutine_t cor, pcvdom_element_t elem,
 purc_variant_t
 pcintr_find_named_var(pcintr_stack_t stack, const char* name);
 
+/*
+ * The inline cache of a variable name which is known before evaluation,
+ * e.g. the name of a `getVariable` node in compiled vcm code. A resolved
+ * variable stays valid as long as no named variable is bound or unbound
+ * (the epoch of the heap) and the lookup starts from the same place: the
+ * same parent frame and the same position and scope of the bottom frame.
+ */
+struct pcintr_var_cache {
+    pcintr_stack_t          stack;
+    uint64_t                parent_serial;
+    pcvdom_element_t        pos;
+    pcvdom_element_t        scope;
+    uint64_t                epoch;
+    // not referenced, the binding keeps it alive until the epoch changes
+    purc_variant_t          value;
+};
+
+purc_variant_t
+pcintr_find_named_var_cached(pcintr_stack_t stack, const char* name,
+        struct pcintr_var_cache *cache);
+
+void
+pcintr_invalidate_var_caches(void);
+
 purc_variant_t
 pcintr_get_symbolized_var (pcintr_stack_t stack, unsigned int number,
         char symbol);
@@ -782,6 +839,18 @@ pcintr_coroutine_get_uri(pcintr_coroutine_t co)
 void
 pcintr_schedule(void *ctxt);
 
+void
+pcintr_wakeup_scheduler(struct pcinst *inst);
+
+void
+pcintr_coroutine_state_changed(pcintr_coroutine_t co);
+
+void
+pcintr_coroutine_add_pending(pcintr_coroutine_t co);
+
+uintptr_t
+pcintr_add_wakeup_fd_monitor(purc_runloop_t runloop, int fd);
+
 void
 pcintr_coroutine_set_result(pcintr_coroutine_t co, purc_variant_t result);
 
@@ -29,8 +29,6 @@
 
 #include "config.h"
 
-#include <stdatomic.h>
-
 #include "private/list.h"
 #include "purc-pcrdr.h"
 
@@ -39,13 +37,22 @@
 #define MSG_QS_EVENT    0x40000000
 #define MSG_QS_VOID     0x80000000
 
+/* The same layout as the header of a message in the move buffer, whose
+   owner is only accessed there, atomically. */
 struct pcinst_msg_hdr {
-    atomic_uint             owner;
+    unsigned int            owner;
     struct list_head        ln;
 };
 
+struct pcinst;
+
 struct pcinst_msg_queue {
     struct purc_rwlock  lock;
+    /* the instance creating the queue; its scheduler is woken up
+       when a message is put into the queue. Messages are only put
+       into the queue on the thread of this instance; messages from
+       other instances go through the move buffer. */
+    struct pcinst      *owner;
     struct list_head    req_msgs;
     struct list_head    res_msgs;
     struct list_head    event_msgs;
@@ -53,13 +60,34 @@ struct pcinst_msg_queue {
 
     uint64_t            state;
     size_t              nr_msgs;
+
+    /* the index of the events in `event_msgs` keyed by
+       (target, targetValue, eventName, elementValue) */
+    struct list_head   *event_buckets;
+    size_t              nr_event_buckets;
+    size_t              nr_event_keys;
+
+    /* instrumentation */
+    size_t              max_msgs;
+    uint64_t            nr_coalesced;
+};
+
+struct pcinst_msg_queue_stats {
+    /* the number of messages in the queue now */
+    size_t              nr_msgs;
+    /* the number of distinct event keys in the queue now */
+    size_t              nr_event_keys;
+    /* the maximal number of messages ever in the queue */
+    size_t              max_msgs;
+    /* the number of events reduced (ignored or overlaid) to a queued one */
+    uint64_t            nr_coalesced;
 };
 
 /* Make sure the size of `struct list_head` is two times of sizeof(void *) */
 #define _COMPILE_TIME_ASSERT(name, x)               \
        typedef int _dummy_ ## name[(x) * 2 - 1]
 _COMPILE_TIME_ASSERT(onwer_atom,
-        sizeof(atomic_uint) == sizeof(purc_atom_t));
+        sizeof(unsigned int) == sizeof(purc_atom_t));
 _COMPILE_TIME_ASSERT(list_head,
         sizeof(struct list_head) == (sizeof(void *) * 2));
 #undef _COMPILE_TIME_ASSERT
@@ -89,6 +117,10 @@ pcinst_msg_queue_get_event_by_element(struct pcinst_msg_queue *queue,
 size_t
 pcinst_msg_queue_count(struct pcinst_msg_queue *queue);
 
+void
+pcinst_msg_queue_get_stats(struct pcinst_msg_queue *queue,
+        struct pcinst_msg_queue_stats *stats);
+
 PCA_EXTERN_C_END
 
 #endif /* not defined PURC_PRIVATE_MSG_QUEUE_H */
@@ -32,6 +32,15 @@
 
 #define PCRDR_TIME_DEF_EXPECTED         5
 
+/* Set this environment variable to 0 or false to wait for the response of
+   every DOM request, instead of pipelining the requests. */
+#define PURC_ENVV_RDR_PIPELINE          "PURC_RDR_PIPELINE"
+
+/* The headless renderer delays every response for the milliseconds given
+   by this environment variable, in order to simulate the round trip
+   to a real renderer. */
+#define PURC_ENVV_HEADLESS_LATENCY      "PURC_HEADLESS_LATENCY"
+
 /* the capabilities of a renderer */
 struct renderer_capabilities {
     /* the protocol name */
@@ -25,5 +25,22 @@
 #ifndef PURC_PRIVATE_RWSTREAM_H
 #define PURC_PRIVATE_RWSTREAM_H
 
+#include "purc-rwstream.h"
+
+PCA_EXTERN_C_BEGIN
+
+/*
+ * Returns the bytes not read yet in a memory-backed rwstream (created by
+ * purc_rwstream_new_from_mem() or purc_rwstream_new_buffer()), so that
+ * the caller can decode them in place. The position of the stream is not
+ * changed; use purc_rwstream_seek() to skip the bytes consumed.
+ *
+ * Returns NULL for other rwstreams.
+ */
+const uint8_t *
+pcrwstream_get_readable_mem(purc_rwstream_t rws, size_t *nr_bytes);
+
+PCA_EXTERN_C_END
+
 #endif /* not defined PURC_PRIVATE_RWSTREAM_H */
 
@@ -0,0 +1,116 @@
+/*
+ * @file slab.h
+ * @brief The internal interfaces of the slab allocator for small objects.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_PRIVATE_SLAB_H
+#define PURC_PRIVATE_SLAB_H
+
+#include "config.h"
+#include "purc-macros.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/*
+ * The slab allocator serves the hot fixed-size objects (variants, the nodes
+ * of containers, the entries of maps, and renderer messages) from size
+ * classes of PCSLAB_GRANULE bytes up to PCSLAB_MAX_SIZE bytes. Larger
+ * objects go to malloc().
+ *
+ * Each instance caches freed objects per size class; the cache of a class
+ * is refilled from and flushed to a depot shared by all threads, so an
+ * object allocated by one instance can be freed by another one (e.g. after
+ * being moved). The chunks of the depot are returned to the system once
+ * the last instance is cleaned up and all the objects are freed.
+ *
+ * The object must be freed with the same size as it was allocated.
+ */
+#define PCSLAB_GRANULE              16
+#define PCSLAB_MAX_SIZE             256
+#define PCSLAB_NR_CLASSES           (PCSLAB_MAX_SIZE / PCSLAB_GRANULE)
+
+/* the default number of free objects an instance caches per size class */
+#define PCSLAB_DEF_MAX_CACHED       512
+
+/* the environment variable to override PCSLAB_DEF_MAX_CACHED */
+#define PURC_ENVV_SLAB_MAX_CACHED   "PURC_SLAB_MAX_CACHED"
+
+struct pcslab_stat {
+    /* the number and the size of free objects cached by the instance */
+    size_t nr_cached;
+    size_t sz_cached;
+
+    /* the size of all chunks and of the free space in the shared depot */
+    size_t sz_chunks;
+    size_t sz_depot;
+};
+
+PCA_EXTERN_C_BEGIN
+
+#if USE(SLAB_ALLOCATOR)
+
+void *pcslab_alloc(size_t size) WTF_INTERNAL;
+void *pcslab_alloc0(size_t size) WTF_INTERNAL;
+void pcslab_free(void *obj, size_t size) WTF_INTERNAL;
+
+/* changes the cap of the cache of the current instance; returns the old cap */
+size_t pcslab_set_max_cached(size_t max_cached) WTF_INTERNAL;
+
+void pcslab_get_stat(struct pcslab_stat *stat) WTF_INTERNAL;
+
+#else /* USE(SLAB_ALLOCATOR) */
+
+static inline void *pcslab_alloc(size_t size)
+{
+    return malloc(size);
+}
+
+static inline void *pcslab_alloc0(size_t size)
+{
+    return calloc(1, size);
+}
+
+static inline void pcslab_free(void *obj, size_t size)
+{
+    (void)size;
+    free(obj);
+}
+
+static inline size_t pcslab_set_max_cached(size_t max_cached)
+{
+    (void)max_cached;
+    return 0;
+}
+
+static inline void pcslab_get_stat(struct pcslab_stat *stat)
+{
+    stat->nr_cached = 0;
+    stat->sz_cached = 0;
+    stat->sz_chunks = 0;
+    stat->sz_depot = 0;
+}
+
+#endif /* !USE(SLAB_ALLOCATOR) */
+
+PCA_EXTERN_C_END
+
+#endif /* PURC_PRIVATE_SLAB_H */
+
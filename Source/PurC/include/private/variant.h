@@ -40,6 +40,11 @@ PCA_EXTERN_C_BEGIN
 #define PCVARIANT_FLAG_NOFREE          PCVARIANT_FLAG_CONSTANT
 #define PCVARIANT_FLAG_EXTRA_SIZE      (0x01 << 1)  // when use extra space
 #define PCVARIANT_FLAG_STRING_STATIC   (0x01 << 2)  // make_string_static
+#define PCVARIANT_FLAG_FROZEN          (0x01 << 3)  // purc_variant_freeze
+
+/* frozen values are immutable and shared by instances; their reference
+   counts are changed atomically, and they are accounted in the move heap. */
+#define PCVARIANT_IS_FROZEN(v)  ((v)->flags & PCVARIANT_FLAG_FROZEN)
 
 #define PVT(t)          (PURC_VARIANT_TYPE##t)
 #define IS_CONTAINER(t) (t == PURC_VARIANT_TYPE_OBJECT || \
@@ -217,6 +222,7 @@ purc_variant_t pcvariant_move_heap_out(purc_variant_t v) WTF_INTERNAL;
 
 void pcvariant_use_move_heap(void) WTF_INTERNAL;
 void pcvariant_use_norm_heap(void) WTF_INTERNAL;
+bool pcvariant_is_using_move_heap(void) WTF_INTERNAL;
 
 purc_variant *pcvariant_alloc(void) WTF_INTERNAL;
 purc_variant *pcvariant_alloc_0(void) WTF_INTERNAL;
@@ -241,7 +247,11 @@ struct set_node {
     struct rb_node                       rbnode;
     struct pcutils_array_list_node       alnode;
     purc_variant_t   val;  // actual variant-element
-    char             md5[33];
+
+    // hash of the unique key(s) of val, and the next node in the same
+    // bucket of the hash index of the set
+    uint64_t                             hash;
+    struct set_node                     *hash_next;
 };
 
 struct variant_set {
@@ -252,6 +262,10 @@ struct variant_set {
     struct rb_root          elems;  // multiple-variant-elements stored in set
     struct pcutils_array_list al;    // struct set_node
 
+    // hash index of elems: struct set_node chained by hash_next
+    struct set_node       **buckets;
+    size_t                  nr_buckets;
+
     // key: arr_node/obj_node/set_node
     // val: parent
     pcutils_map                     *rev_update_chain;
@@ -264,12 +278,22 @@ struct obj_node {
     struct rb_node   node;
     purc_variant_t   key;
     purc_variant_t   val;
+
+    // hash of the key string, and the next node in the same bucket
+    // of the hash index of the object
+    uint64_t         hash;
+    struct obj_node *hash_next;
 };
 
 struct variant_obj {
     struct rb_root          kvs;  // struct obj_node*
     size_t                  size;
 
+    // hash index of kvs: struct obj_node chained by hash_next;
+    // only built for objects with more than a few members
+    struct obj_node       **buckets;
+    size_t                  nr_buckets;
+
     // key: arr_node/obj_node/set_node
     // val: parent
     pcutils_map                     *rev_update_chain;
@@ -283,7 +307,19 @@ struct arr_node {
     purc_variant_t   val;
 };
 
+#define VARIANT_ARR_NR_INLINE_VALS     4
+
+/* The members are stored contiguously in `vals` until the array gets an
+ * edge to a parent in the reverse update chain. A member then needs a
+ * stable location in the array (`arr_me` of struct pcvar_rev_update_edge),
+ * so the members are moved into the nodes of `al` and stay there. */
 struct variant_arr {
+    purc_variant_t               *vals;  // inline_vals or on the heap
+    size_t                        sz_vals;
+    size_t                        nr_vals;
+    purc_variant_t                inline_vals[VARIANT_ARR_NR_INLINE_VALS];
+
+    bool                          use_nodes;
     struct pcutils_array_list     al;  // struct arr_node*
 
     // key: arr_node/obj_node/set_node
@@ -291,6 +327,38 @@ struct variant_arr {
     pcutils_map                     *rev_update_chain;
 };
 
+static inline size_t
+pcvar_arr_length(variant_arr_t data)
+{
+    if (data->use_nodes)
+        return pcutils_array_list_length(&data->al);
+
+    return data->nr_vals;
+}
+
+/* the location of the member at `idx`, which must be less than the length */
+static inline purc_variant_t *
+pcvar_arr_slot(variant_arr_t data, size_t idx)
+{
+    if (data->use_nodes) {
+        struct pcutils_array_list_node *p;
+        p = pcutils_array_list_get(&data->al, idx);
+        return &container_of(p, struct arr_node, node)->val;
+    }
+
+    return data->vals + idx;
+}
+
+/* the node holding the member in `slot`; NULL if stored contiguously */
+static inline struct arr_node *
+pcvar_arr_slot_node(variant_arr_t data, purc_variant_t *slot)
+{
+    if (data->use_nodes)
+        return container_of(slot, struct arr_node, val);
+
+    return NULL;
+}
+
 #define PCVARIANT_SORT_DESC            0x10000000
 #define PCVARIANT_SORT_ASC             0x00000000
 #define PCVARIANT_CMPOPT_MASK          0x0000FFFF
@@ -300,6 +368,15 @@ int pcvariant_array_sort(purc_variant_t value, void *ud,
 int pcvariant_set_sort(purc_variant_t value, void *ud,
         int (*cmp)(purc_variant_t l, purc_variant_t r, void *ud));
 
+/* `cmp` compares the members by their positions before sorting, which lets
+ * the caller compare the keys precomputed in the original order */
+int pcvariant_array_sort_by_pos(purc_variant_t value, void *ud,
+        int (*cmp)(size_t l, size_t r, void *ud));
+/* swaps the members at `i` and `j` without firing any event */
+int pcvariant_array_swap(purc_variant_t value, size_t i, size_t j);
+int pcvariant_set_sort_by_pos(purc_variant_t value, void *ud,
+        int (*cmp)(size_t l, size_t r, void *ud));
+
 int pcvariant_diff(purc_variant_t l, purc_variant_t r);
 int pcvariant_diff_ex(purc_variant_t l, purc_variant_t r,
         enum purc_variant_compare_opt opt);
@@ -428,15 +505,6 @@ pcvariant_md5(char *md5, purc_variant_t val)
     pcvariant_md5_ex(md5, val, salt, caseless, serialize_flags);
 }
 
-// md5 shall be at least 33 bytes long
-void
-pcvariant_md5_by_set(char *md5, purc_variant_t val,
-        purc_variant_t set) WTF_INTERNAL;
-
-int
-pcvariant_diff_by_set(const char *md5l, purc_variant_t l,
-        const char *md5r, purc_variant_t r, purc_variant_t set);
-
 PCA_EXTERN_C_END
 
 /* VWNOTE (WARN)
@@ -449,68 +517,46 @@ PCA_EXTERN_C_END
  */
 
 // purc_variant_t _arr;
-#define variant_array_get_data(_arr)        \
-    &(((variant_arr_t)_arr->sz_ptr[1])->al)
-
-// purc_variant_t _arr;
-// struct arr_node *_p;
-#define foreach_in_variant_array(_arr, _p)                               \
-    array_list_for_each_entry(variant_array_get_data(_arr),              \
-            _p, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p, *_n;
-#define foreach_in_variant_array_safe(_arr, _p, _n)                      \
-    array_list_for_each_entry_safe(variant_array_get_data(_arr),         \
-            _p, _n, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p;
-#define foreach_in_variant_array_reverse(_arr, _p)                       \
-    array_list_for_each_entry_reverse(variant_array_get_data(_arr),      \
-            _p, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p, *_n;
-#define foreach_in_variant_array_reverse_safe(_arr, _p, _n)              \
-    array_list_for_each_entry_reverse_safe(variant_array_get_data(_arr), \
-            _p, _n, node)
-
+// purc_variant_t _val;
+// size_t _idx;
+// the location of the member is available as `_slot` in the loop.
 #define foreach_value_in_variant_array(_arr, _val, _idx)              \
     do {                                                              \
-        struct arr_node *_p;                                          \
-        foreach_in_variant_array(_arr, _p) {                          \
-            _val = _p->val;                                           \
-            _idx = _p->node.idx;                                      \
+        variant_arr_t _data = (variant_arr_t)_arr->sz_ptr[1];         \
+        for (size_t _i = 0; _i < pcvar_arr_length(_data); _i++) {     \
+            purc_variant_t *_slot = pcvar_arr_slot(_data, _i);        \
+            _val = *_slot;                                            \
+            _idx = _i;                                                \
      /* } */                                                          \
  /* } while (0) */
 
-#define foreach_value_in_variant_array_safe(_arr, _val, _idx)      \
-    do {                                                           \
-        struct arr_node *_p, *_n;                                  \
-        foreach_in_variant_array_safe(_arr, _p, _n) {              \
-            _val = _p->val;                                        \
-            _idx = _p->node.idx;                                   \
-     /* } */                                                       \
+// removing the current member in the loop is safe.
+#define foreach_value_in_variant_array_safe(_arr, _val, _idx)         \
+    do {                                                              \
+        variant_arr_t _data = (variant_arr_t)_arr->sz_ptr[1];         \
+        for (size_t _i = 0, _nr = 0;                                  \
+                _i < pcvar_arr_length(_data) &&                       \
+                    (_nr = pcvar_arr_length(_data), true);            \
+                _i = _i + 1 + pcvar_arr_length(_data) - _nr) {        \
+            purc_variant_t *_slot = pcvar_arr_slot(_data, _i);        \
+            _val = *_slot;                                            \
+            _idx = _i;                                                \
+     /* } */                                                          \
  /* } while (0) */
 
 #define foreach_value_in_variant_array_reverse(_arr, _val, _idx)      \
     do {                                                              \
-        struct arr_node *_p;                                          \
-        foreach_in_variant_array_reverse(_arr, _p) {                  \
-            _val = _p->val;                                           \
-            _idx = _p->node.idx;                                      \
+        variant_arr_t _data = (variant_arr_t)_arr->sz_ptr[1];         \
+        for (size_t _i = pcvar_arr_length(_data); _i-- > 0; ) {       \
+            purc_variant_t *_slot = pcvar_arr_slot(_data, _i);        \
+            _val = *_slot;                                            \
+            _idx = _i;                                                \
      /* } */                                                          \
  /* } while (0) */
 
-#define foreach_value_in_variant_array_reverse_safe(_arr, _val, _idx)   \
-    do {                                                                \
-        struct arr_node *_p, *_n;                                       \
-        foreach_in_variant_array_reverse_safe(_arr, _p, _n) {           \
-            _val = _p->val;                                             \
-            _idx = _p->node.idx;                                        \
-     /* } */                                                            \
- /* } while (0) */
+// removing the current member in the loop is safe.
+#define foreach_value_in_variant_array_reverse_safe(_arr, _val, _idx) \
+    foreach_value_in_variant_array_reverse(_arr, _val, _idx)
 
 #define foreach_value_in_variant_object(_obj, _val)                 \
     do {                                                            \
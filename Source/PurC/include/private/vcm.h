@@ -252,6 +252,27 @@ struct pcintr_stack;
 purc_variant_t pcvcm_eval(struct pcvcm_node *tree, struct pcintr_stack *stack,
         bool silently);
 
+/*
+ * Compiles the tree to a flat instruction stream which evaluates to the
+ * same results as the tree does, including the resumption with
+ * pcvcm_eval_again(). The code refers to the nodes of the tree, so it
+ * must be destroyed before the tree.
+ */
+#define PURC_ENVV_VCM_BYTECODE      "PURC_VCM_BYTECODE"
+
+struct pcvcm_code;
+struct pcvcm_code *pcvcm_compile(struct pcvcm_node *tree);
+
+void pcvcm_code_destroy(struct pcvcm_code *code);
+
+purc_variant_t pcvcm_eval_code_ex(struct pcvcm_code *code,
+        struct pcvcm_eval_ctxt **ctxt,
+        find_var_fn find_var, void *find_var_ctxt,
+        bool silently);
+
+purc_variant_t pcvcm_eval_code(struct pcvcm_code *code,
+        struct pcintr_stack *stack, bool silently);
+
 purc_variant_t pcvcm_eval_again(struct pcvcm_node *tree,
         struct pcintr_stack *stack, bool silently, bool timeout);
 
@@ -239,6 +239,17 @@ struct pcvdom_attr*
 pcvdom_element_get_attr_c(struct pcvdom_element *elem,
         const char *key);
 
+// the atom of the key of the attr in the HVML keyword bucket;
+// 0 if the key is not a keyword
+purc_atom_t
+pcvdom_attr_get_keyword(struct pcvdom_attr *attr);
+
+// the value of the attr compiled by pcvcm_compile() on the first call;
+// NULL if the attr has no value, the value can not be compiled, or
+// the environment variable PURC_VCM_BYTECODE is set to `0` or `false`
+struct pcvcm_code*
+pcvdom_attr_get_vcm_code(struct pcvdom_attr *attr);
+
 // operation api
 void pcvdom_node_remove(struct pcvdom_node *node);
 
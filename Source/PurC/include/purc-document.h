@@ -543,6 +543,35 @@ PCA_EXPORT pcdoc_data_node_t
 pcdoc_element_get_child_data_node(purc_document_t doc, pcdoc_element_t elem,
         size_t idx);
 
+/**
+ * Get the first child node of an element.
+ *
+ * @param doc: the document.
+ * @param elem: the element.
+ *
+ * This function and pcdoc_node_next_sibling() iterate over all children
+ * of an element in document order without indexing, so a loop over
+ * the children costs O(n) instead of O(n^2).
+ *
+ * Returns: the first child node; the type of the node is
+ *      %PCDOC_NODE_VOID if the element has no child.
+ */
+PCA_EXPORT pcdoc_node
+pcdoc_element_first_child(purc_document_t doc, pcdoc_element_t elem);
+
+/**
+ * Get the next sibling node of a document node.
+ *
+ * @param doc: the document.
+ * @param node: the current node returned by pcdoc_element_first_child()
+ *      or pcdoc_node_next_sibling().
+ *
+ * Returns: the next sibling node; the type of the node is
+ *      %PCDOC_NODE_VOID if there is no more sibling.
+ */
+PCA_EXPORT pcdoc_node
+pcdoc_node_next_sibling(purc_document_t doc, pcdoc_node node);
+
 /**
  * Get the parent element of a document node.
  *
@@ -471,6 +471,21 @@ pcrdr_conn_set_poll_timeout(pcrdr_conn* conn, int timeout_ms);
 PCA_EXPORT size_t
 pcrdr_conn_pending_requests_count(pcrdr_conn* conn);
 
+/**
+ * Check whether there are data read from the connection but not handled.
+ *
+ * @param conn: the pointer to the renderer connection.
+ *
+ * The messages coming in a batch may be read in at once, and the socket
+ * will not be readable for the rest of them.
+ *
+ * Returns: @true if there are data buffered; otherwise @false.
+ *
+ * Since: 0.8.2
+ */
+PCA_EXPORT bool
+pcrdr_conn_has_buffered_input(pcrdr_conn* conn);
+
 /**
  * Get the server host name of a connection.
  *
@@ -79,6 +79,9 @@ void purc_runloop_stop(purc_runloop_t runloop);
  *
  * @param runloop: the runloop.
  *
+ * This function can be called in any thread. It also resumes the idle
+ * function suspended by purc_runloop_suspend_idle_func().
+ *
  * Returns: void
  *
  * Since: 0.1.1
@@ -134,6 +137,24 @@ PCA_EXPORT
 void purc_runloop_set_idle_func(purc_runloop_t runloop, purc_runloop_func func,
         void *ctxt);
 
+/**
+ * Suspend the idle function of the runloop
+ *
+ * @param runloop: the runloop.
+ * @param timeout_ms: the longest time in milliseconds to suspend the idle
+ *      function; -1 means no limit.
+ *
+ * The idle function will not be called until the timeout expires or the
+ * runloop is woken up by purc_runloop_wakeup() or purc_runloop_dispatch().
+ * This function should be called in the idle function.
+ *
+ * Returns: void
+ *
+ * Since: 0.8.2
+ */
+PCA_EXPORT
+void purc_runloop_suspend_idle_func(purc_runloop_t runloop, long timeout_ms);
+
 typedef bool (*purc_runloop_io_callback)(int fd,
         purc_runloop_io_event event, void *ctxt);
 
@@ -2194,6 +2194,13 @@ struct purc_variant_stat {
     size_t sz_total_mem;
     size_t nr_reserved;
     size_t nr_max_reserved;
+
+    /* the slab allocator: the free memory cached by the instance,
+       the memory of all slab chunks, and the free memory in them which
+       is not cached by any instance. All zero if the slab is disabled. */
+    size_t sz_slab_cached;
+    size_t sz_slab_chunks;
+    size_t sz_slab_free;
 };
 
 /**
@@ -2637,6 +2644,42 @@ purc_variant_container_clone(purc_variant_t ctnr);
 PCA_EXPORT purc_variant_t
 purc_variant_container_clone_recursively(purc_variant_t ctnr);
 
+/**
+ * Freeze a variant and all its descendants.
+ *
+ * @param value: the variant to freeze
+ *
+ * A frozen variant can not be changed any more, and its reference count is
+ * changed atomically. So it can be shared by instances running in different
+ * threads: moving it in a message neither traverses nor copies it.
+ *
+ * The variant is frozen in place; a descendant container also referred
+ * elsewhere is replaced by its deep clone, so the other holders keep
+ * a mutable one. The constants (undefined, null, true, and false) are left
+ * as they are. Call purc_variant_container_clone() to get a mutable copy
+ * of a frozen container.
+ *
+ * Returns: @true on success, otherwise @false, and the error code is set to
+ *  - PURC_ERROR_NOT_SUPPORTED: there is a dynamic or native variant;
+ *  - PURC_ERROR_ACCESS_DENIED: a container to freeze has listeners.
+ *
+ * Since: 0.2.0
+ */
+PCA_EXPORT bool
+purc_variant_freeze(purc_variant_t value);
+
+/**
+ * Check whether a variant is frozen.
+ *
+ * @param value: the variant to check
+ *
+ * Returns: @true if the variant has been frozen by purc_variant_freeze().
+ *
+ * Since: 0.2.0
+ */
+PCA_EXPORT bool
+purc_variant_is_frozen(purc_variant_t value);
+
 struct purc_ejson_parse_tree;
 
 /**
@@ -222,6 +222,7 @@ struct pcmodule _module_errmsg = {
     .init_instance   = NULL,
 };
 
+extern struct pcmodule _module_slab;
 extern struct pcmodule _module_atom;
 extern struct pcmodule _module_keywords;
 extern struct pcmodule _module_runloop;
@@ -241,6 +242,9 @@ extern struct pcmodule _module_fetcher_remote;
 extern struct pcmodule _module_renderer;
 
 struct pcmodule* _pc_modules[] = {
+    // the slab module shall be cleaned up after all other modules
+    &_module_slab,
+
     &_module_locale,
     &_module_atom,
 
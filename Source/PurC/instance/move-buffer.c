@@ -27,6 +27,8 @@
 
 #include "purc-pcrdr.h"
 #include "purc-errors.h"
+#include "purc-runloop.h"
+#include "private/slab.h"
 
 /* this feature needs C11 (stdatomic.h) or above */
 #if HAVE(STDATOMIC_H)
@@ -56,6 +58,9 @@ struct pcinst_move_buffer {
     unsigned int        flags;
     size_t              max_nr_msgs;
     size_t              nr_msgs;
+
+    /* the runloop to wake up when a message comes, if any */
+    purc_runloop_t      runloop;
 };
 
 /* the header of the struct pcrdr_msg */
@@ -128,7 +133,9 @@ pcinst_get_message(void)
         return NULL;
     }
 
-#if HAVE(GLIB)
+#if USE(SLAB_ALLOCATOR)
+    msg = (pcrdr_msg *)pcslab_alloc0(sizeof(pcrdr_msg));
+#elif HAVE(GLIB)
     msg = (pcrdr_msg *)g_slice_alloc0(sizeof(pcrdr_msg));
 #else
     msg = (pcrdr_msg *)calloc(1, sizeof(pcrdr_msg));
@@ -168,7 +175,9 @@ pcinst_put_message(pcrdr_msg *msg)
                 purc_variant_unref(msg->variants[i]);
         }
 
-#if HAVE(GLIB)
+#if USE(SLAB_ALLOCATOR)
+        pcslab_free(msg, sizeof(pcrdr_msg));
+#elif HAVE(GLIB)
         g_slice_free1(sizeof(pcrdr_msg), (gpointer)msg);
 #else
         free(msg);
@@ -218,6 +227,7 @@ purc_inst_create_move_buffer(unsigned int flags, size_t max_msgs)
     mb->flags = flags;
     mb->nr_msgs = 0;
     mb->max_nr_msgs = (max_msgs > 0) ? max_msgs : NR_DEF_MAX_MSGS;
+    mb->runloop = inst->running_loop;
     list_head_init(&mb->msgs);
 
 done:
@@ -258,7 +268,9 @@ pcinst_grind_message(pcrdr_msg *msg)
                 purc_variant_unref(msg->variants[i]);
         }
 
-#if HAVE(GLIB)
+#if USE(SLAB_ALLOCATOR)
+        pcslab_free(msg, sizeof(pcrdr_msg));
+#elif HAVE(GLIB)
         g_slice_free1(sizeof(pcrdr_msg), (gpointer)msg);
 #else
         free(msg);
@@ -396,6 +408,7 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
         list_add_tail(&hdr->ln, &mb->msgs);
         mb->nr_msgs++;
         purc_rwlock_writer_unlock(&mb->lock);
+        purc_runloop_wakeup(mb->runloop);
 
         nr++;
     }
@@ -434,6 +447,7 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
                 list_add_tail(&hdr->ln, &mb->msgs);
                 mb->nr_msgs++;
                 purc_rwlock_writer_unlock(&mb->lock);
+                purc_runloop_wakeup(mb->runloop);
                 nr++;
             }
         }
@@ -622,7 +636,9 @@ purc_inst_destroy_move_buffer(void)
 pcrdr_msg *
 pcinst_get_message(void)
 {
-#if HAVE(GLIB)
+#if USE(SLAB_ALLOCATOR)
+    return pcslab_alloc0(sizeof(pcrdr_msg));
+#elif HAVE(GLIB)
     return g_slice_alloc0(sizeof(pcrdr_msg));
 #else
     return calloc(1, sizeof(pcrdr_msg));
@@ -632,7 +648,9 @@ pcinst_get_message(void)
 void
 pcinst_put_message(pcrdr_msg *msg)
 {
-#if HAVE(GLIB)
+#if USE(SLAB_ALLOCATOR)
+    pcslab_free(msg, sizeof(pcrdr_msg));
+#elif HAVE(GLIB)
     g_slice_free1(sizeof(pcrdr_msg), (gpointer)msg);
 #else
     free(msg);
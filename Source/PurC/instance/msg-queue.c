@@ -37,6 +37,22 @@
 
 #include <sys/time.h>
 
+#define EVENT_BUCKETS_MIN_SIZE      16
+#define EVENT_KEY_MSGS_MIN_SIZE     4
+
+/* The node of the event index: the queued events sharing the same key,
+   in the order of `event_msgs`. The events are kept in a ring buffer,
+   so that the first one can be removed in constant time. */
+struct event_key_node {
+    struct list_head    ln;
+    unsigned long       hash;
+
+    pcrdr_msg         **msgs;
+    size_t              first;
+    size_t              nr;
+    size_t              sz;
+};
+
 struct pcinst_msg_queue *
 pcinst_msg_queue_create(void)
 {
@@ -54,8 +70,14 @@ pcinst_msg_queue_create(void)
         goto done;
     }
 
+    queue->owner = pcinst_current();
     queue->state = 0;
     queue->nr_msgs = 0;
+    queue->event_buckets = NULL;
+    queue->nr_event_buckets = 0;
+    queue->nr_event_keys = 0;
+    queue->max_msgs = 0;
+    queue->nr_coalesced = 0;
     list_head_init(&queue->req_msgs);
     list_head_init(&queue->res_msgs);
     list_head_init(&queue->event_msgs);
@@ -93,12 +115,32 @@ grind_msg_list(struct list_head *msgs)
     return nr;
 }
 
+static void
+clear_event_index(struct pcinst_msg_queue *queue)
+{
+    for (size_t i = 0; i < queue->nr_event_buckets; i++) {
+        struct event_key_node *p, *n;
+        list_for_each_entry_safe(p, n, &queue->event_buckets[i], ln) {
+            list_del(&p->ln);
+            free(p->msgs);
+            free(p);
+        }
+    }
+
+    free(queue->event_buckets);
+    queue->event_buckets = NULL;
+    queue->nr_event_buckets = 0;
+    queue->nr_event_keys = 0;
+}
+
 ssize_t
 pcinst_msg_queue_destroy(struct pcinst_msg_queue *queue)
 {
     ssize_t nr = 0;
     purc_rwlock_writer_lock(&queue->lock);
 
+    clear_event_index(queue);
+
     nr += grind_msg_list(&queue->req_msgs);
     nr += grind_msg_list(&queue->res_msgs);
     nr += grind_msg_list(&queue->event_msgs);
@@ -134,18 +176,251 @@ get_timestamp_us(void)
     return (uint64_t)now.tv_sec * 1000000 + now.tv_usec;
 }
 
+static inline unsigned long
+hash_combine(unsigned long hash, unsigned long value)
+{
+    return hash ^ (value + 0x9e3779b9UL + (hash << 6) + (hash >> 2));
+}
+
+/* Must be consistent with purc_variant_is_equal_to(): the equal variants
+   have the same hash value. */
+static unsigned long
+hash_variant(purc_variant_t v)
+{
+    const unsigned char *bytes;
+    size_t len;
+
+    if (v == PURC_VARIANT_INVALID)
+        return 0;
+
+    unsigned long hash = v->type + 1;
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_BOOLEAN:
+        return hash_combine(hash, v->b);
+
+    case PURC_VARIANT_TYPE_EXCEPTION:
+        return hash_combine(hash, v->atom);
+
+    case PURC_VARIANT_TYPE_LONGINT:
+        return hash_combine(hash, (unsigned long)v->i64);
+
+    case PURC_VARIANT_TYPE_ULONGINT:
+        return hash_combine(hash, (unsigned long)v->u64);
+
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+        bytes = (const unsigned char *)purc_atom_to_string(v->atom);
+        len = strlen((const char *)bytes);
+        return hash_combine(hash, pcutils_hash_hash(bytes, len));
+
+    case PURC_VARIANT_TYPE_STRING:
+    case PURC_VARIANT_TYPE_BSEQUENCE:
+        if (v->flags & (PCVARIANT_FLAG_STRING_STATIC |
+                    PCVARIANT_FLAG_EXTRA_SIZE)) {
+            bytes = (const unsigned char *)v->sz_ptr[1];
+            len = v->sz_ptr[0];
+        }
+        else {
+            bytes = v->bytes;
+            len = v->size;
+        }
+        return hash_combine(hash, pcutils_hash_hash(bytes, len));
+
+    case PURC_VARIANT_TYPE_DYNAMIC:
+    case PURC_VARIANT_TYPE_NATIVE:
+        hash = hash_combine(hash, (unsigned long)(uintptr_t)v->ptr_ptr[0]);
+        return hash_combine(hash, (unsigned long)(uintptr_t)v->ptr_ptr[1]);
+
+    default:
+        /* numbers are compared with a tolerance, and the containers
+           by their members; only the type is hashed for them. */
+        return hash;
+    }
+}
+
+static unsigned long
+hash_event(pcrdr_msg *msg)
+{
+    unsigned long hash = msg->target;
+    hash = hash_combine(hash, (unsigned long)msg->targetValue);
+    hash = hash_combine(hash, hash_variant(msg->eventName));
+    return hash_combine(hash, hash_variant(msg->elementValue));
+}
+
+static inline struct list_head *
+event_bucket(struct pcinst_msg_queue *queue, unsigned long hash)
+{
+    return &queue->event_buckets[hash & (queue->nr_event_buckets - 1)];
+}
+
+static struct event_key_node *
+find_event_key(struct pcinst_msg_queue *queue, pcrdr_msg *msg,
+        unsigned long hash)
+{
+    if (queue->event_buckets == NULL)
+        return NULL;
+
+    struct event_key_node *node;
+    list_for_each_entry(node, event_bucket(queue, hash), ln) {
+        if (node->hash == hash &&
+                is_event_match(node->msgs[node->first], msg))
+            return node;
+    }
+
+    return NULL;
+}
+
+static int
+resize_event_buckets(struct pcinst_msg_queue *queue, size_t nr_buckets)
+{
+    struct list_head *buckets;
+    buckets = malloc(sizeof(struct list_head) * nr_buckets);
+    if (buckets == NULL)
+        return -1;
+
+    for (size_t i = 0; i < nr_buckets; i++)
+        list_head_init(&buckets[i]);
+
+    for (size_t i = 0; i < queue->nr_event_buckets; i++) {
+        struct event_key_node *p, *n;
+        list_for_each_entry_safe(p, n, &queue->event_buckets[i], ln) {
+            list_del(&p->ln);
+            list_add_tail(&p->ln, &buckets[p->hash & (nr_buckets - 1)]);
+        }
+    }
+
+    free(queue->event_buckets);
+    queue->event_buckets = buckets;
+    queue->nr_event_buckets = nr_buckets;
+    return 0;
+}
+
+static int
+event_key_push(struct event_key_node *node, pcrdr_msg *msg, bool tail)
+{
+    if (node->nr == node->sz) {
+        size_t sz = node->sz ? node->sz * 2 : EVENT_KEY_MSGS_MIN_SIZE;
+        pcrdr_msg **msgs = malloc(sizeof(pcrdr_msg *) * sz);
+        if (msgs == NULL)
+            return -1;
+
+        for (size_t i = 0; i < node->nr; i++)
+            msgs[i] = node->msgs[(node->first + i) % node->sz];
+
+        free(node->msgs);
+        node->msgs = msgs;
+        node->first = 0;
+        node->sz = sz;
+    }
+
+    if (tail) {
+        node->msgs[(node->first + node->nr) % node->sz] = msg;
+    }
+    else {
+        node->first = (node->first + node->sz - 1) % node->sz;
+        node->msgs[node->first] = msg;
+    }
+    node->nr++;
+    return 0;
+}
+
+static void
+event_key_remove(struct event_key_node *node, pcrdr_msg *msg)
+{
+    /* in most cases, the first event is removed */
+    if (node->msgs[node->first] == msg) {
+        node->first = (node->first + 1) % node->sz;
+        node->nr--;
+        return;
+    }
+
+    for (size_t i = 1; i < node->nr; i++) {
+        if (node->msgs[(node->first + i) % node->sz] == msg) {
+            for (; i + 1 < node->nr; i++) {
+                node->msgs[(node->first + i) % node->sz] =
+                    node->msgs[(node->first + i + 1) % node->sz];
+            }
+            node->nr--;
+            break;
+        }
+    }
+}
+
+/* If we are out of memory here, the event is still queued, but it will
+   not be reduced with the events coming later. */
+static void
+index_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg,
+        unsigned long hash, bool tail)
+{
+    struct event_key_node *node = find_event_key(queue, msg, hash);
+    if (node) {
+        event_key_push(node, msg, tail);
+        return;
+    }
+
+    if (queue->nr_event_keys >= queue->nr_event_buckets) {
+        size_t nr_buckets = queue->nr_event_buckets ?
+            queue->nr_event_buckets * 2 : EVENT_BUCKETS_MIN_SIZE;
+        if (resize_event_buckets(queue, nr_buckets) &&
+                queue->event_buckets == NULL)
+            return;
+    }
+
+    node = calloc(1, sizeof(*node));
+    if (node == NULL)
+        return;
+
+    node->hash = hash;
+    if (event_key_push(node, msg, tail)) {
+        free(node);
+        return;
+    }
+
+    list_add_tail(&node->ln, event_bucket(queue, hash));
+    queue->nr_event_keys++;
+}
+
+static void
+unindex_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
+{
+    struct event_key_node *node = find_event_key(queue, msg, hash_event(msg));
+    if (node == NULL)
+        return;
+
+    event_key_remove(node, msg);
+    if (node->nr == 0) {
+        list_del(&node->ln);
+        free(node->msgs);
+        free(node);
+        queue->nr_event_keys--;
+    }
+}
+
+static void
+queue_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg,
+        unsigned long hash, bool tail)
+{
+    struct pcinst_msg_hdr *hdr = (struct pcinst_msg_hdr *)msg;
+    if (tail) {
+        list_add_tail(&hdr->ln, &queue->event_msgs);
+    }
+    else {
+        list_add(&hdr->ln, &queue->event_msgs);
+    }
+    index_event(queue, msg, hash, tail);
+    queue->state |= MSG_QS_EVENT;
+    queue->nr_msgs++;
+}
+
 int
 reduce_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, bool tail)
 {
-    struct pcinst_msg_hdr *hdr;
-    struct list_head *p, *n;
-    list_for_each_safe(p, n, &queue->event_msgs) {
-        hdr = list_entry(p, struct pcinst_msg_hdr, ln);
-        pcrdr_msg *orig = (pcrdr_msg*) hdr;
-        if (is_event_match(orig, msg)) {
-            if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE) {
-                return 0;
-            }
+    unsigned long hash = hash_event(msg);
+    struct event_key_node *node = find_event_key(queue, msg, hash);
+    if (node) {
+        pcrdr_msg *orig = node->msgs[node->first];
+        queue->nr_coalesced++;
+
+        if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY) {
             // OVERLAY : data
             if (orig->data) {
                 purc_variant_unref(orig->data);
@@ -155,22 +430,15 @@ reduce_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, bool tail)
                 orig->data = msg->data;
                 purc_variant_ref(orig->data);
             }
-            return 0;
         }
+
+        pcrdr_release_message(msg);
+        return 0;
     }
 
-    hdr = (struct pcinst_msg_hdr *)msg;
     /* keep timestamp */
     msg->resultValue = get_timestamp_us();
-    if (tail) {
-        list_add_tail(&hdr->ln, &queue->event_msgs);
-    }
-    else {
-        list_add(&hdr->ln, &queue->event_msgs);
-    }
-    queue->state |= MSG_QS_EVENT;
-    queue->nr_msgs++;
-
+    queue_event(queue, msg, hash, tail);
     return 0;
 }
 
@@ -205,9 +473,7 @@ pcinst_msg_queue_append(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
         if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_KEEP) {
             /* keep timestamp */
             msg->resultValue = get_timestamp_us();
-            list_add_tail(&hdr->ln, &queue->event_msgs);
-            queue->state |= MSG_QS_EVENT;
-            queue->nr_msgs++;
+            queue_event(queue, msg, hash_event(msg), true);
         }
         else {
             reduce_event(queue, msg, true);
@@ -221,7 +487,11 @@ pcinst_msg_queue_append(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
         break;
     }
 
+    if (queue->nr_msgs > queue->max_msgs)
+        queue->max_msgs = queue->nr_msgs;
+
     purc_rwlock_writer_unlock(&queue->lock);
+    pcintr_wakeup_scheduler(queue->owner);
     return 0;
 }
 
@@ -254,9 +524,7 @@ pcinst_msg_queue_prepend(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
     case PCRDR_MSG_TYPE_EVENT:
         queue->state |= MSG_QS_EVENT;
         if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_KEEP) {
-            list_add(&hdr->ln, &queue->event_msgs);
-            queue->state |= MSG_QS_EVENT;
-            queue->nr_msgs++;
+            queue_event(queue, msg, hash_event(msg), false);
         }
         else {
             reduce_event(queue, msg, false);
@@ -270,7 +538,11 @@ pcinst_msg_queue_prepend(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
         break;
     }
 
+    if (queue->nr_msgs > queue->max_msgs)
+        queue->max_msgs = queue->nr_msgs;
+
     purc_rwlock_writer_unlock(&queue->lock);
+    pcintr_wakeup_scheduler(queue->owner);
     return 0;
 }
 
@@ -313,6 +585,7 @@ pcinst_msg_queue_get_msg(struct pcinst_msg_queue *queue)
     if (queue->state & MSG_QS_EVENT) {
         msg = get_msg(queue, &queue->event_msgs);
         if (msg) {
+            unindex_event(queue, msg);
             goto done;
         }
     }
@@ -348,6 +621,8 @@ pcinst_msg_queue_get_event_by_element(struct pcinst_msg_queue *queue,
                 purc_variant_is_equal_to(m->eventName, event_name)) {
             msg = m;
             list_del(&hdr->ln);
+            unindex_event(queue, msg);
+            queue->nr_msgs--;
             break;
         }
     }
@@ -380,6 +655,7 @@ purc_inst_post_event(purc_atom_t inst_to, pcrdr_msg *msg)
             list_for_each_entry_safe(p, q, crtns, ln) {
                 pcintr_coroutine_t co = p;
                 if (co->cid == msg->targetValue) {
+                    pcintr_coroutine_add_pending(co);
                     return pcinst_msg_queue_append(co->mq, msg);
                 }
             }
@@ -388,6 +664,7 @@ purc_inst_post_event(purc_atom_t inst_to, pcrdr_msg *msg)
             list_for_each_entry_safe(p, q, crtns, ln) {
                 pcintr_coroutine_t co = p;
                 if (co->cid == msg->targetValue) {
+                    pcintr_coroutine_add_pending(co);
                     return pcinst_msg_queue_append(co->mq, msg);
                 }
             }
@@ -399,6 +676,7 @@ purc_inst_post_event(purc_atom_t inst_to, pcrdr_msg *msg)
                 pcrdr_msg *my_msg = pcrdr_clone_message(msg);
                 my_msg->targetValue = co->cid;
                 pcinst_msg_queue_append(co->mq, my_msg);
+                pcintr_coroutine_add_pending(co);
             }
 
             crtns = &heap->stopped_crtns;
@@ -407,6 +685,7 @@ purc_inst_post_event(purc_atom_t inst_to, pcrdr_msg *msg)
                 pcrdr_msg *my_msg = pcrdr_clone_message(msg);
                 my_msg->targetValue = co->cid;
                 pcinst_msg_queue_append(co->mq, my_msg);
+                pcintr_coroutine_add_pending(co);
             }
             pcrdr_release_message(msg);
         }
@@ -498,3 +777,15 @@ pcinst_msg_queue_count(struct pcinst_msg_queue *queue)
     return nr;
 }
 
+
+void
+pcinst_msg_queue_get_stats(struct pcinst_msg_queue *queue,
+        struct pcinst_msg_queue_stats *stats)
+{
+    purc_rwlock_reader_lock(&queue->lock);
+    stats->nr_msgs = queue->nr_msgs;
+    stats->nr_event_keys = queue->nr_event_keys;
+    stats->max_msgs = queue->max_msgs;
+    stats->nr_coalesced = queue->nr_coalesced;
+    purc_rwlock_reader_unlock(&queue->lock);
+}
@@ -180,7 +180,7 @@ first_iterate_without_executor(pcintr_coroutine_t co,
     if (!ctxt->on_attr) {
         purc_variant_t val;
         if (ctxt->with_attr) {
-            val = pcintr_eval_vcm(&co->stack, ctxt->with_attr->val,
+            val = pcintr_eval_vdom_attr(&co->stack, ctxt->with_attr,
                     frame->silently);
             set_attr_val(&co->stack, frame, ctxt->with_attr_idx, val);
         }
@@ -224,7 +224,7 @@ rerun_iterate_without_executor(pcintr_coroutine_t co,
     if (!ctxt->on_attr) {
         purc_variant_t val;
         if (ctxt->with_attr) {
-            val = pcintr_eval_vcm(&co->stack, ctxt->with_attr->val,
+            val = pcintr_eval_vdom_attr(&co->stack, ctxt->with_attr,
                     frame->silently);
             set_attr_val(&co->stack, frame, ctxt->with_attr_idx, val);
         }
@@ -659,7 +659,7 @@ before_first_iterate(pcintr_stack_t stack, struct pcintr_stack_frame *frame,
                     break;
                 }
 
-                val = pcintr_eval_vcm(stack, ctxt->on_attr->val,
+                val = pcintr_eval_vdom_attr(stack, ctxt->on_attr,
                         frame->silently);
                 set_attr_val(stack, frame, ctxt->on_attr_idx, val);
                 if (!val) {
@@ -685,7 +685,7 @@ before_first_iterate(pcintr_stack_t stack, struct pcintr_stack_frame *frame,
                     ctxt->before_first_iterate_step = FUNC_STEP_3RD;
                     break;
                 }
-                val = pcintr_eval_vcm(stack, ctxt->in_attr->val,
+                val = pcintr_eval_vdom_attr(stack, ctxt->in_attr,
                         frame->silently);
                 set_attr_val(stack, frame, ctxt->in_attr_idx, val);
                 if (!val) {
@@ -731,7 +731,7 @@ before_first_iterate(pcintr_stack_t stack, struct pcintr_stack_frame *frame,
                 if (ctxt->by_rule) {
                     purc_variant_t with;
                     if (ctxt->with_attr) {
-                        with = pcintr_eval_vcm(stack, ctxt->with_attr->val,
+                        with = pcintr_eval_vdom_attr(stack, ctxt->with_attr,
                                 frame->silently);
                         set_attr_val(stack, frame, ctxt->with_attr_idx, val);
                     }
@@ -752,7 +752,7 @@ before_first_iterate(pcintr_stack_t stack, struct pcintr_stack_frame *frame,
             case FUNC_STEP_4TH:
                 if (ctxt->by_rule) {
                     if (ctxt->rule_attr) {
-                        val = pcintr_eval_vcm(stack, ctxt->rule_attr->val,
+                        val = pcintr_eval_vdom_attr(stack, ctxt->rule_attr,
                                 frame->silently);
                         set_attr_val(stack, frame, ctxt->rule_attr_idx, val);
                     }
@@ -800,7 +800,7 @@ before_iterate(pcintr_stack_t stack, struct pcintr_stack_frame *frame,
         return 0;
     }
 
-    purc_variant_t val = pcintr_eval_vcm(stack, ctxt->onlyif_attr->val,
+    purc_variant_t val = pcintr_eval_vdom_attr(stack, ctxt->onlyif_attr,
             frame->silently);
     set_attr_val(stack, frame, ctxt->onlyif_attr_idx, val);
     if (!val) {
@@ -923,9 +923,9 @@ eval_attr(pcintr_stack_t stack, struct pcintr_stack_frame *frame)
 
     for (; frame->eval_attr_pos < nr_params; frame->eval_attr_pos++) {
         attr = pcutils_array_get(attrs, frame->eval_attr_pos);
-        name = PCHVML_KEYWORD_ATOM(HVML, attr->key);
+        name = pcvdom_attr_get_keyword(attr);
         if (strcmp(attr->key, ATTR_NAME_ID) == 0) {
-            val = pcintr_eval_vcm(stack, attr->val, frame->silently);
+            val = pcintr_eval_vdom_attr(stack, attr, frame->silently);
             set_attr_val(stack, frame, frame->eval_attr_pos, val);
             if (!val) {
                 goto out;
@@ -1076,7 +1076,7 @@ on_popping_internal_rule(struct ctxt_for_iterate *ctxt, pcintr_stack_t stack,
 
     purc_variant_t val;
     if (ctxt->rule_attr) {
-        val = pcintr_eval_vcm(stack, ctxt->rule_attr->val, frame->silently);
+        val = pcintr_eval_vdom_attr(stack, ctxt->rule_attr, frame->silently);
         set_attr_val(stack, frame, ctxt->rule_attr_idx, val);
     }
     else {
@@ -1193,7 +1193,7 @@ after_iterate_without_executor(pcintr_stack_t stack,
 
             purc_variant_t val;
             if (ctxt->with_attr) {
-                val = pcintr_eval_vcm(stack, ctxt->with_attr->val,
+                val = pcintr_eval_vdom_attr(stack, ctxt->with_attr,
                         frame->silently);
                 set_attr_val(stack, frame, ctxt->with_attr_idx, val);
             }
@@ -1217,8 +1217,8 @@ after_iterate_without_executor(pcintr_stack_t stack,
             break;
         case FUNC_STEP_2ND:
             if (ctxt->while_attr) {
-                purc_variant_t val = pcintr_eval_vcm(stack,
-                        ctxt->while_attr->val, frame->silently);
+                purc_variant_t val = pcintr_eval_vdom_attr(stack,
+                        ctxt->while_attr, frame->silently);
                 set_attr_val(stack, frame, ctxt->while_attr_idx, val);
 
                 if (!val) {
@@ -40,6 +40,7 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <errno.h>
+#include <ctype.h>
 
 struct sort_key {
     char *key;
@@ -400,6 +401,165 @@ sort_cmp(purc_variant_t l, purc_variant_t r, void *data)
     return 0;
 }
 
+/* The keys of a member are computed once before sorting, so that comparing
+ * two members neither looks up the keys nor allocates any memory. */
+struct sort_val {
+    double          number;
+    const char     *str;        // NULL if not available
+    char           *buf;        // the buffer owned by str, if any
+};
+
+struct sort_vals {
+    struct ctxt_for_sort         *ctxt;
+    size_t                        nr_keys;
+    size_t                        nr_vals;
+    struct sort_val              *vals;  // nr_keys values for each member
+};
+
+static void
+sort_vals_release(struct sort_vals *sv)
+{
+    if (sv->vals) {
+        for (size_t i = 0; i < sv->nr_vals; i++) {
+            free(sv->vals[i].buf);
+        }
+        free(sv->vals);
+        sv->vals = NULL;
+    }
+}
+
+static int
+sort_val_init(struct sort_val *sval, purc_variant_t v, bool by_number,
+        bool casesensitively)
+{
+    if (by_number) {
+        sval->number = v ? purc_variant_numberify(v) : 0.0f;
+        return 0;
+    }
+
+    if (!v) {
+        return 0;
+    }
+
+    enum purc_variant_type type = purc_variant_get_type(v);
+    if (type == PURC_VARIANT_TYPE_STRING ||
+            type == PURC_VARIANT_TYPE_ATOMSTRING ||
+            type == PURC_VARIANT_TYPE_EXCEPTION) {
+        /* borrow the string which is what stringifying it gives */
+        sval->str = purc_variant_get_string_const(v);
+    }
+    else {
+        sval->buf = variant_to_string(v);
+        sval->str = sval->buf;
+    }
+
+    if (sval->str && !casesensitively) {
+        /* fold once; comparing the folded keys equals to strcasecmp() */
+        if (!sval->buf) {
+            sval->buf = strdup(sval->str);
+            if (!sval->buf) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return -1;
+            }
+            sval->str = sval->buf;
+        }
+        for (char *p = sval->buf; *p; p++) {
+            *p = tolower((unsigned char)*p);
+        }
+    }
+
+    return 0;
+}
+
+static int
+sort_vals_init(struct sort_vals *sv, struct ctxt_for_sort *ctxt,
+        purc_variant_t container, size_t nr)
+{
+    bool is_set = purc_variant_is_set(container);
+    size_t nr_keys = pcutils_arrlist_length(ctxt->keys);
+
+    sv->ctxt = ctxt;
+    sv->nr_keys = nr_keys;
+    sv->nr_vals = nr * nr_keys;
+    sv->vals = (struct sort_val*)calloc(sv->nr_vals ? sv->nr_vals : 1,
+            sizeof(*sv->vals));
+    if (sv->vals == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t val = is_set ?
+            purc_variant_set_get_by_index(container, i) :
+            purc_variant_array_get(container, i);
+        for (size_t j = 0; j < nr_keys; j++) {
+            struct sort_key *key = pcutils_arrlist_get_idx(ctxt->keys, j);
+            purc_variant_t v = val;
+            if (key->key) {
+                v = PURC_VARIANT_INVALID;
+                if (purc_variant_is_object(val)) {
+                    v = purc_variant_object_get_by_ckey(val, key->key);
+                    purc_clr_error();
+                }
+            }
+
+            if (sort_val_init(sv->vals + i * nr_keys + j, v, key->by_number,
+                        ctxt->casesensitively)) {
+                sort_vals_release(sv);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int
+sort_cmp_by_pos(size_t l, size_t r, void *data)
+{
+    struct sort_vals *sv = data;
+    struct ctxt_for_sort *ctxt = sv->ctxt;
+    const struct sort_val *lv = sv->vals + l * sv->nr_keys;
+    const struct sort_val *rv = sv->vals + r * sv->nr_keys;
+    for (size_t i = 0; i < sv->nr_keys; i++) {
+        struct sort_key *key = pcutils_arrlist_get_idx(ctxt->keys, i);
+        int ret;
+        if (key->by_number) {
+            ret = comp_number(lv[i].number, rv[i].number, ctxt->ascendingly);
+        }
+        else {
+            /* the keys have been folded for caseless order */
+            ret = comp_string(lv[i].str, rv[i].str, ctxt->ascendingly, true);
+        }
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    return 0;
+}
+
+static void
+sort_container(struct ctxt_for_sort *ctxt, purc_variant_t container,
+        size_t nr)
+{
+    struct sort_vals sv;
+    if (sort_vals_init(&sv, ctxt, container, nr)) {
+        /* fall back to computing the keys on every comparison */
+        purc_clr_error();
+        if (purc_variant_is_set(container))
+            pcvariant_set_sort(container, ctxt, sort_cmp);
+        else
+            pcvariant_array_sort(container, ctxt, sort_cmp);
+        return;
+    }
+
+    if (purc_variant_is_set(container))
+        pcvariant_set_sort_by_pos(container, &sv, sort_cmp_by_pos);
+    else
+        pcvariant_array_sort_by_pos(container, &sv, sort_cmp_by_pos);
+    sort_vals_release(&sv);
+}
+
 static bool
 sort_as_number(purc_variant_t val)
 {
@@ -466,7 +626,7 @@ sort_array(struct ctxt_for_sort *ctxt, purc_variant_t array,
             }
         }
     }
-    pcvariant_array_sort(array, ctxt, sort_cmp);
+    sort_container(ctxt, array, nr);
 }
 
 
@@ -519,7 +679,7 @@ sort_set(struct ctxt_for_sort *ctxt, purc_variant_t set, purc_variant_t against)
             }
         }
     }
-    pcvariant_set_sort(set, ctxt, sort_cmp);
+    sort_container(ctxt, set, nr);
 }
 
 static int
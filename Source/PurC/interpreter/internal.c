@@ -495,8 +495,9 @@ pcintr_coroutine_dump(pcintr_coroutine_t co)
     return 0;
 }
 
-purc_variant_t
-pcintr_eval_vcm(pcintr_stack_t stack, struct pcvcm_node *node, bool silently)
+static purc_variant_t
+eval_vcm(pcintr_stack_t stack, struct pcvcm_node *node,
+        struct pcvcm_code *code, bool silently)
 {
     int err = 0;
     purc_variant_t val = PURC_VARIANT_INVALID;
@@ -508,6 +509,9 @@ pcintr_eval_vcm(pcintr_stack_t stack, struct pcvcm_node *node, bool silently)
                 stack->timeout);
         stack->timeout = false;
     }
+    else if (code) {
+        val = pcvcm_eval_code(code, stack, silently);
+    }
     else {
         val = pcvcm_eval(node, stack, silently);
     }
@@ -530,3 +534,17 @@ out:
     return val;
 }
 
+purc_variant_t
+pcintr_eval_vcm(pcintr_stack_t stack, struct pcvcm_node *node, bool silently)
+{
+    return eval_vcm(stack, node, NULL, silently);
+}
+
+purc_variant_t
+pcintr_eval_vdom_attr(pcintr_stack_t stack, struct pcvdom_attr *attr,
+        bool silently)
+{
+    return eval_vcm(stack, attr->val, pcvdom_attr_get_vcm_code(attr),
+            silently);
+}
+
@@ -298,6 +298,10 @@ pcintr_rdr_send_dom_req_raw(pcintr_stack_t stack, pcdoc_operation op,
         pcdoc_element_t element, const char* property,
         pcrdr_msg_data_type data_type, const char *data, size_t len);
 
+/* Unless PURC_ENVV_RDR_PIPELINE is set to 0 or false, the DOM requests
+   sent by the simple functions below are pipelined and the responses are
+   checked asynchronously, so the functions only tell whether the request
+   was sent. */
 bool
 pcintr_rdr_send_dom_req_simple(pcintr_stack_t stack, pcdoc_operation op,
         pcdoc_element_t element, const char* property,
@@ -471,6 +475,11 @@ pcintr_walk_attrs(struct pcintr_stack_frame *frame,
 purc_variant_t
 pcintr_eval_vcm(pcintr_stack_t stack, struct pcvcm_node *node, bool silently);
 
+/* like pcintr_eval_vcm(), evaluating the compiled code cached on the attr */
+purc_variant_t
+pcintr_eval_vdom_attr(pcintr_stack_t stack, struct pcvdom_attr *attr,
+        bool silently);
+
 PCA_EXTERN_C_END
 
 #endif  /* PURC_INTERPRETER_INTERNAL_H */
@@ -63,12 +63,70 @@
 #define BUFF_MIN            1024
 #define BUFF_MAX            1024 * 1024 * 4
 
+static bool
+temp_vars_handler(purc_variant_t source, pcvar_op_t msg_type,
+        void* ctxt, size_t nr_args, purc_variant_t* argv)
+{
+    UNUSED_PARAM(source);
+    UNUSED_PARAM(msg_type);
+    UNUSED_PARAM(ctxt);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+
+    pcintr_invalidate_var_caches();
+    return true;
+}
+
+static void
+watch_temp_vars(struct pcintr_stack_frame *frame)
+{
+    purc_variant_t temp_vars = frame->symbol_vars[PURC_SYMBOL_VAR_EXCLAMATION];
+    if (temp_vars == PURC_VARIANT_INVALID ||
+            !purc_variant_is_object(temp_vars))
+        return;
+
+    int op = PCVAR_OPERATION_GROW | PCVAR_OPERATION_SHRINK |
+        PCVAR_OPERATION_CHANGE;
+    frame->temp_vars_listener = purc_variant_register_post_listener(
+            temp_vars, (pcvar_op_t)op, temp_vars_handler, NULL);
+
+    if (purc_variant_object_get_size(temp_vars) > 0) {
+        pcintr_invalidate_var_caches();
+    }
+}
+
+static void
+unwatch_temp_vars(struct pcintr_stack_frame *frame)
+{
+    purc_variant_t temp_vars = frame->symbol_vars[PURC_SYMBOL_VAR_EXCLAMATION];
+    if (frame->temp_vars_listener) {
+        purc_variant_revoke_listener(temp_vars, frame->temp_vars_listener);
+        frame->temp_vars_listener = NULL;
+    }
+
+    /* the variables bound in the frame go away with it */
+    if (temp_vars != PURC_VARIANT_INVALID &&
+            purc_variant_is_object(temp_vars) &&
+            purc_variant_object_get_size(temp_vars) > 0) {
+        pcintr_invalidate_var_caches();
+    }
+}
+
+static uint64_t
+next_frame_serial(void)
+{
+    struct pcintr_heap *heap = pcintr_get_heap();
+    return heap ? ++heap->frame_serial : 0;
+}
+
 static void
 stack_frame_release(struct pcintr_stack_frame *frame)
 {
     if (!frame)
         return;
 
+    unwatch_temp_vars(frame);
+
     frame->scope = NULL;
     frame->edom_element = NULL;
     frame->pos   = NULL;
@@ -389,6 +447,13 @@ coroutine_release(pcintr_coroutine_t co)
         struct pcintr_heap *heap = pcintr_get_heap();
         PC_ASSERT(heap && co->owner == heap);
 
+        list_del_init(&co->ln_ready);
+        list_del_init(&co->ln_pending);
+        if (co->stack.observe_idle) {
+            co->stack.observe_idle = 0;
+            heap->nr_idle_observers--;
+        }
+
         stack_release(&co->stack);
         pcvdom_document_unref(co->vdom);
 
@@ -504,7 +569,7 @@ static void _cleanup_instance(struct pcinst* inst)
         coroutine_destroy(pco);
     }
 
-    pcutils_sorted_array_destroy(heap->wait_timeout_crtns);
+    free(heap->timeout_crtns);
 
     if (heap->move_buff) {
         size_t n = purc_inst_destroy_move_buffer();
@@ -517,6 +582,12 @@ static void _cleanup_instance(struct pcinst* inst)
         heap->event_timer = NULL;
     }
 
+    if (heap->rdr_fd_monitor) {
+        purc_runloop_remove_fd_monitor(inst->running_loop,
+                heap->rdr_fd_monitor);
+        heap->rdr_fd_monitor = 0;
+    }
+
     if (heap->name_chan_map) {
         pcutils_map_destroy(heap->name_chan_map);
         heap->name_chan_map = NULL;
@@ -543,6 +614,8 @@ static int _init_instance(struct pcinst* inst,
     if (!heap)
         return PURC_ERROR_OUT_OF_MEMORY;
 
+    // the move buffer wakes up the runloop when a message comes
+    inst->running_loop = purc_runloop_get_current();
     heap->move_buff = purc_inst_create_move_buffer(
             PCINST_MOVE_BUFFER_BROADCAST, PCINTR_MOVE_BUFFER_SIZE);
     if (!heap->move_buff) {
@@ -555,16 +628,16 @@ static int _init_instance(struct pcinst* inst,
         return purc_get_last_error();
     }
 
-    inst->running_loop = purc_runloop_get_current();
     inst->intr_heap = heap;
     heap->owner     = inst;
 
     heap->running_coroutine = NULL;
+    heap->rdr_fd = -1;
 
     list_head_init(&heap->crtns);
     list_head_init(&heap->stopped_crtns);
-    heap->wait_timeout_crtns = pcutils_sorted_array_create(
-            SAFLAG_ORDER_ASC | SAFLAG_DUPLCATE_SORTV, 0, NULL, NULL);
+    list_head_init(&heap->ready_crtns);
+    list_head_init(&heap->pending_crtns);
 
     heap->name_chan_map =
         pcutils_map_create(NULL, NULL, NULL,
@@ -578,8 +651,8 @@ static int _init_instance(struct pcinst* inst,
         return PURC_ERROR_OUT_OF_MEMORY;
     }
 
+    // started when an expression variable is observed
     pcintr_timer_set_interval(heap->event_timer, EVENT_TIMER_INTRVAL);
-    pcintr_timer_start(heap->event_timer);
 
     return 0;
 }
@@ -870,6 +943,7 @@ stack_frame_pseudo_create(pcintr_stack_t stack)
 
     struct pcintr_stack_frame *frame = &frame_pseudo->frame;
     frame->type = STACK_FRAME_TYPE_PSEUDO;
+    frame->serial = next_frame_serial();
 
     if (init_stack_frame_pseudo(stack, frame_pseudo))
         goto fail_init;
@@ -974,6 +1048,7 @@ stack_frame_normal_create(pcintr_stack_t stack)
 
     struct pcintr_stack_frame *frame = &frame_normal->frame;
     frame->type = STACK_FRAME_TYPE_NORMAL;
+    frame->serial = next_frame_serial();
 
     if (init_stack_frame_normal(stack, frame_normal))
         goto fail_init;
@@ -1076,7 +1151,7 @@ walk_attr(void *key, void *val, void *ud)
     struct pcvdom_element *element = data->element;
     PC_ASSERT(element);
 
-    purc_atom_t atom = PCHVML_KEYWORD_ATOM(HVML, attr->key);
+    purc_atom_t atom = pcvdom_attr_get_keyword(attr);
     // NOTE: we only dispatch those keyworded-attr to caller
     return data->cb(frame, element, atom, attr, data->ud);
 }
@@ -1785,6 +1860,8 @@ coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
     list_head_init(&co->ln_stopped);
     list_head_init(&co->registered_cancels);
     list_head_init(&co->tasks);
+    list_head_init(&co->ln_ready);
+    list_head_init(&co->ln_pending);
 
     co->mq = pcinst_msg_queue_create();
     if (!co->mq) {
@@ -1803,6 +1880,7 @@ coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
     co->loaded_vars = RB_ROOT;
 
     list_add_tail(&co->ln, &heap->crtns);
+    pcintr_coroutine_state_changed(co);
 
     stack_init(stack);
     pcintr_coroutine_add_sub_exit_observer(co);
@@ -2630,8 +2708,14 @@ pcintr_set_symbol_var(struct pcintr_stack_frame *frame,
     PC_ASSERT(val != PURC_VARIANT_INVALID);
 
     purc_variant_ref(val);
+    if (symbol == PURC_SYMBOL_VAR_EXCLAMATION) {
+        unwatch_temp_vars(frame);
+    }
     PURC_VARIANT_SAFE_CLEAR(frame->symbol_vars[symbol]);
     frame->symbol_vars[symbol] = val;
+    if (symbol == PURC_SYMBOL_VAR_EXCLAMATION) {
+        watch_temp_vars(frame);
+    }
 
     return 0;
 }
@@ -3211,6 +3295,9 @@ pcintr_coroutine_set_state_with_location(pcintr_coroutine_t co,
     UNUSED_PARAM(line);
     UNUSED_PARAM(func);
     co->state = state;
+    if (co->owner) {
+        pcintr_coroutine_state_changed(co);
+    }
 }
 
 pcdoc_element_t
@@ -3388,7 +3475,9 @@ pcintr_stack_frame_eval_attr_and_content(pcintr_stack_t stack,
                     stack->timeout = false;
                 }
                 else {
-                    val = pcvcm_eval(attr->val, stack, frame->silently);
+                    struct pcvcm_code *code = pcvdom_attr_get_vcm_code(attr);
+                    val = code ? pcvcm_eval_code(code, stack, frame->silently) :
+                        pcvcm_eval(attr->val, stack, frame->silently);
                 }
                 ret = purc_get_last_error();
                 if (!val) {
@@ -3488,7 +3577,7 @@ pcintr_walk_attrs(struct pcintr_stack_frame *frame,
     for (size_t i = 0; i < nr; i++) {
         struct pcvdom_attr *attr = pcutils_array_get(element->attrs, i);
         purc_variant_t val = pcutils_array_get(frame->attrs_result, i);
-        purc_atom_t name = PCHVML_KEYWORD_ATOM(HVML, attr->key);
+        purc_atom_t name = pcvdom_attr_get_keyword(attr);
         int r = cb(frame, element, name, val, attr, ud);
         if (r) {
             return r;
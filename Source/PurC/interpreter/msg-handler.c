@@ -309,6 +309,7 @@ dispatch_move_buffer_event(struct pcinst *inst, const pcrdr_msg *msg)
         list_for_each_entry_safe(p, q, crtns, ln) {
             pcintr_coroutine_t co = p;
             if (co->cid == msg->targetValue) {
+                pcintr_coroutine_add_pending(co);
                 return pcinst_msg_queue_append(co->mq, msg_clone);
             }
         }
@@ -317,6 +318,7 @@ dispatch_move_buffer_event(struct pcinst *inst, const pcrdr_msg *msg)
         list_for_each_entry_safe(p, q, crtns, ln) {
             pcintr_coroutine_t co = p;
             if (co->cid == msg->targetValue) {
+                pcintr_coroutine_add_pending(co);
                 return pcinst_msg_queue_append(co->mq, msg_clone);
             }
         }
@@ -328,6 +330,7 @@ dispatch_move_buffer_event(struct pcinst *inst, const pcrdr_msg *msg)
             pcrdr_msg *my_msg = pcrdr_clone_message(msg_clone);
             my_msg->targetValue = co->cid;
             pcinst_msg_queue_append(co->mq, my_msg);
+            pcintr_coroutine_add_pending(co);
         }
 
         crtns = &heap->stopped_crtns;
@@ -336,6 +339,7 @@ dispatch_move_buffer_event(struct pcinst *inst, const pcrdr_msg *msg)
             pcrdr_msg *my_msg = pcrdr_clone_message(msg_clone);
             my_msg->targetValue = co->cid;
             pcinst_msg_queue_append(co->mq, my_msg);
+            pcintr_coroutine_add_pending(co);
         }
         pcrdr_release_message(msg_clone);
     }
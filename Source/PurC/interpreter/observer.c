@@ -168,9 +168,19 @@ observer_handle_default(pcintr_coroutine_t co, struct pcintr_observer *p,
     }
 
     list_add_tail(&task->ln, &co->tasks);
+    pcintr_coroutine_add_pending(co);
     return 0;
 }
 
+static bool
+is_vcm_ev(purc_variant_t observed)
+{
+    struct purc_native_ops *ops = purc_variant_is_native(observed) ?
+        purc_variant_native_get_ops(observed) : NULL;
+    return ops && ops->property_getter &&
+        ops->property_getter(PCVCM_EV_PROPERTY_VCM_EV);
+}
+
 static uint64_t
 get_timestamp_us(void)
 {
@@ -237,8 +247,17 @@ pcintr_register_observer(pcintr_stack_t  stack,
     // observe idle
     purc_variant_t hvml = pcintr_get_coroutine_variable(stack->co,
             BUILTIN_VAR_CRTN);
-    if (observed == hvml) {
+    if (observed == hvml && !stack->observe_idle) {
         stack->observe_idle = 1;
+        stack->co->owner->nr_idle_observers++;
+    }
+
+    // the event timer of the heap checks the observed expression variables
+    if (source == OBSERVER_SOURCE_HVML && is_vcm_ev(observed)) {
+        pcintr_heap_t heap = stack->co->owner;
+        if (!pcintr_timer_is_active(heap->event_timer)) {
+            pcintr_timer_start(heap->event_timer);
+        }
     }
 
     return observer;
@@ -304,8 +323,9 @@ pcintr_revoke_observer(struct pcintr_observer* observer)
     // observe idle
     purc_variant_t hvml = pcintr_get_coroutine_variable(stack->co,
             BUILTIN_VAR_CRTN);
-    if (observer->observed == hvml) {
+    if (observer->observed == hvml && stack->observe_idle) {
         stack->observe_idle = 0;
+        stack->co->owner->nr_idle_observers--;
     }
 
     free_observer(observer);
@@ -1041,29 +1041,24 @@ static const char *rdr_ops[] = {
     "",     // unknown
 };
 
-pcrdr_msg *
-pcintr_rdr_send_dom_req(pcintr_stack_t stack, pcdoc_operation op,
-        pcdoc_element_t element, const char* property,
-        pcrdr_msg_data_type data_type, purc_variant_t data)
+/* Check the page of the coroutine, which may be inherited from the curator,
+   and whether the coroutine is allowed to update the DOM in the renderer. */
+static bool
+is_dom_target_ready(pcintr_coroutine_t co)
 {
-    if (!stack) {
-        return NULL;
-    }
-
-    pcintr_coroutine_t co = stack->co;
     if (co->target_page_handle == 0 || co->target_dom_handle == 0) {
         if (!co->stack.inherit) {
-            return NULL;
+            return false;
         }
 
         pcintr_coroutine_t parent = pcintr_coroutine_get_by_id(co->curator);
         if (!parent || parent->stack.doc != co->stack.doc) {
-            return NULL;
+            return false;
         }
 
         if (parent->target_page_handle == 0
                 || parent->target_page_handle == 0) {
-            return NULL;
+            return false;
         }
 
         co->target_workspace_handle = parent->target_workspace_handle;
@@ -1073,15 +1068,51 @@ pcintr_rdr_send_dom_req(pcintr_stack_t stack, pcdoc_operation op,
     }
 
     if (co->stage != CO_STAGE_OBSERVING && !co->stack.inherit) {
-        return NULL;
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+serialize_element_handle(pcdoc_element_t element, char *elem, size_t sz)
+{
+    int n = snprintf(elem, sz,
+            "%llx", (unsigned long long int)(uint64_t)element);
+    if (n < 0) {
+        purc_set_error(PURC_ERROR_BAD_STDC_CALL);
+        return false;
+    }
+    else if ((size_t)n >= sz) {
+        PC_DEBUG ("Too small elemer to serialize message.\n");
+        purc_set_error(PURC_ERROR_TOO_SMALL_BUFF);
+        return false;
     }
 
-    const char *operation = rdr_ops[op];
+    return true;
+}
+
+static const char *
+dom_req_operation(pcdoc_operation op, const char *property)
+{
     if (property && op == PCDOC_OP_DISPLACE) {
         // VW: use 'update' operation when displace property
-        operation = PCRDR_OPERATION_UPDATE;
+        return PCRDR_OPERATION_UPDATE;
     }
 
+    return rdr_ops[op];
+}
+
+pcrdr_msg *
+pcintr_rdr_send_dom_req(pcintr_stack_t stack, pcdoc_operation op,
+        pcdoc_element_t element, const char* property,
+        pcrdr_msg_data_type data_type, purc_variant_t data)
+{
+    if (!stack || !is_dom_target_ready(stack->co)) {
+        return NULL;
+    }
+
+    const char *operation = dom_req_operation(op, property);
     pcrdr_msg *response_msg = NULL;
 
     pcrdr_msg_target target = PCRDR_MSG_TARGET_DOM;
@@ -1089,15 +1120,7 @@ pcintr_rdr_send_dom_req(pcintr_stack_t stack, pcdoc_operation op,
     pcrdr_msg_element_type element_type = PCRDR_MSG_ELEMENT_TYPE_HANDLE;
 
     char elem[LEN_BUFF_LONGLONGINT];
-    int n = snprintf(elem, sizeof(elem),
-            "%llx", (unsigned long long int)(uint64_t)element);
-    if (n < 0) {
-        purc_set_error(PURC_ERROR_BAD_STDC_CALL);
-        goto failed;
-    }
-    else if ((size_t)n >= sizeof (elem)) {
-        PC_DEBUG ("Too small elemer to serialize message.\n");
-        purc_set_error(PURC_ERROR_TOO_SMALL_BUFF);
+    if (!serialize_element_handle(element, elem, sizeof(elem))) {
         goto failed;
     }
 
@@ -1125,67 +1148,118 @@ failed:
     return NULL;
 }
 
+static purc_variant_t
+make_dom_req_data(pcrdr_msg_data_type data_type, const char *data, size_t len)
+{
+    purc_variant_t req_data;
+    if (data_type == PCRDR_MSG_DATA_TYPE_JSON) {
+        req_data = purc_variant_make_from_json_string(data, len);
+    }
+    else {  /* VW: for other data types */
+        req_data = purc_variant_make_string(data, false);
+    }
+
+    if (req_data == PURC_VARIANT_INVALID) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    }
+    return req_data;
+}
+
 pcrdr_msg *
 pcintr_rdr_send_dom_req_raw(pcintr_stack_t stack, pcdoc_operation op,
         pcdoc_element_t element, const char* property,
         pcrdr_msg_data_type data_type, const char *data, size_t len)
 {
-    if (!stack) {
+    if (!stack || !is_dom_target_ready(stack->co)) {
         return NULL;
     }
 
-    pcintr_coroutine_t co = stack->co;
-    if (co->target_page_handle == 0 || co->target_dom_handle == 0) {
-        if (!co->stack.inherit) {
-            return NULL;
-        }
-
-        pcintr_coroutine_t parent = pcintr_coroutine_get_by_id(co->curator);
-        if (!parent || parent->stack.doc != co->stack.doc) {
-            return NULL;
-        }
+    purc_variant_t req_data = make_dom_req_data(data_type, data, len);
+    if (req_data == PURC_VARIANT_INVALID) {
+        return NULL;
+    }
 
-        if (parent->target_page_handle == 0
-                || parent->target_page_handle == 0) {
-            return NULL;
-        }
+    return pcintr_rdr_send_dom_req(stack, op, element,
+            property, data_type, req_data);
+}
 
-        co->target_workspace_handle = parent->target_workspace_handle;
-        co->target_page_type = parent->target_page_type;
-        co->target_page_handle = parent->target_page_handle;
-        co->target_dom_handle = parent->target_dom_handle;
+static bool
+rdr_pipeline_enabled(void)
+{
+    const char *env_value = getenv(PURC_ENVV_RDR_PIPELINE);
+    if (env_value && (*env_value == '0' ||
+                pcutils_strcasecmp(env_value, "false") == 0)) {
+        return false;
     }
+    return true;
+}
 
-    if (co->stage != CO_STAGE_OBSERVING && !co->stack.inherit) {
-        return NULL;
+static int
+dom_response_handler(pcrdr_conn* conn, const char *request_id, int state,
+        void *context, const pcrdr_msg *response_msg)
+{
+    UNUSED_PARAM(conn);
+    UNUSED_PARAM(context);
+
+    if (state == PCRDR_RESPONSE_TIMEOUT) {
+        PC_WARN("Timeout for the DOM request %s.\n", request_id);
+    }
+    else if (state == PCRDR_RESPONSE_RESULT &&
+            response_msg->retCode != PCRDR_SC_OK) {
+        PC_WARN("The DOM request %s refused by the renderer: %d.\n",
+                request_id, response_msg->retCode);
     }
 
-    pcrdr_msg *ret = NULL;
-    purc_variant_t req_data = PURC_VARIANT_INVALID;
-    if (data_type == PCRDR_MSG_DATA_TYPE_JSON) {
-        req_data = purc_variant_make_from_json_string(data, len);
-        if (req_data == PURC_VARIANT_INVALID) {
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            goto failed;
-        }
+    return 0;
+}
+
+/* Send a DOM request without waiting for the response; the response is
+   matched to the request later when the scheduler dispatches the messages
+   from the renderer. The renderer handles the requests in order, so the
+   DOM requests are pipelined and any synchronous request sent later still
+   sees the effects of them. */
+static bool
+send_dom_req_async(pcintr_stack_t stack, pcdoc_operation op,
+        pcdoc_element_t element, const char* property,
+        pcrdr_msg_data_type data_type, purc_variant_t data)
+{
+    char elem[LEN_BUFF_LONGLONGINT];
+    if (!serialize_element_handle(element, elem, sizeof(elem))) {
+        goto failed;
     }
-    else {  /* VW: for other data types */
-        req_data = purc_variant_make_string(data, false);
-        if (req_data == PURC_VARIANT_INVALID) {
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            goto failed;
-        }
+
+    pcrdr_msg *msg = pcrdr_make_request_message(
+            PCRDR_MSG_TARGET_DOM,               /* target */
+            stack->co->target_dom_handle,       /* target_value */
+            dom_req_operation(op, property),    /* operation */
+            NULL,                               /* request_id */
+            NULL,                               /* source_uri */
+            PCRDR_MSG_ELEMENT_TYPE_HANDLE,      /* element_type */
+            elem,                               /* element */
+            property,                           /* property */
+            PCRDR_MSG_DATA_TYPE_VOID,           /* data_type */
+            NULL,                               /* data */
+            0                                   /* data_len */
+            );
+    if (msg == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
     }
 
-    ret = pcintr_rdr_send_dom_req(stack, op, element,
-            property, data_type, req_data);
-    return ret;
+    msg->dataType = data_type;
+    msg->data = data;
+
+    struct pcinst *inst = pcinst_current();
+    int ret = pcrdr_send_request(inst->conn_to_rdr, msg,
+            PCRDR_TIME_DEF_EXPECTED, NULL, dom_response_handler);
+    pcrdr_release_message(msg);
+    return ret == 0;
 
 failed:
-    if (req_data != PURC_VARIANT_INVALID) {
-        purc_variant_unref(req_data);
+    if (data) {
+        purc_variant_unref(data);
     }
-    return ret;
+    return false;
 }
 
 bool
@@ -1193,6 +1267,15 @@ pcintr_rdr_send_dom_req_simple(pcintr_stack_t stack, pcdoc_operation op,
         pcdoc_element_t element, const char *property,
         pcrdr_msg_data_type data_type, purc_variant_t data)
 {
+    if (rdr_pipeline_enabled()) {
+        if (!stack || !is_dom_target_ready(stack->co)) {
+            return false;
+        }
+
+        return send_dom_req_async(stack, op, element, property,
+                data_type, data);
+    }
+
     pcrdr_msg *response_msg = pcintr_rdr_send_dom_req(stack, op,
             element, property, data_type, data);
     if (response_msg != NULL) {
@@ -1216,6 +1299,21 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack,
         data = " ";
         len = 1;
     }
+
+    if (rdr_pipeline_enabled()) {
+        if (!stack || !is_dom_target_ready(stack->co)) {
+            return false;
+        }
+
+        purc_variant_t req_data = make_dom_req_data(data_type, data, len);
+        if (req_data == PURC_VARIANT_INVALID) {
+            return false;
+        }
+
+        return send_dom_req_async(stack, op, element, property,
+                data_type, req_data);
+    }
+
     pcrdr_msg *response_msg = pcintr_rdr_send_dom_req_raw(stack, op,
             element, property, data_type, data, len);
 
@@ -1225,4 +1323,3 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack,
     }
     return false;
 }
-
@@ -100,6 +100,15 @@ void purc_runloop_set_idle_func(purc_runloop_t runloop, purc_runloop_func func,
     }
 }
 
+void purc_runloop_suspend_idle_func(purc_runloop_t runloop, long timeout_ms)
+{
+    if (runloop) {
+        ((RunLoop*)runloop)->suspendIdleCallback(timeout_ms < 0 ?
+                PurCWTF::Seconds::infinity() :
+                PurCWTF::Seconds::fromMilliseconds(timeout_ms));
+    }
+}
+
 static purc_runloop_io_event
 to_runloop_io_event(GIOCondition condition)
 {
@@ -178,6 +187,21 @@ void purc_runloop_remove_fd_monitor(purc_runloop_t runloop, uintptr_t handle)
     ((RunLoop*)runloop)->removeFdMonitor(handle);
 }
 
+uintptr_t
+pcintr_add_wakeup_fd_monitor(purc_runloop_t runloop, int fd)
+{
+    RunLoop *runLoop = (RunLoop*)runloop;
+
+    return runLoop->addFdMonitor(fd,
+            (GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP),
+            [runLoop] (gint fd, GIOCondition condition) -> gboolean {
+            UNUSED_PARAM(fd);
+            UNUSED_PARAM(condition);
+            runLoop->wakeUp();
+            return true;
+        });
+}
+
 extern "C" purc_atom_t
 pcrun_create_inst_thread(const char *app_name, const char *runner_name,
         purc_cond_handler cond_handler,
@@ -44,6 +44,8 @@
 #define SCHEDULE_SLEEP          10 * 1000       // usec
 #define IDLE_EVENT_TIMEOUT      100             // ms
 #define TIME_SLIECE             0.005           // s
+#define TIMEOUT_CRTNS_MIN_SIZE  8
+#define MAX_RDR_MSGS_PER_STEP   64
 
 #define BUILTIN_VAR_CRTN        PURC_PREDEF_VARNAME_CRTN
 
@@ -63,10 +65,92 @@ pcintr_monotonic_time_ms()
     return timespec_to_ms(&ts);
 }
 
+static inline void
+timeout_crtns_set(struct pcintr_heap *heap, size_t idx, pcintr_coroutine_t co)
+{
+    heap->timeout_crtns[idx] = co;
+    co->timeout_idx = idx;
+}
+
+static void
+timeout_crtns_sift_up(struct pcintr_heap *heap, size_t idx)
+{
+    pcintr_coroutine_t co = heap->timeout_crtns[idx];
+    while (idx > 0) {
+        size_t parent = (idx - 1) / 2;
+        pcintr_coroutine_t p = heap->timeout_crtns[parent];
+        if (p->stopped_timeout <= co->stopped_timeout) {
+            break;
+        }
+        timeout_crtns_set(heap, idx, p);
+        idx = parent;
+    }
+    timeout_crtns_set(heap, idx, co);
+}
+
+static void
+timeout_crtns_sift_down(struct pcintr_heap *heap, size_t idx)
+{
+    pcintr_coroutine_t co = heap->timeout_crtns[idx];
+    size_t nr = heap->nr_timeout_crtns;
+    while (idx * 2 + 1 < nr) {
+        size_t child = idx * 2 + 1;
+        if (child + 1 < nr && heap->timeout_crtns[child + 1]->stopped_timeout <
+                heap->timeout_crtns[child]->stopped_timeout) {
+            child++;
+        }
+        if (co->stopped_timeout <= heap->timeout_crtns[child]->stopped_timeout) {
+            break;
+        }
+        timeout_crtns_set(heap, idx, heap->timeout_crtns[child]);
+        idx = child;
+    }
+    timeout_crtns_set(heap, idx, co);
+}
+
+static int
+timeout_crtns_add(struct pcintr_heap *heap, pcintr_coroutine_t co)
+{
+    if (heap->nr_timeout_crtns == heap->sz_timeout_crtns) {
+        size_t sz = heap->sz_timeout_crtns ?
+            heap->sz_timeout_crtns * 2 : TIMEOUT_CRTNS_MIN_SIZE;
+        pcintr_coroutine_t *crtns = (pcintr_coroutine_t *)realloc(
+                heap->timeout_crtns, sizeof(*crtns) * sz);
+        if (!crtns) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+        heap->timeout_crtns = crtns;
+        heap->sz_timeout_crtns = sz;
+    }
+
+    heap->timeout_crtns[heap->nr_timeout_crtns] = co;
+    timeout_crtns_sift_up(heap, heap->nr_timeout_crtns++);
+    return 0;
+}
+
+static void
+timeout_crtns_remove(struct pcintr_heap *heap, pcintr_coroutine_t co)
+{
+    size_t idx = co->timeout_idx;
+    PC_ASSERT(idx < heap->nr_timeout_crtns && heap->timeout_crtns[idx] == co);
+
+    pcintr_coroutine_t last = heap->timeout_crtns[--heap->nr_timeout_crtns];
+    if (last != co) {
+        timeout_crtns_set(heap, idx, last);
+        timeout_crtns_sift_up(heap, idx);
+        timeout_crtns_sift_down(heap, last->timeout_idx);
+    }
+}
+
 static void
 broadcast_idle_event(struct pcinst *inst)
 {
     struct pcintr_heap *heap = inst->intr_heap;
+    if (heap->nr_idle_observers == 0) {
+        return;
+    }
+
     struct list_head *crtns = &heap->crtns;
     pcintr_coroutine_t p, q;
     list_for_each_entry_safe(p, q, crtns, ln) {
@@ -97,6 +181,30 @@ broadcast_idle_event(struct pcinst *inst)
     }
 }
 
+/* keep the fd of the connection to the renderer monitored by the runloop
+   so that the scheduler wakes up when there is something to read. */
+static void
+watch_rdr_conn(struct pcinst *inst, struct pcrdr_conn *conn)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+    int fd = conn ? pcrdr_conn_socket_fd(conn) : -1;
+    if (fd == heap->rdr_fd) {
+        return;
+    }
+
+    if (heap->rdr_fd_monitor) {
+        purc_runloop_remove_fd_monitor(inst->running_loop,
+                heap->rdr_fd_monitor);
+        heap->rdr_fd_monitor = 0;
+    }
+
+    heap->rdr_fd = fd;
+    if (fd >= 0) {
+        heap->rdr_fd_monitor = pcintr_add_wakeup_fd_monitor(
+                inst->running_loop, fd);
+    }
+}
+
 static void
 handle_rdr_conn_lost(struct pcinst *inst)
 {
@@ -140,6 +248,7 @@ handle_rdr_conn_lost(struct pcinst *inst)
 
     // FIXME:
     // pcrdr_disconnect(inst->conn_to_rdr);
+    watch_rdr_conn(inst, NULL);
     pcrdr_free_connection(inst->conn_to_rdr);
     inst->conn_to_rdr = NULL;
 }
@@ -381,42 +490,30 @@ execute_one_step(struct pcinst *inst)
     bool busy = false;
     struct pcintr_heap *heap = inst->intr_heap;
 
-    pcintr_coroutine_t p, q;
     pcintr_coroutine_t co;
-    struct list_head *crtns;
+    struct list_head *p;
 
     time_t now = pcintr_monotonic_time_ms();
-
-    pcutils_array_t *cos = pcutils_array_create();
-    if (!cos) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return false;
-    }
-
-    size_t nr = pcutils_sorted_array_count(heap->wait_timeout_crtns);
-    for (size_t i = 0; i < nr; i++) {
-        pcutils_sorted_array_get(heap->wait_timeout_crtns, i, (void **)&co);
+    while (heap->nr_timeout_crtns > 0) {
+        co = heap->timeout_crtns[0];
         if (now < co->stopped_timeout) {
             break;
         }
         co->stack.timeout = true;
-        pcutils_array_push(cos, co);
-    }
-
-    nr = pcutils_array_length(cos);
-    for (size_t i = 0; i < nr; i++) {
-        co = pcutils_array_get(cos, i);
         pcintr_resume_coroutine(co);
     }
-    pcutils_array_destroy(cos, true);
 
+    // a coroutine still ready after its time slice goes to the tail of
+    // the queue; leave it and the newcomers to the next pass.
+    size_t nr = 0;
+    list_for_each(p, &heap->ready_crtns) {
+        nr++;
+    }
 
-    crtns = &heap->crtns;
-    list_for_each_entry_safe(p, q, crtns, ln) {
-        pcintr_coroutine_t co = p;
-        if (co->state != CO_STATE_READY) {
-            continue;
-        }
+    while (nr-- > 0 && !list_empty(&heap->ready_crtns)) {
+        co = list_first_entry(&heap->ready_crtns, struct pcintr_coroutine,
+                ln_ready);
+        PC_ASSERT(co->state == CO_STATE_READY);
 
 #if 1
         struct timespec begin;
@@ -458,7 +555,12 @@ check_and_dispatch_event_from_conn(struct pcinst *inst)
         int last_err = purc_get_last_error();
         purc_clr_error();
 
-        pcrdr_wait_and_dispatch_message(conn, 0);
+        /* the responses to the pipelined DOM requests may arrive in
+           a batch; dispatch them together but not to starve others. */
+        for (int i = 0; i < MAX_RDR_MSGS_PER_STEP; i++) {
+            if (pcrdr_wait_and_dispatch_message(conn, 0))
+                break;
+        }
 
         int err = purc_get_last_error();
         if (err == PCRDR_ERROR_IO || err == PCRDR_ERROR_PEER_CLOSED) {
@@ -585,6 +687,25 @@ out:
     return busy;
 }
 
+/* handle the messages which are in the queue of the coroutine now, until
+   it becomes ready to run; those left are waiting for the coroutine to
+   change its state, which wakes up the scheduler. */
+static bool
+handle_coroutine_events(pcintr_coroutine_t co)
+{
+    bool busy = false;
+    size_t nr = pcinst_msg_queue_count(co->mq);
+
+    do {
+        if (handle_coroutine_event(co)) {
+            busy = true;
+        }
+    } while (nr-- > 1 &&
+            !(co->state & (CO_STATE_READY | CO_STATE_RUNNING)));
+
+    return busy;
+}
+
 static bool
 dispatch_event(struct pcinst *inst)
 {
@@ -602,25 +723,16 @@ again:
 
     bool co_is_busy = false;
     struct pcintr_heap *heap = inst->intr_heap;
-    struct list_head *crtns = &heap->crtns;
-    pcintr_coroutine_t p, q;
-    list_for_each_entry_safe(p, q, crtns, ln) {
-        pcintr_coroutine_t co = p;
-        co_is_busy = handle_coroutine_event(co);
-
-        if (co->stack.exited && co->stack.last_msg_read) {
-            pcintr_run_exiting_co(co);
-        }
-
-        if (co_is_busy) {
-            is_busy = true;
-        }
-    }
 
-    crtns = &heap->stopped_crtns;
-    list_for_each_entry_safe(p, q, crtns, ln) {
-        pcintr_coroutine_t co = p;
-        co_is_busy = handle_coroutine_event(co);
+    // the coroutines marked pending while handling these are left to
+    // the next round.
+    LIST_HEAD(crtns);
+    list_splice_init(&heap->pending_crtns, &crtns);
+    while (!list_empty(&crtns)) {
+        pcintr_coroutine_t co = list_first_entry(&crtns,
+                struct pcintr_coroutine, ln_pending);
+        list_del_init(&co->ln_pending);
+        co_is_busy = handle_coroutine_events(co);
 
         if (co->stack.exited && co->stack.last_msg_read) {
             pcintr_run_exiting_co(co);
@@ -640,6 +752,64 @@ again:
     return is_busy;
 }
 
+static inline void
+update_timeout(long *timeout, long ms)
+{
+    if (ms < 0) {
+        ms = 0;
+    }
+    if (*timeout < 0 || ms < *timeout) {
+        *timeout = ms;
+    }
+}
+
+/*
+ * Suspend the idle function of the runloop until the earliest deadline
+ * when nothing is ready to run. The scheduler is woken up early by
+ * pcintr_wakeup_scheduler() when the state of a coroutine changes or a
+ * message is appended to a coroutine, by the move buffer when a message
+ * comes from another instance, and by the fd monitor of the renderer.
+ */
+static void
+suspend_scheduler(struct pcinst *inst)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+    long timeout = -1;
+
+    struct pcrdr_conn *conn = purc_get_conn_to_renderer();
+    watch_rdr_conn(inst, conn);
+    if (conn && pcrdr_conn_pending_requests_count(conn) > 0) {
+        // the requests may time out or be answered without any fd
+        update_timeout(&timeout, SCHEDULE_SLEEP / 1000);
+    }
+
+    if (!list_empty(&heap->ready_crtns) || !list_empty(&heap->pending_crtns)) {
+        return;
+    }
+
+    // the messages read in a batch do not make the fd readable again
+    if (conn && pcrdr_conn_has_buffered_input(conn)) {
+        return;
+    }
+
+    if (heap->nr_idle_observers > 0) {
+        double idle_at = heap->timestamp + IDLE_EVENT_TIMEOUT;
+        double now = pcintr_get_current_time();
+        update_timeout(&timeout, (long)(idle_at - now) + 1);
+    }
+
+    if (heap->nr_timeout_crtns > 0) {
+        pcintr_coroutine_t co = heap->timeout_crtns[0];
+        update_timeout(&timeout,
+                (long)(co->stopped_timeout - pcintr_monotonic_time_ms()));
+    }
+
+    if (timeout != 0) {
+        heap->suspended = 1;
+        purc_runloop_suspend_idle_func(inst->running_loop, timeout);
+    }
+}
+
 void
 pcintr_schedule(void *ctxt)
 {
@@ -655,6 +825,8 @@ pcintr_schedule(void *ctxt)
         goto out_sleep;
     }
 
+    heap->suspended = 0;
+
 again:
 
     // 1. exec one step for all ready coroutines and
@@ -677,12 +849,56 @@ again:
         pcintr_update_timestamp(inst);
     }
 
+    // 6. wait for a message, a timeout or the renderer
+    suspend_scheduler(inst);
+    return;
+
 out_sleep:
     pcutils_usleep(SCHEDULE_SLEEP);
 
     return;
 }
 
+void
+pcintr_wakeup_scheduler(struct pcinst *inst)
+{
+    struct pcintr_heap *heap = inst ? inst->intr_heap : NULL;
+    if (heap && heap->suspended) {
+        heap->suspended = 0;
+        purc_runloop_wakeup(inst->running_loop);
+    }
+}
+
+void
+pcintr_coroutine_add_pending(pcintr_coroutine_t co)
+{
+    if (list_empty(&co->ln_pending)) {
+        list_add_tail(&co->ln_pending, &co->owner->pending_crtns);
+    }
+    pcintr_wakeup_scheduler(co->owner->owner);
+}
+
+/* keep the coroutine in the ready queue while it is ready; in other
+   states but running, the messages and tasks kept waiting for the state
+   may be dispatched now. */
+void
+pcintr_coroutine_state_changed(pcintr_coroutine_t co)
+{
+    struct pcintr_heap *heap = co->owner;
+    if (co->state == CO_STATE_READY) {
+        if (list_empty(&co->ln_ready)) {
+            list_add_tail(&co->ln_ready, &heap->ready_crtns);
+        }
+    }
+    else {
+        list_del_init(&co->ln_ready);
+        if (co->state != CO_STATE_RUNNING) {
+            pcintr_coroutine_add_pending(co);
+        }
+    }
+    pcintr_wakeup_scheduler(heap->owner);
+}
+
 int pcintr_yield(
         int                       cor_stage,
         int                       cor_state,
@@ -890,6 +1106,10 @@ void pcintr_stop_coroutine(pcintr_coroutine_t crtn,
     pcintr_heap_t heap = crtn->owner;
     list_add_tail(&crtn->ln, &heap->stopped_crtns);
 
+    if (crtn->stopped_timeout != -1) {
+        timeout_crtns_remove(heap, crtn);
+    }
+
     if (timeout) {
         time_t curr = pcintr_monotonic_time_ms();
         crtn->stopped_timeout = curr + timespec_to_ms(timeout);
@@ -898,9 +1118,8 @@ void pcintr_stop_coroutine(pcintr_coroutine_t crtn,
         crtn->stopped_timeout = -1;
     }
     if (crtn->stopped_timeout != -1) {
-        if (pcutils_sorted_array_add(heap->wait_timeout_crtns,
-                    (void *)(uintptr_t)crtn->stopped_timeout, crtn) < 0) {
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        if (timeout_crtns_add(heap, crtn) < 0) {
+            crtn->stopped_timeout = -1;
         }
     }
 
@@ -916,15 +1135,7 @@ void pcintr_resume_coroutine(pcintr_coroutine_t crtn)
     list_add_tail(&crtn->ln, &heap->crtns);
 
     if (crtn->stopped_timeout != -1) {
-        size_t nr = pcutils_sorted_array_count(heap->wait_timeout_crtns);
-        for (size_t i = 0; i < nr; i++) {
-            pcintr_coroutine_t co;
-            pcutils_sorted_array_get(heap->wait_timeout_crtns, i, (void **)&co);
-            if (co == crtn) {
-                pcutils_sorted_array_delete(heap->wait_timeout_crtns, i);
-                break;
-            }
-        }
+        timeout_crtns_remove(heap, crtn);
     }
 
     crtn->stopped_timeout = -1;
@@ -194,6 +194,8 @@ static bool mgr_change_handler(purc_variant_t source, pcvar_op_t msg_type,
 static bool mgr_handler(purc_variant_t source, pcvar_op_t msg_type,
         void* ctxt, size_t nr_args, purc_variant_t* argv)
 {
+    pcintr_invalidate_var_caches();
+
     switch (msg_type) {
     case PCVAR_OPERATION_GROW:
         return mgr_grow_handler(source, msg_type, ctxt, nr_args, argv);
@@ -264,6 +266,9 @@ int pcvarmgr_destroy(pcvarmgr_t mgr)
         if (mgr->listener) {
             purc_variant_revoke_listener(mgr->object, mgr->listener);
         }
+        if (purc_variant_object_get_size(mgr->object) > 0) {
+            pcintr_invalidate_var_caches();
+        }
         purc_variant_unref(mgr->object);
         free(mgr);
     }
@@ -359,13 +364,25 @@ bool pcvarmgr_dispatch_except(pcvarmgr_t mgr, const char* name,
     return true;
 }
 
+/*
+ * The lookups below only report the miss of the whole chain, in
+ * pcintr_find_named_var(); formatting an error for every scope passed
+ * by costs more than the lookups themselves.
+ */
+static inline purc_variant_t
+mgr_lookup(pcvarmgr_t mgr, const char *name)
+{
+    if (mgr == NULL)
+        return PURC_VARIANT_INVALID;
+    return purc_variant_object_get_by_ckey(mgr->object, name);
+}
+
 static purc_variant_t
 _find_named_scope_var_in_vdom(purc_coroutine_t cor,
         pcvdom_element_t elem, const char* name, pcvarmgr_t* mgr)
 {
     if (!elem || !name) {
         PC_ASSERT(name); // FIXME: still recoverable???
-        purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
         return PURC_VARIANT_INVALID;
     }
 
@@ -373,7 +390,7 @@ _find_named_scope_var_in_vdom(purc_coroutine_t cor,
 
 again:
 
-    v = pcintr_get_scope_variable(cor, elem, name);
+    v = mgr_lookup(pcintr_get_scope_variables(cor, elem), name);
     if (v) {
         if (mgr) {
             *mgr = pcintr_get_scope_variables(cor, elem);
@@ -385,7 +402,6 @@ again:
     if (elem)
         goto again;
 
-    purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
     return PURC_VARIANT_INVALID;
 }
 
@@ -400,7 +416,6 @@ _find_named_scope_var(purc_coroutine_t cor,
 
     if (!elem || !name) {
         PC_ASSERT(name); // FIXME: still recoverable???
-        purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
         return PURC_VARIANT_INVALID;
     }
 
@@ -408,7 +423,7 @@ _find_named_scope_var(purc_coroutine_t cor,
 
 again:
 
-    v = pcintr_get_scope_variable(cor, elem, name);
+    v = mgr_lookup(pcintr_get_scope_variables(cor, elem), name);
     if (v) {
         if (mgr) {
             *mgr = pcintr_get_scope_variables(cor, elem);
@@ -426,7 +441,6 @@ again:
             goto again;
     }
 
-    purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
     return PURC_VARIANT_INVALID;
 }
 
@@ -434,17 +448,11 @@ static purc_variant_t
 find_cor_level_var(purc_coroutine_t cor, const char* name)
 {
     PC_ASSERT(name);
-    if (!cor) {
-        purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
+    if (!cor || !cor->vdom) {
         return PURC_VARIANT_INVALID;
     }
 
-    purc_variant_t v = purc_coroutine_get_variable(cor, name);
-    if (v) {
-        return v;
-    }
-    purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
-    return PURC_VARIANT_INVALID;
+    return mgr_lookup(cor->variables, name);
 }
 
 purc_variant_t
@@ -470,7 +478,7 @@ purc_get_runner_variable(const char* name)
 static inline purc_variant_t
 find_inst_var(const char *name)
 {
-    return purc_get_runner_variable(name);
+    return mgr_lookup(pcinst_get_variables(), name);
 }
 
 static purc_variant_t
@@ -481,7 +489,6 @@ _find_named_temp_var(struct pcintr_stack_frame *frame, const char *name)
 again:
 
     if (p == NULL) {
-        purc_set_error(PURC_ERROR_ENTITY_NOT_FOUND);
         return PURC_VARIANT_INVALID;
     }
 
@@ -494,6 +501,10 @@ again:
         if (purc_variant_is_object(tmp) == false)
             break;
 
+        /* most frames bind nothing */
+        if (purc_variant_object_get_size(tmp) == 0)
+            break;
+
         purc_variant_t v;
         v = purc_variant_object_get_by_ckey(tmp, name);
         if (v == PURC_VARIANT_INVALID)
@@ -547,6 +558,50 @@ pcintr_find_named_var(pcintr_stack_t stack, const char* name)
     return PURC_VARIANT_INVALID;
 }
 
+void
+pcintr_invalidate_var_caches(void)
+{
+    struct pcintr_heap *heap = pcintr_get_heap();
+    if (heap) {
+        heap->var_epoch++;
+    }
+}
+
+purc_variant_t
+pcintr_find_named_var_cached(pcintr_stack_t stack, const char* name,
+        struct pcintr_var_cache *cache)
+{
+    struct pcintr_heap *heap = pcintr_get_heap();
+    if (!stack || !heap) {
+        return pcintr_find_named_var(stack, name);
+    }
+
+    struct pcintr_stack_frame* frame = pcintr_stack_get_bottom_frame(stack);
+    PC_ASSERT(frame);
+
+    struct pcintr_stack_frame* parent = pcintr_stack_frame_get_parent(frame);
+    uint64_t parent_serial = parent ? parent->serial : 0;
+
+    if (cache->value && cache->stack == stack &&
+            cache->epoch == heap->var_epoch &&
+            cache->parent_serial == parent_serial &&
+            cache->pos == frame->pos && cache->scope == frame->scope) {
+        purc_clr_error();
+        return cache->value;
+    }
+
+    purc_variant_t v = pcintr_find_named_var(stack, name);
+    if (v) {
+        cache->stack = stack;
+        cache->parent_serial = parent_serial;
+        cache->pos = frame->pos;
+        cache->scope = frame->scope;
+        cache->epoch = heap->var_epoch;
+    }
+    cache->value = v;
+    return v;
+}
+
 enum purc_symbol_var _to_symbol(char symbol)
 {
     switch (symbol) {
@@ -151,13 +151,165 @@ int pcrdr_conn_set_poll_timeout(pcrdr_conn* conn, int timeout_ms)
 
 size_t pcrdr_conn_pending_requests_count(pcrdr_conn* conn)
 {
-    size_t n = 0;
+    return conn->nr_pending_requests;
+}
+
+bool pcrdr_conn_has_buffered_input(pcrdr_conn* conn)
+{
+    return conn->has_buffered_input ? conn->has_buffered_input(conn) : false;
+}
+
+#define PENDING_BUCKETS_MIN_SIZE    16
+#define PENDING_HEAP_MIN_SIZE       8
+
+static unsigned long hash_request_id(purc_variant_t request_id)
+{
+    size_t len;
+    const char *str = purc_variant_get_string_const_ex(request_id, &len);
+    return pcutils_hash_hash((const unsigned char *)str, len);
+}
+
+static inline struct list_head *
+pending_bucket(pcrdr_conn *conn, unsigned long hash)
+{
+    return &conn->pending_buckets[hash & (conn->nr_pending_buckets - 1)];
+}
+
+static int resize_pending_buckets(pcrdr_conn *conn, size_t nr_buckets)
+{
+    struct list_head *buckets;
+    buckets = malloc(sizeof(struct list_head) * nr_buckets);
+    if (buckets == NULL)
+        return -1;
+
+    for (size_t i = 0; i < nr_buckets; i++)
+        list_head_init(&buckets[i]);
+
+    for (size_t i = 0; i < conn->nr_pending_buckets; i++) {
+        struct pending_request *p, *n;
+        list_for_each_entry_safe(p, n, &conn->pending_buckets[i], ln_hash) {
+            list_del(&p->ln_hash);
+            list_add_tail(&p->ln_hash, &buckets[p->hash & (nr_buckets - 1)]);
+        }
+    }
+
+    free(conn->pending_buckets);
+    conn->pending_buckets = buckets;
+    conn->nr_pending_buckets = nr_buckets;
+    return 0;
+}
+
+static inline void
+pending_heap_set(pcrdr_conn *conn, size_t idx, struct pending_request *pr)
+{
+    conn->pending_heap[idx] = pr;
+    pr->heap_idx = idx;
+}
+
+static void pending_heap_sift_up(pcrdr_conn *conn, size_t idx)
+{
+    struct pending_request *pr = conn->pending_heap[idx];
+    while (idx > 0) {
+        size_t parent = (idx - 1) / 2;
+        if (conn->pending_heap[parent]->time_expected <= pr->time_expected)
+            break;
+        pending_heap_set(conn, idx, conn->pending_heap[parent]);
+        idx = parent;
+    }
+    pending_heap_set(conn, idx, pr);
+}
+
+static void pending_heap_sift_down(pcrdr_conn *conn, size_t idx)
+{
+    size_t nr = conn->nr_pending_requests;
+    struct pending_request *pr = conn->pending_heap[idx];
+    for (;;) {
+        size_t child = idx * 2 + 1;
+        if (child >= nr)
+            break;
+        if (child + 1 < nr && conn->pending_heap[child + 1]->time_expected <
+                conn->pending_heap[child]->time_expected)
+            child++;
+        if (pr->time_expected <= conn->pending_heap[child]->time_expected)
+            break;
+        pending_heap_set(conn, idx, conn->pending_heap[child]);
+        idx = child;
+    }
+    pending_heap_set(conn, idx, pr);
+}
+
+/* index the pending request by its identifier and expected time */
+static int add_pending_request(pcrdr_conn *conn, struct pending_request *pr)
+{
+    if (conn->nr_pending_requests >= conn->nr_pending_buckets) {
+        size_t nr_buckets = conn->nr_pending_buckets ?
+            conn->nr_pending_buckets * 2 : PENDING_BUCKETS_MIN_SIZE;
+        if (resize_pending_buckets(conn, nr_buckets) &&
+                conn->pending_buckets == NULL)
+            goto failed;
+    }
+
+    if (conn->nr_pending_requests == conn->sz_pending_heap) {
+        size_t sz = conn->sz_pending_heap ?
+            conn->sz_pending_heap * 2 : PENDING_HEAP_MIN_SIZE;
+        struct pending_request **heap = realloc(conn->pending_heap,
+                sizeof(struct pending_request *) * sz);
+        if (heap == NULL)
+            goto failed;
+
+        conn->pending_heap = heap;
+        conn->sz_pending_heap = sz;
+    }
+
+    pr->hash = hash_request_id(pr->request_id);
+    list_add_tail(&pr->ln_hash, pending_bucket(conn, pr->hash));
+    list_add_tail(&pr->list, &conn->pending_requests);
+
+    conn->pending_heap[conn->nr_pending_requests] = pr;
+    pr->heap_idx = conn->nr_pending_requests;
+    conn->nr_pending_requests++;
+    pending_heap_sift_up(conn, pr->heap_idx);
+    return 0;
+
+failed:
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return -1;
+}
+
+static struct pending_request *
+find_pending_request(pcrdr_conn *conn, purc_variant_t request_id)
+{
+    if (conn->pending_buckets == NULL)
+        return NULL;
+
+    unsigned long hash = hash_request_id(request_id);
+    const char *str = purc_variant_get_string_const(request_id);
+
     struct pending_request *pr;
-    list_for_each_entry(pr, &conn->pending_requests, list) {
-        n++;
+    list_for_each_entry(pr, pending_bucket(conn, hash), ln_hash) {
+        if (pr->hash == hash &&
+                strcmp(purc_variant_get_string_const(pr->request_id), str) == 0)
+            return pr;
     }
 
-    return n;
+    return NULL;
+}
+
+static void remove_pending_request(pcrdr_conn *conn, struct pending_request *pr)
+{
+    size_t idx = pr->heap_idx;
+    size_t last = --conn->nr_pending_requests;
+    if (idx != last) {
+        struct pending_request *moved = conn->pending_heap[last];
+        pending_heap_set(conn, idx, moved);
+        pending_heap_sift_down(conn, idx);
+        pending_heap_sift_up(conn, moved->heap_idx);
+    }
+
+    list_del(&pr->ln_hash);
+    list_del(&pr->list);
+    purc_variant_unref(pr->request_id);
+    free(pr);
 }
 
 int pcrdr_free_connection(pcrdr_conn* conn)
@@ -180,6 +332,8 @@ int pcrdr_free_connection(pcrdr_conn* conn)
         free(pr);
     }
 
+    free(conn->pending_buckets);
+    free(conn->pending_heap);
     free(conn);
 
     return 0;
@@ -244,7 +398,12 @@ pcrdr_set_handler_for_response_from_extra_source(pcrdr_conn* conn,
         pr->time_expected = purc_get_monotoic_time() + 3600;
     else
         pr->time_expected = purc_get_monotoic_time() + seconds_expected;
-    list_add_tail(&pr->list, &conn->pending_requests);
+
+    if (add_pending_request(conn, pr)) {
+        purc_variant_unref(pr->request_id);
+        free(pr);
+        return -1;
+    }
 
     return 0;
 }
@@ -269,28 +428,17 @@ int pcrdr_send_request(pcrdr_conn* conn, pcrdr_msg *request_msg,
         response_handler);
 }
 
-static inline int
-variant_strcmp(purc_variant_t a, purc_variant_t b)
-{
-    if (a == b)
-        return 0;
-
-    return strcmp(
-            purc_variant_get_string_const(a),
-            purc_variant_get_string_const(b));
-}
-
 static int
 handle_response_message(pcrdr_conn* conn, const pcrdr_msg *msg)
 {
     int retval = -1;
 
-    if (!list_empty(&conn->pending_requests)) {
+    if (conn->nr_pending_requests > 0) {
+        /* the responses may arrive in any order */
         struct pending_request *pr;
-        pr = list_first_entry(&conn->pending_requests,
-                struct pending_request, list);
+        pr = find_pending_request(conn, msg->requestId);
 
-        if (variant_strcmp(msg->requestId, pr->request_id) == 0) {
+        if (pr) {
             const char *request_id =
                 purc_variant_get_string_const(msg->requestId);
             if (pr->response_handler && pr->response_handler(conn,
@@ -301,12 +449,10 @@ handle_response_message(pcrdr_conn* conn, const pcrdr_msg *msg)
             }
 
             retval = 0;
-            list_del(&pr->list);
-            purc_variant_unref(pr->request_id);
-            free(pr);
+            remove_pending_request(conn, pr);
         }
         else {
-            purc_log_error("response not matched the first pending request\n");
+            purc_log_error("response not matched any pending request\n");
             purc_set_error(PCRDR_ERROR_UNEXPECTED);
         }
     }
@@ -321,21 +467,18 @@ handle_response_message(pcrdr_conn* conn, const pcrdr_msg *msg)
 static int
 check_timeout_requests(pcrdr_conn *conn)
 {
-    struct pending_request *pr, *n;
     time_t now = purc_get_monotoic_time();
 
-    list_for_each_entry_safe(pr, n, &conn->pending_requests, list) {
-        if (now >= pr->time_expected) {
-            if (pr->response_handler) {
-                pr->response_handler(conn,
-                    purc_variant_get_string_const(pr->request_id),
-                        PCRDR_RESPONSE_TIMEOUT, pr->context, NULL);
-            }
-
-            list_del(&pr->list);
-            purc_variant_unref(pr->request_id);
-            free(pr);
+    while (conn->nr_pending_requests > 0 &&
+            now >= conn->pending_heap[0]->time_expected) {
+        struct pending_request *pr = conn->pending_heap[0];
+        if (pr->response_handler) {
+            pr->response_handler(conn,
+                purc_variant_get_string_const(pr->request_id),
+                    PCRDR_RESPONSE_TIMEOUT, pr->context, NULL);
         }
+
+        remove_pending_request(conn, pr);
     }
 
     return 0;
@@ -501,7 +644,10 @@ pcrdr_wait_response_for_specific_request(pcrdr_conn* conn,
        we have to allocate this struct in heap,
        while it could have been allocated on the stack. */
     struct pending_request *pr = calloc(1, sizeof(*pr));
-    assert(pr);
+    if (pr == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
 
     pr->request_id = purc_variant_ref(request_id);
     pr->response_handler = my_sync_response_handler;
@@ -510,7 +656,11 @@ pcrdr_wait_response_for_specific_request(pcrdr_conn* conn,
         pr->time_expected = purc_get_monotoic_time() + 3600;
     else
         pr->time_expected = purc_get_monotoic_time() + seconds_expected;
-    list_add(&pr->list, &conn->pending_requests);
+    if (add_pending_request(conn, pr)) {
+        purc_variant_unref(pr->request_id);
+        free(pr);
+        return -1;
+    }
 
     while (*response_msg == NULL) {
         pcrdr_msg *msg;
@@ -560,9 +710,7 @@ pcrdr_wait_response_for_specific_request(pcrdr_conn* conn,
     }
 
     if (*response_msg == NULL) {
-        list_del(&pr->list);
-        purc_variant_unref(pr->request_id);
-        free(pr);
+        remove_pending_request(conn, pr);
     }
     else if (*response_msg == MSG_POINTER_INVALID) {
         *response_msg = NULL;   /* reset response messge to NULL */
@@ -34,6 +34,11 @@
 
 struct pending_request {
     struct list_head        list;
+    /* the link in the bucket of the request identifier */
+    struct list_head        ln_hash;
+    /* the index in the timeout min-heap */
+    size_t                  heap_idx;
+    unsigned long           hash;
 
     purc_variant_t          request_id;
     pcrdr_response_handler  response_handler;
@@ -67,12 +72,23 @@ struct pcrdr_conn {
     /* the pending requests queue */
     struct list_head pending_requests;
 
+    /* the pending requests indexed by the request identifier */
+    struct list_head *pending_buckets;
+    size_t nr_pending_buckets;
+    size_t nr_pending_requests;
+
+    /* the min-heap of the pending requests by the expected time */
+    struct pending_request **pending_heap;
+    size_t sz_pending_heap;
+
     /* operations */
     int (*wait_message) (pcrdr_conn* conn, int timeout_ms);
     pcrdr_msg *(*read_message) (pcrdr_conn* conn);
     int (*send_message) (pcrdr_conn* conn, pcrdr_msg *msg);
     int (*ping_peer) (pcrdr_conn* conn);
     int (*disconnect) (pcrdr_conn* conn);
+    /* optional: whether there are data read in but not handled yet */
+    bool (*has_buffered_input) (pcrdr_conn* conn);
 };
 
 #endif  /* PURC_PCRDR_CONN_H */
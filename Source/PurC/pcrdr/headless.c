@@ -26,7 +26,7 @@
 #include "config.h"
 #include "purc-pcrdr.h"
 #include "private/pcrdr.h"
-#include "private/kvlist.h"
+#include "private/list.h"
 #include "private/debug.h"
 #include "private/utils.h"
 #include "private/ports.h"
@@ -104,6 +104,10 @@ struct session_info {
 };
 
 struct result_info {
+    struct list_head ln;
+    purc_variant_t requestId;
+    struct timespec ts_sent;
+
     int         retCode;
     uint64_t    resultValue;
     pcrdr_msg_data_type data_type;
@@ -114,37 +118,52 @@ struct pcrdr_prot_data {
     // FILE pointer to serialize the message.
     FILE                *fp;
 
-    // requestId -> results;
-    struct kvlist        results;
+    // the results in the order of the requests, like a real renderer
+    // sends the responses; so the requests can be pipelined.
+    struct list_head     results;
+
+    // the simulated latency of the responses in seconds
+    double               latency;
 
     // FILE pointer to serialize the message.
     struct session_info *session;
 };
 
-static struct result_info *result_of_first_request(pcrdr_conn* conn)
+static struct result_info *first_result(pcrdr_conn* conn)
 {
-    if (list_empty(&conn->pending_requests)) {
+    if (list_empty(&conn->prot_data->results)) {
         return NULL;
     }
 
-    struct pending_request *pr;
-    pr = list_first_entry(&conn->pending_requests,
-            struct pending_request, list);
-
-    const char *request_id;
-    request_id = purc_variant_get_string_const(pr->request_id);
-
-    struct result_info **data;
-    data = pcutils_kvlist_get(&conn->prot_data->results, request_id);
-    if (data == NULL)
-        return NULL;
+    return list_first_entry(&conn->prot_data->results,
+            struct result_info, ln);
+}
 
-    return *data;
+static void release_result(struct result_info *result)
+{
+    list_del(&result->ln);
+    purc_variant_unref(result->requestId);
+    free(result);
 }
 
 static int my_wait_message(pcrdr_conn* conn, int timeout_ms)
 {
-    if (result_of_first_request(conn) == NULL) {
+    struct result_info *result = first_result(conn);
+
+    if (result && conn->prot_data->latency > 0) {
+        double elapsed = purc_get_elapsed_seconds(&result->ts_sent, NULL);
+        if (elapsed < conn->prot_data->latency) {
+            double left = conn->prot_data->latency - elapsed;
+            if (left * 1000 > timeout_ms) {
+                pcutils_usleep(timeout_ms * 1000ULL);
+                return 0;
+            }
+
+            pcutils_usleep((unsigned long long)(left * 1000000));
+        }
+    }
+
+    if (result == NULL) {
         if (timeout_ms > 1000) {
             pcutils_sleep(timeout_ms / 1000);
         }
@@ -178,28 +197,25 @@ static pcrdr_msg *my_read_message(pcrdr_conn* conn)
     pcrdr_msg* msg = NULL;
     struct result_info *result;
 
-    if ((result = result_of_first_request(conn)) == NULL) {
-        purc_log_warn("There is not any result for the first request.\n");
+    if ((result = first_result(conn)) == NULL) {
+        purc_log_warn("There is not any result for the requests.\n");
         purc_set_error(PCRDR_ERROR_UNEXPECTED);
         return NULL;
     }
 
-    struct pending_request *pr;
-    pr = list_first_entry(&conn->pending_requests,
-            struct pending_request, list);
-
-    const char *request_id;
-    request_id = purc_variant_get_string_const(pr->request_id);
-
     msg = pcrdr_make_response_message(
-            request_id, NULL,
+            purc_variant_get_string_const(result->requestId), NULL,
             result->retCode, (uint64_t)(uintptr_t)result->resultValue,
             PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
-    msg->dataType = result->data_type;
-    msg->data = result->data;
+    if (msg) {
+        msg->dataType = result->data_type;
+        msg->data = result->data;
+    }
+    else if (result->data) {
+        purc_variant_unref(result->data);
+    }
 
-    pcutils_kvlist_delete(&conn->prot_data->results, request_id);
-    free(result);
+    release_result(result);
 
     if (msg == NULL) {
         purc_set_error(PCRDR_ERROR_NOMEM);
@@ -1334,6 +1350,10 @@ static int evaluate_result(struct pcrdr_prot_data *prot_data,
     struct result_info *result;
 
     result = calloc(1, sizeof(*result));
+    if (result == NULL) {
+        purc_set_error(PCRDR_ERROR_NOMEM);
+        return -1;
+    }
 
     op_atom = pcrdr_check_operation(
             purc_variant_get_string_const(msg->operation));
@@ -1351,10 +1371,18 @@ static int evaluate_result(struct pcrdr_prot_data *prot_data,
     handlers[op_id](prot_data, msg, op_id, result);
 
 done:
-    pcutils_kvlist_set(&prot_data->results,
-            purc_variant_get_string_const(msg->requestId),
-            &result);
+    if (strcmp(purc_variant_get_string_const(msg->requestId),
+                PCRDR_REQUESTID_NORETURN) == 0) {
+        /* for request without return */
+        if (result->data)
+            purc_variant_unref(result->data);
+        free(result);
+        return 0;
+    }
 
+    result->requestId = purc_variant_ref(msg->requestId);
+    clock_gettime(CLOCK_MONOTONIC, &result->ts_sent);
+    list_add_tail(&result->ln, &prot_data->results);
     return 0;
 }
 
@@ -1382,18 +1410,13 @@ static int my_ping_peer(pcrdr_conn* conn)
 
 static int my_disconnect(pcrdr_conn* conn)
 {
-    const char *name;
-    void *next, *data;
-    struct result_info *result;
+    struct result_info *result, *next;
 
-    kvlist_for_each_safe(&conn->prot_data->results, name, next, data) {
-        result = *(struct result_info **)data;
-
-        pcutils_kvlist_delete(&conn->prot_data->results, name);
-        free(result);
+    list_for_each_entry_safe(result, next, &conn->prot_data->results, ln) {
+        if (result->data)
+            purc_variant_unref(result->data);
+        release_result(result);
     }
-
-    pcutils_kvlist_free(&conn->prot_data->results);
     fclose(conn->prot_data->fp);
     if (conn->prot_data->session)
         free(conn->prot_data->session);
@@ -1458,7 +1481,12 @@ pcrdr_msg *pcrdr_headless_connect(const char* renderer_uri,
         goto failed;
     }
 
-    pcutils_kvlist_init(&(*conn)->prot_data->results, NULL);
+    list_head_init(&(*conn)->prot_data->results);
+
+    const char *env_value = getenv(PURC_ENVV_HEADLESS_LATENCY);
+    if (env_value) {
+        (*conn)->prot_data->latency = atoi(env_value) / 1000.0;
+    }
 
     msg = pcrdr_make_response_message("0", NULL,
             PCRDR_SC_OK, 0,
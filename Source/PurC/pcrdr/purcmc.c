@@ -46,18 +46,75 @@
 #include <sys/socket.h>
 #include <sys/fcntl.h>
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <sys/time.h>
 
 #define CLI_PATH    "/var/tmp/"
 #define CLI_PERM    S_IRWXU
 
-static inline int conn_read (int fd, void *buff, ssize_t sz)
+/* the size of the buffer for the input, enough for a few full frames */
+#define RD_BUFF_SIZE            (PCRDR_MAX_FRAME_PAYLOAD_SIZE * 4)
+
+/* the maximal number of frames written by one call to writev(); the two
+   vectors for each frame are well under IOV_MAX */
+#define MAX_FRAMES_PER_WRITE    16
+
+struct pcrdr_prot_data {
+    /* the bytes read from the socket but not consumed yet; all the bytes
+       available are read at once, so the frames coming in a batch are
+       consumed without another system call. */
+    char   *rd_buf;
+    size_t  rd_pos;
+    size_t  rd_len;
+
+    /* the buffer to serialize the messages to send, kept for reuse */
+    char   *wr_buf;
+    size_t  wr_len;
+    size_t  sz_wr_buf;
+};
+
+static int conn_read (pcrdr_conn* conn, void *buff, size_t sz)
 {
-    if (read (fd, buff, sz) == sz) {
-        return 0;
+    struct pcrdr_prot_data *prot_data = conn->prot_data;
+    char *dst = buff;
+
+    while (sz > 0) {
+        ssize_t n;
+
+        if (prot_data->rd_len > 0) {
+            n = (sz < prot_data->rd_len) ? sz : prot_data->rd_len;
+            memcpy (dst, prot_data->rd_buf + prot_data->rd_pos, n);
+            prot_data->rd_pos += n;
+            prot_data->rd_len -= n;
+            dst += n;
+            sz -= n;
+            continue;
+        }
+
+        /* read a large payload directly */
+        if (sz >= RD_BUFF_SIZE) {
+            n = read (conn->fd, dst, sz);
+            if (n > 0) {
+                dst += n;
+                sz -= n;
+                continue;
+            }
+        }
+        else {
+            n = read (conn->fd, prot_data->rd_buf, RD_BUFF_SIZE);
+            if (n > 0) {
+                prot_data->rd_pos = 0;
+                prot_data->rd_len = n;
+                continue;
+            }
+        }
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        return PCRDR_ERROR_IO;
     }
 
-    return PCRDR_ERROR_IO;
+    return 0;
 }
 
 static inline int conn_write (int fd, const void *data, ssize_t sz)
@@ -69,11 +126,46 @@ static inline int conn_write (int fd, const void *data, ssize_t sz)
     return PCRDR_ERROR_IO;
 }
 
+static int conn_writev (int fd, struct iovec *iov, int iovcnt)
+{
+    while (iovcnt > 0) {
+        ssize_t n = writev (fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return PCRDR_ERROR_IO;
+        }
+
+        /* skip the vectors written, and the part written of the next one */
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    return 0;
+}
+
+static bool my_has_buffered_input (pcrdr_conn* conn)
+{
+    return conn->prot_data->rd_len > 0;
+}
+
 static int my_wait_message (pcrdr_conn* conn, int timeout_ms)
 {
     fd_set rfds;
     struct timeval tv;
 
+    /* the rest of a buffered frame is coming or has come */
+    if (my_has_buffered_input (conn))
+        return 1;
+
     FD_ZERO (&rfds);
     FD_SET (conn->fd, &rfds);
 
@@ -125,31 +217,53 @@ done:
     return msg;
 }
 
+static ssize_t write_to_buffer (void *ctxt, const void *buf, size_t count)
+{
+    struct pcrdr_prot_data *prot_data = ctxt;
+
+    if (prot_data->wr_len + count > prot_data->sz_wr_buf) {
+        size_t sz = prot_data->sz_wr_buf;
+        while (sz < prot_data->wr_len + count)
+            sz *= 2;
+
+        char *wr_buf = realloc (prot_data->wr_buf, sz);
+        if (wr_buf == NULL)
+            return -1;
+
+        prot_data->wr_buf = wr_buf;
+        prot_data->sz_wr_buf = sz;
+    }
+
+    memcpy (prot_data->wr_buf + prot_data->wr_len, buf, count);
+    prot_data->wr_len += count;
+    return count;
+}
+
 static int my_send_message (pcrdr_conn* conn, pcrdr_msg *msg)
 {
+    struct pcrdr_prot_data *prot_data = conn->prot_data;
     int retv = -1;
-    purc_rwstream_t buffer = NULL;
-
-    buffer = purc_rwstream_new_buffer (PCRDR_MIN_PACKET_BUFF_SIZE,
-            PCRDR_MAX_INMEM_PAYLOAD_SIZE);
 
-    if (pcrdr_serialize_message (msg,
-                (pcrdr_cb_write)purc_rwstream_write, buffer) < 0) {
+    prot_data->wr_len = 0;
+    if (pcrdr_serialize_message (msg, write_to_buffer, prot_data) < 0) {
         goto done;
     }
 
-    size_t packet_len;
-    const char * packet = purc_rwstream_get_mem_buffer (buffer, &packet_len);
-
-    if (pcrdr_purcmc_send_text_packet (conn, packet, packet_len) < 0) {
+    if (pcrdr_purcmc_send_text_packet (conn,
+                prot_data->wr_buf, prot_data->wr_len) < 0) {
         goto done;
     }
 
     retv = 0;
 
 done:
-    if (buffer) {
-        purc_rwstream_destroy(buffer);
+    /* do not hold a buffer for a large message */
+    if (prot_data->sz_wr_buf > PCRDR_MAX_INMEM_PAYLOAD_SIZE) {
+        char *wr_buf = realloc (prot_data->wr_buf, PCRDR_MIN_PACKET_BUFF_SIZE);
+        if (wr_buf) {
+            prot_data->wr_buf = wr_buf;
+            prot_data->sz_wr_buf = PCRDR_MIN_PACKET_BUFF_SIZE;
+        }
     }
 
     return retv;
@@ -210,6 +324,10 @@ static int my_disconnect (pcrdr_conn* conn)
 
     close (conn->fd);
 
+    free (conn->prot_data->rd_buf);
+    free (conn->prot_data->wr_buf);
+    free (conn->prot_data);
+
     return err_code;
 }
 
@@ -234,12 +352,30 @@ static int purcmc_connect_via_unix_socket (const char* path_to_socket,
         return -1;
     }
 
+    if (((*conn)->prot_data =
+                calloc (1, sizeof (struct pcrdr_prot_data))) == NULL ||
+            ((*conn)->prot_data->rd_buf = malloc (RD_BUFF_SIZE)) == NULL ||
+            ((*conn)->prot_data->wr_buf =
+                malloc (PCRDR_MIN_PACKET_BUFF_SIZE)) == NULL) {
+        PC_DEBUG ("Failed to allocate space for protocol data: %s\n",
+                strerror (errno));
+        if ((*conn)->prot_data) {
+            free ((*conn)->prot_data->rd_buf);
+            free ((*conn)->prot_data);
+        }
+        free (*conn);
+        *conn = NULL;
+        purc_set_error(PCRDR_ERROR_NOMEM);
+        return -1;
+    }
+    (*conn)->prot_data->sz_wr_buf = PCRDR_MIN_PACKET_BUFF_SIZE;
+
     /* create a Unix domain stream socket */
     if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0) {
         PC_DEBUG ("Failed to call `socket` in %s: %s\n", __func__,
                 strerror (errno));
-        purc_set_error(PCRDR_ERROR_IO);
-        return -1;
+        fd = -1;
+        goto error;
     }
 
     {
@@ -299,16 +435,21 @@ static int purcmc_connect_via_unix_socket (const char* path_to_socket,
     (*conn)->send_message = my_send_message;
     (*conn)->ping_peer = my_ping_peer;
     (*conn)->disconnect = my_disconnect;
+    (*conn)->has_buffered_input = my_has_buffered_input;
 
     list_head_init (&(*conn)->pending_requests);
 
     return fd;
 
 error:
-    close (fd);
+    if (fd >= 0)
+        close (fd);
 
     if ((*conn)->own_host_name)
        free((*conn)->own_host_name);
+    free((*conn)->prot_data->rd_buf);
+    free((*conn)->prot_data->wr_buf);
+    free((*conn)->prot_data);
     free(*conn);
     *conn = NULL;
 
@@ -337,7 +478,7 @@ int pcrdr_purcmc_read_packet (pcrdr_conn* conn, char* packet_buf, size_t *sz_pac
     if (conn->type == CT_UNIX_SOCKET) {
         USFrameHeader header;
 
-        if (conn_read (conn->fd, &header, sizeof (USFrameHeader))) {
+        if (conn_read (conn, &header, sizeof (USFrameHeader))) {
             PC_DEBUG ("Failed to read frame header from Unix socket\n");
             err_code = PCRDR_ERROR_IO;
             goto done;
@@ -380,7 +521,7 @@ int pcrdr_purcmc_read_packet (pcrdr_conn* conn, char* packet_buf, size_t *sz_pac
                 is_text = 0;
             }
 
-            if (conn_read (conn->fd, packet_buf, header.sz_payload)) {
+            if (conn_read (conn, packet_buf, header.sz_payload)) {
                 PC_DEBUG ("Failed to read packet from Unix socket\n");
                 err_code = PCRDR_ERROR_IO;
                 goto done;
@@ -393,7 +534,7 @@ int pcrdr_purcmc_read_packet (pcrdr_conn* conn, char* packet_buf, size_t *sz_pac
                 left = 0;
             offset = header.sz_payload;
             while (left > 0) {
-                if (conn_read (conn->fd, &header, sizeof (USFrameHeader))) {
+                if (conn_read (conn, &header, sizeof (USFrameHeader))) {
                     PC_DEBUG ("Failed to read frame header from Unix socket\n");
                     err_code = PCRDR_ERROR_IO;
                     goto done;
@@ -406,7 +547,7 @@ int pcrdr_purcmc_read_packet (pcrdr_conn* conn, char* packet_buf, size_t *sz_pac
                     goto done;
                 }
 
-                if (conn_read (conn->fd, packet_buf + offset, header.sz_payload)) {
+                if (conn_read (conn, packet_buf + offset, header.sz_payload)) {
                     PC_DEBUG ("Failed to read packet from Unix socket\n");
                     err_code = PCRDR_ERROR_IO;
                     goto done;
@@ -458,7 +599,7 @@ int pcrdr_purcmc_read_packet_alloc (pcrdr_conn* conn, void **packet, size_t *sz_
     if (conn->type == CT_UNIX_SOCKET) {
         USFrameHeader header;
 
-        if (conn_read (conn->fd, &header, sizeof (USFrameHeader))) {
+        if (conn_read (conn, &header, sizeof (USFrameHeader))) {
             PC_DEBUG ("Failed to read frame header from Unix socket\n");
             err_code = PCRDR_ERROR_IO;
             goto done;
@@ -521,14 +662,14 @@ int pcrdr_purcmc_read_packet_alloc (pcrdr_conn* conn, void **packet, size_t *sz_
                 goto done;
             }
 
-            if (conn_read (conn->fd, packet_buf, header.sz_payload)) {
+            if (conn_read (conn, packet_buf, header.sz_payload)) {
                 PC_DEBUG ("Failed to read packet from Unix socket\n");
                 err_code = PCRDR_ERROR_IO;
                 goto done;
             }
 
             while (left > 0) {
-                if (conn_read (conn->fd, &header, sizeof (USFrameHeader))) {
+                if (conn_read (conn, &header, sizeof (USFrameHeader))) {
                     PC_DEBUG ("Failed to read frame header from Unix socket\n");
                     err_code = PCRDR_ERROR_IO;
                     goto done;
@@ -541,7 +682,7 @@ int pcrdr_purcmc_read_packet_alloc (pcrdr_conn* conn, void **packet, size_t *sz_
                     goto done;
                 }
 
-                if (conn_read (conn->fd, packet_buf + offset, header.sz_payload)) {
+                if (conn_read (conn, packet_buf + offset, header.sz_payload)) {
                     PC_DEBUG ("Failed to read packet from Unix socket\n");
                     err_code = PCRDR_ERROR_IO;
                     goto done;
@@ -595,50 +736,58 @@ done:
     return 0;
 }
 
+/* the header and the payload of every frame are written by one writev() */
 int pcrdr_purcmc_send_text_packet (pcrdr_conn* conn, const char* text, size_t len)
 {
     int retv = 0;
 
     if (conn->type == CT_UNIX_SOCKET) {
-        USFrameHeader header;
-
-        if (len > PCRDR_MAX_FRAME_PAYLOAD_SIZE) {
-            size_t left = len;
+        USFrameHeader headers[MAX_FRAMES_PER_WRITE];
+        struct iovec iov[MAX_FRAMES_PER_WRITE * 2];
+        size_t left = len;
+        int nr_frames = 0;
+
+        do {
+            USFrameHeader *header = headers + nr_frames;
+
+            if (len <= PCRDR_MAX_FRAME_PAYLOAD_SIZE) {
+                header->op = US_OPCODE_TEXT;
+                header->fragmented = 0;
+                header->sz_payload = len;
+                left = 0;
+            }
+            else if (left == len) {
+                header->op = US_OPCODE_TEXT;
+                header->fragmented = len;
+                header->sz_payload = PCRDR_MAX_FRAME_PAYLOAD_SIZE;
+                left -= PCRDR_MAX_FRAME_PAYLOAD_SIZE;
+            }
+            else if (left > PCRDR_MAX_FRAME_PAYLOAD_SIZE) {
+                header->op = US_OPCODE_CONTINUATION;
+                header->fragmented = 0;
+                header->sz_payload = PCRDR_MAX_FRAME_PAYLOAD_SIZE;
+                left -= PCRDR_MAX_FRAME_PAYLOAD_SIZE;
+            }
+            else {
+                header->op = US_OPCODE_END;
+                header->fragmented = 0;
+                header->sz_payload = left;
+                left = 0;
+            }
 
-            do {
-                if (left == len) {
-                    header.op = US_OPCODE_TEXT;
-                    header.fragmented = len;
-                    header.sz_payload = PCRDR_MAX_FRAME_PAYLOAD_SIZE;
-                    left -= PCRDR_MAX_FRAME_PAYLOAD_SIZE;
-                }
-                else if (left > PCRDR_MAX_FRAME_PAYLOAD_SIZE) {
-                    header.op = US_OPCODE_CONTINUATION;
-                    header.fragmented = 0;
-                    header.sz_payload = PCRDR_MAX_FRAME_PAYLOAD_SIZE;
-                    left -= PCRDR_MAX_FRAME_PAYLOAD_SIZE;
-                }
-                else {
-                    header.op = US_OPCODE_END;
-                    header.fragmented = 0;
-                    header.sz_payload = left;
-                    left = 0;
-                }
+            iov[nr_frames * 2].iov_base = header;
+            iov[nr_frames * 2].iov_len = sizeof (USFrameHeader);
+            iov[nr_frames * 2 + 1].iov_base = (char *)text;
+            iov[nr_frames * 2 + 1].iov_len = header->sz_payload;
+            text += header->sz_payload;
+            nr_frames++;
 
-                if (conn_write (conn->fd, &header, sizeof (USFrameHeader)) == 0) {
-                    retv = conn_write (conn->fd, text, header.sz_payload);
-                    text += header.sz_payload;
-                }
+            if (nr_frames == MAX_FRAMES_PER_WRITE || left == 0) {
+                retv = conn_writev (conn->fd, iov, nr_frames * 2);
+                nr_frames = 0;
+            }
 
-            } while (left > 0 && retv == 0);
-        }
-        else {
-            header.op = US_OPCODE_TEXT;
-            header.fragmented = 0;
-            header.sz_payload = len;
-            if (conn_write (conn->fd, &header, sizeof (USFrameHeader)) == 0)
-                retv = conn_write (conn->fd, text, len);
-        }
+        } while (left > 0 && retv == 0);
     }
     else if (conn->type == CT_WEB_SOCKET) {
         /* TODO */
@@ -42,7 +42,6 @@ void
 pcutils_array_list_init(struct pcutils_array_list *al)
 {
     memset(al, 0, sizeof(*al));
-    INIT_LIST_HEAD(&al->list);
 }
 
 void
@@ -87,8 +86,6 @@ pcutils_array_list_set(struct pcutils_array_list *al,
         struct pcutils_array_list_node **old)
 {
     PC_ASSERT(node);
-    PC_ASSERT(node->node.prev == NULL);
-    PC_ASSERT(node->node.next == NULL);
     PC_ASSERT(node->idx == (size_t)-1);
     PC_ASSERT(old);
 
@@ -96,12 +93,10 @@ pcutils_array_list_set(struct pcutils_array_list *al,
         return -1;
 
     PC_ASSERT(al->nodes);
-    struct pcutils_array_list_node *curr = al->nodes[idx];
-    list_del(&curr->node);
-    list_add_tail(&node->node, &al->list);
-
     *old = al->nodes[idx];
+    (*old)->idx = -1;
     al->nodes[idx] = node;
+    node->idx = idx;
 
     return 0;
 }
@@ -112,14 +107,13 @@ pcutils_array_list_insert_before(struct pcutils_array_list *al,
         struct pcutils_array_list_node *node)
 {
     PC_ASSERT(node);
-    PC_ASSERT(node->node.prev == NULL);
-    PC_ASSERT(node->node.next == NULL);
     PC_ASSERT(node->idx == (size_t)-1);
 
     int r;
 
     if (al->nr == al->sz) {
-        r = pcutils_array_list_expand(al, al->sz + 16);
+        /* grow geometrically to keep appending amortized O(1) */
+        r = pcutils_array_list_expand(al, al->sz + al->sz / 2 + 16);
         if (r)
             return -1;
     }
@@ -127,19 +121,15 @@ pcutils_array_list_insert_before(struct pcutils_array_list *al,
     if (idx >= al->nr)
         idx = al->nr;
 
-    if (al->nr > 0) {
-        for (size_t i=al->nr-1; i>=idx; --i) {
-            al->nodes[i+1] = al->nodes[i];
-            al->nodes[i+1]->idx = i+1;
-            if (i==0)
-                break;
-        }
+    if (idx < al->nr) {
+        memmove(al->nodes + idx + 1, al->nodes + idx,
+                (al->nr - idx) * sizeof(*al->nodes));
+        for (size_t i = idx + 1; i <= al->nr; ++i)
+            al->nodes[i]->idx = i;
     }
     al->nodes[idx] = node;
     al->nodes[idx]->idx = idx;
 
-    list_add_tail(&node->node, &al->list);
-
     al->nr += 1;
 
     return 0;
@@ -157,13 +147,12 @@ pcutils_array_list_remove(struct pcutils_array_list *al,
 
     struct pcutils_array_list_node *node = al->nodes[idx];
 
-    for (size_t i=node->idx; i+1<al->nr; ++i) {
-        al->nodes[i] = al->nodes[i+1];
+    memmove(al->nodes + idx, al->nodes + idx + 1,
+            (al->nr - idx - 1) * sizeof(*al->nodes));
+    for (size_t i = idx; i + 1 < al->nr; ++i)
         al->nodes[i]->idx = i;
-    }
     al->nodes[al->nr-1] = NULL;
 
-    list_del(&node->node);
     node->idx = -1;
 
     *old = node;
@@ -173,16 +162,6 @@ pcutils_array_list_remove(struct pcutils_array_list *al,
     return 0;
 }
 
-struct pcutils_array_list_node*
-pcutils_array_list_get(struct pcutils_array_list *al,
-        size_t idx)
-{
-    if (idx < al->nr)
-        return al->nodes[idx];
-
-    return NULL;
-}
-
 int
 pcutils_array_list_swap(struct pcutils_array_list *al,
         size_t i, size_t j)
@@ -204,35 +183,56 @@ pcutils_array_list_swap(struct pcutils_array_list *al,
     return 0;
 }
 
-struct arr_user_data {
-    int (*cmp)(struct pcutils_array_list_node *l,
+typedef int (*node_cmp_f)(struct pcutils_array_list_node *l,
         struct pcutils_array_list_node *r, void *ud);
-    void *ud;
-};
 
-#if OS(HURD) || OS(LINUX)
-static int cmp_f(const void *l, const void *r, void *ud)
-{
-    struct pcutils_array_list_node *l_n, *r_n;
-    l_n = *(struct pcutils_array_list_node**)l;
-    r_n = *(struct pcutils_array_list_node**)r;
+#define MERGE_SORT_RUN      16
 
-    struct arr_user_data *d = (struct arr_user_data*)ud;
-    return d->cmp(l_n, r_n, d->ud);
+static void
+insertion_sort(struct pcutils_array_list_node **nodes, size_t nr,
+        void *ud, node_cmp_f cmp)
+{
+    for (size_t i = 1; i < nr; i++) {
+        struct pcutils_array_list_node *node = nodes[i];
+        size_t j = i;
+        while (j > 0 && cmp(nodes[j - 1], node, ud) > 0) {
+            nodes[j] = nodes[j - 1];
+            j--;
+        }
+        nodes[j] = node;
+    }
 }
-#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD) || OS(WINDOWS)
-static int cmp_f(void *ud, const void *l, const void *r)
+
+static void
+merge_sort(struct pcutils_array_list_node **nodes, size_t nr,
+        struct pcutils_array_list_node **tmp, void *ud, node_cmp_f cmp)
 {
-    struct pcutils_array_list_node *l_n, *r_n;
-    l_n = *(struct pcutils_array_list_node**)l;
-    r_n = *(struct pcutils_array_list_node**)r;
+    if (nr <= MERGE_SORT_RUN) {
+        insertion_sort(nodes, nr, ud, cmp);
+        return;
+    }
+
+    size_t half = nr / 2;
+    merge_sort(nodes, half, tmp, ud, cmp);
+    merge_sort(nodes + half, nr - half, tmp, ud, cmp);
+
+    /* already in order */
+    if (cmp(nodes[half - 1], nodes[half], ud) <= 0)
+        return;
 
-    struct arr_user_data *d = (struct arr_user_data*)ud;
-    return d->cmp(l_n, r_n, d->ud);
+    memcpy(tmp, nodes, half * sizeof(*nodes));
+
+    size_t i = 0, j = half, k = 0;
+    while (i < half && j < nr) {
+        /* take the left one on ties to keep the sort stable */
+        if (cmp(nodes[j], tmp[i], ud) < 0)
+            nodes[k++] = nodes[j++];
+        else
+            nodes[k++] = tmp[i++];
+    }
+    while (i < half)
+        nodes[k++] = tmp[i++];
 }
-#else
-#error Unsupported operating system.
-#endif
 
 void
 pcutils_array_list_sort(struct pcutils_array_list *al,
@@ -242,18 +242,19 @@ pcutils_array_list_sort(struct pcutils_array_list *al,
     struct pcutils_array_list_node **nodes = al->nodes;
     size_t nr = al->nr;
 
-    struct arr_user_data d = {
-        .cmp = cmp,
-        .ud  = ud,
-    };
-
-#if OS(HURD) || OS(LINUX)
-    qsort_r(nodes, nr, sizeof(*nodes), cmp_f, &d);
-#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD)
-    qsort_r(nodes, nr, sizeof(*nodes), &d, cmp_f);
-#elif OS(WINDOWS)
-    qsort_s(nodes, nr, sizeof(*nodes), cmp_f, &d);
-#endif
+    struct pcutils_array_list_node **tmp = NULL;
+    if (nr > MERGE_SORT_RUN)
+        tmp = (struct pcutils_array_list_node**)malloc(
+                (nr / 2) * sizeof(*nodes));
+
+    if (tmp) {
+        merge_sort(nodes, nr, tmp, ud, cmp);
+        free(tmp);
+    }
+    else {
+        /* still stable, though quadratic when out of memory */
+        insertion_sort(nodes, nr, ud, cmp);
+    }
 
     for (size_t i=0; i<al->nr; ++i) {
         struct pcutils_array_list_node *l = al->nodes[i];
@@ -22,31 +22,113 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "config.h"
+
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <sys/types.h>
 
 #include "purc-ports.h"
 #include "purc-utils.h"
 #include "purc-errors.h"
 #include "private/instance.h"
-#include "private/map.h"
 #include "private/utils.h"
 
 #if PURC_ATOM_BUCKET_BITS > 16
 #error "Too many bits reserved for bucket"
 #endif
 
+/*
+ * The atom table is read far more often than it is written: every
+ * keyword, event name, and endpoint lookup goes through
+ * purc_atom_try_string() or purc_atom_to_string(), from all instances
+ * in the process. So readers never take a lock; only the writers
+ * (creating or removing an atom) serialize on `atom_lock`.
+ *
+ * Each bucket owns an open-addressing hash table of 64-bit slots, and
+ * an array (quarks) mapping the sequence number of an atom to its
+ * string. A slot holds the 32-bit hash of the string in the high half
+ * and the sequence number in the low half; an empty slot is zero, and
+ * a slot whose sequence number is zero is a tombstone left by
+ * purc_atom_remove_string_ex().
+ *
+ * The writers never change a table or a quarks array in place except
+ * by storing a single slot or a single string pointer; when either
+ * has to grow, a new copy is built and published with a release store.
+ * The old copies and all atom strings are only freed when the module
+ * is cleaned up, so that a reader holding an old pointer is always
+ * safe. A removed atom is made invisible by clearing its string in the
+ * quarks array, which readers check before comparing the string.
+ */
+
+/* this feature needs C11 (stdatomic.h) or above */
+#if HAVE(STDATOMIC_H)
+
+#include <stdatomic.h>
+
+#define ATOMIC(type)                _Atomic(type)
+#define LOAD_ACQUIRE(p)             atomic_load_explicit(p, memory_order_acquire)
+#define LOAD_RELAXED(p)             atomic_load_explicit(p, memory_order_relaxed)
+#define STORE_RELEASE(p, v)         \
+    atomic_store_explicit(p, v, memory_order_release)
+#define STORE_RELAXED(p, v)         \
+    atomic_store_explicit(p, v, memory_order_relaxed)
+
+#define atom_reader_lock()          do { } while (0)
+#define atom_reader_unlock()        do { } while (0)
+
+#else   /* HAVE(STDATOMIC_H) */
+
+/* fall back to serializing the readers with the writers */
+#define ATOMIC(type)                type
+#define LOAD_ACQUIRE(p)             (*(p))
+#define LOAD_RELAXED(p)             (*(p))
+#define STORE_RELEASE(p, v)         (*(p) = (v))
+#define STORE_RELAXED(p, v)         (*(p) = (v))
+
+#define atom_reader_lock()          purc_mutex_lock(&atom_lock)
+#define atom_reader_unlock()        purc_mutex_unlock(&atom_lock)
+
+#endif  /* !HAVE(STDATOMIC_H) */
+
+/* all blocks which can only be freed on cleanup are chained by this header */
+struct atom_retired {
+    struct atom_retired *next;
+};
+
+struct atom_table {
+    struct atom_retired         retired;
+    size_t                      nr_slots;   /* always a power of two */
+    ATOMIC(uint64_t)            slots[];
+};
+
+struct atom_quarks {
+    struct atom_retired         retired;
+    size_t                      capacity;
+    ATOMIC(char *)              strings[];
+};
+
 static struct atom_bucket {
-    purc_atom_t     bucket_bits;
-    purc_atom_t     atom_seq_id;
+    ATOMIC(struct atom_table *)     table;
+    ATOMIC(struct atom_quarks *)    quarks;
 
-    pcutils_map    *atom_map;
-    char**          quarks;
+    /* the following fields are only accessed by the writers */
+    purc_atom_t     atom_seq_id;
+    size_t          nr_used;        /* live slots and tombstones */
+    size_t          nr_live;
 } atom_buckets[PURC_ATOM_BUCKETS_NR];
 
+struct atom_string_block {
+    struct atom_retired         retired;
+    size_t                      size;
+    size_t                      offset;
+    char                        data[];
+};
+
 #define ATOM_BITS_NR        (sizeof(purc_atom_t) << 3)
 
 #define BUCKET_BITS(bucket)       \
@@ -62,68 +144,237 @@ static struct atom_bucket {
     (seq < ((purc_atom_t)1 << (ATOM_BITS_NR - PURC_ATOM_BUCKET_BITS)))
 
 #define ATOM_BLOCK_SIZE         (1024 >> PURC_ATOM_BUCKET_BITS)
-#define ATOM_STRING_BLOCK_SIZE  (4096 - sizeof (size_t))
+#define ATOM_STRING_BLOCK_SIZE  (4096 - sizeof (struct atom_string_block))
+#define ATOM_TABLE_MIN_SLOTS    64
 
-static inline purc_atom_t
-atom_new(struct atom_bucket *bucket, char *string, bool need_free);
+#define SLOT_MAKE(hash, seq)    (((uint64_t)(hash) << 32) | (seq))
+#define SLOT_HASH(slot)         ((uint32_t)((slot) >> 32))
+#define SLOT_SEQ(slot)          ((purc_atom_t)(slot))
 
-static purc_rwlock atom_rwlock;
-static char *atom_block = NULL;
-static int  atom_block_offset = 0;
+static purc_mutex atom_lock;
+static struct atom_string_block *atom_string_blocks;
+static struct atom_retired *atom_retired_list;
+
+/* HOLDS: atom_lock */
+static inline void atom_retire(struct atom_retired *retired)
+{
+    retired->next = atom_retired_list;
+    atom_retired_list = retired;
+}
+
+/* Jenkins' one-at-a-time hash; never returns zero so that a slot
+   holding a valid atom or a tombstone is never taken as empty. */
+static inline uint32_t atom_hash(const char *string)
+{
+    const unsigned char *p = (const unsigned char *)string;
+    uint32_t hash = 0;
+
+    while (*p) {
+        hash += *p++;
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+
+    return hash | 1;
+}
 
-static void atom_init_bucket(struct atom_bucket *bucket)
+static struct atom_table *atom_table_new(size_t nr_slots)
 {
-    assert (bucket->atom_seq_id == 0);
+    struct atom_table *table;
+
+    table = calloc(1, sizeof(*table) + sizeof(table->slots[0]) * nr_slots);
+    if (table)
+        table->nr_slots = nr_slots;
+    return table;
+}
+
+/*
+ * Returns the index of the slot of @string in @table, or -1 if not found.
+ * It is called by both readers and writers.
+ */
+static ssize_t
+atom_table_find(struct atom_bucket *bucket, struct atom_table *table,
+        const char *string, uint32_t hash, purc_atom_t *seq)
+{
+    size_t mask = table->nr_slots - 1;
+    size_t idx = hash & mask;
+
+    for (size_t n = 0; n < table->nr_slots; n++, idx = (idx + 1) & mask) {
+        uint64_t slot = LOAD_ACQUIRE(&table->slots[idx]);
+
+        if (slot == 0)
+            break;
+
+        if (SLOT_HASH(slot) != hash || SLOT_SEQ(slot) == 0)
+            continue;
+
+        /* the quarks array is loaded after the slot, so it covers the seq */
+        struct atom_quarks *quarks = LOAD_ACQUIRE(&bucket->quarks);
+        purc_atom_t s = SLOT_SEQ(slot);
+        if (s >= quarks->capacity)
+            continue;
+
+        const char *str = LOAD_ACQUIRE(&quarks->strings[s]);
+        if (str && strcmp(str, string) == 0) {
+            *seq = s;
+            return (ssize_t)idx;
+        }
+    }
+
+    return -1;
+}
+
+/* HOLDS: atom_lock */
+static void atom_table_insert(struct atom_table *table, uint64_t slot)
+{
+    size_t mask = table->nr_slots - 1;
+    size_t idx = SLOT_HASH(slot) & mask;
+
+    while (LOAD_RELAXED(&table->slots[idx]) != 0)
+        idx = (idx + 1) & mask;
+
+    STORE_RELEASE(&table->slots[idx], slot);
+}
+
+/* HOLDS: atom_lock */
+static bool atom_table_reserve(struct atom_bucket *bucket)
+{
+    struct atom_table *table = LOAD_RELAXED(&bucket->table);
+
+    /* keep the load factor (tombstones included) not greater than 1/2 */
+    if ((bucket->nr_used + 1) * 2 <= table->nr_slots)
+        return true;
+
+    size_t nr_slots = ATOM_TABLE_MIN_SLOTS;
+    while (nr_slots < (bucket->nr_live + 1) * 4)
+        nr_slots <<= 1;
+
+    struct atom_table *new_table = atom_table_new(nr_slots);
+    if (new_table == NULL)
+        return false;
+
+    for (size_t i = 0; i < table->nr_slots; i++) {
+        uint64_t slot = LOAD_RELAXED(&table->slots[i]);
+        if (slot && SLOT_SEQ(slot))
+            atom_table_insert(new_table, slot);
+    }
+
+    STORE_RELEASE(&bucket->table, new_table);
+    atom_retire(&table->retired);
+    bucket->nr_used = bucket->nr_live;
+    return true;
+}
+
+/* HOLDS: atom_lock */
+static bool atom_quarks_reserve(struct atom_bucket *bucket)
+{
+    struct atom_quarks *quarks = LOAD_RELAXED(&bucket->quarks);
+
+    if (quarks && bucket->atom_seq_id < quarks->capacity)
+        return true;
 
-    bucket->atom_map = pcutils_map_create(NULL, NULL, NULL, NULL,
-            comp_key_string, false);
-    bucket->quarks = (char **)malloc(sizeof(char *) * ATOM_BLOCK_SIZE);
-    bucket->quarks[0] = NULL;
+    size_t capacity = bucket->atom_seq_id + ATOM_BLOCK_SIZE;
+    struct atom_quarks *new_quarks = calloc(1, sizeof(*new_quarks) +
+            sizeof(new_quarks->strings[0]) * capacity);
+    if (new_quarks == NULL)
+        return false;
+
+    new_quarks->capacity = capacity;
+    if (quarks) {
+        for (size_t i = 0; i < quarks->capacity; i++) {
+            STORE_RELAXED(&new_quarks->strings[i],
+                    LOAD_RELAXED(&quarks->strings[i]));
+        }
+    }
+
+    /*
+     * Like the implementation in glib, we do not free the old quarks
+     * array at once, so that the readers can do lockless lookup.
+     * Unlike glib, the old arrays are freed when the module is cleaned up.
+     */
+    STORE_RELEASE(&bucket->quarks, new_quarks);
+    if (quarks)
+        atom_retire(&quarks->retired);
+    return true;
+}
+
+/* HOLDS: atom_lock */
+static bool atom_init_bucket(struct atom_bucket *bucket)
+{
+    assert(bucket->atom_seq_id == 0);
+
+    /* sequence number 0 is reserved for tombstones and the null atom */
     bucket->atom_seq_id = 1;
+    if (!atom_quarks_reserve(bucket))
+        goto failed;
+
+    struct atom_table *table = atom_table_new(ATOM_TABLE_MIN_SLOTS);
+    if (table == NULL)
+        goto failed;
 
-    assert(bucket->quarks != NULL);
+    STORE_RELEASE(&bucket->table, table);
+    return true;
+
+failed:
+    bucket->atom_seq_id = 0;
+    return false;
 }
 
-static inline struct atom_bucket *atom_get_bucket(int bucket)
+/* HOLDS: atom_lock */
+static struct atom_bucket *atom_get_bucket_locked(int bucket)
 {
     assert(bucket >= 0 && bucket < PURC_ATOM_BUCKETS_NR);
 
     struct atom_bucket *atom_bucket = atom_buckets + bucket;
     if (UNLIKELY(atom_bucket->atom_seq_id == 0)) {
-        atom_init_bucket(atom_bucket);
-        atom_bucket->bucket_bits = BUCKET_BITS(bucket);
+        if (!atom_init_bucket(atom_bucket))
+            return NULL;
     }
 
     return atom_bucket;
 }
 
-static inline void atom_put_bucket(int bucket)
+static void atom_put_bucket(int bucket)
 {
     assert(bucket >= 0 && bucket < PURC_ATOM_BUCKETS_NR);
 
     struct atom_bucket *atom_bucket = atom_buckets + bucket;
-    if (LIKELY(atom_bucket->atom_map)) {
-        pcutils_map_destroy(atom_bucket->atom_map);
-        free(atom_bucket->quarks);
-        memset(atom_bucket, 0, sizeof(*atom_bucket));
-    }
+    struct atom_table *table = LOAD_RELAXED(&atom_bucket->table);
+    struct atom_quarks *quarks = LOAD_RELAXED(&atom_bucket->quarks);
+
+    if (table)
+        free(table);
+    if (quarks)
+        free(quarks);
+    STORE_RELAXED(&atom_bucket->table, NULL);
+    STORE_RELAXED(&atom_bucket->quarks, NULL);
+    atom_bucket->atom_seq_id = 0;
+    atom_bucket->nr_used = 0;
+    atom_bucket->nr_live = 0;
 }
 
 purc_atom_t
 purc_atom_try_string_ex(int bucket, const char *string)
 {
-    struct atom_bucket *atom_bucket = atom_get_bucket(bucket);
-    const pcutils_map_entry* entry = NULL;
-    purc_atom_t atom = 0;
+    assert(bucket >= 0 && bucket < PURC_ATOM_BUCKETS_NR);
+
+    struct atom_bucket *atom_bucket = atom_buckets + bucket;
+    purc_atom_t atom = 0, seq;
 
-    if (string == NULL || atom_bucket == NULL)
+    if (string == NULL)
         return 0;
 
-    purc_rwlock_reader_lock(&atom_rwlock);
-    if ((entry = pcutils_map_find(atom_bucket->atom_map, string))) {
-        atom = (purc_atom_t)(uintptr_t)entry->val;
-    }
-    purc_rwlock_reader_unlock(&atom_rwlock);
+    uint32_t hash = atom_hash(string);
+
+    atom_reader_lock();
+    struct atom_table *table = LOAD_ACQUIRE(&atom_bucket->table);
+    if (table && atom_table_find(atom_bucket, table, string, hash, &seq) >= 0)
+        atom = seq | BUCKET_BITS(bucket);
+    atom_reader_unlock();
 
     return atom;
 }
@@ -131,100 +382,141 @@ purc_atom_try_string_ex(int bucket, const char *string)
 bool
 purc_atom_remove_string_ex(int bucket, const char *string)
 {
-    struct atom_bucket *atom_bucket = atom_get_bucket(bucket);
+    assert(bucket >= 0 && bucket < PURC_ATOM_BUCKETS_NR);
 
-    if (string == NULL || atom_bucket == NULL)
+    struct atom_bucket *atom_bucket = atom_buckets + bucket;
+    purc_atom_t seq;
+    bool ret = false;
+
+    if (string == NULL)
         return false;
 
-    const pcutils_map_entry* entry;
-    bool ret;
-    purc_atom_t atom;
+    uint32_t hash = atom_hash(string);
+
+    purc_mutex_lock(&atom_lock);
+    struct atom_table *table = LOAD_RELAXED(&atom_bucket->table);
+    ssize_t idx;
+    if (table &&
+            (idx = atom_table_find(atom_bucket, table, string, hash,
+                                   &seq)) >= 0) {
+        struct atom_quarks *quarks = LOAD_RELAXED(&atom_bucket->quarks);
 
-    purc_rwlock_writer_lock(&atom_rwlock);
-    if ((entry = pcutils_map_find(atom_bucket->atom_map, string))) {
-        atom = (purc_atom_t)(uintptr_t)entry->val;
-        pcutils_map_erase(atom_bucket->atom_map, (void *)string);
-        atom = ATOM_TO_SEQUENCE(atom);
-        atom_bucket->quarks[atom] = NULL;
+        /* the string itself is kept in the arena until cleanup */
+        STORE_RELEASE(&quarks->strings[seq], NULL);
+        STORE_RELEASE(&table->slots[idx], SLOT_MAKE(hash, 0));
+        atom_bucket->nr_live--;
         ret = true;
     }
-    else {
-        ret = false;
-    }
-    purc_rwlock_writer_unlock(&atom_rwlock);
+    purc_mutex_unlock(&atom_lock);
 
     return ret;
 }
 
-/* HOLDS: atom_rwlock_lock */
+/* HOLDS: atom_lock */
 static char *
-atom_strdup(const char *string, bool *need_free)
+atom_strdup(const char *string)
 {
-    char *copy;
+    struct atom_string_block *block;
     size_t len;
 
     len = strlen(string) + 1;
 
-    /* For strings longer than half the block size, fall back
-       to strdup so that we fill our blocks at least 50%. */
-    if (len > ATOM_STRING_BLOCK_SIZE / 2 ||
-            atom_block_offset + len > ATOM_STRING_BLOCK_SIZE) {
-        *need_free = true;
-        return strdup(string);
+    /* For strings longer than half the block size, use a dedicated block
+       so that we fill our blocks at least 50%. */
+    if (len > ATOM_STRING_BLOCK_SIZE / 2) {
+        block = malloc(sizeof(*block) + len);
+        if (block == NULL)
+            return NULL;
+
+        block->size = block->offset = len;
+        if (atom_string_blocks) {
+            /* keep the current block at the head of the chain */
+            block->retired.next = atom_string_blocks->retired.next;
+            atom_string_blocks->retired.next = &block->retired;
+        }
+        else {
+            block->retired.next = NULL;
+            atom_string_blocks = block;
+        }
+        return memcpy(block->data, string, len);
     }
 
-    *need_free = false;
-    if (atom_block == NULL) {
-        atom_block = malloc(ATOM_STRING_BLOCK_SIZE);
+    block = atom_string_blocks;
+    if (block == NULL || block->offset + len > block->size) {
+        block = malloc(sizeof(*block) + ATOM_STRING_BLOCK_SIZE);
+        if (block == NULL)
+            return NULL;
+
+        block->size = ATOM_STRING_BLOCK_SIZE;
+        block->offset = 0;
+        block->retired.next =
+            atom_string_blocks ? &atom_string_blocks->retired : NULL;
+        atom_string_blocks = block;
     }
 
-    copy = atom_block + atom_block_offset;
+    char *copy = block->data + block->offset;
     memcpy(copy, string, len);
-    atom_block_offset += len;
+    block->offset += len;
 
     return copy;
 }
 
-/* HOLDS: purc_atom_rwlock_writer_lock */
-static inline purc_atom_t
-atom_from_string(struct atom_bucket *bucket, const char *string,
+/* HOLDS: atom_lock */
+static purc_atom_t
+atom_new(struct atom_bucket *bucket, int bucket_id,
+        char *string, uint32_t hash)
+{
+    purc_atom_t atom;
+
+    if (!atom_quarks_reserve(bucket) || !atom_table_reserve(bucket))
+        return 0;
+
+    atom = bucket->atom_seq_id;
+    struct atom_quarks *quarks = LOAD_RELAXED(&bucket->quarks);
+
+    /* publish the string before the slot refering to it */
+    STORE_RELEASE(&quarks->strings[atom], string);
+    atom_table_insert(LOAD_RELAXED(&bucket->table), SLOT_MAKE(hash, atom));
+    bucket->nr_used++;
+    bucket->nr_live++;
+    bucket->atom_seq_id++;
+
+    assert(IS_VALID_SEQ_ID(bucket->atom_seq_id));
+
+    return atom | BUCKET_BITS(bucket_id);
+}
+
+static purc_atom_t
+atom_from_string(int bucket, const char *string,
         bool duplicate, bool *newly_created)
 {
-    purc_atom_t atom = 0;
-    pcutils_map_entry* entry;
+    purc_atom_t atom = 0, seq;
+    uint32_t hash = atom_hash(string);
+
+    purc_mutex_lock(&atom_lock);
+
+    struct atom_bucket *atom_bucket = atom_get_bucket_locked(bucket);
+    if (atom_bucket == NULL)
+        goto done;
 
-    entry = pcutils_map_find(bucket->atom_map, string);
-    if (entry) {
-        atom = (purc_atom_t)(uintptr_t)entry->val;
-        assert(atom);
+    if (atom_table_find(atom_bucket, LOAD_RELAXED(&atom_bucket->table),
+                string, hash, &seq) >= 0) {
+        atom = seq | BUCKET_BITS(bucket);
 
         if (newly_created)
             *newly_created = false;
     }
     else {
-        bool need_free;
-        if (duplicate)
-            string = atom_strdup(string, &need_free);
-        else
-            need_free = false;
-        atom = atom_new(bucket, (char *)string, need_free);
+        char *copy = duplicate ? atom_strdup(string) : (char *)string;
+        if (copy)
+            atom = atom_new(atom_bucket, bucket, copy, hash);
 
         if (newly_created)
-            *newly_created = true;
+            *newly_created = (atom != 0);
     }
 
-    return atom;
-}
-
-static inline purc_atom_t
-atom_from_string_locked(struct atom_bucket *bucket, const char *string,
-        bool duplicate, bool *newly_created)
-{
-    purc_atom_t atom = 0;
-    purc_rwlock_writer_lock(&atom_rwlock);
-    atom = atom_from_string(bucket, string, duplicate, newly_created);
-    purc_rwlock_writer_unlock(&atom_rwlock);
-
+done:
+    purc_mutex_unlock(&atom_lock);
     return atom;
 }
 
@@ -234,8 +526,7 @@ purc_atom_from_string_ex2(int bucket, const char *string, bool *newly_created)
     if (!string)
         return 0;
 
-    return atom_from_string_locked(atom_get_bucket(bucket), string,
-            true, newly_created);
+    return atom_from_string(bucket, string, true, newly_created);
 }
 
 purc_atom_t
@@ -245,8 +536,7 @@ purc_atom_from_static_string_ex2(int bucket, const char *string,
     if (!string)
         return 0;
 
-    return atom_from_string_locked(atom_get_bucket(bucket), string,
-            false, newly_created);
+    return atom_from_string(bucket, string, false, newly_created);
 }
 
 const char *
@@ -259,63 +549,16 @@ purc_atom_to_string(purc_atom_t atom)
         return NULL;
 
     bucket = ATOM_TO_BUCKET(atom);
-    struct atom_bucket *atom_bucket = atom_get_bucket(bucket);
+    struct atom_bucket *atom_bucket = atom_buckets + bucket;
     atom = ATOM_TO_SEQUENCE(atom);
-    purc_rwlock_reader_lock(&atom_rwlock);
-    if (atom < atom_bucket->atom_seq_id)
-        result = atom_bucket->quarks[atom];
-    purc_rwlock_reader_unlock(&atom_rwlock);
-
-    return result;
-}
 
-static void free_dup_key(void *key, void *data)
-{
-    UNUSED_PARAM(data);
-    if (key)
-        free(key);
-}
+    atom_reader_lock();
+    struct atom_quarks *quarks = LOAD_ACQUIRE(&atom_bucket->quarks);
+    if (quarks && atom < quarks->capacity)
+        result = LOAD_ACQUIRE(&quarks->strings[atom]);
+    atom_reader_unlock();
 
-/* HOLDS: purc_atom_rwlock_writer_lock */
-static inline purc_atom_t
-atom_new(struct atom_bucket *bucket, char *string, bool need_free)
-{
-    purc_atom_t atom;
-    char **atoms_new;
-
-    if (bucket->atom_seq_id % ATOM_BLOCK_SIZE == 0) {
-        atoms_new = (char **)malloc(sizeof (char *) *
-                (bucket->atom_seq_id + ATOM_BLOCK_SIZE));
-        if (bucket->atom_seq_id != 0)
-            memcpy(atoms_new, bucket->quarks,
-                    sizeof (char *) * bucket->atom_seq_id);
-        memset(atoms_new + bucket->atom_seq_id, 0,
-                sizeof (char *) * ATOM_BLOCK_SIZE);
-
-        /*
-         * The implementation in glib did not free the old quarks array.
-         * The author said: `This leaks the old quarks array. Its unfortunate,
-         * but it allows us to do lockless lookup of the arrays, and there
-         * shouldn't be that many quarks in an app`.
-         *
-         * In our implementation, we do free the old quarks.
-         * Indeed, we can use realloc() instead of malloc() and memcpy()
-         */
-        free(bucket->quarks);
-        bucket->quarks = atoms_new;
-    }
-
-    atom = bucket->atom_seq_id;
-    bucket->quarks[atom] = string;
-    atom |= bucket->bucket_bits;
-    pcutils_map_insert_ex(bucket->atom_map,
-                string, (void *)(uintptr_t)atom,
-                need_free ? free_dup_key : NULL);
-    bucket->atom_seq_id++;
-
-    assert(IS_VALID_SEQ_ID(bucket->atom_seq_id));
-
-    return atom;
+    return result;
 }
 
 static void
@@ -327,10 +570,21 @@ atom_cleanup_once(void)
         atom_put_bucket(bucket);
     }
 
-    if (atom_rwlock.native_impl)
-        purc_rwlock_clear(&atom_rwlock);
-    if (atom_block)
-        free(atom_block);
+    while (atom_retired_list) {
+        struct atom_retired *next = atom_retired_list->next;
+        free(atom_retired_list);
+        atom_retired_list = next;
+    }
+
+    while (atom_string_blocks) {
+        struct atom_string_block *next =
+            (struct atom_string_block *)atom_string_blocks->retired.next;
+        free(atom_string_blocks);
+        atom_string_blocks = next;
+    }
+
+    if (atom_lock.native_impl)
+        purc_mutex_clear(&atom_lock);
 }
 
 static int
@@ -338,12 +592,12 @@ atom_init_once(void)
 {
     int r = 0;
 
-    purc_rwlock_init(&atom_rwlock);
-    if (atom_rwlock.native_impl == NULL)
+    purc_mutex_init(&atom_lock);
+    if (atom_lock.native_impl == NULL)
         goto fail_lock;
 
     /* init the default bucket only */
-    if (!atom_get_bucket(0))
+    if (!atom_get_bucket_locked(0))
         goto fail_atom;
 
     r = atexit(atom_cleanup_once);
@@ -354,13 +608,9 @@ atom_init_once(void)
 
 fail_atexit:
     atom_put_bucket(0);
-    if (atom_block) {
-        free(atom_block);
-        atom_block = NULL;
-    }
 
 fail_atom:
-    purc_rwlock_clear(&atom_rwlock);
+    purc_mutex_clear(&atom_lock);
 
 fail_lock:
     return -1;
@@ -32,6 +32,7 @@
 #include "config.h"
 #include "private/debug.h"
 #include "private/map.h"
+#include "private/slab.h"
 #include "purc-ports.h"
 
 #if HAVE(GLIB)
@@ -114,7 +115,19 @@ int pcutils_map_destroy (pcutils_map* map)
     return 0;
 }
 
-#if HAVE(GLIB)
+#if USE(SLAB_ALLOCATOR)
+static inline UNUSED_FUNCTION pcutils_map_entry *alloc_entry(void) {
+    return (pcutils_map_entry *)pcslab_alloc(sizeof(pcutils_map_entry));
+}
+
+static inline UNUSED_FUNCTION pcutils_map_entry *alloc_entry_0(void) {
+    return (pcutils_map_entry *)pcslab_alloc0(sizeof(pcutils_map_entry));
+}
+
+static inline void free_entry(pcutils_map_entry *v) {
+    pcslab_free(v, sizeof(pcutils_map_entry));
+}
+#elif HAVE(GLIB)
 static inline UNUSED_FUNCTION pcutils_map_entry *alloc_entry(void) {
     return (pcutils_map_entry *)g_slice_alloc(sizeof(pcutils_map_entry));
 }
@@ -28,6 +28,7 @@
 #include "purc-utils.h"
 #include "private/errors.h"
 #include "private/instance.h"
+#include "private/rwstream.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -557,6 +558,23 @@ int purc_rwstream_read_utf8_char (purc_rwstream_t rws, char* buf_utf8,
     return ch_len;
 }
 
+const uint8_t *
+pcrwstream_get_readable_mem(purc_rwstream_t rws, size_t *nr_bytes)
+{
+    if (rws->funcs == &mem_funcs) {
+        struct mem_rwstream* mem = (struct mem_rwstream *)rws;
+        *nr_bytes = mem->stop - mem->here;
+        return mem->here;
+    }
+    else if (rws->funcs == &buffer_funcs) {
+        struct buffer_rwstream* buffer = (struct buffer_rwstream *)rws;
+        *nr_bytes = buffer->stop - buffer->here;
+        return buffer->here;
+    }
+
+    return NULL;
+}
+
 ssize_t purc_rwstream_write (purc_rwstream_t rws, const void* buf, size_t count)
 {
     if (rws == NULL) {
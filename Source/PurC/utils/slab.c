@@ -0,0 +1,413 @@
+/*
+ * @file slab.c
+ * @brief The slab allocator for small fixed-size objects.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "purc-ports.h"
+#include "private/instance.h"
+#include "private/slab.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if USE(PTHREADS)
+#include <pthread.h>
+#endif
+
+#if USE(SLAB_ALLOCATOR)
+
+#define CHUNK_SIZE          (64 * 1024)
+#define BATCH_SIZE          32
+
+struct slab_free {
+    struct slab_free       *next;
+};
+
+/* the free objects of a size class cached by an instance */
+struct slab_bin {
+    struct slab_free       *head;
+    size_t                  nr;
+};
+
+struct pcslab_cache {
+    struct slab_bin         bins[PCSLAB_NR_CLASSES];
+    size_t                  max_cached;
+};
+
+struct depot_bin {
+    struct slab_free       *head;
+    size_t                  nr;
+
+    /* the space of the last chunk not carved into objects yet */
+    char                   *bump;
+    char                   *end;
+};
+
+struct slab_chunk {
+    struct slab_chunk      *next;
+};
+
+/* round the header up so that the objects keep the alignment of malloc() */
+#define CHUNK_HEADER_SIZE   \
+    ((sizeof(struct slab_chunk) + PCSLAB_GRANULE - 1) & ~(PCSLAB_GRANULE - 1))
+
+static struct {
+    purc_mutex              lock;
+    struct depot_bin        bins[PCSLAB_NR_CLASSES];
+    struct slab_chunk      *chunks;
+    size_t                  sz_chunks;
+    size_t                  sz_free;
+
+    /* the number of the instances, and of the objects out of the depot;
+       the chunks are freed when both drop to zero */
+    size_t                  nr_insts;
+    size_t                  nr_used;
+} depot;
+
+static void depot_init(void)
+{
+    purc_mutex_init(&depot.lock);
+}
+
+static inline void depot_lock(void)
+{
+#if USE(PTHREADS)          /* { */
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, depot_init);
+#else                      /* }{ */
+    static int inited = false;
+    if (!inited) {
+        depot_init();
+        inited = true;
+    }
+#endif                     /* } */
+
+    /* the depot is shared by all threads; it is not locked only if
+       the mutex could not be created */
+    if (depot.lock.native_impl)
+        purc_mutex_lock(&depot.lock);
+}
+
+static inline void depot_unlock(void)
+{
+    if (depot.lock.native_impl)
+        purc_mutex_unlock(&depot.lock);
+}
+
+static inline size_t class_size(unsigned cls)
+{
+    return (cls + 1) * PCSLAB_GRANULE;
+}
+
+/* called with the depot locked */
+static struct slab_free *depot_carve(unsigned cls)
+{
+    struct depot_bin *bin = depot.bins + cls;
+    size_t size = class_size(cls);
+
+    if (bin->bump == NULL || bin->bump + size > bin->end) {
+        struct slab_chunk *chunk = malloc(CHUNK_SIZE);
+        if (chunk == NULL)
+            return NULL;
+
+        chunk->next = depot.chunks;
+        depot.chunks = chunk;
+        depot.sz_chunks += CHUNK_SIZE;
+
+        /* the tail of the previous chunk is lost for good */
+        if (bin->bump)
+            depot.sz_free -= bin->end - bin->bump;
+
+        bin->bump = (char *)chunk + CHUNK_HEADER_SIZE;
+        bin->end = bin->bump +
+            (CHUNK_SIZE - CHUNK_HEADER_SIZE) / size * size;
+        depot.sz_free += bin->end - bin->bump;
+    }
+
+    struct slab_free *obj = (struct slab_free *)bin->bump;
+    bin->bump += size;
+    depot.sz_free -= size;
+    return obj;
+}
+
+/* called with the depot locked, when no object is out of the depot */
+static void depot_release(void)
+{
+    struct slab_chunk *chunk = depot.chunks;
+    while (chunk) {
+        struct slab_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    depot.chunks = NULL;
+    memset(depot.bins, 0, sizeof(depot.bins));
+    depot.sz_chunks = 0;
+    depot.sz_free = 0;
+}
+
+/* moves at most `nr` objects of the class from the depot to the list */
+static size_t depot_get(unsigned cls, struct slab_free **list, size_t nr)
+{
+    struct depot_bin *bin = depot.bins + cls;
+    size_t size = class_size(cls);
+    size_t got = 0;
+
+    depot_lock();
+    while (got < nr) {
+        struct slab_free *obj = bin->head;
+        if (obj) {
+            bin->head = obj->next;
+            bin->nr--;
+            depot.sz_free -= size;
+        }
+        else if ((obj = depot_carve(cls)) == NULL) {
+            break;
+        }
+
+        obj->next = *list;
+        *list = obj;
+        got++;
+    }
+    depot.nr_used += got;
+    depot_unlock();
+
+    return got;
+}
+
+/* gives the first `nr` objects of the list back to the depot */
+static struct slab_free *
+depot_put(unsigned cls, struct slab_free *list, size_t nr)
+{
+    struct depot_bin *bin = depot.bins + cls;
+
+    depot_lock();
+    size_t i;
+    for (i = 0; i < nr && list; i++) {
+        struct slab_free *obj = list;
+        list = obj->next;
+
+        obj->next = bin->head;
+        bin->head = obj;
+    }
+    bin->nr += i;
+    depot.sz_free += i * class_size(cls);
+    depot.nr_used -= i;
+    if (depot.nr_used == 0 && depot.nr_insts == 0)
+        depot_release();
+    depot_unlock();
+
+    return list;
+}
+
+static inline struct pcslab_cache *current_cache(void)
+{
+    struct pcinst *inst = pcinst_current();
+    return inst ? inst->slab_cache : NULL;
+}
+
+void *pcslab_alloc(size_t size)
+{
+    if (size == 0 || size > PCSLAB_MAX_SIZE)
+        return malloc(size);
+
+    unsigned cls = (size - 1) / PCSLAB_GRANULE;
+    struct pcslab_cache *cache = current_cache();
+    struct slab_free *obj = NULL;
+
+    if (cache) {
+        struct slab_bin *bin = cache->bins + cls;
+        if (bin->head == NULL)
+            bin->nr += depot_get(cls, &bin->head, BATCH_SIZE);
+
+        obj = bin->head;
+        if (obj) {
+            bin->head = obj->next;
+            bin->nr--;
+        }
+    }
+    else {
+        depot_get(cls, &obj, 1);
+    }
+
+    return obj;
+}
+
+void *pcslab_alloc0(size_t size)
+{
+    if (size == 0 || size > PCSLAB_MAX_SIZE)
+        return calloc(1, size);
+
+    void *obj = pcslab_alloc(size);
+    if (obj)
+        memset(obj, 0, size);
+    return obj;
+}
+
+void pcslab_free(void *p, size_t size)
+{
+    if (p == NULL)
+        return;
+
+    if (size == 0 || size > PCSLAB_MAX_SIZE) {
+        free(p);
+        return;
+    }
+
+    unsigned cls = (size - 1) / PCSLAB_GRANULE;
+    struct pcslab_cache *cache = current_cache();
+    struct slab_free *obj = p;
+
+    if (cache) {
+        struct slab_bin *bin = cache->bins + cls;
+        obj->next = bin->head;
+        bin->head = obj;
+        bin->nr++;
+
+        /* keep the objects freed last, they are likely still in cache */
+        if (bin->nr > cache->max_cached) {
+            size_t nr_keep = cache->max_cached / 2;
+            struct slab_free **pp = &bin->head;
+            for (size_t i = 0; i < nr_keep; i++)
+                pp = &(*pp)->next;
+
+            size_t nr_put = bin->nr - nr_keep;
+            depot_put(cls, *pp, nr_put);
+            *pp = NULL;
+            bin->nr = nr_keep;
+        }
+    }
+    else {
+        obj->next = NULL;
+        depot_put(cls, obj, 1);
+    }
+}
+
+size_t pcslab_set_max_cached(size_t max_cached)
+{
+    struct pcslab_cache *cache = current_cache();
+    if (cache == NULL)
+        return 0;
+
+    size_t old = cache->max_cached;
+    cache->max_cached = max_cached;
+
+    for (unsigned cls = 0; cls < PCSLAB_NR_CLASSES; cls++) {
+        struct slab_bin *bin = cache->bins + cls;
+        while (bin->nr > max_cached) {
+            bin->head = depot_put(cls, bin->head, 1);
+            bin->nr--;
+        }
+    }
+
+    return old;
+}
+
+void pcslab_get_stat(struct pcslab_stat *stat)
+{
+    memset(stat, 0, sizeof(*stat));
+
+    struct pcslab_cache *cache = current_cache();
+    if (cache) {
+        for (unsigned cls = 0; cls < PCSLAB_NR_CLASSES; cls++) {
+            stat->nr_cached += cache->bins[cls].nr;
+            stat->sz_cached += cache->bins[cls].nr * class_size(cls);
+        }
+    }
+
+    depot_lock();
+    stat->sz_chunks = depot.sz_chunks;
+    stat->sz_depot = depot.sz_free;
+    depot_unlock();
+}
+
+static int slab_init_instance(struct pcinst *curr_inst,
+        const purc_instance_extra_info* extra_info)
+{
+    UNUSED_PARAM(extra_info);
+
+    struct pcslab_cache *cache = calloc(1, sizeof(*cache));
+    if (cache == NULL)
+        return PURC_ERROR_OUT_OF_MEMORY;
+
+    cache->max_cached = PCSLAB_DEF_MAX_CACHED;
+
+    const char *env_value = getenv(PURC_ENVV_SLAB_MAX_CACHED);
+    if (env_value) {
+        char *end;
+        unsigned long max_cached = strtoul(env_value, &end, 10);
+        if (end != env_value && *end == '\0')
+            cache->max_cached = max_cached;
+    }
+
+    curr_inst->slab_cache = cache;
+
+    depot_lock();
+    depot.nr_insts++;
+    depot_unlock();
+    return PURC_ERROR_OK;
+}
+
+static void slab_cleanup_instance(struct pcinst *curr_inst)
+{
+    struct pcslab_cache *cache = curr_inst->slab_cache;
+    if (cache == NULL)
+        return;
+
+    /* the objects freed from now on go to the depot directly */
+    curr_inst->slab_cache = NULL;
+
+    depot_lock();
+    depot.nr_insts--;
+    depot_unlock();
+
+    /* the chunks are freed by the last put once the last instance is
+       gone and all the objects are back, if ever */
+    for (unsigned cls = 0; cls < PCSLAB_NR_CLASSES; cls++) {
+        struct slab_bin *bin = cache->bins + cls;
+        depot_put(cls, bin->head, bin->nr);
+    }
+
+    free(cache);
+}
+
+struct pcmodule _module_slab = {
+    .id              = PURC_HAVE_UTILS,
+    .module_inited   = 0,
+
+    .init_once       = NULL,
+    .init_instance   = slab_init_instance,
+    .cleanup_instance = slab_cleanup_instance,
+};
+
+#else /* USE(SLAB_ALLOCATOR) */
+
+struct pcmodule _module_slab = {
+    .id              = PURC_HAVE_UTILS,
+    .module_inited   = 0,
+
+    .init_once       = NULL,
+    .init_instance   = NULL,
+};
+
+#endif /* !USE(SLAB_ALLOCATOR) */
+
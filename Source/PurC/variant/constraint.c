@@ -506,6 +506,11 @@ wind_up(struct reverse_checker *checker)
 void
 pcvar_adjust_set_by_descendant(purc_variant_t val)
 {
+    // fast path: nothing to adjust for a container that no set refers to
+    struct pcutils_map *chain = get_chain(val);
+    if (!chain || pcutils_map_get_size(chain) == 0)
+        return;
+
     copy_key_fn copy_key = ref;
     free_key_fn free_key = unref;
     copy_val_fn copy_val = ref;
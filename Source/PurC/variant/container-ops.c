@@ -31,6 +31,7 @@
 
 
 #include <limits.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
@@ -316,6 +317,250 @@ remove_array_member(void* ctxt, purc_variant_t member,
     return true;
 }
 
+/* A transient index used to remove the members of a container from a large
+ * array in one pass. Every element of the array is hashed consistently with
+ * PCVARIANT_COMPARE_OPT_AUTO, so the elements equal to a member can only be
+ * in a few chains. The hash only selects the candidates; they are confirmed
+ * by purc_variant_compare_ex(), and the lowest index wins as is_in_array()
+ * does. */
+#define ARR_INDEX_MIN_COST      256
+#define ARR_INDEX_NIL           ((size_t)-1)
+
+struct arr_index {
+    purc_variant_t      array;
+    size_t              nr_elems;       // the original number of elements
+    size_t              nr_removed;
+    size_t              nr_buckets;     // a power of two
+    size_t             *buckets;        // the chains in ascending order
+    size_t             *next;
+    size_t             *fenwick;        // to map to the current indices
+    unsigned char      *removed;
+    size_t              nonfinite;      // the chain of NaNs and infinities
+    size_t              numbers;        // the list of all numbers
+    size_t             *next_number;
+    bool                broken;         // the array was changed by others
+};
+
+static inline uint64_t
+hash_bytes(uint64_t hash, const void *bytes, size_t len)
+{
+    const unsigned char *p = bytes;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static inline bool
+is_number(purc_variant_t v)
+{
+    return v->type == PURC_VARIANT_TYPE_NUMBER ||
+        v->type == PURC_VARIANT_TYPE_LONGINT ||
+        v->type == PURC_VARIANT_TYPE_ULONGINT ||
+        v->type == PURC_VARIANT_TYPE_LONGDOUBLE;
+}
+
+static inline uint64_t
+hash_number(double d)
+{
+    if (d == 0)
+        d = 0;      /* -0 equals to 0 */
+    return hash_bytes(0xcbf29ce484222325ULL, &d, sizeof(d));
+}
+
+static uint64_t
+hash_string(purc_variant_t v)
+{
+    /* stringify in the same way as compare_string_method() */
+    char stackbuf[128];
+    char *buf = pcvar_compare_stringify(v, stackbuf, sizeof(stackbuf));
+    const char *s = buf ? buf : stackbuf;
+    uint64_t hash = hash_bytes(0x84222325cbf29ce4ULL, s, strlen(s));
+    free(buf);
+    return hash;
+}
+
+static void
+arr_index_release(struct arr_index *index)
+{
+    free(index->buckets);
+    free(index->next);
+    free(index->fenwick);
+    free(index->removed);
+    free(index->next_number);
+}
+
+static bool
+arr_index_init(struct arr_index *index, purc_variant_t array)
+{
+    size_t n = purc_variant_array_get_size(array);
+    size_t nr_buckets = 16;
+    while (nr_buckets < n)
+        nr_buckets <<= 1;
+
+    memset(index, 0, sizeof(*index));
+    index->array = array;
+    index->nr_elems = n;
+    index->nr_buckets = nr_buckets;
+    index->nonfinite = ARR_INDEX_NIL;
+    index->numbers = ARR_INDEX_NIL;
+    index->buckets = malloc(sizeof(size_t) * nr_buckets);
+    index->next = malloc(sizeof(size_t) * n);
+    index->fenwick = calloc(n + 1, sizeof(size_t));
+    index->removed = calloc(n, 1);
+    index->next_number = malloc(sizeof(size_t) * n);
+    if (!index->buckets || !index->next || !index->fenwick ||
+            !index->removed || !index->next_number) {
+        arr_index_release(index);
+        return false;
+    }
+
+    for (size_t i = 0; i < nr_buckets; i++)
+        index->buckets[i] = ARR_INDEX_NIL;
+
+    /* insert backwards, so that every chain is in ascending order */
+    for (size_t idx = n; idx-- > 0;) {
+        purc_variant_t v = purc_variant_array_get(array, idx);
+        size_t *head;
+
+        index->next_number[idx] = ARR_INDEX_NIL;
+        if (is_number(v)) {
+            index->next_number[idx] = index->numbers;
+            index->numbers = idx;
+
+            double d = purc_variant_numberify(v);
+            if (isfinite(d))
+                head = index->buckets + (hash_number(d) & (nr_buckets - 1));
+            else
+                head = &index->nonfinite;
+        }
+        else {
+            head = index->buckets + (hash_string(v) & (nr_buckets - 1));
+        }
+
+        index->next[idx] = *head;
+        *head = idx;
+    }
+
+    return true;
+}
+
+/* maps an original index to the current index in the array */
+static size_t
+arr_index_current(struct arr_index *index, size_t idx)
+{
+    size_t nr = 0;
+    for (size_t i = idx; i > 0; i -= i & (~i + 1))
+        nr += index->fenwick[i];
+    return idx - nr;
+}
+
+static bool
+arr_index_is_equal(struct arr_index *index, size_t idx, purc_variant_t v)
+{
+    purc_variant_t val = purc_variant_array_get(index->array,
+            arr_index_current(index, idx));
+    return purc_variant_compare_ex(val, v, PCVARIANT_COMPARE_OPT_AUTO) == 0;
+}
+
+struct arr_index_match {
+    size_t             *link;           // the link to the matched element
+    size_t              idx;
+};
+
+static void
+arr_index_match_chain(struct arr_index *index, size_t *head,
+        purc_variant_t v, struct arr_index_match *match)
+{
+    for (size_t *link = head; *link != ARR_INDEX_NIL && *link < match->idx;
+            link = index->next + *link) {
+        if (!index->removed[*link] && arr_index_is_equal(index, *link, v)) {
+            match->link = link;
+            match->idx = *link;
+            break;
+        }
+    }
+}
+
+static bool
+arr_index_find(struct arr_index *index, purc_variant_t v,
+        struct arr_index_match *match)
+{
+    size_t mask = index->nr_buckets - 1;
+
+    match->link = NULL;
+    match->idx = ARR_INDEX_NIL;
+
+    double d = purc_variant_numberify(v);
+    if (isfinite(d)) {
+        /* equal_doubles() tolerates up to two units in the last place */
+        double probes[5];
+        probes[0] = d;
+        probes[1] = nextafter(d, -INFINITY);
+        probes[2] = nextafter(probes[1], -INFINITY);
+        probes[3] = nextafter(d, INFINITY);
+        probes[4] = nextafter(probes[3], INFINITY);
+        for (size_t i = 0; i < PCA_TABLESIZE(probes); i++) {
+            if (isfinite(probes[i]))
+                arr_index_match_chain(index,
+                        index->buckets + (hash_number(probes[i]) & mask),
+                        v, match);
+        }
+        arr_index_match_chain(index, &index->nonfinite, v, match);
+    }
+    else {
+        /* every number is equal to an infinity */
+        for (size_t idx = index->numbers;
+                idx != ARR_INDEX_NIL && idx < match->idx;
+                idx = index->next_number[idx]) {
+            if (!index->removed[idx] && arr_index_is_equal(index, idx, v)) {
+                match->link = NULL;
+                match->idx = idx;
+                break;
+            }
+        }
+    }
+
+    arr_index_match_chain(index, index->buckets + (hash_string(v) & mask),
+            v, match);
+
+    return match->idx != ARR_INDEX_NIL;
+}
+
+static bool
+remove_array_member_by_index(void* ctxt, purc_variant_t member,
+        purc_variant_t member_extra, bool silently)
+{
+    struct arr_index *index = (struct arr_index *)ctxt;
+    if (index->broken)
+        return remove_array_member(index->array, member, member_extra,
+                silently);
+
+    struct arr_index_match match;
+    if (!arr_index_find(index, member, &match))
+        return true;
+
+    if (!purc_variant_array_remove(index->array,
+                arr_index_current(index, match.idx)))
+        return false;
+
+    /* the element left in a chain is skipped by the removed flag */
+    if (match.link)
+        *match.link = index->next[match.idx];
+    index->removed[match.idx] = 1;
+    for (size_t i = match.idx + 1; i <= index->nr_elems; i += i & (~i + 1))
+        index->fenwick[i]++;
+    index->nr_removed++;
+
+    /* a listener may change the array; do not trust the index any more */
+    if ((size_t)purc_variant_array_get_size(index->array) !=
+            index->nr_elems - index->nr_removed)
+        index->broken = true;
+
+    return true;
+}
+
 static bool
 prepend_array_member(void* ctxt, purc_variant_t member,
         purc_variant_t member_extra, bool silently)
@@ -543,7 +788,25 @@ array_remove(purc_variant_t dst, purc_variant_t src, bool silently)
         goto end;
     }
 
-    if (purc_variant_is_array(src)) {
+    size_t nr_dst = purc_variant_array_get_size(dst);
+    size_t nr_src = purc_variant_is_array(src) ?
+        (size_t)purc_variant_array_get_size(src) :
+        (size_t)purc_variant_set_get_size(src);
+
+    struct arr_index index;
+    if (dst != src && nr_dst * nr_src >= ARR_INDEX_MIN_COST &&
+            arr_index_init(&index, dst)) {
+        if (purc_variant_is_array(src)) {
+            ret = array_foreach(src, remove_array_member_by_index, &index,
+                    silently);
+        }
+        else {
+            ret = set_foreach(src, remove_array_member_by_index, &index,
+                    silently);
+        }
+        arr_index_release(&index);
+    }
+    else if (purc_variant_is_array(src)) {
         ret = array_foreach(src, remove_array_member, dst, silently);
     }
     else {
@@ -38,6 +38,12 @@
 static struct purc_mutex        mh_lock;
 static struct pcvariant_heap    move_heap;
 
+/* the constants referred by frozen values */
+static struct purc_variant      frozen_undefined;
+static struct purc_variant      frozen_null;
+static struct purc_variant      frozen_false;
+static struct purc_variant      frozen_true;
+
 static void mvheap_cleanup_once(void)
 {
     if (mh_lock.native_impl)
@@ -67,6 +73,14 @@ static void mvheap_cleanup_once(void)
     PC_ASSERT(stat->sz_total_mem == 4 * sizeof(purc_variant));
 }
 
+static void init_frozen_constant(purc_variant_t v, enum purc_variant_type type)
+{
+    v->type = type;
+    v->refc = 0;
+    v->flags = PCVARIANT_FLAG_NOFREE | PCVARIANT_FLAG_FROZEN;
+    INIT_LIST_HEAD(&v->listeners);
+}
+
 static int mvheap_init_once(void)
 {
     move_heap.v_undefined.type = PURC_VARIANT_TYPE_UNDEFINED;
@@ -90,6 +104,12 @@ static int mvheap_init_once(void)
     move_heap.v_true.flags = PCVARIANT_FLAG_NOFREE;
     move_heap.v_true.b = true;
 
+    init_frozen_constant(&frozen_undefined, PURC_VARIANT_TYPE_UNDEFINED);
+    init_frozen_constant(&frozen_null, PURC_VARIANT_TYPE_NULL);
+    init_frozen_constant(&frozen_false, PURC_VARIANT_TYPE_BOOLEAN);
+    init_frozen_constant(&frozen_true, PURC_VARIANT_TYPE_BOOLEAN);
+    frozen_true.b = true;
+
     struct purc_variant_stat *stat = &move_heap.stat;
     stat->nr_values[PURC_VARIANT_TYPE_UNDEFINED] = 0;
     stat->sz_mem[PURC_VARIANT_TYPE_UNDEFINED] = sizeof(purc_variant);
@@ -137,6 +157,10 @@ move_variant_in(struct pcinst *inst, purc_variant_t v)
 {
     /* move directly and change the stat info */
 
+    /* frozen values are in the move heap already */
+    if (PCVARIANT_IS_FROZEN(v))
+        return;
+
     if (IS_CONTAINER(v->type) ||
             ((v->type == PURC_VARIANT_TYPE_STRING ||
                 v->type == PURC_VARIANT_TYPE_BSEQUENCE) &&
@@ -164,6 +188,9 @@ move_or_clone_immutable(struct pcinst *inst, purc_variant_t v)
 {
     purc_variant_t retv = PURC_VARIANT_INVALID;
 
+    if (PCVARIANT_IS_FROZEN(v))
+        return v;
+
     if (IS_CONTAINER(v->type))
         return retv;
 
@@ -243,6 +270,9 @@ move_keys_in_cloned_set(struct travel_context *ctxt, purc_variant_t arr);
 static bool
 move_keys_in_cloned_array(struct travel_context *ctxt, purc_variant_t arr)
 {
+    if (PCVARIANT_IS_FROZEN(arr))
+        return true;
+
     size_t idx;
     purc_variant_t v;
     foreach_value_in_variant_array(arr, v, idx) {
@@ -254,7 +284,7 @@ move_keys_in_cloned_array(struct travel_context *ctxt, purc_variant_t arr)
             break;
 
         case PURC_VARIANT_TYPE_OBJECT:
-            move_keys_in_cloned_array(ctxt, v);
+            move_keys_in_cloned_object(ctxt, v);
             break;
 
         case PURC_VARIANT_TYPE_SET:
@@ -274,6 +304,9 @@ move_keys_in_cloned_array(struct travel_context *ctxt, purc_variant_t arr)
 static bool
 move_keys_in_cloned_object(struct travel_context *ctxt, purc_variant_t obj)
 {
+    if (PCVARIANT_IS_FROZEN(obj))
+        return true;
+
     purc_variant_t k,v;
     foreach_key_value_in_variant_object(obj, k, v) {
 
@@ -312,6 +345,9 @@ move_keys_in_cloned_object(struct travel_context *ctxt, purc_variant_t obj)
 static bool
 move_keys_in_cloned_set(struct travel_context *ctxt, purc_variant_t set)
 {
+    if (PCVARIANT_IS_FROZEN(set))
+        return true;
+
     purc_variant_t v;
     foreach_value_in_variant_set(set, v) {
 
@@ -377,6 +413,9 @@ static bool
 move_or_clone_mutable_descendants_in_array(struct travel_context *ctxt,
         purc_variant_t arr)
 {
+    if (PCVARIANT_IS_FROZEN(arr))
+        return true;
+
     size_t idx;
     purc_variant_t v;
     foreach_value_in_variant_array(arr, v, idx) {
@@ -410,7 +449,7 @@ move_or_clone_mutable_descendants_in_array(struct travel_context *ctxt,
             break;
         }
 
-        if (IS_CONTAINER(v->type) && v->refc > 1) {
+        if (IS_CONTAINER(v->type) && v->refc > 1 && !PCVARIANT_IS_FROZEN(v)) {
             retv = purc_variant_container_clone_recursively(v);
             if (retv == PURC_VARIANT_INVALID) {
                 purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
@@ -419,7 +458,7 @@ move_or_clone_mutable_descendants_in_array(struct travel_context *ctxt,
 
             move_keys_in_cloned_container(ctxt, retv);
 
-            _p->val = retv;
+            *_slot = retv;
             pcutils_arrlist_append(ctxt->vrts_to_unref, v);
         }
 
@@ -432,6 +471,9 @@ static bool
 move_or_clone_mutable_descendants_in_object(struct travel_context *ctxt,
         purc_variant_t obj)
 {
+    if (PCVARIANT_IS_FROZEN(obj))
+        return true;
+
     purc_variant_t k,v;
     foreach_key_value_in_variant_object(obj, k, v) {
         purc_variant_t retk, retv;
@@ -473,7 +515,7 @@ move_or_clone_mutable_descendants_in_object(struct travel_context *ctxt,
                 pcutils_arrlist_append(ctxt->vrts_to_unref, k);
             }
 
-            if (v->refc > 1) {
+            if (v->refc > 1 && !PCVARIANT_IS_FROZEN(v)) {
                 retv = purc_variant_container_clone_recursively(v);
                 if (retv == PURC_VARIANT_INVALID) {
                     purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
@@ -503,6 +545,9 @@ static bool
 move_or_clone_mutable_descendants_in_set(struct travel_context *ctxt,
         purc_variant_t set)
 {
+    if (PCVARIANT_IS_FROZEN(set))
+        return true;
+
     purc_variant_t v;
     foreach_value_in_variant_set(set, v) {
         purc_variant_t retv;
@@ -534,7 +579,7 @@ move_or_clone_mutable_descendants_in_set(struct travel_context *ctxt,
             break;
         }
 
-        if (IS_CONTAINER(v->type) && v->refc > 1) {
+        if (IS_CONTAINER(v->type) && v->refc > 1 && !PCVARIANT_IS_FROZEN(v)) {
             retv = purc_variant_container_clone_recursively(v);
             if (retv == PURC_VARIANT_INVALID) {
                 purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
@@ -584,6 +629,9 @@ static bool
 move_or_clone_immutable_descendants_in_array(struct travel_context *ctxt,
         purc_variant_t arr)
 {
+    if (PCVARIANT_IS_FROZEN(arr))
+        return true;
+
     size_t idx;
     purc_variant_t v;
     foreach_value_in_variant_array(arr, v, idx) {
@@ -616,7 +664,7 @@ move_or_clone_immutable_descendants_in_array(struct travel_context *ctxt,
         }
 
         if (retv != v) {
-            _p->val = retv;
+            *_slot = retv;
             if (!(v->flags & PCVARIANT_FLAG_NOFREE))
                 pcutils_arrlist_append(ctxt->vrts_to_unref, v);
         }
@@ -630,6 +678,9 @@ static bool
 move_or_clone_immutable_descendants_in_object(struct travel_context *ctxt,
         purc_variant_t obj)
 {
+    if (PCVARIANT_IS_FROZEN(obj))
+        return true;
+
     purc_variant_t k,v;
     foreach_key_value_in_variant_object(obj, k, v) {
         purc_variant_t retk, retv;
@@ -672,6 +723,9 @@ static bool
 move_or_clone_immutable_descendants_in_set(struct travel_context *ctxt,
         purc_variant_t set)
 {
+    if (PCVARIANT_IS_FROZEN(set))
+        return true;
+
     purc_variant_t v;
     foreach_value_in_variant_set(set, v) {
         purc_variant_t retv;
@@ -742,6 +796,10 @@ purc_variant_t pcvariant_move_heap_in(purc_variant_t v)
     struct pcinst *inst = pcinst_current();
     struct travel_context ctxt;
 
+    /* a frozen value is shared as is */
+    if (PCVARIANT_IS_FROZEN(v))
+        return v;
+
     ctxt.inst = pcinst_current();
     ctxt.vrts_to_unref = pcutils_arrlist_new(cb_free_element);
     if (ctxt.vrts_to_unref == NULL) {
@@ -793,6 +851,9 @@ static void move_container_self_out(purc_variant_t v)
 {
     struct pcinst *inst = pcinst_current();
 
+    if (PCVARIANT_IS_FROZEN(v))
+        return;
+
     inst->org_vrt_heap->stat.sz_mem[v->type] += v->sz_ptr[0];
     inst->org_vrt_heap->stat.sz_total_mem += v->sz_ptr[0];
 
@@ -818,6 +879,9 @@ static purc_variant_t move_set_descendants_out(purc_variant_t v);
 
 static purc_variant_t move_array_descendants_out(purc_variant_t arr)
 {
+    if (PCVARIANT_IS_FROZEN(arr))
+        return arr;
+
     size_t idx;
     purc_variant_t v;
 
@@ -846,7 +910,7 @@ static purc_variant_t move_array_descendants_out(purc_variant_t arr)
             break;
         }
 
-        _p->val = retv;
+        *_slot = retv;
 
     } end_foreach;
 
@@ -855,6 +919,9 @@ static purc_variant_t move_array_descendants_out(purc_variant_t arr)
 
 static purc_variant_t move_object_descendants_out(purc_variant_t obj)
 {
+    if (PCVARIANT_IS_FROZEN(obj))
+        return obj;
+
     purc_variant_t k,v;
     foreach_key_value_in_variant_object(obj, k, v) {
         purc_variant_t retk, retv;
@@ -891,6 +958,9 @@ static purc_variant_t move_object_descendants_out(purc_variant_t obj)
 
 static purc_variant_t move_set_descendants_out(purc_variant_t set)
 {
+    if (PCVARIANT_IS_FROZEN(set))
+        return set;
+
     purc_variant_t v;
     foreach_value_in_variant_set(set, v) {
         purc_variant_t retv;
@@ -927,6 +997,9 @@ static purc_variant_t move_variant_out(purc_variant_t v)
     purc_variant_t retv = v;
     struct pcinst *inst = pcinst_current();
 
+    if (PCVARIANT_IS_FROZEN(v))
+        return v;
+
     if (v == &move_heap.v_undefined) {
         retv = &inst->org_vrt_heap->v_undefined;
         v->refc--;
@@ -1004,6 +1077,9 @@ purc_variant_t pcvariant_move_heap_out(purc_variant_t v)
 {
     purc_variant_t retv = PURC_VARIANT_INVALID;
 
+    if (PCVARIANT_IS_FROZEN(v))
+        return v;
+
     pcvariant_use_move_heap();
     retv = move_variant_out(v);
     pcvariant_use_norm_heap();
@@ -1011,6 +1087,314 @@ purc_variant_t pcvariant_move_heap_out(purc_variant_t v)
     return retv;
 }
 
+/*
+ * A frozen value is immutable, and is shared by instances without moving
+ * or cloning it. Freezing a value is done in three passes:
+ *
+ *  1. check all descendants can be frozen;
+ *  2. replace the constants with the frozen ones, and the mutable
+ *     descendants also referred elsewhere with their deep clones;
+ *  3. move the values to the move heap and mark them frozen.
+ */
+static bool
+check_freezable(purc_variant_t v, bool in_place);
+
+static bool
+check_freezable_member(purc_variant_t m, bool in_place)
+{
+    /* a mutable member referred elsewhere will be cloned */
+    return check_freezable(m, in_place && m->refc == 1);
+}
+
+static bool
+check_freezable(purc_variant_t v, bool in_place)
+{
+    if (PCVARIANT_IS_FROZEN(v))
+        return true;
+
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_DYNAMIC:
+    case PURC_VARIANT_TYPE_NATIVE:
+        /* the entities behind them may not be thread-safe */
+        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+        return false;
+
+    case PURC_VARIANT_TYPE_ARRAY:
+    case PURC_VARIANT_TYPE_OBJECT:
+    case PURC_VARIANT_TYPE_SET:
+        /* the listeners would never be fired */
+        if (in_place && !list_empty(&v->listeners)) {
+            purc_set_error(PURC_ERROR_ACCESS_DENIED);
+            return false;
+        }
+        break;
+
+    case PURC_VARIANT_TYPE_TUPLE:
+        break;
+
+    default:
+        return true;
+    }
+
+    size_t idx, sz = 0;
+    purc_variant_t k, m;
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+        foreach_value_in_variant_array(v, m, idx) {
+            UNUSED_PARAM(idx);
+            if (!check_freezable_member(m, in_place))
+                return false;
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_OBJECT:
+        foreach_key_value_in_variant_object(v, k, m) {
+            UNUSED_PARAM(k);
+            if (!check_freezable_member(m, in_place))
+                return false;
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_SET:
+        foreach_value_in_variant_set(v, m) {
+            if (!check_freezable_member(m, in_place))
+                return false;
+        } end_foreach;
+        break;
+
+    default:
+        purc_variant_tuple_size(v, &sz);
+        for (idx = 0; idx < sz; idx++) {
+            m = purc_variant_tuple_get(v, idx);
+            if (!check_freezable_member(m, in_place))
+                return false;
+        }
+        break;
+    }
+
+    return true;
+}
+
+/* returns the member to be frozen in place of `m`; a new one if not `m` */
+static purc_variant_t
+member_to_freeze(purc_variant_t m)
+{
+    if (PCVARIANT_IS_FROZEN(m))
+        return m;
+
+    if (m->flags & PCVARIANT_FLAG_NOFREE) {
+        purc_variant_t c;
+        if (m->type == PURC_VARIANT_TYPE_UNDEFINED)
+            c = &frozen_undefined;
+        else if (m->type == PURC_VARIANT_TYPE_NULL)
+            c = &frozen_null;
+        else
+            c = m->b ? &frozen_true : &frozen_false;
+        return purc_variant_ref(c);
+    }
+
+    if (pcvariant_is_mutable(m) && m->refc > 1) {
+        purc_variant_t retv = pcvariant_container_clone(m, true);
+        if (retv == PURC_VARIANT_INVALID)
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return retv;
+    }
+
+    return m;
+}
+
+static void
+release_replaced_member(purc_variant_t m, struct pcvar_rev_update_edge *edge)
+{
+    if (IS_CONTAINER(m->type)) {
+        pcvar_break_edge_to_parent(m, edge);
+        pcvar_break_rue_downward(m);
+    }
+
+    purc_variant_unref(m);
+}
+
+static bool
+replace_members_to_freeze(purc_variant_t v)
+{
+    if (PCVARIANT_IS_FROZEN(v))
+        return true;
+
+    size_t idx, sz = 0;
+    purc_variant_t k, m, n;
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+        foreach_value_in_variant_array(v, m, idx) {
+            UNUSED_PARAM(idx);
+            if ((n = member_to_freeze(m)) == PURC_VARIANT_INVALID)
+                return false;
+
+            if (n != m) {
+                struct pcvar_rev_update_edge edge = {
+                    .parent         = v,
+                    .arr_me         = pcvar_arr_slot_node(_data, _slot),
+                };
+                *_slot = n;
+                release_replaced_member(m, &edge);
+            }
+
+            if (!replace_members_to_freeze(n))
+                return false;
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_OBJECT:
+        foreach_key_value_in_variant_object(v, k, m) {
+            UNUSED_PARAM(k);
+            if ((n = member_to_freeze(m)) == PURC_VARIANT_INVALID)
+                return false;
+
+            if (n != m) {
+                struct pcvar_rev_update_edge edge = {
+                    .parent         = v,
+                    .obj_me         = _node,
+                };
+                _node->val = n;
+                release_replaced_member(m, &edge);
+            }
+
+            if (!replace_members_to_freeze(n))
+                return false;
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_SET:
+        foreach_value_in_variant_set(v, m) {
+            if ((n = member_to_freeze(m)) == PURC_VARIANT_INVALID)
+                return false;
+
+            if (n != m) {
+                struct pcvar_rev_update_edge edge = {
+                    .parent         = v,
+                    .set_me         = _sn,
+                };
+                _sn->val = n;
+                release_replaced_member(m, &edge);
+            }
+
+            if (!replace_members_to_freeze(n))
+                return false;
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_TUPLE:
+        purc_variant_tuple_size(v, &sz);
+        for (idx = 0; idx < sz; idx++) {
+            m = purc_variant_tuple_get(v, idx);
+            if ((n = member_to_freeze(m)) == PURC_VARIANT_INVALID)
+                return false;
+
+            if (n != m) {
+                purc_variant_tuple_set(v, idx, n);
+                purc_variant_unref(n);
+            }
+
+            if (!replace_members_to_freeze(n))
+                return false;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return true;
+}
+
+/* called with mh_lock locked */
+static void
+freeze_in_place(struct pcinst *inst, purc_variant_t v)
+{
+    if (PCVARIANT_IS_FROZEN(v))
+        return;
+
+    move_variant_in(inst, v);
+    v->flags |= PCVARIANT_FLAG_FROZEN;
+
+    /* the reverse update edges are useless for the frozen containers */
+    pcutils_map *chain = NULL;
+    size_t idx, sz = 0;
+    purc_variant_t k, m;
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+        chain = pcvar_arr_get_data(v)->rev_update_chain;
+        foreach_value_in_variant_array(v, m, idx) {
+            UNUSED_PARAM(idx);
+            freeze_in_place(inst, m);
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_OBJECT:
+        chain = pcvar_obj_get_data(v)->rev_update_chain;
+        foreach_key_value_in_variant_object(v, k, m) {
+            freeze_in_place(inst, k);
+            freeze_in_place(inst, m);
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_SET:
+        chain = pcvar_set_get_data(v)->rev_update_chain;
+        foreach_value_in_variant_set(v, m) {
+            freeze_in_place(inst, m);
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_TUPLE:
+        purc_variant_tuple_size(v, &sz);
+        for (idx = 0; idx < sz; idx++)
+            freeze_in_place(inst, purc_variant_tuple_get(v, idx));
+        break;
+
+    default:
+        break;
+    }
+
+    if (chain)
+        pcutils_map_clear(chain);
+}
+
+bool purc_variant_freeze(purc_variant_t value)
+{
+    struct pcinst *inst = pcinst_current();
+
+    if (value == PURC_VARIANT_INVALID || inst == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return false;
+    }
+
+    /* the constants are moved between heaps as they were */
+    if (PCVARIANT_IS_FROZEN(value) || (value->flags & PCVARIANT_FLAG_NOFREE))
+        return true;
+
+    if (!check_freezable(value, true))
+        return false;
+
+    if (!replace_members_to_freeze(value))
+        return false;
+
+    purc_mutex_lock(&mh_lock);
+    freeze_in_place(inst, value);
+    purc_mutex_unlock(&mh_lock);
+
+    return true;
+}
+
+bool purc_variant_is_frozen(purc_variant_t value)
+{
+    return value != PURC_VARIANT_INVALID && PCVARIANT_IS_FROZEN(value);
+}
+
+bool pcvariant_is_using_move_heap(void)
+{
+    struct pcinst *inst = pcinst_current();
+    return inst->variant_heap == &move_heap;
+}
+
 void pcvariant_use_move_heap(void)
 {
     struct pcinst *inst = pcinst_current();
@@ -76,6 +76,9 @@ purc_variant_register_pre_listener(purc_variant_t v,
         return NULL;
     }
 
+    /* a frozen container never changes */
+    PCVARIANT_CHECK_NOT_FROZEN_RET(v, NULL);
+
     return register_listener(v, PCVAR_LISTENER_PRE, op, handler, ctxt);
 }
 
@@ -98,6 +101,9 @@ purc_variant_register_post_listener(purc_variant_t v,
         return NULL;
     }
 
+    /* a frozen container never changes */
+    PCVARIANT_CHECK_NOT_FROZEN_RET(v, NULL);
+
     return register_listener(v, PCVAR_LISTENER_POST, op, handler, ctxt);
 }
 
@@ -196,6 +202,9 @@ void
 pcvar_break_rue_downward(purc_variant_t val)
 {
     PC_ASSERT(val != PURC_VARIANT_INVALID);
+    if (PCVARIANT_IS_FROZEN(val))
+        return;
+
     switch (val->type) {
         case PURC_VARIANT_TYPE_ARRAY:
             if (pcvar_container_belongs_to_set(val))
@@ -254,6 +263,9 @@ int
 pcvar_build_rue_downward(purc_variant_t val)
 {
     PC_ASSERT(val != PURC_VARIANT_INVALID);
+    if (PCVARIANT_IS_FROZEN(val))
+        return 0;
+
     switch (val->type) {
         case PURC_VARIANT_TYPE_ARRAY:
             return pcvar_array_build_rue_downward(val);
@@ -27,6 +27,7 @@
 #include "config.h"
 #include "private/variant.h"
 #include "private/errors.h"
+#include "private/slab.h"
 #include "variant-internals.h"
 #include "purc-errors.h"
 #include "purc-utils.h"
@@ -39,88 +40,127 @@
 static size_t
 variant_arr_length(variant_arr_t data)
 {
-    struct pcutils_array_list *al = &data->al;
-    return pcutils_array_list_length(al);
+    return pcvar_arr_length(data);
+}
+
+/* the position argument is only materialized when someone is listening */
+static inline bool
+has_listeners(purc_variant_t arr, bool check)
+{
+    return check && !list_empty(&arr->listeners);
 }
 
 static inline bool
-grow(purc_variant_t arr, purc_variant_t pos, purc_variant_t value,
+grow(purc_variant_t arr, size_t idx, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!has_listeners(arr, check))
         return true;
 
+    purc_variant_t pos = purc_variant_make_longint(idx);
+    if (pos == PURC_VARIANT_INVALID)
+        return false;
+
     purc_variant_t vals[] = { pos, value };
 
-    return pcvariant_on_pre_fired(arr, PCVAR_OPERATION_GROW,
+    bool ok = pcvariant_on_pre_fired(arr, PCVAR_OPERATION_GROW,
             PCA_TABLESIZE(vals), vals);
+    purc_variant_unref(pos);
+    return ok;
 }
 
 static inline bool
-shrink(purc_variant_t arr, purc_variant_t pos, purc_variant_t value,
+shrink(purc_variant_t arr, size_t idx, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!has_listeners(arr, check))
         return true;
 
+    purc_variant_t pos = purc_variant_make_longint(idx);
+    if (pos == PURC_VARIANT_INVALID)
+        return false;
+
     purc_variant_t vals[] = { pos, value };
 
-    return pcvariant_on_pre_fired(arr, PCVAR_OPERATION_SHRINK,
+    bool ok = pcvariant_on_pre_fired(arr, PCVAR_OPERATION_SHRINK,
             PCA_TABLESIZE(vals), vals);
+    purc_variant_unref(pos);
+    return ok;
 }
 
 static inline bool
-change(purc_variant_t arr, purc_variant_t pos,
+change(purc_variant_t arr, size_t idx,
         purc_variant_t o, purc_variant_t n,
         bool check)
 {
-    if (!check)
+    if (!has_listeners(arr, check))
         return true;
 
+    purc_variant_t pos = purc_variant_make_longint(idx);
+    if (pos == PURC_VARIANT_INVALID)
+        return false;
+
     purc_variant_t vals[] = { pos, o, n };
 
-    return pcvariant_on_pre_fired(arr, PCVAR_OPERATION_CHANGE,
+    bool ok = pcvariant_on_pre_fired(arr, PCVAR_OPERATION_CHANGE,
             PCA_TABLESIZE(vals), vals);
+    purc_variant_unref(pos);
+    return ok;
 }
 
 static inline void
-grown(purc_variant_t arr, purc_variant_t pos, purc_variant_t value,
+grown(purc_variant_t arr, size_t idx, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!has_listeners(arr, check))
+        return;
+
+    purc_variant_t pos = purc_variant_make_longint(idx);
+    if (pos == PURC_VARIANT_INVALID)
         return;
 
     purc_variant_t vals[] = { pos, value };
 
     pcvariant_on_post_fired(arr, PCVAR_OPERATION_GROW,
             PCA_TABLESIZE(vals), vals);
+    purc_variant_unref(pos);
 }
 
 static inline void
-shrunk(purc_variant_t arr, purc_variant_t pos, purc_variant_t value,
+shrunk(purc_variant_t arr, size_t idx, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!has_listeners(arr, check))
+        return;
+
+    purc_variant_t pos = purc_variant_make_longint(idx);
+    if (pos == PURC_VARIANT_INVALID)
         return;
 
     purc_variant_t vals[] = { pos, value };
 
     pcvariant_on_post_fired(arr, PCVAR_OPERATION_SHRINK,
             PCA_TABLESIZE(vals), vals);
+    purc_variant_unref(pos);
 }
 
 static inline void
-changed(purc_variant_t arr, purc_variant_t pos,
+changed(purc_variant_t arr, size_t idx,
         purc_variant_t o, purc_variant_t n,
         bool check)
 {
-    if (!check)
+    if (!has_listeners(arr, check))
+        return;
+
+    purc_variant_t pos = purc_variant_make_longint(idx);
+    if (pos == PURC_VARIANT_INVALID)
         return;
 
     purc_variant_t vals[] = { pos, o, n };
 
     pcvariant_on_post_fired(arr, PCVAR_OPERATION_CHANGE,
             PCA_TABLESIZE(vals), vals);
+    purc_variant_unref(pos);
 }
 
 variant_arr_t
@@ -173,24 +213,14 @@ arr_node_destroy(purc_variant_t arr, struct arr_node *node)
         return;
 
     arr_node_release(arr, node);
-    free(node);
-}
-
-static purc_variant_t
-variant_arr_make_pos(variant_arr_t data, size_t idx)
-{
-    size_t len = variant_arr_length(data);
-    if (idx > len)
-        idx = len;
-
-    return purc_variant_make_longint(idx);
+    pcslab_free(node, sizeof(*node));
 }
 
 static struct arr_node*
 arr_node_create(purc_variant_t val)
 {
     struct arr_node *node;
-    node = (struct arr_node*)calloc(1, sizeof(*node));
+    node = (struct arr_node*)pcslab_alloc0(sizeof(*node));
     if (!node) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
@@ -204,6 +234,50 @@ arr_node_create(purc_variant_t val)
     return node;
 }
 
+/* moves the contiguous members into the nodes, which give the members
+   stable locations for the reverse update edges; for good */
+static int
+use_nodes(variant_arr_t data)
+{
+    if (data->use_nodes)
+        return 0;
+
+    struct pcutils_array_list *al = &data->al;
+    if (pcutils_array_list_expand(al, data->nr_vals)) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    for (size_t i = 0; i < data->nr_vals; i++) {
+        struct arr_node *node;
+        node = (struct arr_node*)pcslab_alloc0(sizeof(*node));
+        if (!node) {
+            /* the members are still owned by vals */
+            struct pcutils_array_list_node *p;
+            while (pcutils_array_list_length(al) > 0) {
+                pcutils_array_list_remove(al,
+                        pcutils_array_list_length(al) - 1, &p);
+                pcslab_free(container_of(p, struct arr_node, node),
+                        sizeof(struct arr_node));
+            }
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+
+        node->node.idx = (size_t)-1;
+        node->val = data->vals[i];
+        pcutils_array_list_append(al, &node->node);
+    }
+
+    if (data->vals != data->inline_vals)
+        free(data->vals);
+    data->vals = NULL;
+    data->sz_vals = 0;
+    data->nr_vals = 0;
+    data->use_nodes = true;
+    return 0;
+}
+
 static int
 build_rev_update_chain(purc_variant_t arr, struct arr_node *node)
 {
@@ -266,6 +340,88 @@ check_grow(purc_variant_t arr, size_t idx, purc_variant_t val)
     return -1;
 }
 
+/* The array stored contiguously does not belong to any set, so only the
+   listeners are to be notified when changing it. */
+static int
+vals_insert_before(purc_variant_t arr, variant_arr_t data, size_t idx,
+        purc_variant_t val, bool check)
+{
+    if (check && !grow(arr, idx, val, check))
+        return -1;
+
+    if (data->nr_vals == data->sz_vals) {
+        /* grow geometrically to keep appending amortized O(1) */
+        size_t sz = data->sz_vals + data->sz_vals / 2 + 16;
+        purc_variant_t *vals;
+        if (data->vals == data->inline_vals) {
+            vals = (purc_variant_t*)malloc(sz * sizeof(*vals));
+            if (vals)
+                memcpy(vals, data->vals, data->nr_vals * sizeof(*vals));
+        }
+        else {
+            vals = (purc_variant_t*)realloc(data->vals, sz * sizeof(*vals));
+        }
+
+        if (!vals) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+        data->vals = vals;
+        data->sz_vals = sz;
+    }
+
+    memmove(data->vals + idx + 1, data->vals + idx,
+            (data->nr_vals - idx) * sizeof(*data->vals));
+    data->vals[idx] = purc_variant_ref(val);
+    data->nr_vals++;
+
+    if (check)
+        grown(arr, idx, val, check);
+
+    return 0;
+}
+
+static int
+vals_set(purc_variant_t arr, variant_arr_t data, size_t idx,
+        purc_variant_t val, bool check)
+{
+    purc_variant_t old = data->vals[idx];
+    if (old == val) {
+        // NOTE: keep refc intact
+        return 0;
+    }
+
+    if (check && !change(arr, idx, old, val, check))
+        return -1;
+
+    data->vals[idx] = purc_variant_ref(val);
+
+    if (check)
+        changed(arr, idx, old, val, check);
+
+    purc_variant_unref(old);
+    return 0;
+}
+
+static int
+vals_remove(purc_variant_t arr, variant_arr_t data, size_t idx, bool check)
+{
+    purc_variant_t old = data->vals[idx];
+
+    if (check && !shrink(arr, idx, old, check))
+        return -1;
+
+    memmove(data->vals + idx, data->vals + idx + 1,
+            (data->nr_vals - idx - 1) * sizeof(*data->vals));
+    data->nr_vals--;
+
+    if (check)
+        shrunk(arr, idx, old, check);
+
+    purc_variant_unref(old);
+    return 0;
+}
+
 static int
 variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
         bool check)
@@ -278,22 +434,19 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx > nr)
         idx = nr;
 
-    purc_variant_t pos = variant_arr_make_pos(data, idx);
-    if (pos == PURC_VARIANT_INVALID)
-        return -1;
+    if (!data->use_nodes)
+        return vals_insert_before(arr, data, idx, val, check);
 
+    struct pcutils_array_list *al = &data->al;
     struct arr_node *node = NULL;
 
     do {
         if (check) {
-            if (!grow(arr, pos, val, check))
+            if (!grow(arr, idx, val, check))
                 break;
 
             if (check_grow(arr, idx, val))
@@ -319,16 +472,13 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
                 break;
 
             pcvar_adjust_set_by_descendant(arr);
-            grown(arr, pos, val, check);
+            grown(arr, idx, val, check);
         }
 
-        purc_variant_unref(pos);
-
         return 0;
     } while (0);
 
     arr_node_destroy(arr, node);
-    purc_variant_unref(pos);
 
     return -1;
 }
@@ -340,6 +490,8 @@ refresh_extra(purc_variant_t arr)
     variant_arr_t data = pcvar_arr_get_data(arr);
     if (data) {
         extra += sizeof(*data);
+        if (data->vals != data->inline_vals)
+            extra += data->sz_vals * sizeof(*data->vals);
         struct pcutils_array_list *al = &data->al;
         extra += al->sz * sizeof(*al->nodes);
         extra += al->nr * sizeof(struct arr_node);
@@ -352,8 +504,7 @@ variant_arr_append(purc_variant_t arr, purc_variant_t val,
         bool check)
 {
     variant_arr_t data = pcvar_arr_get_data(arr);
-    struct pcutils_array_list *al = &data->al;
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     int r = variant_arr_insert_before(arr, nr, val, check);
     refresh_extra(arr);
     return r ? -1 : 0;
@@ -369,15 +520,10 @@ variant_arr_prepend(purc_variant_t arr, purc_variant_t val,
 static purc_variant_t
 variant_arr_get(variant_arr_t data, size_t idx)
 {
-    struct pcutils_array_list *al = &data->al;
-    struct pcutils_array_list_node *p;
-    p = pcutils_array_list_get(al, idx);
-    if (p == NULL)
+    if (idx >= variant_arr_length(data))
         return PURC_VARIANT_INVALID;
 
-    struct arr_node *node;
-    node = (struct arr_node*)container_of(p, struct arr_node, node);
-    return node->val;
+    return *pcvar_arr_slot(data, idx);
 }
 
 static int
@@ -429,15 +575,16 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx >= nr) {
         purc_set_error(PURC_ERROR_OVERFLOW);
         return -1;
     }
 
+    if (!data->use_nodes)
+        return vals_set(arr, data, idx, val, check);
+
+    struct pcutils_array_list *al = &data->al;
     struct pcutils_array_list_node *p;
     p = pcutils_array_list_get(al, idx);
     PC_ASSERT(p);
@@ -450,15 +597,11 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
         return 0;
     }
 
-    purc_variant_t pos = variant_arr_make_pos(data, idx);
-    if (pos == PURC_VARIANT_INVALID)
-        return -1;
-
     do {
         purc_variant_t old = old_node->val;
 
         if (check) {
-            if (!change(arr, pos, old, val, check))
+            if (!change(arr, idx, old, val, check))
                 break;
 
             if (check_change(arr, old_node, val))
@@ -481,17 +624,14 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
         if (check) {
             pcvar_adjust_set_by_descendant(arr);
 
-            changed(arr, pos, old, val, check);
+            changed(arr, idx, old, val, check);
         }
 
         purc_variant_unref(old);
-        purc_variant_unref(pos);
 
         return 0;
     } while (0);
 
-    purc_variant_unref(pos);
-
     return -1;
 }
 
@@ -546,19 +686,16 @@ variant_arr_remove(purc_variant_t arr, size_t idx,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx >= nr) {
         // FIXME: failure or success???
         return 0;
     }
 
-    purc_variant_t pos = variant_arr_make_pos(data, idx);
-    if (pos == PURC_VARIANT_INVALID)
-        return -1;
+    if (!data->use_nodes)
+        return vals_remove(arr, data, idx, check);
 
+    struct pcutils_array_list *al = &data->al;
     struct pcutils_array_list_node *p, *n;
     p = pcutils_array_list_get(al, idx);
     PC_ASSERT(p);
@@ -569,7 +706,7 @@ variant_arr_remove(purc_variant_t arr, size_t idx,
 
     do {
         if (check) {
-            if (!shrink(arr, pos, node->val, check))
+            if (!shrink(arr, idx, node->val, check))
                 break;
 
             if (check_shrink(arr, node))
@@ -587,17 +724,14 @@ variant_arr_remove(purc_variant_t arr, size_t idx,
         if (check) {
             pcvar_adjust_set_by_descendant(arr);
 
-            shrunk(arr, pos, node->val, check);
+            shrunk(arr, idx, node->val, check);
         }
 
         arr_node_destroy(arr, node);
-        purc_variant_unref(pos);
 
         return 0;
     } while (0);
 
-    purc_variant_unref(pos);
-
     return -1;
 }
 
@@ -608,6 +742,12 @@ array_release (purc_variant_t arr)
     if (!data)
         return;
 
+    while (data->nr_vals > 0) {
+        purc_variant_unref(data->vals[--data->nr_vals]);
+    }
+    if (data->vals != data->inline_vals)
+        free(data->vals);
+
     struct pcutils_array_list *al = &data->al;
     struct arr_node *p, *n;
     array_list_for_each_entry_reverse_safe(al, p, n, node) {
@@ -640,24 +780,25 @@ make_array(size_t sz)
         var->flags         = PCVARIANT_FLAG_EXTRA_SIZE;
         var->refc          = 1;
 
-        size_t initial_size = ARRAY_LIST_DEFAULT_SIZE;
-        if (sz>initial_size)
-            initial_size = sz;
-
         variant_arr_t data = (variant_arr_t)calloc(1, sizeof(*data));
         if (!data) {
             pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
             break;
         }
 
-        struct pcutils_array_list *al;
-        al = &data->al;
-        pcutils_array_list_init(al);
-        if (pcutils_array_list_expand(al, initial_size)) {
-            pcutils_array_list_reset(al);
-            free(data);
-            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            break;
+        pcutils_array_list_init(&data->al);
+        if (sz > VARIANT_ARR_NR_INLINE_VALS) {
+            data->vals = (purc_variant_t*)malloc(sz * sizeof(*data->vals));
+            if (!data->vals) {
+                free(data);
+                pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                break;
+            }
+            data->sz_vals = sz;
+        }
+        else {
+            data->vals = data->inline_vals;
+            data->sz_vals = VARIANT_ARR_NR_INLINE_VALS;
         }
 
         var->sz_ptr[1]     = (uintptr_t)data;
@@ -783,6 +924,7 @@ bool purc_variant_array_append (purc_variant_t arr, purc_variant_t value)
 {
     PCVARIANT_CHECK_FAIL_RET(arr && arr->type==PVT(_ARRAY) && value,
         PURC_VARIANT_INVALID);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(arr, false);
 
     bool check = true;
     int r = variant_arr_append(arr, value, check);
@@ -794,6 +936,7 @@ bool purc_variant_array_prepend (purc_variant_t arr, purc_variant_t value)
 {
     PCVARIANT_CHECK_FAIL_RET(arr && arr->type==PVT(_ARRAY) && value,
         PURC_VARIANT_INVALID);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(arr, false);
 
     bool check = true;
     int r = variant_arr_prepend(arr, value, check);
@@ -827,6 +970,7 @@ bool purc_variant_array_set(purc_variant_t arr, size_t idx,
 {
     PCVARIANT_CHECK_FAIL_RET(arr && arr->type==PVT(_ARRAY) &&
         value && arr != value, false);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(arr, false);
 
     bool check = true;
     int r = variant_arr_set(arr, idx, value, check);
@@ -838,6 +982,7 @@ bool purc_variant_array_remove (purc_variant_t arr, int idx)
 {
     PCVARIANT_CHECK_FAIL_RET(arr && arr->type==PVT(_ARRAY) && idx>=0,
         false);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(arr, false);
 
     bool check = true;
     int r = variant_arr_remove(arr, idx, check);
@@ -850,6 +995,7 @@ bool purc_variant_array_insert_before (purc_variant_t arr, int idx,
 {
     PCVARIANT_CHECK_FAIL_RET(arr && arr->type==PVT(_ARRAY) &&
         idx>=0 && value && arr != value, false);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(arr, false);
 
     bool check = true;
     int r = variant_arr_insert_before(arr, idx, value, check);
@@ -880,6 +1026,71 @@ sort_cmp(struct pcutils_array_list_node *l, struct pcutils_array_list_node *r,
     return d->cmp(l_n->val, r_n->val, d->ud);
 }
 
+struct vals_user_data {
+    variant_arr_t data;
+    void *ud;
+};
+
+static int
+vals_sort_cmp(struct pcutils_array_list_node *l,
+        struct pcutils_array_list_node *r, void *ud)
+{
+    struct vals_user_data *vd = (struct vals_user_data*)ud;
+    struct arr_user_data *d = (struct arr_user_data*)vd->ud;
+    return d->cmp(vd->data->vals[l->idx], vd->data->vals[r->idx], d->ud);
+}
+
+/* Sorts the members stored contiguously: the indices are sorted with the
+   same (stable) algorithm as the nodes, then the members are permuted. */
+static int
+vals_sort(variant_arr_t data, void *ud,
+        int (*cmp)(struct pcutils_array_list_node *l,
+            struct pcutils_array_list_node *r, void *ud))
+{
+    size_t nr = data->nr_vals;
+    if (nr < 2)
+        return 0;
+
+    struct pcutils_array_list_node *idx_nodes;
+    purc_variant_t *vals;
+    idx_nodes = (struct pcutils_array_list_node*)malloc(
+            nr * sizeof(*idx_nodes));
+    vals = (purc_variant_t*)malloc(nr * sizeof(*vals));
+
+    struct pcutils_array_list al;
+    pcutils_array_list_init(&al);
+    if (!idx_nodes || !vals || pcutils_array_list_expand(&al, nr)) {
+        pcutils_array_list_reset(&al);
+        free(vals);
+        free(idx_nodes);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    for (size_t i = 0; i < nr; i++) {
+        idx_nodes[i].idx = (size_t)-1;
+        pcutils_array_list_append(&al, idx_nodes + i);
+    }
+
+    struct vals_user_data vd = {
+        .data = data,
+        .ud   = ud,
+    };
+    pcutils_array_list_sort(&al, &vd, cmp);
+
+    for (size_t i = 0; i < nr; i++) {
+        vals[i] = data->vals[al.nodes[i] - idx_nodes];
+    }
+    memcpy(data->vals, vals, nr * sizeof(*vals));
+
+    /* the index nodes are not owned by the list */
+    al.nr = 0;
+    pcutils_array_list_reset(&al);
+    free(vals);
+    free(idx_nodes);
+    return 0;
+}
+
 static int vrtcmp(purc_variant_t l, purc_variant_t r, void *ud)
 {
     uintptr_t sort_flags;
@@ -899,6 +1110,7 @@ int pcvariant_array_sort(purc_variant_t arr, void *ud,
 {
     if (!arr || arr->type != PURC_VARIANT_TYPE_ARRAY)
         return -1;
+    PCVARIANT_CHECK_NOT_FROZEN_RET(arr, -1);
 
     variant_arr_t data = pcvar_arr_get_data(arr);
 
@@ -911,11 +1123,79 @@ int pcvariant_array_sort(purc_variant_t arr, void *ud,
         d.cmp = vrtcmp;
     }
 
+    if (!data->use_nodes)
+        return vals_sort(data, &d, vals_sort_cmp);
+
     pcutils_array_list_sort(&data->al, &d, sort_cmp);
 
     return 0;
 }
 
+struct arr_pos_user_data {
+    int (*cmp)(size_t l, size_t r, void *ud);
+    void *ud;
+};
+
+static int
+sort_pos_cmp(struct pcutils_array_list_node *l,
+        struct pcutils_array_list_node *r, void *ud)
+{
+    struct arr_pos_user_data *d = (struct arr_pos_user_data*)ud;
+    return d->cmp(l->idx, r->idx, d->ud);
+}
+
+static int
+vals_sort_pos_cmp(struct pcutils_array_list_node *l,
+        struct pcutils_array_list_node *r, void *ud)
+{
+    struct vals_user_data *vd = (struct vals_user_data*)ud;
+    return sort_pos_cmp(l, r, vd->ud);
+}
+
+int pcvariant_array_sort_by_pos(purc_variant_t arr, void *ud,
+        int (*cmp)(size_t l, size_t r, void *ud))
+{
+    if (!arr || arr->type != PURC_VARIANT_TYPE_ARRAY || !cmp)
+        return -1;
+    PCVARIANT_CHECK_NOT_FROZEN_RET(arr, -1);
+
+    variant_arr_t data = pcvar_arr_get_data(arr);
+
+    struct arr_pos_user_data d = {
+        .cmp = cmp,
+        .ud  = ud,
+    };
+
+    if (!data->use_nodes)
+        return vals_sort(data, &d, vals_sort_pos_cmp);
+
+    pcutils_array_list_sort(&data->al, &d, sort_pos_cmp);
+
+    return 0;
+}
+
+int pcvariant_array_swap(purc_variant_t arr, size_t i, size_t j)
+{
+    if (!arr || arr->type != PURC_VARIANT_TYPE_ARRAY)
+        return -1;
+    PCVARIANT_CHECK_NOT_FROZEN_RET(arr, -1);
+
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    size_t nr = variant_arr_length(data);
+    if (i >= nr || j >= nr) {
+        purc_set_error(PURC_ERROR_OVERFLOW);
+        return -1;
+    }
+
+    if (data->use_nodes)
+        return pcutils_array_list_swap(&data->al, i, j);
+
+    purc_variant_t tmp = data->vals[i];
+    data->vals[i] = data->vals[j];
+    data->vals[j] = tmp;
+    return 0;
+}
+
 purc_variant_t
 pcvariant_array_clone(purc_variant_t arr, bool recursively)
 {
@@ -958,11 +1238,12 @@ pcvar_array_break_rue_downward(purc_variant_t arr)
     PC_ASSERT(purc_variant_is_array(arr));
 
     variant_arr_t data = pcvar_arr_get_data(arr);
-    if (!data)
+    if (!data || !data->use_nodes)
         return;
 
+    struct pcutils_array_list *al = &data->al;
     struct arr_node *p;
-    foreach_in_variant_array(arr, p) {
+    array_list_for_each_entry(al, p, node) {
         struct pcvar_rev_update_edge edge = {
             .parent         = arr,
             .arr_me         = p,
@@ -996,8 +1277,13 @@ pcvar_array_build_rue_downward(purc_variant_t arr)
     if (!data)
         return 0;
 
+    /* the members refer back to their nodes from now on */
+    if (use_nodes(data))
+        return -1;
+
+    struct pcutils_array_list *al = &data->al;
     struct arr_node *p;
-    foreach_in_variant_array(arr, p) {
+    array_list_for_each_entry(al, p, node) {
         struct pcvar_rev_update_edge edge = {
             .parent         = arr,
             .arr_me         = p,
@@ -1022,6 +1308,9 @@ pcvar_array_build_edge_to_parent(purc_variant_t arr,
     if (!data)
         return 0;
 
+    if (use_nodes(data))
+        return -1;
+
     if (!data->rev_update_chain) {
         data->rev_update_chain = pcvar_create_rev_update_chain();
         if (!data->rev_update_chain)
@@ -1040,66 +1329,17 @@ pcvar_array_build_edge_to_parent(purc_variant_t arr,
     return r ? -1 : 0;
 }
 
-static struct pcutils_array_list_node*
-next_node(struct pcutils_array_list *al, struct pcutils_array_list_node *node)
-{
-    if (!node)
-        return NULL;
-    size_t count = pcutils_array_list_length(al);
-    size_t idx = node->idx + 1;
-    if (idx >= count)
-        return NULL;
-
-    return pcutils_array_list_get(al, idx);
-}
-
-static struct pcutils_array_list_node*
-prev_node(struct pcutils_array_list *al, struct pcutils_array_list_node *node)
-{
-    if (!node)
-        return NULL;
-    if (node->idx == 0)
-        return NULL;
-
-    size_t count = pcutils_array_list_length(al);
-    size_t idx = node->idx - 1;
-    if (idx >= count)
-        return NULL;
-
-    return pcutils_array_list_get(al, idx);
-}
-
 static void
-it_refresh(struct arr_iterator *it,
-        struct pcutils_array_list *al,
-        struct pcutils_array_list_node *curr)
+it_refresh(struct arr_iterator *it, size_t idx)
 {
-    struct pcutils_array_list_node *next  = NULL;
-    struct pcutils_array_list_node *prev  = NULL;
-    if (curr) {
-        next  = next_node(al, curr);
-        prev  = prev_node(al, curr);
-    }
-
-    if (curr) {
-        it->curr = container_of(curr, struct arr_node, node);
-    }
-    else {
-        it->curr = NULL;
-    }
-
-    if (next) {
-        it->next = container_of(next, struct arr_node, node);
-    }
-    else {
-        it->next = NULL;
-    }
-
-    if (prev) {
-        it->prev = container_of(prev, struct arr_node, node);
+    variant_arr_t data = pcvar_arr_get_data(it->arr);
+    if (idx < variant_arr_length(data)) {
+        it->idx  = idx;
+        it->curr = *pcvar_arr_slot(data, idx);
     }
     else {
-        it->prev = NULL;
+        it->idx  = 0;
+        it->curr = PURC_VARIANT_INVALID;
     }
 }
 
@@ -1112,17 +1352,7 @@ pcvar_arr_it_first(purc_variant_t arr)
     if (arr == PURC_VARIANT_INVALID)
         return it;
 
-    variant_arr_t data = pcvar_arr_get_data(arr);
-    size_t count = variant_arr_length(data);
-    if (count == 0)
-        return it;
-
-    struct pcutils_array_list *al = &data->al;
-
-    struct pcutils_array_list_node *first;
-    first = pcutils_array_list_get_first(al);
-
-    it_refresh(&it, al, first);
+    it_refresh(&it, 0);
 
     return it;
 }
@@ -1141,12 +1371,7 @@ pcvar_arr_it_last(purc_variant_t arr)
     if (count == 0)
         return it;
 
-    struct pcutils_array_list *al = &data->al;
-
-    struct pcutils_array_list_node *last;
-    last = pcutils_array_list_get_last(al);
-
-    it_refresh(&it, al, last);
+    it_refresh(&it, count - 1);
 
     return it;
 }
@@ -1154,45 +1379,24 @@ pcvar_arr_it_last(purc_variant_t arr)
 void
 pcvar_arr_it_next(struct arr_iterator *it)
 {
-    if (it->curr == NULL)
+    if (it->curr == PURC_VARIANT_INVALID)
         return;
 
-    if (it->next) {
-        variant_arr_t data = pcvar_arr_get_data(it->arr);
-        struct pcutils_array_list *al = &data->al;
-
-        struct pcutils_array_list_node *next;
-        next = &it->next->node;
-
-        it_refresh(it, al, next);
-    }
-    else {
-        it->curr = NULL;
-        it->next = NULL;
-        it->prev = NULL;
-    }
+    it_refresh(it, it->idx + 1);
 }
 
 void
 pcvar_arr_it_prev(struct arr_iterator *it)
 {
-    if (it->curr == NULL)
+    if (it->curr == PURC_VARIANT_INVALID)
         return;
 
-    if (it->prev) {
-        variant_arr_t data = pcvar_arr_get_data(it->arr);
-        struct pcutils_array_list *al = &data->al;
-
-        struct pcutils_array_list_node *prev;
-        prev = &it->prev->node;
-
-        it_refresh(it, al, prev);
-    }
-    else {
-        it->curr = NULL;
-        it->next = NULL;
-        it->prev = NULL;
+    if (it->idx == 0) {
+        it->curr = PURC_VARIANT_INVALID;
+        return;
     }
+
+    it_refresh(it, it->idx - 1);
 }
 
 
@@ -36,6 +36,13 @@
         return (ret);                                           \
     }
 
+/* frozen values can not be changed */
+#define PCVARIANT_CHECK_NOT_FROZEN_RET(v, ret)                  \
+    if (PCVARIANT_IS_FROZEN(v)) {                               \
+        pcinst_set_error(PURC_ERROR_ACCESS_DENIED);             \
+        return (ret);                                           \
+    }
+
 #ifdef __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
@@ -178,9 +185,8 @@ pcvar_obj_it_prev(struct obj_iterator *it);
 struct arr_iterator {
     purc_variant_t                arr;
 
-    struct arr_node              *curr;
-    struct arr_node              *next;
-    struct arr_node              *prev;
+    size_t                        idx;
+    purc_variant_t                curr;
 };
 
 struct arr_iterator
@@ -270,6 +276,12 @@ pcvar_set_add(purc_variant_t set, purc_variant_t val);
 int
 pcvar_readjust_set(purc_variant_t set, struct set_node *node);
 
+// stringify `v` as purc_variant_compare_ex() does for the string methods;
+// the result is written to `stackbuffer` if it fits (and NULL is returned),
+// otherwise a buffer which shall be free'd by the caller is returned
+char *
+pcvar_compare_stringify(purc_variant_t v, char *stackbuffer, size_t size);
+
 // compare both variant-type and variant-value
 // recursive-implementation, thus caller's responsible for enough stack space
 // except stack space, no extra memory is required
@@ -27,6 +27,7 @@
 #include "private/variant.h"
 #include "private/errors.h"
 #include "purc-errors.h"
+#include "private/slab.h"
 #include "variant-internals.h"
 
 
@@ -36,7 +37,8 @@
 #include <string.h>
 
 #define OBJ_EXTRA_SIZE(data) (sizeof(*data) + \
-        (data->size) * sizeof(struct obj_node))
+        (data->size) * sizeof(struct obj_node) + \
+        (data->nr_buckets) * sizeof(struct obj_node*))
 
 static inline bool
 grow(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
@@ -127,6 +129,144 @@ pcvar_obj_get_data(purc_variant_t obj)
     return data;
 }
 
+#define FNV_PRIME 0x100000001b3ULL
+#define FNV_INIT  0xcbf29ce484222325ULL
+
+static uint64_t
+obj_key_hash(const char *key)
+{
+    const unsigned char *p = (const unsigned char *)key;
+    uint64_t hash = FNV_INIT;
+
+    for (; *p; p++) {
+        hash ^= *p;
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/*
+ * Objects with more than OBJ_INDEX_MIN_SIZE members keep a hash index of
+ * their nodes besides the red-black tree, which still gives the order of
+ * iteration. Once built, the index always holds every node, so a miss in
+ * it is final for a lookup; only an insertion has to descend the tree to
+ * find where to link the new node.
+ */
+#define OBJ_INDEX_MIN_SIZE      8
+#define OBJ_INDEX_MIN_BUCKETS   16
+
+static int
+obj_index_rebuild(variant_obj_t data, size_t nr_buckets)
+{
+    struct obj_node **buckets;
+    buckets = (struct obj_node**)calloc(nr_buckets, sizeof(*buckets));
+    if (!buckets)
+        return -1;
+
+    struct rb_node *p = pcutils_rbtree_first(&data->kvs);
+    for (; p; p = pcutils_rbtree_next(p)) {
+        struct obj_node *node = container_of(p, struct obj_node, node);
+        struct obj_node **head = buckets + (node->hash & (nr_buckets - 1));
+        node->hash_next = *head;
+        *head = node;
+    }
+
+    free(data->buckets);
+    data->buckets = buckets;
+    data->nr_buckets = nr_buckets;
+    return 0;
+}
+
+// node shall be linked to the tree already
+static void
+obj_index_add(variant_obj_t data, struct obj_node *node)
+{
+    if (data->size > OBJ_INDEX_MIN_SIZE && data->size > data->nr_buckets) {
+        size_t nr_buckets = data->nr_buckets ?
+            data->nr_buckets : OBJ_INDEX_MIN_BUCKETS;
+        while (nr_buckets < data->size)
+            nr_buckets <<= 1;
+
+        // the rebuilt index holds the new node already; if it fails,
+        // the old index (if any) is kept and still has to be complete
+        if (obj_index_rebuild(data, nr_buckets) == 0)
+            return;
+    }
+
+    if (data->buckets == NULL)
+        return;
+
+    struct obj_node **head;
+    head = data->buckets + (node->hash & (data->nr_buckets - 1));
+    node->hash_next = *head;
+    *head = node;
+}
+
+static void
+obj_index_remove(variant_obj_t data, struct obj_node *node)
+{
+    if (data->buckets == NULL)
+        return;
+
+    struct obj_node **pp;
+    pp = data->buckets + (node->hash & (data->nr_buckets - 1));
+    for (; *pp; pp = &(*pp)->hash_next) {
+        if (*pp == node) {
+            *pp = node->hash_next;
+            break;
+        }
+    }
+    node->hash_next = NULL;
+}
+
+/*
+ * Finds the node of key. When it is not found and pparent/ppnode are
+ * given, they are set to the place where a node for key shall be linked.
+ */
+static struct obj_node*
+find_obj_node(variant_obj_t data, const char *key,
+        struct rb_node **pparent, struct rb_node ***ppnode)
+{
+    if (data->buckets && ppnode == NULL) {
+        uint64_t hash = obj_key_hash(key);
+        struct obj_node *node;
+        node = data->buckets[hash & (data->nr_buckets - 1)];
+        for (; node; node = node->hash_next) {
+            if (node->hash == hash &&
+                    strcmp(key, purc_variant_get_string_const(node->key)) == 0)
+                return node;
+        }
+
+        return NULL;
+    }
+
+    struct rb_root *root = &data->kvs;
+    struct rb_node **pnode = &root->rb_node;
+    struct rb_node *parent = NULL;
+    while (*pnode) {
+        struct obj_node *node;
+        node = container_of(*pnode, struct obj_node, node);
+        const char *sk = purc_variant_get_string_const(node->key);
+        int ret = strcmp(key, sk);
+
+        parent = *pnode;
+
+        if (ret < 0)
+            pnode = &parent->rb_left;
+        else if (ret > 0)
+            pnode = &parent->rb_right;
+        else
+            return node;
+    }
+
+    if (pparent)
+        *pparent = parent;
+    if (ppnode)
+        *ppnode = pnode;
+    return NULL;
+}
+
 static purc_variant_t v_object_new_with_capacity(void)
 {
     purc_variant_t var = pcvariant_get(PVT(_OBJECT));
@@ -184,6 +324,7 @@ obj_node_release(purc_variant_t obj, struct obj_node *node)
     struct rb_root *root = &data->kvs;
     if (&node->node == root->rb_node || node->node.rb_parent) {
         --data->size;
+        obj_index_remove(data, node);
         pcutils_rbtree_erase(&node->node, root);
         node->node.rb_parent = NULL;
     }
@@ -200,7 +341,7 @@ obj_node_destroy(purc_variant_t obj, struct obj_node *node)
 
     obj_node_release(obj, node);
 
-    free(node);
+    pcslab_free(node, sizeof(*node));
 }
 
 static struct obj_node*
@@ -212,7 +353,7 @@ obj_node_create(purc_variant_t k, purc_variant_t v)
     }
 
     struct obj_node *node;
-    node = (struct obj_node*)calloc(1, sizeof(*node));
+    node = (struct obj_node*)pcslab_alloc0(sizeof(*node));
     if (!node) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
@@ -220,6 +361,7 @@ obj_node_create(purc_variant_t k, purc_variant_t v)
 
     node->key = purc_variant_ref(k);
     node->val = purc_variant_ref(v);
+    node->hash = obj_key_hash(purc_variant_get_string_const(k));
 
     return node;
 }
@@ -296,28 +438,8 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
 {
     variant_obj_t data = pcvar_obj_get_data(obj);
     struct rb_root *root = &data->kvs;
-    struct rb_node **pnode = &root->rb_node;
-    struct rb_node *parent = NULL;
-    struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sk = purc_variant_get_string_const(node->key);
-        int ret = strcmp(key, sk);
-
-        parent = *pnode;
-
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
-        }
-    }
-
-    if (!entry) {
+    struct obj_node *node = find_obj_node(data, key, NULL, NULL);
+    if (!node) {
         if (silently)
             return 0;
 
@@ -325,8 +447,7 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
         return -1;
     }
 
-    struct obj_node *node;
-    node = container_of(entry, struct obj_node, node);
+    struct rb_node *entry = &node->node;
     purc_variant_t k = node->key;
     purc_variant_t v = node->val;
 
@@ -343,6 +464,7 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
 
         --data->size;
         PC_ASSERT(entry == root->rb_node || entry->rb_parent);
+        obj_index_remove(data, node);
         pcutils_rbtree_erase(entry, root);
         entry->rb_parent = NULL;
 
@@ -474,27 +596,24 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
     PC_ASSERT(data);
 
     struct rb_root *root = &data->kvs;
-    struct rb_node **pnode = &root->rb_node;
+    struct rb_node **pnode = NULL;
     struct rb_node *parent = NULL;
     struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sko = purc_variant_get_string_const(node->key);
-        int ret = strcmp(sk, sko);
-
-        parent = *pnode;
 
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
-        }
+    struct obj_node *found;
+    if (data->buckets) {
+        // hashed lookup first, descend the tree only to insert
+        found = find_obj_node(data, sk, NULL, NULL);
+        if (!found)
+            find_obj_node(data, sk, &parent, &pnode);
+    }
+    else {
+        found = find_obj_node(data, sk, &parent, &pnode);
     }
 
+    if (found)
+        entry = &found->node;
+
     if (!entry) { //new the entry
         struct obj_node *node = obj_node_create(key, val);
         if (!node)
@@ -515,6 +634,7 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
             pcutils_rbtree_insert_color(entry, root);
 
             ++data->size;
+            obj_index_add(data, node);
 
             if (check) {
                 if (build_rev_update_chain(obj, node))
@@ -754,6 +874,11 @@ void pcvariant_object_release (purc_variant_t value)
 
     struct rb_root *root = &data->kvs;
 
+    // no need to maintain the index while destroying all the nodes
+    free(data->buckets);
+    data->buckets = NULL;
+    data->nr_buckets = 0;
+
     struct rb_node *p, *n;
     pcutils_rbtree_for_each_safe(pcutils_rbtree_first(root), p, n) {
         struct obj_node *node;
@@ -804,38 +929,13 @@ purc_variant_object_get_by_ckey(purc_variant_t obj, const char* key)
         PURC_VARIANT_INVALID);
 
     variant_obj_t data = pcvar_obj_get_data(obj);
-    struct rb_root *root = &data->kvs;
-
-    struct rb_node **pnode = &root->rb_node;
-    struct rb_node *parent = NULL;
-    struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sk = purc_variant_get_string_const(node->key);
-
-        int ret = strcmp(key, sk);
-
-        parent = *pnode;
-
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
-        }
-    }
-
-    if (!entry) {
+    struct obj_node *node = find_obj_node(data, key, NULL, NULL);
+    if (!node) {
         pcinst_set_error(PCVARIANT_ERROR_NO_SUCH_KEY);
 
         return PURC_VARIANT_INVALID;
     }
 
-    struct obj_node *node;
-    node = container_of(entry, struct obj_node, node);
     return node->val;
 }
 
@@ -845,6 +945,7 @@ bool purc_variant_object_set (purc_variant_t obj,
     PCVARIANT_CHECK_FAIL_RET(obj && obj->type==PVT(_OBJECT) &&
         obj->sz_ptr[1] && key && value,
         false);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(obj, false);
 
     bool check = true;
     int r = v_object_set(obj, key, value, check);
@@ -859,6 +960,7 @@ purc_variant_object_remove_by_static_ckey(purc_variant_t obj, const char* key,
     PCVARIANT_CHECK_FAIL_RET(obj && obj->type==PVT(_OBJECT) &&
         obj->sz_ptr[1] && key,
         false);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(obj, false);
 
     bool check = true;
     if (v_object_remove(obj, key, silently, check))
@@ -29,6 +29,7 @@
 #include "private/errors.h"
 #include "private/stringbuilder.h"
 #include "purc-errors.h"
+#include "private/slab.h"
 #include "variant-internals.h"
 
 
@@ -138,6 +139,7 @@ variant_set_get_extra_size(variant_set_t data)
 
     extra += sz_record * count;
     extra += sizeof(struct set_node*)*(data->al.nr);
+    extra += sizeof(struct set_node*)*(data->nr_buckets);
 
     return extra;
 }
@@ -148,71 +150,6 @@ pcv_set_set_data(purc_variant_t set, variant_set_t data)
     set->sz_ptr[1]     = (uintptr_t)data;
 }
 
-static int
-obj_node_diff(struct obj_node *l, struct obj_node *r)
-{
-    int diff = 0;
-
-    purc_variant_t lk, rk;
-    lk = l->key;
-    rk = r->key;
-    PC_ASSERT(lk);
-    PC_ASSERT(rk);
-
-    if (lk != rk) {
-        diff = pcvariant_diff(lk, rk);
-        if (diff)
-            return diff;
-    }
-
-    purc_variant_t lv, rv;
-    lv = l->val;
-    rv = r->val;
-    PC_ASSERT(lv);
-    PC_ASSERT(rv);
-
-    if (lv != rv) {
-        diff = pcvariant_diff(lv, rv);
-    }
-
-    return diff;
-}
-
-static int
-variant_set_compare_by_set_keys(purc_variant_t set,
-        purc_variant_t l, purc_variant_t r)
-{
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
-    PC_ASSERT(purc_variant_is_set(set));
-    PC_ASSERT(l != PURC_VARIANT_INVALID);
-    PC_ASSERT(r != PURC_VARIANT_INVALID);
-    PC_ASSERT(pcvariant_is_mutable(l));
-    PC_ASSERT(pcvariant_is_mutable(r));
-
-    int diff;
-
-    struct kv_iterator lit, rit;
-    lit = pcvar_kv_it_first(set, l);
-    rit = pcvar_kv_it_first(set, r);
-    while (1) {
-        struct obj_node *ln = lit.it.curr;
-        struct obj_node *rn = rit.it.curr;
-        if (ln == NULL && rn == NULL)
-            return 0;
-        if (ln == NULL)
-            return -1;
-        if (rn == NULL)
-            return 1;
-
-        diff = obj_node_diff(ln, rn);
-        if (diff)
-            return diff;
-
-        pcvar_kv_it_next(&lit);
-        pcvar_kv_it_next(&rit);
-    }
-}
-
 static int
 variant_set_init(variant_set_t data, const char *unique_key, bool caseless)
 {
@@ -356,23 +293,9 @@ struct element_rb_node {
     struct rb_node     **pnode;
     struct rb_node      *parent;
     struct rb_node      *entry;
+    uint64_t             hash;
 };
 
-static int
-_compare_generic(purc_variant_t _new, purc_variant_t _old, bool caseless)
-{
-    purc_vrtcmp_opt_t opt = PCVARIANT_COMPARE_OPT_CASE;
-    if (caseless)
-        opt = PCVARIANT_COMPARE_OPT_CASELESS;
-
-    int diff;
-    diff = purc_variant_compare_ex(_new, _old, opt);
-
-    // FIXME: what if allocation failed internally in purc_variant_compare_ex?
-
-    return diff;
-}
-
 static purc_variant_t
 _get_by_key(purc_variant_t val, const char *key)
 {
@@ -393,24 +316,140 @@ _get_by_key(purc_variant_t val, const char *key)
     return purc_variant_make_undefined();
 }
 
+/*
+ * The elements of a set are ordered and compared by the stringified
+ * values of their unique keys (or of the whole value for a generic set),
+ * as purc_variant_compare_ex() does. A probe keeps these strings of the
+ * value being searched, so that they are generated only once for all
+ * the comparisons, and the hash of them for the hash index.
+ */
+#define SET_PROBE_INLINE_KEYS   4
+#define SET_PROBE_BUF_SIZE      128
+
+struct set_probe_key {
+    const char             *str;
+    char                   *heap;
+    char                    buf[SET_PROBE_BUF_SIZE];
+};
+
+struct set_probe {
+    size_t                  nr_keys;
+    struct set_probe_key   *keys;
+    struct set_probe_key    inline_keys[SET_PROBE_INLINE_KEYS];
+    uint64_t                hash;
+};
+
+#define FNV_PRIME 0x100000001b3ULL
+#define FNV_INIT  0xcbf29ce484222325ULL
+
+static uint64_t
+hash_key_string(uint64_t hash, const char *str, bool caseless)
+{
+    const unsigned char *p = (const unsigned char *)str;
+
+    for (; *p; p++) {
+        unsigned char c = *p;
+        if (caseless) {
+            /* pcutils_strcasecmp() may fold non-ASCII characters by the
+               locale; leave them out so that equal keys hash the same */
+            if (c >= 0x80)
+                continue;
+            if (c >= 'A' && c <= 'Z')
+                c += 'a' - 'A';
+        }
+        hash ^= c;
+        hash *= FNV_PRIME;
+    }
+
+    /* terminate the key so that the keys ("ab", "c") and ("a", "bc")
+       hash differently */
+    hash ^= 0xFF;
+    hash *= FNV_PRIME;
+    return hash;
+}
+
+static const char *
+stringify_key(variant_set_t data, purc_variant_t val, size_t idx,
+        char *buf, size_t sz_buf, char **heap)
+{
+    purc_variant_t v = val;
+    if (data->unique_key)
+        v = _get_by_key(val, data->keynames[idx]);
+
+    /* the strings are compared as is, no need to copy them */
+    const char *str;
+    *heap = NULL;
+    if (purc_variant_is_string(v)) {
+        str = purc_variant_get_string_const(v);
+    }
+    else if (purc_variant_is_atomstring(v)) {
+        str = purc_variant_get_atom_string_const(v);
+    }
+    else {
+        *heap = pcvar_compare_stringify(v, buf, sz_buf);
+        str = *heap ? *heap : buf;
+    }
+
+    // the key value is still held by val
+    if (data->unique_key)
+        purc_variant_unref(v);
+    return str;
+}
+
 static int
-_compare_by_unique_keys(purc_variant_t _new, purc_variant_t _old,
-        variant_set_t data)
+set_probe_init(struct set_probe *probe, variant_set_t data,
+        purc_variant_t val)
 {
-    int diff = 0;
+    probe->nr_keys = data->nr_keynames;
+    if (probe->nr_keys <= SET_PROBE_INLINE_KEYS) {
+        probe->keys = probe->inline_keys;
+    }
+    else {
+        probe->keys = malloc(sizeof(*probe->keys) * probe->nr_keys);
+        if (probe->keys == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+    }
 
-    for (size_t i=0; i<data->nr_keynames; ++i) {
-        const char *key = data->keynames[i];
+    probe->hash = FNV_INIT;
+    for (size_t i = 0; i < probe->nr_keys; i++) {
+        struct set_probe_key *key = probe->keys + i;
+        key->str = stringify_key(data, val, i, key->buf, sizeof(key->buf),
+                &key->heap);
+        probe->hash = hash_key_string(probe->hash, key->str, data->caseless);
+    }
+    return 0;
+}
 
-        purc_variant_t _new_v = _get_by_key(_new, key);
-        purc_variant_t _old_v = _get_by_key(_old, key);
+static void
+set_probe_release(struct set_probe *probe)
+{
+    for (size_t i = 0; i < probe->nr_keys; i++)
+        free(probe->keys[i].heap);
 
-        PC_ASSERT(_new_v != PURC_VARIANT_INVALID);
-        PC_ASSERT(_old_v != PURC_VARIANT_INVALID);
+    if (probe->keys != probe->inline_keys)
+        free(probe->keys);
+}
 
-        diff = _compare_generic(_new_v, _old_v, data->caseless);
-        PURC_VARIANT_SAFE_CLEAR(_new_v);
-        PURC_VARIANT_SAFE_CLEAR(_old_v);
+static int
+set_probe_compare(struct set_probe *probe, purc_variant_t val,
+        variant_set_t data)
+{
+    PC_ASSERT(val != PURC_VARIANT_INVALID);
+
+    int diff = 0;
+    for (size_t i = 0; i < probe->nr_keys; i++) {
+        char buf[SET_PROBE_BUF_SIZE];
+        char *heap;
+        const char *str = stringify_key(data, val, i, buf, sizeof(buf),
+                &heap);
+
+        if (data->caseless)
+            diff = pcutils_strcasecmp(probe->keys[i].str, str);
+        else
+            diff = strcmp(probe->keys[i].str, str);
+        free(heap);
 
         if (diff)
             break;
@@ -419,45 +458,113 @@ _compare_by_unique_keys(purc_variant_t _new, purc_variant_t _old,
     return diff;
 }
 
-static int
-_compare(purc_variant_t _new, purc_variant_t _old,
-        variant_set_t data)
+/*
+ * The hash index only speeds up finding an existing element: a miss in
+ * the index always falls back to searching the red-black tree, which is
+ * needed anyway to find the position to insert. So a node which could
+ * not be indexed (out of memory) or whose hash is out of date only makes
+ * the search slower.
+ */
+#define SET_INDEX_MIN_BUCKETS   16
+
+static struct set_node*
+set_index_find(variant_set_t data, struct set_probe *probe)
 {
-    PC_ASSERT(_new != PURC_VARIANT_INVALID);
-    PC_ASSERT(_old != PURC_VARIANT_INVALID);
-    if (data->unique_key == NULL) {
-        // generic set
-        return _compare_generic(_new, _old, data->caseless);
+    if (data->buckets == NULL)
+        return NULL;
+
+    struct set_node *node;
+    node = data->buckets[probe->hash & (data->nr_buckets - 1)];
+    for (; node; node = node->hash_next) {
+        if (node->hash == probe->hash &&
+                set_probe_compare(probe, node->val, data) == 0)
+            return node;
     }
 
-    return _compare_by_unique_keys(_new, _old, data);
+    return NULL;
 }
 
 static void
-find_element_rb_node(struct element_rb_node *node,
-        purc_variant_t set, purc_variant_t kvs)
+set_index_resize(variant_set_t data, size_t nr_buckets)
+{
+    struct set_node **buckets;
+    buckets = (struct set_node**)calloc(nr_buckets, sizeof(*buckets));
+    if (!buckets)
+        return;
+
+    for (size_t i = 0; i < data->nr_buckets; i++) {
+        struct set_node *node = data->buckets[i];
+        while (node) {
+            struct set_node *next = node->hash_next;
+            struct set_node **head = buckets + (node->hash & (nr_buckets - 1));
+            node->hash_next = *head;
+            *head = node;
+            node = next;
+        }
+    }
+
+    free(data->buckets);
+    data->buckets = buckets;
+    data->nr_buckets = nr_buckets;
+}
+
+static void
+set_index_add(variant_set_t data, struct set_node *node)
+{
+    size_t count = pcutils_array_list_length(&data->al);
+    if (count > data->nr_buckets) {
+        size_t nr_buckets = data->nr_buckets ?
+            data->nr_buckets : SET_INDEX_MIN_BUCKETS;
+        while (nr_buckets < count)
+            nr_buckets <<= 1;
+        set_index_resize(data, nr_buckets);
+    }
+
+    if (data->buckets == NULL)
+        return;
+
+    struct set_node **head;
+    head = data->buckets + (node->hash & (data->nr_buckets - 1));
+    node->hash_next = *head;
+    *head = node;
+}
+
+static void
+set_index_remove(variant_set_t data, struct set_node *node)
+{
+    if (data->buckets == NULL)
+        return;
+
+    struct set_node **pp;
+    pp = data->buckets + (node->hash & (data->nr_buckets - 1));
+    for (; *pp; pp = &(*pp)->hash_next) {
+        if (*pp == node) {
+            *pp = node->hash_next;
+            break;
+        }
+    }
+    node->hash_next = NULL;
+}
+
+static void
+probe_element_rb_node(struct element_rb_node *node,
+        variant_set_t data, struct set_probe *probe)
 {
-    variant_set_t data = pcvar_set_get_data(set);
     struct rb_root *root = &data->elems;
     struct rb_node **pnode = &root->rb_node;
     struct rb_node *parent = NULL;
     struct rb_node *entry = NULL;
-    char md5[33];
-    pcvariant_md5_by_set(md5, kvs, set);
 
-    while (*pnode) {
+    struct set_node *found = set_index_find(data, probe);
+    if (found) {
+        pnode = NULL;
+        entry = &found->rbnode;
+    }
+
+    while (entry == NULL && *pnode) {
         struct set_node *on;
         on = container_of(*pnode, struct set_node, rbnode);
-        int diff;
-        if (0) {
-            diff = variant_set_compare_by_set_keys(set, kvs, on->val);
-        }
-        else if (0) {
-            diff = pcvariant_diff_by_set(md5, kvs, on->md5, on->val, set);
-        }
-        else {
-            diff = _compare(kvs, on->val, data);
-        }
+        int diff = set_probe_compare(probe, on->val, data);
 
         parent = *pnode;
 
@@ -476,13 +583,30 @@ find_element_rb_node(struct element_rb_node *node,
     node->pnode  = pnode;
     node->parent = parent;
     node->entry  = entry;
+    node->hash   = probe->hash;
+}
+
+static int
+find_element_rb_node(struct element_rb_node *node,
+        purc_variant_t set, purc_variant_t kvs)
+{
+    variant_set_t data = pcvar_set_get_data(set);
+    struct set_probe probe;
+
+    if (set_probe_init(&probe, data, kvs))
+        return -1;
+
+    probe_element_rb_node(node, data, &probe);
+    set_probe_release(&probe);
+    return 0;
 }
 
 static struct set_node*
 find_element(purc_variant_t set, purc_variant_t kvs)
 {
     struct element_rb_node node;
-    find_element_rb_node(&node, set, kvs);
+    if (find_element_rb_node(&node, set, kvs))
+        return NULL;
 
     if (!node.entry)
         return NULL;
@@ -572,6 +696,7 @@ elem_node_remove(purc_variant_t set, struct set_node *node)
     PC_ASSERT(data);
 
     pcutils_rbtree_erase(&node->rbnode, &data->elems);
+    set_index_remove(data, node);
 
     int r;
     struct pcutils_array_list_node *old;
@@ -601,7 +726,7 @@ elem_node_destroy(purc_variant_t set, struct set_node *node)
         return;
 
     elem_node_release(set, node);
-    free(node);
+    pcslab_free(node, sizeof(*node));
 }
 
 static int
@@ -651,6 +776,10 @@ variant_set_release(purc_variant_t set, variant_set_t data)
 {
     variant_set_release_elems(set, data);
 
+    free(data->buckets);
+    data->buckets = NULL;
+    data->nr_buckets = 0;
+
     if (data->rev_update_chain) {
         pcvar_destroy_rev_update_chain(data->rev_update_chain);
         data->rev_update_chain = NULL;
@@ -707,14 +836,12 @@ variant_set_create_elem_node(purc_variant_t set, purc_variant_t val)
     variant_set_t data = pcvar_set_get_data(set);
     PC_ASSERT(data);
 
-    struct set_node *_new = (struct set_node*)calloc(1, sizeof(*_new));
+    struct set_node *_new = (struct set_node*)pcslab_alloc0(sizeof(*_new));
     if (!_new) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
 
-    pcvariant_md5_by_set(_new->md5, val, set);
-
     _new->alnode.idx = (size_t)-1;
     _new->val = val;
     purc_variant_ref(val);
@@ -838,7 +965,7 @@ check_grow(purc_variant_t set, purc_variant_t val)
 
 static int
 insert(purc_variant_t set, variant_set_t data,
-        purc_variant_t val,
+        purc_variant_t val, uint64_t hash,
         struct rb_node *parent, struct rb_node **pnode,
         bool check)
 {
@@ -871,6 +998,9 @@ insert(purc_variant_t set, variant_set_t data,
         pcutils_rbtree_link_node(entry, parent, pnode);
         pcutils_rbtree_insert_color(entry, &data->elems);
 
+        node->hash = hash;
+        set_index_add(data, node);
+
         if (check) {
             if (!elem_node_setup_constraints(set, node))
                 break;
@@ -895,7 +1025,8 @@ pcvar_set_add(purc_variant_t set, purc_variant_t val)
     PC_ASSERT(data);
 
     struct element_rb_node rbn;
-    find_element_rb_node(&rbn, set, val);
+    if (find_element_rb_node(&rbn, set, val))
+        return -1;
 
     if (rbn.entry) {
         purc_set_error(PURC_ERROR_DUPLICATED);
@@ -903,7 +1034,8 @@ pcvar_set_add(purc_variant_t set, purc_variant_t val)
     }
 
     bool check = false;
-    return insert(set, data, val, rbn.parent, rbn.pnode, check);
+    return insert(set, data, val, rbn.hash, rbn.parent, rbn.pnode,
+            check);
 }
 
 static int
@@ -958,10 +1090,12 @@ insert_or_replace(purc_variant_t set,
         bool check)
 {
     struct element_rb_node rbn;
-    find_element_rb_node(&rbn, set, val);
+    if (find_element_rb_node(&rbn, set, val))
+        return -1;
 
     if (!rbn.entry) {
-        int r = insert(set, data, val, rbn.parent, rbn.pnode, check);
+        int r = insert(set, data, val, rbn.hash, rbn.parent, rbn.pnode,
+            check);
 
         return r ? -1 : 0;
     }
@@ -993,6 +1127,12 @@ insert_or_replace(purc_variant_t set,
         if (elem_node_replace(set, curr, val, check))
             break;
 
+        if (curr->hash != rbn.hash) {
+            set_index_remove(data, curr);
+            curr->hash = rbn.hash;
+            set_index_add(data, curr);
+        }
+
         if (check) {
             pcvar_adjust_set_by_descendant(set);
 
@@ -1125,6 +1265,7 @@ purc_variant_set_add(purc_variant_t set, purc_variant_t value, bool overwrite)
 {
     PCVARIANT_CHECK_FAIL_RET(set && set->type==PVT(_SET) && value,
         PURC_VARIANT_INVALID);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(set, false);
 
     // FIXME: shall clear error here???
     purc_clr_error();
@@ -1147,6 +1288,7 @@ purc_variant_set_remove(purc_variant_t set, purc_variant_t value,
 {
     PCVARIANT_CHECK_FAIL_RET(set && set->type==PVT(_SET) && value,
             PURC_VARIANT_INVALID);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(set, false);
 
     variant_set_t data = pcvar_set_get_data(set);
     PC_ASSERT(data);
@@ -1154,10 +1296,15 @@ purc_variant_set_remove(purc_variant_t set, purc_variant_t value,
 
     bool check = true;
     int r = 0;
-    struct set_node *p;
-    p = find_element(set, value);
-    if (p)
+    struct set_node *p = NULL;
+    struct element_rb_node rbn;
+    if (find_element_rb_node(&rbn, set, value))
+        return false;
+
+    if (rbn.entry) {
+        p = container_of(rbn.entry, struct set_node, rbnode);
         r = set_remove(set, p, check);
+    }
 
     if (r)
         return false;
@@ -1198,6 +1345,7 @@ purc_variant_set_remove_member_by_key_values(purc_variant_t set,
 {
     PCVARIANT_CHECK_FAIL_RET(set && set->type==PVT(_SET) && v1,
         PURC_VARIANT_INVALID);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(set, PURC_VARIANT_INVALID);
 
     variant_set_t data = pcvar_set_get_data(set);
     if (!data || !data->unique_key || data->nr_keynames==0) {
@@ -1279,6 +1427,7 @@ PCA_EXPORT purc_variant_t
 purc_variant_set_remove_by_index(purc_variant_t set, size_t idx)
 {
     PC_ASSERT(set);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(set, PURC_VARIANT_INVALID);
 
     variant_set_t data = pcvar_set_get_data(set);
     size_t count = pcutils_array_list_length(&data->al);
@@ -1317,6 +1466,7 @@ purc_variant_set_set_by_index(purc_variant_t set,
         size_t idx, purc_variant_t val)
 {
     PC_ASSERT(set);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(set, false);
 
     variant_set_t data = pcvar_set_get_data(set);
     size_t count = pcutils_array_list_length(&data->al);
@@ -1570,6 +1720,7 @@ int pcvariant_set_sort(purc_variant_t value, void *ud,
         int (*cmp)(purc_variant_t l, purc_variant_t r, void *ud))
 {
     PC_ASSERT(value != PURC_VARIANT_INVALID);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(value, -1);
 
     variant_set_t data = pcvar_set_get_data(value);
     struct pcutils_array_list *al = &data->al;
@@ -1584,6 +1735,38 @@ int pcvariant_set_sort(purc_variant_t value, void *ud,
     return 0;
 }
 
+struct set_pos_user_data {
+    int (*cmp)(size_t l, size_t r, void *ud);
+    void *ud;
+};
+
+static int
+cmp_pos_f(struct pcutils_array_list_node *l,
+        struct pcutils_array_list_node *r, void *ud)
+{
+    struct set_pos_user_data *d = (struct set_pos_user_data*)ud;
+    return d->cmp(l->idx, r->idx, d->ud);
+}
+
+int pcvariant_set_sort_by_pos(purc_variant_t value, void *ud,
+        int (*cmp)(size_t l, size_t r, void *ud))
+{
+    PC_ASSERT(value != PURC_VARIANT_INVALID);
+    PC_ASSERT(cmp);
+    PCVARIANT_CHECK_NOT_FROZEN_RET(value, -1);
+
+    variant_set_t data = pcvar_set_get_data(value);
+
+    struct set_pos_user_data d = {
+        .cmp = cmp,
+        .ud  = ud,
+    };
+
+    pcutils_array_list_sort(&data->al, &d, cmp_pos_f);
+
+    return 0;
+}
+
 purc_variant_t
 pcvariant_set_find(purc_variant_t set, purc_variant_t value)
 {
@@ -2088,10 +2271,18 @@ pcvar_readjust_set(purc_variant_t set, struct set_node *node)
     PC_ASSERT(purc_variant_is_set(set));
     variant_set_t data = pcvar_set_get_data(set);
 
+    /* make the probe before taking the node out, so that it stays in
+       place if the probe fails */
+    struct set_probe probe;
+    if (set_probe_init(&probe, data, node->val))
+        return -1;
+
     pcutils_rbtree_erase(&node->rbnode, &data->elems);
+    set_index_remove(data, node);
 
     struct element_rb_node rbn;
-    find_element_rb_node(&rbn, set, node->val);
+    probe_element_rb_node(&rbn, data, &probe);
+    set_probe_release(&probe);
     PC_ASSERT(rbn.entry == NULL);
 
     struct rb_node *entry = &node->rbnode;
@@ -2099,6 +2290,9 @@ pcvar_readjust_set(purc_variant_t set, struct set_node *node)
     pcutils_rbtree_link_node(entry, rbn.parent, rbn.pnode);
     pcutils_rbtree_insert_color(entry, &data->elems);
 
+    node->hash = rbn.hash;
+    set_index_add(data, node);
+
     return 0;
 }
 
@@ -107,6 +107,8 @@ bool purc_variant_tuple_set(purc_variant_t tuple,
     if (members == NULL || idx >= sz)
         return false;
 
+    PCVARIANT_CHECK_NOT_FROZEN_RET(tuple, false);
+
     assert(value);
     /* do not change */
     if (value == members[idx])
@@ -31,6 +31,7 @@
 #include "private/debug.h"
 #include "private/dvobjs.h"
 #include "private/utils.h"
+#include "private/slab.h"
 #include "variant-internals.h"
 
 #include <stdlib.h>
@@ -86,7 +87,19 @@ static struct err_msg_seg _variant_err_msgs_seg = {
     variant_err_msgs
 };
 
-#if HAVE(GLIB)
+#if USE(SLAB_ALLOCATOR)
+purc_variant *pcvariant_alloc(void) {
+    return (purc_variant *)pcslab_alloc(sizeof(purc_variant));
+}
+
+purc_variant *pcvariant_alloc_0(void) {
+    return (purc_variant *)pcslab_alloc0(sizeof(purc_variant));
+}
+
+void pcvariant_free(purc_variant *v) {
+    pcslab_free(v, sizeof(purc_variant));
+}
+#elif HAVE(GLIB)
 purc_variant *pcvariant_alloc(void) {
     return (purc_variant *)g_slice_alloc(sizeof(purc_variant));
 }
@@ -295,6 +308,9 @@ enum purc_variant_type purc_variant_get_type(purc_variant_t value)
 
 bool pcvariant_is_mutable(purc_variant_t val)
 {
+    if (PCVARIANT_IS_FROZEN(val))
+        return false;
+
     switch (val->type) {
         case PURC_VARIANT_TYPE_ARRAY:
         case PURC_VARIANT_TYPE_OBJECT:
@@ -325,6 +341,9 @@ purc_variant_ref_count(purc_variant_t value)
 {
     PC_ASSERT(value);
 
+    if (PCVARIANT_IS_FROZEN(value))
+        return __atomic_load_n(&value->refc, __ATOMIC_RELAXED);
+
     /* this should not occur */
     if (UNLIKELY(value->refc == 0)) {
         PC_ASSERT(0);
@@ -338,6 +357,12 @@ purc_variant_t purc_variant_ref (purc_variant_t value)
 {
     PC_ASSERT(value);
 
+    /* frozen values are shared by threads */
+    if (PCVARIANT_IS_FROZEN(value)) {
+        __atomic_add_fetch(&value->refc, 1, __ATOMIC_RELAXED);
+        return value;
+    }
+
     /* this should not occur */
     if (UNLIKELY(value->refc == 0)) {
         PC_ASSERT(0);
@@ -351,10 +376,45 @@ purc_variant_t purc_variant_ref (purc_variant_t value)
     return value;
 }
 
+static void
+release_variant(purc_variant_t value)
+{
+    // release the extra memory used by the variant
+    pcvariant_release_fn release_fn = variant_releasers[value->type];
+    if (release_fn)
+        release_fn(value);
+
+    // release the variant itself
+    pcvariant_put(value);
+}
+
+static unsigned int
+unref_frozen(purc_variant_t value)
+{
+    unsigned int refc;
+    refc = __atomic_sub_fetch(&value->refc, 1, __ATOMIC_ACQ_REL);
+
+    if (refc == 0 && !(value->flags & PCVARIANT_FLAG_NOFREE)) {
+        // frozen values are accounted in the move heap; the descendants
+        // are released with the move heap in use already.
+        bool nested = pcvariant_is_using_move_heap();
+        if (!nested)
+            pcvariant_use_move_heap();
+        release_variant(value);
+        if (!nested)
+            pcvariant_use_norm_heap();
+    }
+
+    return refc;
+}
+
 unsigned int purc_variant_unref(purc_variant_t value)
 {
     PC_ASSERT(value);
 
+    if (PCVARIANT_IS_FROZEN(value))
+        return unref_frozen(value);
+
     /* this should not occur */
     if (UNLIKELY(value->refc == 0)) {
         PC_ASSERT(0);
@@ -368,13 +428,7 @@ unsigned int purc_variant_unref(purc_variant_t value)
 
     // VWNOTE: only non-constant values has a releaser
     if (value->refc == 0 && !(value->flags & PCVARIANT_FLAG_NOFREE)) {
-        // release the extra memory used by the variant
-        pcvariant_release_fn release_fn = variant_releasers[value->type];
-        if (release_fn)
-            release_fn(value);
-
-        // release the variant itself
-        pcvariant_put(value);
+        release_variant(value);
         return 0;
     }
 
@@ -398,6 +452,12 @@ const struct purc_variant_stat *purc_variant_usage_stat(void)
     value = &(inst->variant_heap->v_false);
     inst->variant_heap->stat.nr_values[PURC_VARIANT_TYPE_BOOLEAN] += value->refc;
 
+    struct pcslab_stat slab_stat;
+    pcslab_get_stat(&slab_stat);
+    inst->variant_heap->stat.sz_slab_cached = slab_stat.sz_cached;
+    inst->variant_heap->stat.sz_slab_chunks = slab_stat.sz_chunks;
+    inst->variant_heap->stat.sz_slab_free = slab_stat.sz_depot;
+
     return &inst->variant_heap->stat;
 }
 
@@ -1488,8 +1548,8 @@ static int compare_number_method (purc_variant_t v1, purc_variant_t v2)
     return ret;
 }
 
-static char *
-compare_stringify (purc_variant_t v, char *stackbuffer, size_t size)
+char *
+pcvar_compare_stringify (purc_variant_t v, char *stackbuffer, size_t size)
 {
     char * buffer = NULL;
     size_t total = 0;
@@ -1557,11 +1617,11 @@ static int compare_string_method (purc_variant_t v1, purc_variant_t v2,
     char stackbuf1[128];
     char stackbuf2[sizeof(stackbuf1)];
 
-    buf1 = compare_stringify (v1, stackbuf1, sizeof(stackbuf1));
+    buf1 = pcvar_compare_stringify (v1, stackbuf1, sizeof(stackbuf1));
     if (buf1 == NULL)
         buf1 = stackbuf1;
 
-    buf2 = compare_stringify (v2, stackbuf2, sizeof(stackbuf2));
+    buf2 = pcvar_compare_stringify (v2, stackbuf2, sizeof(stackbuf2));
     if (buf2 == NULL)
         buf2 = stackbuf2;
 
@@ -2717,7 +2777,7 @@ purc_variant_is_mutable(purc_variant_t var, bool *is_mutable)
     }
 
     if (is_mutable)
-        *is_mutable = IS_CONTAINER(var->type);
+        *is_mutable = IS_CONTAINER(var->type) && !PCVARIANT_IS_FROZEN(var);
 
     return 0;
 }
@@ -2901,23 +2961,12 @@ cmp_by_arr(purc_variant_t l, purc_variant_t r,
     PC_ASSERT(ld);
     PC_ASSERT(rd);
 
-    struct pcutils_array_list *la = &ld->al;
-    struct pcutils_array_list *ra = &rd->al;
-
-    struct pcutils_array_list_node *lnode = pcutils_array_list_get_first(la);
-    struct pcutils_array_list_node *rnode = pcutils_array_list_get_first(ra);
-
-    for (;
-        lnode && rnode;
-        lnode = pcutils_array_list_get(la, lnode->idx + 1),
-        rnode = pcutils_array_list_get(ra, rnode->idx + 1))
-    {
-        struct arr_node *lo, *ro;
-        lo = container_of(lnode, struct arr_node, node);
-        ro = container_of(rnode, struct arr_node, node);
+    size_t lnr = pcvar_arr_length(ld);
+    size_t rnr = pcvar_arr_length(rd);
 
-        purc_variant_t lv = lo->val;
-        purc_variant_t rv = ro->val;
+    for (size_t i = 0; i < lnr && i < rnr; i++) {
+        purc_variant_t lv = *pcvar_arr_slot(ld, i);
+        purc_variant_t rv = *pcvar_arr_slot(rd, i);
         PC_ASSERT(lv != PURC_VARIANT_INVALID);
         PC_ASSERT(rv != PURC_VARIANT_INVALID);
 
@@ -2926,9 +2975,9 @@ cmp_by_arr(purc_variant_t l, purc_variant_t r,
             return diff;
     }
 
-    if (lnode)
+    if (lnr > rnr)
         return 1;
-    else if (rnode)
+    else if (lnr < rnr)
         return -1;
     else
         return 0;
@@ -3608,110 +3657,6 @@ void pcvariant_md5_ex(char *md5, purc_variant_t val, const char *salt,
     pcutils_bin2hex(md5_digest, MD5_DIGEST_SIZE, md5, uppercase);
 }
 
-void
-pcvariant_md5_by_set(char *md5, purc_variant_t val, purc_variant_t set)
-{
-    PC_ASSERT(md5);
-    PC_ASSERT(val != PURC_VARIANT_INVALID);
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
-
-    variant_set_t data = pcvar_set_get_data(set);
-    PC_ASSERT(data);
-
-    if (data->unique_key == NULL) {
-        pcvariant_md5(md5, val);
-        return;
-    }
-
-    purc_variant_t undefined = purc_variant_make_undefined();
-    PC_ASSERT(undefined);
-
-    if (val->type != PVT(_OBJECT)) {
-        pcvariant_md5(md5, undefined);
-        purc_variant_unref(undefined);
-        return;
-    }
-
-    pcutils_md5_ctxt ud;
-
-    pcutils_md5_begin(&ud);
-
-    struct stringify_arg arg;
-    arg.cb    = do_stringify_md5;
-    arg.arg   = &ud;
-    arg.flags = 0;
-
-    for (size_t i=0; i<data->nr_keynames; ++i) {
-        purc_variant_t v;
-        v = purc_variant_object_get_by_ckey(val, data->keynames[i]);
-        if (v == PURC_VARIANT_INVALID) {
-            v = undefined;
-        }
-        stringify_kv(&arg, data->keynames[i], v);
-    }
-
-    unsigned char md5_digest[MD5_DIGEST_SIZE];
-    pcutils_md5_end(&ud, md5_digest);
-
-    bool uppercase = true;
-    pcutils_bin2hex(md5_digest, MD5_DIGEST_SIZE, md5, uppercase);
-
-    purc_variant_unref(undefined);
-}
-
-int
-pcvariant_diff_by_set(const char *md5l, purc_variant_t l,
-        const char *md5r, purc_variant_t r, purc_variant_t set)
-{
-    // TODO: https://gitlab.fmsoft.cn/hvml/hvml-docs/-/blob/master/zh/hvml-spec-v1.0-zh.md#21610-%E9%9B%86%E5%90%88%E5%8F%98%E9%87%8F
-
-    PC_ASSERT(md5l);
-    PC_ASSERT(l != PURC_VARIANT_INVALID);
-    PC_ASSERT(md5r);
-    PC_ASSERT(r != PURC_VARIANT_INVALID);
-
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
-
-    int diff;
-
-    variant_set_t data = pcvar_set_get_data(set);
-    PC_ASSERT(data);
-
-    if (data->unique_key == NULL) {
-        return pcvariant_diff(l, r);
-    }
-
-    diff = strcmp(md5l, md5r);
-    if (diff)
-        return diff;
-
-    purc_variant_t undefined = purc_variant_make_undefined();
-    PC_ASSERT(undefined);
-
-    for (size_t i=0; i<data->nr_keynames; ++i) {
-        purc_variant_t vl = PURC_VARIANT_INVALID;
-        purc_variant_t vr = PURC_VARIANT_INVALID;
-
-        if (l->type == PVT(_OBJECT))
-            vl = purc_variant_object_get_by_ckey(l, data->keynames[i]);
-        if (r->type == PVT(_OBJECT))
-            vr = purc_variant_object_get_by_ckey(r, data->keynames[i]);
-
-        if (vl == PURC_VARIANT_INVALID)
-            vl = undefined;
-        if (vr == PURC_VARIANT_INVALID)
-            vr = undefined;
-
-        diff = pcvariant_diff(vl, vr);
-        if (diff)
-            break;
-    }
-
-    purc_variant_unref(undefined);
-
-    return diff;
-}
-
 bool pcvariant_is_scalar(purc_variant_t v)
 {
     switch (v->type) {
@@ -0,0 +1,237 @@
+/*
+ * @file compile.c
+ * @date 2022/11/02
+ * @brief Lowering a vcm tree to a flat instruction stream.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The code of a tree evaluates the nodes in the same order as the tree
+ * walker in eval.c does: every node becomes an EVAL instruction placed
+ * after the code of its params (post-order), and the result of each node
+ * goes to its own register. The params of a node take consecutive
+ * registers, so an EVAL instruction hands them to the `eval` op of the
+ * node as the `params_result` of a frame without copying.
+ *
+ * The nodes which choose their params at run time (the `select_param` op
+ * is not the default one, i.e. the cjsonee operators) get a SELECT
+ * instruction in front of the code of every param, which jumps over the
+ * code of the param, or of the next one, like the walker skips them.
+ *
+ * The name of a getVariable node is usually a constant string; when it
+ * names a named variable (not $0?, $? or $#anchor!), the EVAL instruction
+ * gets an inline cache for the variable it resolves to, which saves the
+ * walk over the scopes until the bindings change.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "purc-errors.h"
+#include "private/errors.h"
+#include "private/interpreter.h"
+#include "private/vcm.h"
+
+#include "eval.h"
+#include "ops.h"
+
+static bool
+has_select_param(struct pcvcm_eval_stack_frame_ops *ops)
+{
+    return ops->select_param != select_param_default;
+}
+
+static bool
+has_var_cache(struct pcvcm_node *node)
+{
+    if (node->type != PCVCM_NODE_TYPE_FUNC_GET_VARIABLE) {
+        return false;
+    }
+
+    struct pcvcm_node *name = pcvcm_node_first_child(node);
+    if (!name || name->type != PCVCM_NODE_TYPE_STRING ||
+            pctree_node_next(&name->tree_node)) {
+        return false;
+    }
+    return pcvcm_is_named_var((const char *)name->sz_ptr[1]);
+}
+
+static void
+count_node(struct pcvcm_node *node, size_t *nr_nodes, size_t *nr_selects,
+        size_t *nr_vars)
+{
+    struct pcvcm_eval_stack_frame_ops *ops = pcvcm_eval_get_ops_by_node(node);
+    size_t nr_children = 0;
+
+    struct pcvcm_node *child = pcvcm_node_first_child(node);
+    while (child) {
+        count_node(child, nr_nodes, nr_selects, nr_vars);
+        nr_children++;
+        child = (struct pcvcm_node *)pctree_node_next(&child->tree_node);
+    }
+
+    (*nr_nodes)++;
+    if (has_select_param(ops)) {
+        *nr_selects += nr_children;
+    }
+    if (has_var_cache(node)) {
+        (*nr_vars)++;
+    }
+}
+
+static int
+emit_node(struct pcvcm_code *code, struct pcvcm_node *node, uint32_t reg,
+        uint32_t *next_reg)
+{
+    struct pcvcm_eval_stack_frame_ops *ops = pcvcm_eval_get_ops_by_node(node);
+    uint32_t first = code->nr_instrs;
+    uint32_t args = *next_reg;
+    uint32_t nr_args = 0;
+
+    struct pcvcm_node *child = pcvcm_node_first_child(node);
+    while (child) {
+        code->nodes[args + nr_args] = child;
+        nr_args++;
+        child = (struct pcvcm_node *)pctree_node_next(&child->tree_node);
+    }
+    *next_reg += nr_args;
+
+    /* the checks done when a frame is pushed only depend on the tree */
+    struct pcvcm_eval_stack_frame frame = {
+        .node = node,
+        .params = code->nodes + args,
+        .nr_params = nr_args,
+        .ops = ops,
+    };
+    if (ops->after_pushed(NULL, &frame) != 0) {
+        return -1;
+    }
+
+    struct pcvcm_code_instr *last_select = NULL;
+    for (uint32_t i = 0; i < nr_args; i++) {
+        struct pcvcm_code_instr *select = NULL;
+        if (has_select_param(ops)) {
+            select = code->instrs + code->nr_instrs++;
+            select->opcode = PCVCM_CODE_OP_SELECT;
+            select->node = node;
+            select->ops = ops;
+            select->args = args;
+            select->nr_args = nr_args;
+            select->pos = i;
+        }
+
+        if (emit_node(code, code->nodes[args + i], args + i, next_reg)) {
+            return -1;
+        }
+
+        if (select) {
+            select->skip = code->nr_instrs;
+            select->skip_next = code->nr_instrs;
+        }
+        if (last_select) {
+            last_select->skip_next = code->nr_instrs;
+        }
+        last_select = select;
+    }
+
+    struct pcvcm_code_instr *eval = code->instrs + code->nr_instrs++;
+    eval->opcode = PCVCM_CODE_OP_EVAL;
+    eval->node = node;
+    eval->ops = ops;
+    eval->args = args;
+    eval->nr_args = nr_args;
+    eval->dst = reg;
+    eval->first = first;
+    if (has_var_cache(node)) {
+        eval->var_cache = code->var_caches + code->nr_var_caches++;
+    }
+    return 0;
+}
+
+struct pcvcm_code *
+pcvcm_compile(struct pcvcm_node *tree)
+{
+    if (!tree) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    size_t nr_nodes = 0;
+    size_t nr_selects = 0;
+    size_t nr_vars = 0;
+    count_node(tree, &nr_nodes, &nr_selects, &nr_vars);
+    if (nr_nodes + nr_selects > UINT32_MAX) {
+        purc_set_error(PURC_ERROR_TOO_LARGE_ENTITY);
+        return NULL;
+    }
+
+    struct pcvcm_code *code;
+    code = (struct pcvcm_code *)calloc(1, sizeof(*code));
+    if (!code) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    code->tree = tree;
+    code->nr_regs = nr_nodes;
+    code->instrs = (struct pcvcm_code_instr *)calloc(nr_nodes + nr_selects,
+            sizeof(struct pcvcm_code_instr));
+    code->nodes = (struct pcvcm_node **)calloc(nr_nodes,
+            sizeof(struct pcvcm_node *));
+    if (!code->instrs || !code->nodes) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    if (nr_vars) {
+        code->var_caches = (struct pcintr_var_cache *)calloc(nr_vars,
+                sizeof(struct pcintr_var_cache));
+        if (!code->var_caches) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto failed;
+        }
+    }
+
+    uint32_t next_reg = 1;
+    code->nodes[0] = tree;
+    if (emit_node(code, tree, 0, &next_reg)) {
+        goto failed;
+    }
+    PC_ASSERT(code->nr_instrs == nr_nodes + nr_selects);
+    PC_ASSERT(next_reg == nr_nodes);
+    PC_ASSERT(code->nr_var_caches == nr_vars);
+    return code;
+
+failed:
+    pcvcm_code_destroy(code);
+    return NULL;
+}
+
+void
+pcvcm_code_destroy(struct pcvcm_code *code)
+{
+    if (code) {
+        free(code->instrs);
+        free(code->nodes);
+        free(code->var_caches);
+        free(code);
+    }
+}
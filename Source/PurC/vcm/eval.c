@@ -55,78 +55,106 @@ pcvcm_eval_stack_frame_step_name(enum pcvcm_eval_stack_frame_step type)
     return stepnames[type];
 }
 
+static inline bool
+is_inline_frame(struct pcvcm_eval_ctxt *ctxt,
+        struct pcvcm_eval_stack_frame *frame)
+{
+    return frame >= ctxt->frames &&
+        frame < ctxt->frames + PCVCM_EVAL_CTXT_NR_INLINE_FRAMES;
+}
+
 struct pcvcm_eval_stack_frame *
-pcvcm_eval_stack_frame_create(struct pcvcm_node *node, size_t return_pos)
+pcvcm_eval_stack_frame_create(struct pcvcm_eval_ctxt *ctxt,
+        struct pcvcm_node *node, size_t return_pos)
 {
     struct pcvcm_eval_stack_frame *frame;
-    frame = (struct pcvcm_eval_stack_frame*)calloc(1,sizeof(*frame));
-    if (!frame) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        goto out;
+    if (!list_empty(&ctxt->free_frames)) {
+        frame = list_first_entry(&ctxt->free_frames,
+                struct pcvcm_eval_stack_frame, ln);
+        list_del(&frame->ln);
+    }
+    else {
+        frame = (struct pcvcm_eval_stack_frame*)malloc(sizeof(*frame));
+        if (!frame) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto out;
+        }
     }
 
     frame->node = node;
     frame->pos = 0;
     frame->return_pos = return_pos;
+    frame->step = STEP_AFTER_PUSH;
     frame->nr_params = pcvcm_node_children_count(node);
-    if (frame->nr_params) {
-        frame->params = pcutils_array_create();
-        if (!frame->params) {
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            goto out_destroy_frame;
-        }
-        frame->params_result = pcutils_array_create();
-        if (!frame->params_result) {
+    if (frame->nr_params <= PCVCM_EVAL_FRAME_NR_INLINE_PARAMS) {
+        frame->params = frame->inline_params;
+        frame->params_result = frame->inline_results;
+    }
+    else {
+        frame->params = (struct pcvcm_node **)malloc(
+                sizeof(struct pcvcm_node *) * frame->nr_params);
+        frame->params_result = (purc_variant_t *)malloc(
+                sizeof(purc_variant_t) * frame->nr_params);
+        if (!frame->params || !frame->params_result) {
             purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            goto out_destroy_params;
-        }
-
-        struct pctree_node *child = pctree_node_child(
-                (struct pctree_node*)node);
-        while (child) {
-            int ret = pcutils_array_push(frame->params, child);
-            if (ret != PURC_ERROR_OK) {
-                goto out_destroy_params_result;
-            }
-            child = pctree_node_next(child);
+            goto out_free_frame;
         }
+    }
 
+    size_t i = 0;
+    struct pctree_node *child = pctree_node_child((struct pctree_node*)node);
+    while (child) {
+        frame->params[i] = (struct pcvcm_node *)child;
+        frame->params_result[i] = PURC_VARIANT_INVALID;
+        child = pctree_node_next(child);
+        i++;
     }
+
     frame->ops = pcvcm_eval_get_ops_by_node(node);
     return frame;
 
-out_destroy_params_result:
-    pcutils_array_destroy(frame->params_result, true);
-
-out_destroy_params:
-    pcutils_array_destroy(frame->params, true);
-
-out_destroy_frame:
-    free(frame);
+out_free_frame:
+    if (frame->params != frame->inline_params) {
+        free(frame->params);
+        free(frame->params_result);
+    }
+    if (is_inline_frame(ctxt, frame)) {
+        list_add(&frame->ln, &ctxt->free_frames);
+    }
+    else {
+        free(frame);
+    }
+    frame = NULL;
 
 out:
     return frame;
 }
 
+/* releases the params of the frame and keeps the frame for reuse */
 void
-pcvcm_eval_stack_frame_destroy(struct pcvcm_eval_stack_frame *frame)
+pcvcm_eval_stack_frame_destroy(struct pcvcm_eval_ctxt *ctxt,
+        struct pcvcm_eval_stack_frame *frame)
 {
     if (!frame) {
         return;
     }
-    if (frame->params) {
-        pcutils_array_destroy(frame->params, true);
-    }
-    if (frame->params_result) {
-        for (size_t i = 0; i < frame->nr_params; i++) {
-            purc_variant_t v = pcutils_array_get(frame->params_result, i);
-            if (v) {
-                purc_variant_unref(v);
-            }
+
+    for (size_t i = 0; i < frame->nr_params; i++) {
+        purc_variant_t v = frame->params_result[i];
+        if (v) {
+            purc_variant_unref(v);
         }
-        pcutils_array_destroy(frame->params_result, true);
     }
-    free(frame);
+
+    if (frame->params != frame->inline_params) {
+        free(frame->params);
+        free(frame->params_result);
+    }
+    frame->params = NULL;
+    frame->params_result = NULL;
+    frame->nr_params = 0;
+
+    list_add(&frame->ln, &ctxt->free_frames);
 }
 
 struct pcvcm_eval_ctxt *
@@ -140,6 +168,10 @@ pcvcm_eval_ctxt_create()
     }
 
     list_head_init(&ctxt->stack);
+    list_head_init(&ctxt->free_frames);
+    for (int i = PCVCM_EVAL_CTXT_NR_INLINE_FRAMES - 1; i >= 0; i--) {
+        list_add(&ctxt->frames[i].ln, &ctxt->free_frames);
+    }
 out:
     return ctxt;
 }
@@ -153,7 +185,23 @@ pcvcm_eval_ctxt_destroy(struct pcvcm_eval_ctxt *ctxt)
     struct list_head *stack = &ctxt->stack;
     struct pcvcm_eval_stack_frame *p, *n;
     list_for_each_entry_safe(p, n, stack, ln) {
-        pcvcm_eval_stack_frame_destroy(p);
+        list_del(&p->ln);
+        pcvcm_eval_stack_frame_destroy(ctxt, p);
+    }
+    list_for_each_entry_safe(p, n, &ctxt->free_frames, ln) {
+        if (!is_inline_frame(ctxt, p)) {
+            free(p);
+        }
+    }
+    if (ctxt->regs) {
+        for (size_t i = 0; i < ctxt->code->nr_regs; i++) {
+            if (ctxt->regs[i]) {
+                purc_variant_unref(ctxt->regs[i]);
+            }
+        }
+        if (ctxt->regs != ctxt->inline_regs) {
+            free(ctxt->regs);
+        }
     }
     if (ctxt->result) {
         purc_variant_unref(ctxt->result);
@@ -233,7 +281,7 @@ pcvcm_dump_frame(struct pcvcm_eval_stack_frame *frame, purc_rwstream_t rws,
 #if __DEV_VCM__
     for (size_t i = 0; i < frame->nr_params; i++) {
         print_indent(rws, indent, NULL);
-        struct pcvcm_node *param = pcutils_array_get(frame->params, i);
+        struct pcvcm_node *param = frame->params[i];
         char *s = pcvcm_node_to_string(param, &len);
 
         if (i == frame->pos && frame->step == STEP_EVAL_PARAMS) {
@@ -246,7 +294,7 @@ pcvcm_dump_frame(struct pcvcm_eval_stack_frame *frame, purc_rwstream_t rws,
         purc_rwstream_write(rws, s, len);
 
         if (i < frame->pos) {
-            purc_variant_t result = pcutils_array_get(frame->params_result, i);
+            purc_variant_t result = frame->params_result[i];
             if (result) {
                 const char *type = pcvariant_typename(result);
                 snprintf(buf, DUMP_BUF_SIZE, ", result: %s/", type);
@@ -388,7 +436,7 @@ push_frame(struct pcvcm_eval_ctxt *ctxt, struct pcvcm_node *node,
         size_t return_pos)
 {
     struct pcvcm_eval_stack_frame *frame = pcvcm_eval_stack_frame_create(
-            node, return_pos);
+            ctxt, node, return_pos);
     if (frame == NULL) {
         goto out;
     }
@@ -404,7 +452,7 @@ pop_frame(struct pcvcm_eval_ctxt *ctxt)
     struct pcvcm_eval_stack_frame *last = list_last_entry(
             &ctxt->stack, struct pcvcm_eval_stack_frame, ln);
     list_del(&last->ln);
-    pcvcm_eval_stack_frame_destroy(last);
+    pcvcm_eval_stack_frame_destroy(ctxt, last);
 }
 
 purc_variant_t
@@ -549,7 +597,7 @@ eval_frame(struct pcvcm_eval_ctxt *ctxt, struct pcvcm_eval_stack_frame *frame,
 
             case STEP_EVAL_PARAMS:
                 for (; frame->pos < frame->nr_params; frame->pos++) {
-                    purc_variant_t v = pcutils_array_get(frame->params_result, frame->pos);
+                    purc_variant_t v = frame->params_result[frame->pos];
                     if (v) {
                         continue;
                     }
@@ -573,7 +621,7 @@ eval_frame(struct pcvcm_eval_ctxt *ctxt, struct pcvcm_eval_stack_frame *frame,
                     if (!val) {
                         goto out;
                     }
-                    pcutils_array_set(frame->params_result, param_frame->return_pos, val);
+                    frame->params_result[param_frame->return_pos] = val;
                     pop_frame(ctxt);
                 }
                 frame->step = STEP_EVAL_VCM;
@@ -668,7 +716,7 @@ eval_vcm(struct pcvcm_node *tree,
         pop_frame(ctxt);
         frame = bottom_frame(ctxt);
         if (frame) {
-            pcutils_array_set(frame->params_result, return_pos, result);
+            frame->params_result[return_pos] = result;
         }
     } while (frame);
 
@@ -687,8 +735,125 @@ out:
     return result;
 }
 
+/*
+ * Runs the compiled code of ctxt->code like eval_vcm() walks the tree:
+ * a failed instruction leaves ctxt->pc on itself, so that evaluating
+ * again resumes from it with the results of the done ones kept in the
+ * registers.
+ */
+static purc_variant_t
+eval_code(struct pcvcm_eval_ctxt *ctxt,
+        find_var_fn find_var, void *find_var_ctxt,
+        bool silently, bool timeout, bool again)
+{
+    struct pcvcm_code *code = ctxt->code;
+    purc_variant_t result = PURC_VARIANT_INVALID;
+    struct pcvcm_eval_stack_frame frame;
+    size_t resume_pc = 0;
+
+    ctxt->find_var = find_var;
+    ctxt->find_var_ctxt = find_var_ctxt;
+    if (silently) {
+        ctxt->flags |= PCVCM_EVAL_FLAG_SILENTLY;
+    }
+
+    if (timeout) {
+        ctxt->flags |= PCVCM_EVAL_FLAG_TIMEOUT;
+    }
+
+    if (again) {
+        ctxt->flags |= PCVCM_EVAL_FLAG_AGAIN;
+        resume_pc = ctxt->pc;
+    }
+    else if (code->nr_regs > PCVCM_EVAL_CTXT_NR_INLINE_REGS) {
+        ctxt->regs = (purc_variant_t *)calloc(code->nr_regs,
+                sizeof(purc_variant_t));
+        if (!ctxt->regs) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto out;
+        }
+    }
+    else {
+        ctxt->regs = ctxt->inline_regs;
+    }
+
+    while (ctxt->pc < code->nr_instrs) {
+        struct pcvcm_code_instr *instr = code->instrs + ctxt->pc;
+
+        frame.node = instr->node;
+        frame.params = code->nodes + instr->args;
+        frame.params_result = ctxt->regs + instr->args;
+        frame.ops = instr->ops;
+        frame.nr_params = instr->nr_args;
+        frame.return_pos = 0;
+
+        if (instr->opcode == PCVCM_CODE_OP_SELECT) {
+            frame.pos = instr->pos;
+            frame.step = STEP_EVAL_PARAMS;
+            if (instr->ops->select_param(ctxt, &frame, instr->pos)) {
+                ctxt->pc++;
+            }
+            else if (frame.pos != instr->pos) {
+                ctxt->pc = instr->skip_next;
+            }
+            else {
+                ctxt->pc = instr->skip;
+            }
+            continue;
+        }
+
+        frame.pos = instr->nr_args;
+        frame.step = STEP_EVAL_VCM;
+        ctxt->var_cache = instr->var_cache;
+        result = instr->ops->eval(ctxt, &frame);
+        ctxt->var_cache = NULL;
+        ctxt->err = purc_get_last_error();
+        if ((result == PURC_VARIANT_INVALID) &&
+                (ctxt->err != PURC_ERROR_AGAIN) &&
+                (ctxt->flags & PCVCM_EVAL_FLAG_SILENTLY)) {
+            result = purc_variant_make_undefined();
+        }
+        instr->node->attach = (uintptr_t)result;
+        if (!result) {
+            goto out;
+        }
+
+        for (size_t i = 0; i < instr->nr_args; i++) {
+            if (frame.params_result[i]) {
+                purc_variant_unref(frame.params_result[i]);
+                frame.params_result[i] = PURC_VARIANT_INVALID;
+            }
+        }
+
+        /* eval_vcm() stops at an error when it pops the frames which
+           were on the stack when the evaluation was interrupted */
+        if (again && instr->first <= resume_pc && resume_pc <= ctxt->pc &&
+                ctxt->err) {
+            goto out;
+        }
+
+        if (ctxt->pc + 1 == code->nr_instrs) {
+            ctxt->pc++;
+            break;
+        }
+        ctxt->regs[instr->dst] = result;
+        result = PURC_VARIANT_INVALID;
+        ctxt->pc++;
+    }
+
+out:
+    if (result) {
+        if (ctxt->result) {
+            purc_variant_unref(ctxt->result);
+        }
+        ctxt->result = purc_variant_ref(result);
+    }
+    return result;
+}
+
 static int i = 0;
-purc_variant_t pcvcm_eval_full(struct pcvcm_node *tree,
+static purc_variant_t
+eval_full(struct pcvcm_node *tree, struct pcvcm_code *code,
         struct pcvcm_eval_ctxt **ctxt_out,
         find_var_fn find_var, void *find_var_ctxt,
         bool silently)
@@ -723,8 +888,15 @@ purc_variant_t pcvcm_eval_full(struct pcvcm_node *tree,
     ctxt->enable_log = enable_log;
     ctxt->node = tree;
 
-    result = eval_vcm(tree, ctxt, find_var, find_var_ctxt, silently,
-            false, false);
+    if (code) {
+        ctxt->code = code;
+        result = eval_code(ctxt, find_var, find_var_ctxt, silently,
+                false, false);
+    }
+    else {
+        result = eval_vcm(tree, ctxt, find_var, find_var_ctxt, silently,
+                false, false);
+    }
 
 out:
     err = purc_get_last_error();
@@ -766,6 +938,24 @@ out:
     return result;
 }
 
+purc_variant_t pcvcm_eval_full(struct pcvcm_node *tree,
+        struct pcvcm_eval_ctxt **ctxt_out,
+        find_var_fn find_var, void *find_var_ctxt,
+        bool silently)
+{
+    return eval_full(tree, NULL, ctxt_out, find_var, find_var_ctxt,
+            silently);
+}
+
+purc_variant_t pcvcm_eval_code_full(struct pcvcm_code *code,
+        struct pcvcm_eval_ctxt **ctxt_out,
+        find_var_fn find_var, void *find_var_ctxt,
+        bool silently)
+{
+    return eval_full(code ? code->tree : NULL, code, ctxt_out,
+            find_var, find_var_ctxt, silently);
+}
+
 purc_variant_t pcvcm_eval_again_full(struct pcvcm_node *tree,
         struct pcvcm_eval_ctxt *ctxt,
         find_var_fn find_var, void *find_var_ctxt,
@@ -796,8 +986,14 @@ purc_variant_t pcvcm_eval_again_full(struct pcvcm_node *tree,
         purc_clr_error();
     }
 
-    result = eval_vcm(tree, ctxt, find_var, find_var_ctxt, silently,
-            timeout, true);
+    if (ctxt->code) {
+        result = eval_code(ctxt, find_var, find_var_ctxt, silently,
+                timeout, true);
+    }
+    else {
+        result = eval_vcm(tree, ctxt, find_var, find_var_ctxt, silently,
+                timeout, true);
+    }
 
 out:
     if (enable_log) {
@@ -47,6 +47,15 @@
 #define KEY_PARAM_NODE                  "__vcm_param_node"
 
 
+/* params of a frame up to this count are stored in the frame itself */
+#define PCVCM_EVAL_FRAME_NR_INLINE_PARAMS   4
+
+/* frames embedded in an evaluation context; deeper frames use the heap */
+#define PCVCM_EVAL_CTXT_NR_INLINE_FRAMES    8
+
+/* registers embedded in an evaluation context for compiled code */
+#define PCVCM_EVAL_CTXT_NR_INLINE_REGS      16
+
 #define MIN_BUF_SIZE                    32
 #define MAX_BUF_SIZE                    SIZE_MAX
 
@@ -75,12 +84,15 @@ enum pcvcm_eval_method_type {
 };
 
 struct pcvcm_eval_stack_frame_ops;
+struct pcintr_var_cache;
 struct pcvcm_eval_stack_frame {
     struct list_head        ln;
 
     struct pcvcm_node      *node;
-    pcutils_array_t        *params;
-    pcutils_array_t        *params_result;
+    /* point to the inline arrays below, or to heap arrays if there are
+       more than PCVCM_EVAL_FRAME_NR_INLINE_PARAMS params */
+    struct pcvcm_node     **params;
+    purc_variant_t         *params_result;
     struct pcvcm_eval_stack_frame_ops *ops;
 
     size_t                  nr_params;
@@ -88,11 +100,59 @@ struct pcvcm_eval_stack_frame {
     size_t                  return_pos;
 
     enum pcvcm_eval_stack_frame_step step;
+
+    struct pcvcm_node      *inline_params[PCVCM_EVAL_FRAME_NR_INLINE_PARAMS];
+    purc_variant_t          inline_results[PCVCM_EVAL_FRAME_NR_INLINE_PARAMS];
+};
+
+enum pcvcm_code_opcode {
+    /* asks the node whether to evaluate its param at `pos` */
+    PCVCM_CODE_OP_SELECT = 0,
+    /* evaluates the node from the results of its params */
+    PCVCM_CODE_OP_EVAL,
+};
+
+struct pcvcm_code_instr {
+    enum pcvcm_code_opcode  opcode;
+    struct pcvcm_node      *node;
+    struct pcvcm_eval_stack_frame_ops *ops;
+
+    /* the params of the node live in registers [args, args + nr_args) */
+    uint32_t                args;
+    uint32_t                nr_args;
+
+    /* EVAL: the result register and the first instruction of the subtree */
+    uint32_t                dst;
+    uint32_t                first;
+
+    /* EVAL of a getVariable node with a constant name of a named variable */
+    struct pcintr_var_cache *var_cache;
+
+    /* SELECT: where to go if the param, or also the next one, is skipped */
+    uint32_t                pos;
+    uint32_t                skip;
+    uint32_t                skip_next;
+};
+
+/* a vcm tree lowered to a post-order instruction stream, see compile.c */
+struct pcvcm_code {
+    struct pcvcm_node      *tree;
+    struct pcvcm_code_instr *instrs;
+    size_t                  nr_instrs;
+
+    /* the node evaluated into each register */
+    struct pcvcm_node     **nodes;
+    size_t                  nr_regs;
+
+    struct pcintr_var_cache *var_caches;
+    size_t                  nr_var_caches;
 };
 
 struct pcvcm_eval_ctxt {
     /* struct pcvcm_eval_stack_frame */
     struct list_head        stack;
+    /* popped frames kept for reuse */
+    struct list_head        free_frames;
     uint32_t                flags;
     find_var_fn             find_var;
     void                   *find_var_ctxt;
@@ -101,6 +161,16 @@ struct pcvcm_eval_ctxt {
     int                     err;
 
     unsigned int            enable_log:1;
+
+    /* set when evaluating compiled code instead of walking the tree */
+    struct pcvcm_code      *code;
+    purc_variant_t         *regs;
+    size_t                  pc;
+    /* the cache of the getVariable node being evaluated, if any */
+    struct pcintr_var_cache *var_cache;
+
+    struct pcvcm_eval_stack_frame frames[PCVCM_EVAL_CTXT_NR_INLINE_FRAMES];
+    purc_variant_t          inline_regs[PCVCM_EVAL_CTXT_NR_INLINE_REGS];
 };
 
 struct pcvcm_eval_stack_frame_ops {
@@ -119,15 +189,24 @@ extern "C" {
 #endif  /* __cplusplus */
 
 struct pcvcm_eval_stack_frame *
-pcvcm_eval_stack_frame_create(struct pcvcm_node *node, size_t return_pos);
+pcvcm_eval_stack_frame_create(struct pcvcm_eval_ctxt *ctxt,
+        struct pcvcm_node *node, size_t return_pos);
 
 void
-pcvcm_eval_stack_frame_destroy(struct pcvcm_eval_stack_frame *);
+pcvcm_eval_stack_frame_destroy(struct pcvcm_eval_ctxt *ctxt,
+        struct pcvcm_eval_stack_frame *frame);
 
 
 struct pcvcm_eval_ctxt *
 pcvcm_eval_ctxt_create();
 
+/* the find_var_fn of the evaluations on an interpreter stack */
+purc_variant_t
+pcvcm_find_stack_var(void *ctxt, const char *name);
+
+bool
+pcvcm_is_named_var(const char *name);
+
 void
 pcvcm_eval_ctxt_destroy(struct pcvcm_eval_ctxt *ctxt);
 
@@ -171,6 +250,11 @@ purc_variant_t pcvcm_eval_full(struct pcvcm_node *tree,
         find_var_fn find_var, void *find_var_ctxt,
         bool silently);
 
+purc_variant_t pcvcm_eval_code_full(struct pcvcm_code *code,
+        struct pcvcm_eval_ctxt **ctxt_out,
+        find_var_fn find_var, void *find_var_ctxt,
+        bool silently);
+
 purc_variant_t pcvcm_eval_again_full(struct pcvcm_node *tree,
         struct pcvcm_eval_ctxt *ctxt,
         find_var_fn find_var, void *find_var_ctxt,
@@ -61,8 +61,8 @@ eval(struct pcvcm_eval_ctxt *ctxt,
     UNUSED_PARAM(ctxt);
     UNUSED_PARAM(frame);
     purc_variant_t ret_var = PURC_VARIANT_INVALID;
-    struct pcvcm_node *caller_node = pcutils_array_get(frame->params, 0);
-    purc_variant_t caller_var = pcutils_array_get(frame->params_result, 0);
+    struct pcvcm_node *caller_node = frame->params[0];
+    purc_variant_t caller_var = frame->params_result[0];
 
     if (!purc_variant_is_dynamic(caller_var)
             && !pcvcm_eval_is_native_wrapper(caller_var)) {
@@ -71,19 +71,9 @@ eval(struct pcvcm_eval_ctxt *ctxt,
 
     unsigned call_flags = pcvcm_eval_ctxt_get_call_flags(ctxt);
 
-    purc_variant_t *params = NULL;
+    /* the arguments are the results of the params after the caller */
     size_t nr_params = frame->nr_params - 1;
-    if (nr_params > 0) {
-        params = (purc_variant_t*)calloc(nr_params, sizeof(purc_variant_t));
-        if (!params) {
-            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            goto out_free_params;
-        }
-
-        for (size_t i = 1, j = 0; i < frame->nr_params; i++, j++) {
-            params[j] = pcutils_array_get(frame->params_result, i);
-        }
-    }
+    purc_variant_t *params = nr_params > 0 ? frame->params_result + 1 : NULL;
 
     if (purc_variant_is_dynamic(caller_var)) {
         ret_var = pcvcm_eval_call_dvariant_method(
@@ -103,11 +93,6 @@ eval(struct pcvcm_eval_ctxt *ctxt,
         }
     }
 
-out_free_params:
-    if (params) {
-        free(params);
-    }
-
 out:
     return ret_var;
 }
@@ -74,7 +74,7 @@ select_param(struct pcvcm_eval_ctxt *ctxt,
 {
     UNUSED_PARAM(ctxt);
     purc_variant_t curr_val = PURC_VARIANT_INVALID;
-    struct pcvcm_node *param = pcutils_array_get(frame->params, pos);
+    struct pcvcm_node *param = frame->params[pos];
     bool is_op = is_cjsonee_op(param);
     if (!is_op) {
         goto out;
@@ -87,7 +87,7 @@ select_param(struct pcvcm_eval_ctxt *ctxt,
     }
 
     for (int i = pos -1; i >= 0; i -= 2) {
-        curr_val = pcutils_array_get(frame->params_result, i);
+        curr_val = frame->params_result[i];
         if (curr_val) {
             break;
         }
@@ -132,7 +132,7 @@ eval(struct pcvcm_eval_ctxt *ctxt,
     UNUSED_PARAM(frame);
     purc_variant_t curr_val = PURC_VARIANT_INVALID;
     for (int i = frame->nr_params - 1; i >= 0; i--) {
-        curr_val = pcutils_array_get(frame->params_result, i);
+        curr_val = frame->params_result[i];
         if (curr_val && (i % 2 == 0)) {
             break;
         }
@@ -62,11 +62,11 @@ eval(struct pcvcm_eval_ctxt *ctxt, struct pcvcm_eval_stack_frame *frame)
     purc_variant_t ret_var = PURC_VARIANT_INVALID;
     purc_variant_t inner_ret = PURC_VARIANT_INVALID;
 
-    struct pcvcm_node *caller_node = pcutils_array_get(frame->params, 0);
-    purc_variant_t caller_var = pcutils_array_get(frame->params_result, 0);
+    struct pcvcm_node *caller_node = frame->params[0];
+    purc_variant_t caller_var = frame->params_result[0];
 
-    struct pcvcm_node *param_node = pcutils_array_get(frame->params, 1);
-    purc_variant_t param_var = pcutils_array_get(frame->params_result, 1);
+    struct pcvcm_node *param_node = frame->params[1];
+    purc_variant_t param_var = frame->params_result[1];
 
     if (param_node->type == PCVCM_NODE_TYPE_STRING) {
         if (pcutils_parse_int64((const char*)param_node->sz_ptr[1],
@@ -59,7 +59,7 @@ eval(struct pcvcm_eval_ctxt *ctxt,
         struct pcvcm_eval_stack_frame *frame)
 {
     purc_variant_t ret = PURC_VARIANT_INVALID;
-    purc_variant_t name = pcutils_array_get(frame->params_result, 0);
+    purc_variant_t name = frame->params_result[0];
     if (name == PURC_VARIANT_INVALID || !purc_variant_is_string(name)) {
         purc_set_error(PURC_ERROR_INVALID_VALUE);
         goto out;
@@ -71,7 +71,13 @@ eval(struct pcvcm_eval_ctxt *ctxt,
     }
 
     const char *sname = purc_variant_get_string_const(name);
-    ret = ctxt->find_var(ctxt->find_var_ctxt, sname);
+    if (ctxt->var_cache && ctxt->find_var == pcvcm_find_stack_var) {
+        ret = pcintr_find_named_var_cached(
+                (pcintr_stack_t)ctxt->find_var_ctxt, sname, ctxt->var_cache);
+    }
+    else {
+        ret = ctxt->find_var(ctxt->find_var_ctxt, sname);
+    }
 out:
     if (ret) {
         purc_variant_ref(ret);
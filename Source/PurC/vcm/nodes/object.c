@@ -66,8 +66,8 @@ eval(struct pcvcm_eval_ctxt *ctxt,
     }
 
     for (size_t i = 0; i < frame->nr_params; i += 2) {
-        purc_variant_t key = pcutils_array_get(frame->params_result, i);
-        purc_variant_t value = pcutils_array_get(frame->params_result, i + 1);
+        purc_variant_t key = frame->params_result[i];
+        purc_variant_t value = frame->params_result[i + 1];
         if (!purc_variant_object_set(object, key, value)) {
             goto out;
         }
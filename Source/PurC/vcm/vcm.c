@@ -521,8 +521,18 @@ is_digit(char c)
     return c >= '0' && c <= '9';
 }
 
-static purc_variant_t
-find_stack_var(void *ctxt, const char *name)
+bool
+pcvcm_is_named_var(const char *name)
+{
+    size_t nr_name = strlen(name);
+    if (nr_name == 0 || is_digit(name[0]) || name[0] == '#') {
+        return false;
+    }
+    return !(nr_name == 1 && purc_ispunct(name[0]));
+}
+
+purc_variant_t
+pcvcm_find_stack_var(void *ctxt, const char *name)
 {
     struct pcintr_stack *stack = (struct pcintr_stack*)ctxt;
     size_t nr_name = strlen(name);
@@ -564,19 +574,34 @@ pcvcm_eval(struct pcvcm_node *tree, struct pcintr_stack *stack, bool silently)
             stack->vcm_ctxt = NULL;
         }
         purc_variant_t ret = pcvcm_eval_ex(tree, &stack->vcm_ctxt,
-                find_stack_var, stack, silently);
+                pcvcm_find_stack_var, stack, silently);
         return ret;
     }
     return pcvcm_eval_ex(tree, NULL, NULL, NULL, silently);
 }
 
+purc_variant_t
+pcvcm_eval_code(struct pcvcm_code *code, struct pcintr_stack *stack,
+        bool silently)
+{
+    if (stack) {
+        if (stack->vcm_ctxt) {
+            pcvcm_eval_ctxt_destroy(stack->vcm_ctxt);
+            stack->vcm_ctxt = NULL;
+        }
+        return pcvcm_eval_code_ex(code, &stack->vcm_ctxt,
+                pcvcm_find_stack_var, stack, silently);
+    }
+    return pcvcm_eval_code_ex(code, NULL, NULL, NULL, silently);
+}
+
 purc_variant_t
 pcvcm_eval_again(struct pcvcm_node *tree, struct pcintr_stack *stack,
         bool silently, bool timeout)
 {
     if (stack) {
         purc_variant_t ret = pcvcm_eval_again_ex(tree, stack->vcm_ctxt,
-                find_stack_var, stack, silently, timeout);
+                pcvcm_find_stack_var, stack, silently, timeout);
         return ret;
     }
     return pcvcm_eval_again_ex(tree, NULL, NULL, NULL, silently, timeout);
@@ -590,6 +615,14 @@ pcvcm_eval_ex(struct pcvcm_node *tree, struct pcvcm_eval_ctxt **ctxt,
     return pcvcm_eval_full(tree, ctxt, find_var, find_var_ctxt, silently);
 }
 
+purc_variant_t
+pcvcm_eval_code_ex(struct pcvcm_code *code, struct pcvcm_eval_ctxt **ctxt,
+        find_var_fn find_var, void *find_var_ctxt,
+        bool silently)
+{
+    return pcvcm_eval_code_full(code, ctxt, find_var, find_var_ctxt, silently);
+}
+
 purc_variant_t
 pcvcm_eval_again_ex(struct pcvcm_node *tree, struct pcvcm_eval_ctxt *ctxt,
         find_var_fn find_var, void *find_var_ctxt,
@@ -98,6 +98,15 @@ struct pcvdom_attr {
 
     // text/jsonnee/no-value
     struct pcvcm_node        *val;
+
+    // the atom of key in the HVML keyword bucket, resolved on creation,
+    // see pcvdom_attr_get_keyword
+    purc_atom_t               keyword;
+
+    // val compiled on demand, see pcvdom_attr_get_vcm_code
+    struct pcvcm_code        *code;
+    unsigned int              code_tried:1;
+    unsigned int              keyword_resolved:1;
 };
 
 struct pcvdom_element {
@@ -31,6 +31,7 @@
 #include "private/stringbuilder.h"
 
 #include "hvml-attr.h"
+#include "keywords.h"
 
 #include "vdom-internal.h"
 
@@ -110,6 +111,9 @@ attr_destroy(struct pcvdom_attr *doc);
 static struct pcvdom_attr*
 attr_create(void);
 
+static void
+attr_resolve_keyword(struct pcvdom_attr *attr);
+
 static void
 vdom_node_destroy(struct pcvdom_node *node);
 
@@ -255,6 +259,7 @@ pcvdom_attr_create(const char *key, enum pchvml_attr_operator op,
     }
 
     attr->val = vcm;
+    attr_resolve_keyword(attr);
 
     return attr;
 }
@@ -560,6 +565,44 @@ pcvdom_element_get_attr_c(struct pcvdom_element *elem,
     return attr;
 }
 
+static bool
+vcm_bytecode_enabled(void)
+{
+    const char *env_value = getenv(PURC_ENVV_VCM_BYTECODE);
+    if (env_value && (*env_value == '0' ||
+                pcutils_strcasecmp(env_value, "false") == 0)) {
+        return false;
+    }
+    return true;
+}
+
+purc_atom_t
+pcvdom_attr_get_keyword(struct pcvdom_attr *attr)
+{
+    if (UNLIKELY(!attr->keyword_resolved))
+        attr_resolve_keyword(attr);
+
+    return attr->keyword;
+}
+
+struct pcvcm_code*
+pcvdom_attr_get_vcm_code(struct pcvdom_attr *attr)
+{
+    if (!attr->code_tried) {
+        attr->code_tried = 1;
+        if (attr->val && vcm_bytecode_enabled()) {
+            int err = purc_get_last_error();
+            attr->code = pcvcm_compile(attr->val);
+            /* falls back to the tree walker quietly */
+            if (!attr->code) {
+                purc_set_error(err);
+            }
+        }
+    }
+
+    return attr->code;
+}
+
 // operation api
 void
 pcvdom_node_remove(struct pcvdom_node *node)
@@ -1183,6 +1226,10 @@ attr_reset(struct pcvdom_attr *attr)
     attr->pre_defined = NULL;
     attr->key = NULL;
 
+    pcvcm_code_destroy(attr->code);
+    attr->code = NULL;
+    attr->code_tried = 0;
+
     pcvcm_node_destroy(attr->val);
     attr->val = NULL;
 }
@@ -1195,6 +1242,18 @@ attr_destroy(struct pcvdom_attr *attr)
     free(attr);
 }
 
+static void
+attr_resolve_keyword(struct pcvdom_attr *attr)
+{
+    attr->keyword = PCHVML_KEYWORD_ATOM(HVML, attr->key);
+
+    /* the keyword atoms are not available before the keywords module
+     * is initialized; try again on the first use in this case */
+    if (attr->keyword ||
+            pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ON)) != 0)
+        attr->keyword_resolved = 1;
+}
+
 static struct pcvdom_attr*
 attr_create(void)
 {
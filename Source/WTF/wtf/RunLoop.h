@@ -43,6 +43,7 @@
 #endif
 
 #if USE(GLIB_EVENT_LOOP)
+#include <atomic>
 #include <wtf/glib/GRefPtr.h>
 #include <wtf/glib/GFdMonitor.h>
 #endif
@@ -96,6 +97,9 @@ public:
 #if USE(GLIB_EVENT_LOOP)
     WTF_EXPORT_PRIVATE GMainContext* mainContext() const { return m_mainContext.get(); }
     WTF_EXPORT_PRIVATE void setIdleCallback(PurCWTF::Function<void()>&& function);
+    // Stops calling the idle callback until the timeout expires or wakeUp()
+    // is called, which may happen on any thread. Use it in the idle callback.
+    WTF_EXPORT_PRIVATE void suspendIdleCallback(Seconds timeout);
     WTF_EXPORT_PRIVATE uintptr_t addFdMonitor(gint fd, GIOCondition condition,
             Function<gboolean(gint, GIOCondition)>&& callback);
     WTF_EXPORT_PRIVATE void removeFdMonitor(uintptr_t handle);
@@ -239,6 +243,8 @@ private:
 
     GRefPtr<GSource> m_idleSource;
     Function<void()> m_idleCallback;
+    std::atomic<unsigned> m_wakeUpCount { 0 };
+    unsigned m_idleWakeUpCount { 0 };
 
     Vector<RefPtr<GFdMonitor>> m_fdMonitors;
 #elif USE(GENERIC_EVENT_LOOP)
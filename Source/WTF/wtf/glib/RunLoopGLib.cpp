@@ -50,6 +50,23 @@ static GSourceFuncs runLoopSourceFunctions = {
     nullptr, // closure_marshall
 };
 
+// The idle source stays ready (ready time 0) until the callback suspends it.
+static GSourceFuncs runLoopIdleSourceFunctions = {
+    nullptr, // prepare
+    nullptr, // check
+    // dispatch
+    [](GSource* source, GSourceFunc callback, gpointer userData) -> gboolean
+    {
+        if (g_source_get_ready_time(source) == -1)
+            return G_SOURCE_CONTINUE;
+        g_source_set_ready_time(source, 0);
+        return callback(userData);
+    },
+    nullptr, // finalize
+    nullptr, // closure_callback
+    nullptr, // closure_marshall
+};
+
 RunLoop::RunLoop()
 {
     m_mainContext = g_main_context_get_thread_default();
@@ -71,12 +88,13 @@ RunLoop::RunLoop()
     }, this, nullptr);
     g_source_attach(m_source.get(), m_mainContext.get());
 
-    m_idleSource = adoptGRef(g_idle_source_new());
+    m_idleSource = adoptGRef(g_source_new(&runLoopIdleSourceFunctions, sizeof(GSource)));
     g_source_set_priority(m_idleSource.get(), RunLoopSourcePriority::RunLoopDispatcher);
     g_source_set_name(m_idleSource.get(), "[PurCFetcher] RunLoop idle");
     g_source_set_can_recurse(m_idleSource.get(), TRUE);
     g_source_set_callback(m_idleSource.get(), [](gpointer userData) -> gboolean {
         RunLoop* runloop = static_cast<RunLoop*>(userData);
+        runloop->m_idleWakeUpCount = runloop->m_wakeUpCount.load();
         if (runloop->m_idleCallback) {
             runloop->m_idleCallback();
         }
@@ -100,9 +118,25 @@ void RunLoop::setIdleCallback(PurCWTF::Function<void()>&& function)
 {
     RunLoop& runloop = RunLoop::current();
     runloop.m_idleCallback = WTFMove(function);
-    if (runloop.m_idleCallback && runloop.m_idleSource->context == NULL) {
-        g_source_attach(runloop.m_idleSource.get(), runloop.m_mainContext.get());
+    if (runloop.m_idleCallback) {
+        g_source_set_ready_time(runloop.m_idleSource.get(), 0);
+        if (runloop.m_idleSource->context == NULL)
+            g_source_attach(runloop.m_idleSource.get(), runloop.m_mainContext.get());
+    }
+}
+
+void RunLoop::suspendIdleCallback(Seconds timeout)
+{
+    gint64 readyTime = -1;
+    if (timeout < Seconds::infinity()) {
+        gint64 currentTime = g_get_monotonic_time();
+        readyTime = currentTime + std::min<gint64>(G_MAXINT64 - currentTime, timeout.microsecondsAs<gint64>());
     }
+    g_source_set_ready_time(m_idleSource.get(), readyTime);
+
+    // A wakeUp() called since the callback began may have been overridden.
+    if (m_wakeUpCount.load() != m_idleWakeUpCount)
+        g_source_set_ready_time(m_idleSource.get(), 0);
 }
 
 uintptr_t RunLoop::addFdMonitor(gint fd, GIOCondition condition,
@@ -165,6 +199,9 @@ void RunLoop::stop()
 void RunLoop::wakeUp()
 {
     g_source_set_ready_time(m_source.get(), 0);
+
+    m_wakeUpCount++;
+    g_source_set_ready_time(m_idleSource.get(), 0);
 }
 
 RunLoop::CycleResult RunLoop::cycle(RunLoopMode)
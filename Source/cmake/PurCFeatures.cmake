@@ -98,6 +98,7 @@ macro(PURC_OPTION_BEGIN)
     PURC_OPTION_DEFINE(ENABLE_DEVELOPER_MODE "Toggle developer mode" PUBLIC OFF)
 
     PURC_OPTION_DEFINE(USE_SYSTEM_MALLOC "Toggle system allocator instead of PurC's custom allocator" PRIVATE ${USE_SYSTEM_MALLOC_DEFAULT})
+    PURC_OPTION_DEFINE(USE_SLAB_ALLOCATOR "Toggle the slab allocator for variants and other small objects" PRIVATE OFF)
     PURC_OPTION_DEFINE(ENABLE_ICU "Enable icu" PUBLIC OFF)
 
 #PURC_OPTION_DEFINE(ENABLE_LCMD "Toggle support for LCMD protocol" PUBLIC ON)
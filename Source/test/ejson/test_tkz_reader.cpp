@@ -0,0 +1,326 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc.h"
+
+#include "private/ejson.h"
+#include "private/tkz-helper.h"
+#include "purc-rwstream.h"
+
+#include "../helpers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace std;
+
+static void
+make_mixed_text(vector<char> &text, size_t nr_chars)
+{
+    static const char *samples[] = {
+        "{\"key\": [1, 2.5, \"abc\"]}\n",
+        "\xe4\xb8\xad\xe6\x96\x87",         /* CJK */
+        "\xc3\xa9t\xc3\xa9",                /* Latin-1 supplement */
+        "$STR.join($ARGS, ' ')",
+    };
+
+    size_t i = 0;
+    while (i < nr_chars) {
+        const char *s = samples[i % PCA_TABLESIZE(samples)];
+        text.insert(text.end(), s, s + strlen(s));
+        i += strlen(s);
+    }
+}
+
+static void
+decode_reference(const vector<char> &text, vector<uint32_t> &ucs)
+{
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void *)text.data(),
+            text.size());
+    for (;;) {
+        char utf8[8] = {0};
+        uint32_t uc = 0;
+        int n = purc_rwstream_read_utf8_char(rws, utf8, &uc);
+        if (n < 0) {
+            uc = TKZ_INVALID_CHARACTER;
+        }
+        ucs.push_back(uc);
+        if (n == 0) {
+            break;
+        }
+    }
+    purc_rwstream_destroy(rws);
+}
+
+struct pipe_writer {
+    int fd;
+    const vector<char> *text;
+    size_t sz_chunk;
+};
+
+static void *
+write_to_pipe(void *arg)
+{
+    struct pipe_writer *writer = (struct pipe_writer *)arg;
+    const char *p = writer->text->data();
+    size_t left = writer->text->size();
+    while (left > 0) {
+        size_t n = left < writer->sz_chunk ? left : writer->sz_chunk;
+        ssize_t ret = write(writer->fd, p, n);
+        if (ret <= 0)
+            break;
+        p += ret;
+        left -= ret;
+    }
+    close(writer->fd);
+    return NULL;
+}
+
+static void
+check_reader(purc_rwstream_t rws, const vector<uint32_t> &ucs)
+{
+    struct tkz_reader *reader = tkz_reader_new();
+    ASSERT_NE(reader, nullptr);
+
+    tkz_reader_set_rwstream(reader, rws);
+    for (size_t i = 0; i < ucs.size(); i++) {
+        struct tkz_uc *uc = tkz_reader_next_char(reader);
+        ASSERT_NE(uc, nullptr);
+        ASSERT_EQ(uc->character, ucs[i]) << "at character " << i;
+
+        if (i % 7 == 6) {
+            tkz_reader_reconsume_last_char(reader);
+            tkz_reader_reconsume_last_char(reader);
+            uc = tkz_reader_next_char(reader);
+            ASSERT_EQ(uc->character, ucs[i - 1]);
+            uc = tkz_reader_next_char(reader);
+            ASSERT_EQ(uc->character, ucs[i]);
+        }
+    }
+
+    tkz_reader_destroy(reader);
+}
+
+TEST(tkz_reader, memory)
+{
+    PurCInstance purc(false);
+
+    vector<char> text;
+    vector<uint32_t> ucs;
+    make_mixed_text(text, 200000);
+    decode_reference(text, ucs);
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem(text.data(),
+            text.size());
+    check_reader(rws, ucs);
+
+    /* the bytes decoded in place are given back to the stream */
+    ASSERT_EQ(purc_rwstream_tell(rws), (off_t)text.size());
+    purc_rwstream_destroy(rws);
+}
+
+TEST(tkz_reader, pipe)
+{
+    PurCInstance purc(false);
+
+    vector<char> text;
+    vector<uint32_t> ucs;
+    make_mixed_text(text, 200000);
+    decode_reference(text, ucs);
+
+    /* odd-sized writes split the UTF-8 characters between reads */
+    size_t chunks[] = { 1, 7, 4093, 100000 };
+    for (size_t i = 0; i < PCA_TABLESIZE(chunks); i++) {
+        int fds[2];
+        ASSERT_EQ(pipe(fds), 0);
+
+        struct pipe_writer writer = { fds[1], &text, chunks[i] };
+        pthread_t th;
+        ASSERT_EQ(pthread_create(&th, NULL, write_to_pipe, &writer), 0);
+
+        purc_rwstream_t rws = purc_rwstream_new_from_unix_fd(fds[0]);
+        check_reader(rws, ucs);
+        purc_rwstream_destroy(rws);
+
+        pthread_join(th, NULL);
+        close(fds[0]);
+    }
+}
+
+TEST(tkz_reader, bad_encoding)
+{
+    PurCInstance purc(false);
+
+    const char *bad[] = {
+        "ab\x80" "cd",
+        "ab\xc3",
+        "ab\xe4\xb8" "cd",
+        "ab\xf0\x9f\x98\x80" "cd",
+        "ab\xfe" "cd",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(bad); i++) {
+        vector<char> text(bad[i], bad[i] + strlen(bad[i]));
+        vector<uint32_t> ucs;
+        decode_reference(text, ucs);
+
+        purc_rwstream_t rws = purc_rwstream_new_from_mem(text.data(),
+                text.size());
+        check_reader(rws, ucs);
+        purc_rwstream_destroy(rws);
+    }
+}
+
+/* reconsume up to and beyond the limit of the consumed characters, so that
+   the characters come from the ring across its wrap-around boundary */
+TEST(tkz_reader, reconsume_across_ring)
+{
+    PurCInstance purc(false);
+
+    vector<char> text;
+    make_mixed_text(text, 4096);
+    vector<uint32_t> ucs;
+    decode_reference(text, ucs);
+    ucs.pop_back();     /* the end of file */
+
+    vector<struct tkz_uc> expected;
+    int line = 1, column = 0;
+    for (size_t i = 0; i < ucs.size(); i++) {
+        struct tkz_uc uc = { ucs[i], line, ++column, (int)i + 1 };
+        expected.push_back(uc);
+        if (ucs[i] == '\n') {
+            line++;
+            column = 0;
+        }
+    }
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem(text.data(),
+            text.size());
+    struct tkz_reader *reader = tkz_reader_new();
+    ASSERT_NE(reader, nullptr);
+    tkz_reader_set_rwstream(reader, rws);
+
+    /* the model: the index of the next character, and the number of the
+       characters can be reconsumed, which is 10 at most */
+    size_t next = 0, nr_consumed = 0;
+    size_t step = 0;
+    while (next < expected.size()) {
+        struct tkz_uc *uc = tkz_reader_next_char(reader);
+        ASSERT_NE(uc, nullptr);
+        ASSERT_EQ(uc->character, expected[next].character) << "at " << next;
+        ASSERT_EQ(uc->line, expected[next].line) << "at " << next;
+        ASSERT_EQ(uc->column, expected[next].column) << "at " << next;
+        ASSERT_EQ(uc->position, expected[next].position) << "at " << next;
+        next++;
+        if (nr_consumed < 10)
+            nr_consumed++;
+
+        /* 0 to 12 characters back every 13 steps */
+        if (++step % 13 == 0) {
+            size_t nr_back = (step / 13) % 13;
+            for (size_t i = 0; i < nr_back; i++) {
+                ASSERT_TRUE(tkz_reader_reconsume_last_char(reader));
+                if (nr_consumed > 0) {
+                    nr_consumed--;
+                    next--;
+                }
+            }
+        }
+    }
+
+    tkz_reader_destroy(reader);
+    purc_rwstream_destroy(rws);
+}
+
+TEST(tkz_reader, perf_parse_from_pipe)
+{
+    PurCInstance purc(false);
+
+    vector<char> text;
+    text.push_back('[');
+    for (int i = 0; i < 100000; i++) {
+        const char *item = "{\"id\": 12345, \"name\": \"\xe4\xb8\xad\xe6\x96"
+            "\x87 text\", \"tags\": [\"a\", \"b\"]},\n";
+        text.insert(text.end(), item, item + strlen(item));
+    }
+    text.push_back('0');
+    text.push_back(']');
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    struct pipe_writer writer = { fds[1], &text, 65536 };
+    pthread_t th;
+    ASSERT_EQ(pthread_create(&th, NULL, write_to_pipe, &writer), 0);
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    purc_rwstream_t rws = purc_rwstream_new_from_unix_fd(fds[0]);
+    purc_variant_t v = purc_variant_load_from_json_stream(rws);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+
+    double elapsed = purc_get_elapsed_seconds(&begin, NULL);
+    PRINTF("parsed %zu bytes from a pipe in %.3f seconds\n",
+            text.size(), elapsed);
+
+    purc_variant_unref(v);
+    purc_rwstream_destroy(rws);
+    pthread_join(th, NULL);
+    close(fds[0]);
+}
+
+TEST(tkz_reader, perf_next_char)
+{
+    PurCInstance purc(false);
+
+    vector<char> text;
+    make_mixed_text(text, 8 * 1024 * 1024);
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem(text.data(),
+            text.size());
+    struct tkz_reader *reader = tkz_reader_new();
+    tkz_reader_set_rwstream(reader, rws);
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    /* reconsume like the tokenizers do when they look ahead */
+    size_t nr_chars = 0;
+    struct tkz_uc *uc;
+    while ((uc = tkz_reader_next_char(reader)) && uc->character) {
+        if (++nr_chars % 16 == 0) {
+            tkz_reader_reconsume_last_char(reader);
+            tkz_reader_reconsume_last_char(reader);
+            tkz_reader_next_char(reader);
+            tkz_reader_next_char(reader);
+        }
+    }
+
+    double elapsed = purc_get_elapsed_seconds(&begin, NULL);
+    PRINTF("%zu characters in %.3f seconds: %.2f ns per character\n",
+            nr_chars, elapsed, elapsed * 1e9 / nr_chars);
+
+    tkz_reader_destroy(reader);
+    purc_rwstream_destroy(rws);
+}
@@ -21,6 +21,7 @@
 
 #include "private/ejson.h"
 #include "private/utils.h"
+#include "private/variant.h"
 #include "purc-rwstream.h"
 
 #include "../helpers.h"
@@ -28,6 +29,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 using namespace std;
@@ -191,6 +195,29 @@ TEST_P(ejson_parser_vcm_eval, parse_and_serialize)
     fprintf(stderr, "com=%s\n", comp);
     ASSERT_STREQ(buf, comp) << "Test Case : "<< get_name();
 
+    /* the compiled code evaluates to the same result */
+    struct pcvcm_code *code = pcvcm_compile(root);
+    ASSERT_NE(code, nullptr) << "Test Case : "<< get_name();
+    purc_variant_t vc = pcvcm_eval_code(code, NULL, false);
+    ASSERT_NE(vc, PURC_VARIANT_INVALID) << "Test Case : "<< get_name();
+
+    char buf_code[1024] = {0};
+    purc_rwstream_t rws_code = purc_rwstream_new_from_mem(buf_code,
+            sizeof(buf_code) - 1);
+    n = purc_variant_serialize(vc, rws_code,
+            0,
+            PCVARIANT_SERIALIZE_OPT_REAL_EJSON |
+            PCVARIANT_SERIALIZE_OPT_PLAIN |
+            PCVARIANT_SERIALIZE_OPT_BSEQUENCE_BASE64,
+            &len_expected);
+    ASSERT_GT(n, 0) << "Test Case : "<< get_name();
+    buf_code[n] = 0;
+    ASSERT_STREQ(buf_code, comp) << "Test Case : "<< get_name();
+
+    purc_variant_unref(vc);
+    purc_rwstream_destroy(rws_code);
+    pcvcm_code_destroy(code);
+
     size_t nr_serial = 0;
     char* serial = pcvcm_node_serialize(root, &nr_serial);
 
@@ -347,3 +374,197 @@ std::vector<ejson_test_data> read_ejson_test_data()
 INSTANTIATE_TEST_SUITE_P(ejson, ejson_parser_vcm_eval,
         testing::ValuesIn(read_ejson_test_data()));
 
+TEST(ejson_vcm_code, perf_tree_walk_vs_bytecode)
+{
+    PurCInstance purc((unsigned int)PURC_MODULE_EJSON);
+
+    std::vector<ejson_test_data> corpora = read_ejson_test_data();
+    std::vector<struct pcvcm_node *> trees;
+    std::vector<struct pcvcm_code *> codes;
+    for (size_t i = 0; i < corpora.size(); i++) {
+        if (corpora[i].error != PCEJSON_SUCCESS)
+            continue;
+
+        size_t sz = strlen(corpora[i].json) + 1;
+        purc_rwstream_t rws = purc_rwstream_new_from_mem(corpora[i].json, sz);
+        struct pcvcm_node *root = NULL;
+        struct pcejson *parser = NULL;
+        pcejson_parse(&root, &parser, rws, 32);
+        pcejson_destroy(parser);
+        purc_rwstream_destroy(rws);
+        if (!root)
+            continue;
+
+        struct pcvcm_code *code = pcvcm_compile(root);
+        ASSERT_NE(code, nullptr) << "Test Case : "<< corpora[i].name;
+        trees.push_back(root);
+        codes.push_back(code);
+    }
+    purc_clr_error();
+
+    const int nr_loops = 200;
+    double elapsed[2];
+    for (int method = 0; method < 2; method++) {
+        struct timespec begin;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+
+        for (int n = 0; n < nr_loops; n++) {
+            for (size_t i = 0; i < trees.size(); i++) {
+                purc_variant_t v = method == 0 ?
+                    pcvcm_eval(trees[i], NULL, false) :
+                    pcvcm_eval_code(codes[i], NULL, false);
+                if (v)
+                    purc_variant_unref(v);
+            }
+        }
+
+        elapsed[method] = purc_get_elapsed_seconds(&begin, NULL);
+    }
+
+    PRINTF("%zu expressions evaluated %d times: tree walk %.3fs, "
+            "bytecode %.3fs\n", trees.size(), nr_loops,
+            elapsed[0], elapsed[1]);
+
+    for (size_t i = 0; i < trees.size(); i++) {
+        pcvcm_code_destroy(codes[i]);
+        pcvcm_node_destroy(trees[i]);
+    }
+}
+
+
+/* the variables suspend the evaluation on the first lookup of each name */
+struct again_vars {
+    purc_variant_t x;
+    purc_variant_t y;
+    std::vector<std::string> asked;
+    int nr_suspended;
+    int nr_lookups;
+};
+
+static purc_variant_t
+again_find_var(void *ctxt, const char *name)
+{
+    struct again_vars *vars = (struct again_vars *)ctxt;
+
+    vars->nr_lookups++;
+    if (std::find(vars->asked.begin(), vars->asked.end(), name) ==
+            vars->asked.end()) {
+        vars->asked.push_back(name);
+        vars->nr_suspended++;
+        purc_set_error(PURC_ERROR_AGAIN);
+        return PURC_VARIANT_INVALID;
+    }
+
+    if (strcmp(name, "X") == 0)
+        return vars->x;
+    if (strcmp(name, "Y") == 0)
+        return vars->y;
+
+    purc_set_error(PURC_ERROR_NOT_EXISTS);
+    return PURC_VARIANT_INVALID;
+}
+
+static char *
+eval_with_again(struct pcvcm_node *tree, struct pcvcm_code *code,
+        struct again_vars *vars)
+{
+    struct pcvcm_eval_ctxt *ctxt = NULL;
+    purc_variant_t v;
+
+    vars->asked.clear();
+    vars->nr_suspended = 0;
+    vars->nr_lookups = 0;
+
+    v = code ? pcvcm_eval_code_ex(code, &ctxt, again_find_var, vars, false) :
+        pcvcm_eval_ex(tree, &ctxt, again_find_var, vars, false);
+    while (v == PURC_VARIANT_INVALID &&
+            purc_get_last_error() == PURC_ERROR_AGAIN) {
+        if (ctxt == NULL)
+            break;
+        v = pcvcm_eval_again_ex(tree, ctxt, again_find_var, vars,
+                false, false);
+    }
+
+    if (ctxt)
+        pcvcm_eval_ctxt_destroy(ctxt);
+    if (v == PURC_VARIANT_INVALID)
+        return NULL;
+
+    char *buf = pcvariant_to_string(v);
+    purc_variant_unref(v);
+    return buf;
+}
+
+TEST(ejson_vcm_code, eval_again_resumes_compiled_code)
+{
+    static const struct {
+        const char *ejson;
+        const char *expected;
+        int nr_suspended;
+    } cases[] = {
+        { "[1, $X, 3]", "[1,\"hello\",3]", 1 },
+        { "[1, $X, { \"a\": $Y.b }, $X]",
+            "[1,\"hello\",{\"a\":2},\"hello\"]", 2 },
+        { "{{ $X ; $Y.b }}", "2", 2 },
+        { "{{ $NOPE || $X }}", NULL, 1 },
+        { "[[$Y.b, $X], [$X, $Y]]",
+            "[[2,\"hello\"],[\"hello\",{\"b\":2}]]", 2 },
+    };
+
+    PurCInstance purc((unsigned int)PURC_MODULE_EJSON);
+
+    struct again_vars vars;
+    vars.x = purc_variant_make_string("hello", false);
+    vars.y = purc_variant_make_object_0();
+    purc_variant_t b = purc_variant_make_ulongint(2);
+    purc_variant_object_set_by_static_ckey(vars.y, "b", b);
+    purc_variant_unref(b);
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        size_t sz = strlen(cases[i].ejson) + 1;
+        purc_rwstream_t rws = purc_rwstream_new_from_mem(
+                (void *)cases[i].ejson, sz);
+        struct pcvcm_node *root = NULL;
+        struct pcejson *parser = NULL;
+        pcejson_parse(&root, &parser, rws, 32);
+        pcejson_destroy(parser);
+        purc_rwstream_destroy(rws);
+        ASSERT_NE(root, nullptr) << "Test Case : " << cases[i].ejson;
+
+        struct pcvcm_code *code = pcvcm_compile(root);
+        ASSERT_NE(code, nullptr) << "Test Case : " << cases[i].ejson;
+
+        char *walked = eval_with_again(root, NULL, &vars);
+        int nr_walk_suspended = vars.nr_suspended;
+        int nr_walk_lookups = vars.nr_lookups;
+        char *run = eval_with_again(root, code, &vars);
+
+        /* the code resumes from the suspended instruction, it does not
+           look up the variables already found once more */
+        ASSERT_EQ(vars.nr_suspended, nr_walk_suspended)
+            << "Test Case : " << cases[i].ejson;
+        ASSERT_EQ(vars.nr_lookups, nr_walk_lookups)
+            << "Test Case : " << cases[i].ejson;
+        if (cases[i].expected) {
+            ASSERT_EQ(vars.nr_suspended, cases[i].nr_suspended)
+                << "Test Case : " << cases[i].ejson;
+            ASSERT_NE(walked, nullptr) << "Test Case : " << cases[i].ejson;
+            ASSERT_NE(run, nullptr) << "Test Case : " << cases[i].ejson;
+            ASSERT_STREQ(walked, cases[i].expected)
+                << "Test Case : " << cases[i].ejson;
+            ASSERT_STREQ(run, walked) << "Test Case : " << cases[i].ejson;
+        }
+        else {
+            ASSERT_EQ(walked, nullptr) << "Test Case : " << cases[i].ejson;
+            ASSERT_EQ(run, nullptr) << "Test Case : " << cases[i].ejson;
+        }
+
+        free(walked);
+        free(run);
+        pcvcm_code_destroy(code);
+        pcvcm_node_destroy(root);
+    }
+
+    purc_variant_unref(vars.x);
+    purc_variant_unref(vars.y);
+}
@@ -22,11 +22,14 @@
 #include "private/variant.h"
 #include "private/ejson-parser.h"
 #include "private/executor.h"
+#include "private/hashtable.h"
+#include "private/instance.h"
 #include "private/utils.h"
 
 #include <gtest/gtest.h>
 #include <glob.h>
 #include <limits.h>
+#include <time.h>
 
 
 #include "../helpers.h"
@@ -864,3 +867,127 @@ TEST(executors, utf8_wchar)
 {
 }
 
+static purc_variant_t
+make_numbers(size_t nr)
+{
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t v = purc_variant_make_number(i);
+        purc_variant_array_append(arr, v);
+        purc_variant_unref(v);
+    }
+    return arr;
+}
+
+// iterate like <iterate> does: pass the rule to every step
+static ssize_t
+iterate_by_rule(purc_exec_ops_t ops, purc_variant_t input, const char *rule)
+{
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_ITERATE, input, true);
+    if (inst == NULL)
+        return -1;
+
+    ssize_t n = 0;
+    purc_exec_iter_t it = ops->it_begin(inst, rule);
+    if (it == NULL && inst->err_msg)
+        n = -1;
+    for (; it; it = ops->it_next(inst, it, rule)) {
+        n++;
+    }
+    purc_clr_error();
+
+    ops->destroy(inst);
+    return n;
+}
+
+static size_t
+nr_cached_rules(void)
+{
+    struct pcexecutor_heap *heap = pcinst_current()->executor_heap;
+    return heap->rules ? pchash_table_length(heap->rules) : 0;
+}
+
+TEST(executors, rule_cache)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test", "executors",
+            &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("FILTER", &ops));
+
+    purc_variant_t input = make_numbers(100);
+
+    ASSERT_EQ(iterate_by_rule(ops, input, "FILTER: GT 30"), 69);
+    ASSERT_EQ(nr_cached_rules(), 1U);
+    ASSERT_EQ(iterate_by_rule(ops, input, "FILTER: GT 30"), 69);
+    ASSERT_EQ(nr_cached_rules(), 1U);
+    ASSERT_EQ(iterate_by_rule(ops, input, "FILTER: ALL"), 100);
+    ASSERT_EQ(nr_cached_rules(), 2U);
+
+    // the bad rules are not cached
+    ASSERT_EQ(iterate_by_rule(ops, input, "FILTER: GT"), -1);
+    ASSERT_EQ(nr_cached_rules(), 2U);
+
+    // the cached rule is kept alive by the instance using it after evicted
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_ITERATE, input, true);
+    ASSERT_NE(inst, nullptr);
+    purc_exec_iter_t it = ops->it_begin(inst, "FILTER: LT 10");
+    ASSERT_NE(it, nullptr);
+
+    for (size_t i = 0; i < PCEXECUTOR_MAX_CACHED_RULES * 2; i++) {
+        char rule[64];
+        snprintf(rule, sizeof(rule), "FILTER: GE %zu", i % 100);
+        ASSERT_EQ(iterate_by_rule(ops, input, rule), (ssize_t)(100 - i % 100));
+        ASSERT_LE(nr_cached_rules(), (size_t)PCEXECUTOR_MAX_CACHED_RULES);
+    }
+
+    size_t n = 1;
+    while ((it = ops->it_next(inst, it, "FILTER: LT 10")))
+        n++;
+    purc_clr_error();
+    ASSERT_EQ(n, 10U);
+    ops->destroy(inst);
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
+
+TEST(executors, rule_cache_perf)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test", "executors",
+            &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("FILTER", &ops));
+
+    const size_t nr_items = 100000;
+    purc_variant_t input = make_numbers(nr_items);
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ASSERT_EQ(iterate_by_rule(ops, input, "FILTER: GE 0"), (ssize_t)nr_items);
+    PRINTF("iterating over %zu items with FILTER: %fs\n", nr_items,
+            purc_get_elapsed_seconds(&begin, NULL));
+
+    purc_variant_unref(input);
+    input = make_numbers(10);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t i = 0; i < nr_items; i++) {
+        purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_CHOOSE, input,
+                true);
+        purc_variant_t v = ops->choose(inst, "FILTER: GT 4");
+        ASSERT_NE(v, PURC_VARIANT_INVALID);
+        purc_variant_unref(v);
+        ops->destroy(inst);
+    }
+    PRINTF("choosing %zu times with FILTER: %fs\n", nr_items,
+            purc_get_elapsed_seconds(&begin, NULL));
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
@@ -21,15 +21,19 @@
 
 #include "purc-executor.h"
 
+#include "private/executor.h"
 #include "private/utils.h"
 
 #include <gtest/gtest.h>
 #include <glob.h>
 #include <limits.h>
+#include <time.h>
 
 #include "../helpers.h"
 
 extern "C" {
+#include "pcexe-helper.h"
+#include "exe_sql.h"
 #include "exe_sql.tab.h"
 }
 
@@ -68,9 +72,8 @@ parse(const char *rule, char *err_msg, size_t sz_err_msg)
     r = exe_sql_parse(rule, strlen(rule), &param) == 0;
     if (param.err_msg) {
         snprintf(err_msg, sz_err_msg, "%s", param.err_msg);
-        free(param.err_msg);
-        param.err_msg = NULL;
     }
+    exe_sql_param_reset(&param);
 
     return r;
 }
@@ -105,3 +108,351 @@ TEST(exe_sql, files)
     ASSERT_TRUE(ok);
 }
 
+
+static const char *locales =
+    "["
+    "{\"locale\":\"zh_CN\",\"rank\":80,\"age\":3},"
+    "{\"locale\":\"zh_TW\",\"rank\":60,\"age\":5},"
+    "{\"locale\":\"en_US\",\"rank\":90,\"age\":3},"
+    "{\"locale\":\"en_UK\",\"rank\":70,\"age\":5},"
+    "{\"locale\":\"ja_JP\",\"rank\":50,\"age\":7,\"note\":\"x\"}"
+    "]";
+
+static std::string
+serialize(purc_variant_t v)
+{
+    char buf[4096];
+    purc_rwstream_t out = purc_rwstream_new_from_mem(buf, sizeof(buf) - 1);
+    size_t len = 0;
+    ssize_t r = purc_variant_serialize(v, out, 0,
+            PCVARIANT_SERIALIZE_OPT_PLAIN, &len);
+    purc_rwstream_destroy(out);
+    if (r < 0)
+        return "<error>";
+    return std::string(buf, r);
+}
+
+// iterate over the result of the query and join the rows with `;`
+static std::string
+iterate(purc_exec_ops_t ops, purc_variant_t input, const char *rule)
+{
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_ITERATE, input, true);
+    if (inst == NULL)
+        return "<error>";
+
+    std::string s;
+    purc_exec_iter_t it = ops->it_begin(inst, rule);
+    if (it == NULL && inst->err_msg)
+        s = "<error>";
+    for (; it; it = ops->it_next(inst, it, rule)) {
+        if (!s.empty())
+            s += ";";
+        s += serialize(ops->it_value(inst, it));
+    }
+    purc_clr_error();
+
+    ops->destroy(inst);
+    return s;
+}
+
+TEST(exe_sql, select)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test", "exe_sql",
+            &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("SQL", &ops));
+
+    purc_variant_t input = purc_variant_make_from_json_string(locales,
+            strlen(locales));
+    ASSERT_NE(input, PURC_VARIANT_INVALID);
+
+    EXPECT_EQ(iterate(ops, input,
+                "SQL: SELECT locale WHERE locale LIKE 'zh_*'"),
+            "{\"locale\":\"zh_CN\"};{\"locale\":\"zh_TW\"}");
+    EXPECT_EQ(iterate(ops, input,
+                "SQL: SELECT locale AS l, rank - 50 AS r WHERE rank >= 70"),
+            "{\"l\":\"zh_CN\",\"r\":30};{\"l\":\"en_US\",\"r\":40};"
+            "{\"l\":\"en_UK\",\"r\":20}");
+    EXPECT_EQ(iterate(ops, input,
+                "SQL: SELECT locale WHERE age = 3 OR locale = 'en_UK'"),
+            "{\"locale\":\"zh_CN\"};{\"locale\":\"en_US\"};"
+            "{\"locale\":\"en_UK\"}");
+    EXPECT_EQ(iterate(ops, input,
+                "SQL: SELECT locale WHERE locale IN ('zh_TW', 'ja_JP')"),
+            "{\"locale\":\"zh_TW\"};{\"locale\":\"ja_JP\"}");
+    EXPECT_EQ(iterate(ops, input, "SQL: SELECT note WHERE note != 'y'"),
+            "{\"note\":\"x\"}");
+    EXPECT_EQ(iterate(ops, input,
+                "SQL: SELECT locale ORDER BY age DESC, rank LIMIT 3"),
+            "{\"locale\":\"ja_JP\"};{\"locale\":\"zh_TW\"};"
+            "{\"locale\":\"en_UK\"}");
+    EXPECT_EQ(iterate(ops, input,
+                "SQL: SELECT age, COUNT(*), SUM(rank), MAX(locale) "
+                "GROUP BY age ORDER BY age"),
+            "{\"COUNT(*)\":2,\"MAX(locale)\":\"zh_CN\",\"SUM(rank)\":170,"
+            "\"age\":3};"
+            "{\"COUNT(*)\":2,\"MAX(locale)\":\"zh_TW\",\"SUM(rank)\":130,"
+            "\"age\":5};"
+            "{\"COUNT(*)\":1,\"MAX(locale)\":\"ja_JP\",\"SUM(rank)\":50,"
+            "\"age\":7}");
+    EXPECT_EQ(iterate(ops, input,
+                "SQL: SELECT locale WHERE age = 7 "
+                "UNION SELECT locale WHERE rank < 60"),
+            "{\"locale\":\"ja_JP\"}");
+
+    // the aggregate query without GROUP BY yields a single row
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_REDUCE, input, true);
+    ASSERT_NE(inst, nullptr);
+    purc_variant_t v = ops->reduce(inst,
+            "SQL: SELECT AVG(rank) AS avg, MIN(rank) AS min "
+            "WHERE age < 7");
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    EXPECT_EQ(serialize(v), "{\"avg\":75,\"min\":60}");
+    purc_variant_unref(v);
+    ops->destroy(inst);
+
+    // bad rules
+    EXPECT_EQ(iterate(ops, input, "SQL: SELECT FOO(rank)"), "<error>");
+    EXPECT_EQ(iterate(ops, input, "SQL: SELECT * WHERE COUNT(*) > 1"),
+            "<error>");
+    EXPECT_EQ(iterate(ops, input, "SQL: SELECT * WHERE"), "<error>");
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
+
+static purc_variant_t
+make_rows(size_t nr)
+{
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t row = purc_variant_make_object(0,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+        purc_variant_t v = purc_variant_make_number(i);
+        purc_variant_object_set_by_static_ckey(row, "id", v);
+        purc_variant_unref(v);
+        v = purc_variant_make_number(i % 67);
+        purc_variant_object_set_by_static_ckey(row, "grp", v);
+        purc_variant_unref(v);
+        v = purc_variant_make_number((i * 7) % 100);
+        purc_variant_object_set_by_static_ckey(row, "score", v);
+        purc_variant_unref(v);
+        purc_variant_array_append(arr, row);
+        purc_variant_unref(row);
+    }
+    return arr;
+}
+
+static ssize_t
+count_rows(purc_exec_ops_t ops, purc_variant_t input, const char *rule)
+{
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_CHOOSE, input, true);
+    if (inst == NULL)
+        return -1;
+
+    ssize_t n = -1;
+    purc_variant_t v = ops->choose(inst, rule);
+    if (v != PURC_VARIANT_INVALID) {
+        if (purc_variant_is_array(v))
+            n = purc_variant_array_get_size(v);
+        else
+            n = 1;
+        purc_variant_unref(v);
+    }
+    ops->destroy(inst);
+    return n;
+}
+
+TEST(exe_sql, index)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test", "exe_sql",
+            &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("SQL", &ops));
+
+    const size_t nr_rows = 30000;
+    purc_variant_t input = make_rows(nr_rows);
+
+    // `grp + 0` can not be looked up in the index, so it scans all rows
+    static const char *rules[][2] = {
+        { "SQL: SELECT id WHERE grp = 7 AND score > 50",
+          "SQL: SELECT id WHERE grp + 0 = 7 AND score > 50" },
+        { "SQL: SELECT id WHERE grp IN (3, 5, 8) ORDER BY id DESC",
+          "SQL: SELECT id WHERE grp + 0 IN (3, 5, 8) ORDER BY id DESC" },
+        { "SQL: SELECT id WHERE score = 14 AND grp = 2",
+          "SQL: SELECT id WHERE score + 0 = 14 AND grp + 0 = 2" },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(rules); i++) {
+        ssize_t n = count_rows(ops, input, rules[i][0]);
+        ASSERT_GT(n, 0);
+        ASSERT_EQ(n, count_rows(ops, input, rules[i][1]));
+    }
+
+    // the same rows in the same order whichever plan is used
+    purc_variant_t small = make_rows(200);
+    for (size_t i = 0; i < PCA_TABLESIZE(rules); i++) {
+        ASSERT_EQ(iterate(ops, small, rules[i][0]),
+                iterate(ops, small, rules[i][1]));
+    }
+    purc_variant_unref(small);
+
+    // an index is built when the same field is looked up again
+    const size_t nr_selects = 67;
+    for (int indexed = 0; indexed < 2; indexed++) {
+        std::string rule = "SQL: ";
+        for (size_t i = 0; i < nr_selects; i++) {
+            char select[128];
+            snprintf(select, sizeof(select),
+                    "%sSELECT id WHERE grp%s = %zu AND score > 97",
+                    i ? " UNION " : "", indexed ? "" : " + 0", i);
+            rule += select;
+        }
+
+        struct timespec begin;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        ssize_t n = count_rows(ops, input, rule.c_str());
+        ASSERT_GT(n, 0);
+
+        PRINTF("selecting %zd of %zu rows with %zu SELECTs %s: %fs\n",
+                n, nr_rows, nr_selects, indexed ? "by index" : "by scanning",
+                purc_get_elapsed_seconds(&begin, NULL));
+    }
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
+
+// the indexes of the first rule do not outlive the change of the records
+TEST(exe_sql, index_after_update)
+{
+    PurCInstance purc;
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("SQL", &ops));
+
+    purc_variant_t input = make_rows(40);
+    for (size_t i = 0; i < 40; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "n%zu", i % 4);
+        purc_variant_t v = purc_variant_make_string(name, false);
+        purc_variant_object_set_by_static_ckey(
+                purc_variant_array_get(input, i), "name", v);
+        purc_variant_unref(v);
+    }
+
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_CHOOSE, input, true);
+    ASSERT_NE(inst, nullptr);
+
+    // the second SELECT looks the rows up in the index on `name`
+    purc_variant_t v = ops->choose(inst, "SQL: SELECT id WHERE name = 'n1' "
+            "UNION SELECT id WHERE name = 'n2' AND id < 10");
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    EXPECT_EQ(purc_variant_array_get_size(v), 12);
+    purc_variant_unref(v);
+
+    // replace the strings of the field which the index was keyed by
+    for (size_t i = 1; i < 40; i += 4) {
+        v = purc_variant_make_string("n3", false);
+        purc_variant_object_set_by_static_ckey(
+                purc_variant_array_get(input, i), "name", v);
+        purc_variant_unref(v);
+    }
+
+    v = ops->choose(inst, "SQL: SELECT id WHERE name = 'n3' AND id < 6 "
+            "UNION SELECT id WHERE name = 'n1'");
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    EXPECT_EQ(serialize(v), "[{\"id\":1},{\"id\":3},{\"id\":5}]");
+    purc_variant_unref(v);
+
+    ops->destroy(inst);
+    purc_variant_unref(input);
+}
+
+static double exit_result;
+
+static int
+exit_handler(purc_cond_t event, void *arg, void *data)
+{
+    (void)arg;
+
+    if (event == PURC_COND_COR_EXITED) {
+        struct purc_cor_exit_info *info = (struct purc_cor_exit_info *)data;
+        if (!purc_variant_cast_to_number(info->result, &exit_result, false))
+            exit_result = -1;
+    }
+
+    return 0;
+}
+
+static double
+run_records(size_t nr, const char *body, double *result)
+{
+    std::string hvml = "<hvml target=\"void\"><body><init as=\"rows\">[";
+    char buf[128];
+    for (size_t i = 0; i < nr; i++) {
+        snprintf(buf, sizeof(buf),
+                "%s{\"id\":%zu,\"grp\":%zu,\"score\":%zu}",
+                i ? "," : "", i, i % 100, (i * 37) % 101);
+        hvml += buf;
+    }
+    hvml += "]</init>";
+    hvml += body;
+    hvml += "</body></hvml>";
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml.c_str());
+    if (vdom == NULL)
+        return -1;
+    exit_result = -1;
+    purc_schedule_vdom_null(vdom);
+    purc_run(exit_handler);
+    *result = exit_result;
+    return purc_get_elapsed_seconds(&begin, NULL);
+}
+
+TEST(exe_sql, hvml_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "exe_sql", false);
+    ASSERT_TRUE(purc);
+
+    const size_t nr = 10000;
+    static const char *filter =
+        "<init as=\"result\" with=[] />"
+        "<iterate on=\"$rows\" by=\"FILTER: ALL\">"
+        "<test with $L.and($L.eq($?.grp, 7), $L.gt($?.score, 50)) >"
+        "<update on=\"$result\" to=\"append\" with=\"$2?\" />"
+        "</test>"
+        "</iterate>"
+        "<exit with $EJSON.count($result) />";
+    static const char *sql =
+        "<choose on=\"$rows\" "
+        "by=\"SQL: SELECT * WHERE grp = 7 AND score > 50\">"
+        "<exit with $EJSON.count($?) />"
+        "</choose>";
+
+    // the time to load the records
+    double nr_filtered, nr_selected;
+    double base = run_records(nr, "", &nr_filtered);
+    ASSERT_GE(base, 0);
+
+    double t = run_records(nr, filter, &nr_filtered);
+    ASSERT_GE(t, 0);
+    PRINTF("selecting %.0f of %zu records with FILTER and <test>: %fs\n",
+            nr_filtered, nr, t - base);
+
+    t = run_records(nr, sql, &nr_selected);
+    ASSERT_GE(t, 0);
+    PRINTF("selecting %.0f of %zu records with SQL: %fs\n",
+            nr_selected, nr, t - base);
+
+    ASSERT_GT(nr_selected, 0);
+    ASSERT_EQ(nr_filtered, nr_selected);
+}
@@ -0,0 +1,195 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc.h"
+#include "purc-document.h"
+
+#include "../helpers.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <time.h>
+
+static std::string
+attr_of(purc_document_t doc, pcdoc_element_t elem, const char *name)
+{
+    const char *val;
+    size_t len;
+    if (elem == NULL ||
+            pcdoc_element_get_attribute(doc, elem, name, &val, &len))
+        return "";
+    return std::string(val, len);
+}
+
+static std::string
+text_of(purc_document_t doc, pcdoc_text_node_t text_node)
+{
+    const char *text;
+    size_t len;
+    if (text_node == NULL ||
+            pcdoc_text_content_get_text(doc, text_node, &text, &len))
+        return "";
+    return std::string(text, len);
+}
+
+TEST(html_children, access)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hybridos.test",
+            "test_html_children", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    /* 40 paragraphs with a text node after each one */
+    const int nr_paras = 40;
+    std::string html = "<html><body>";
+    for (int i = 0; i < nr_paras; i++) {
+        html += "<p id=\"p" + std::to_string(i) + "\">x</p>t"
+            + std::to_string(i);
+    }
+    html += "<!-- end --></body></html>";
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html.c_str(), html.length());
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_element_t body = purc_document_body(doc);
+    ASSERT_NE(body, nullptr);
+
+    size_t nr_elems = 0, nr_texts = 0;
+    ASSERT_EQ(pcdoc_element_children_count(doc, body, &nr_elems, &nr_texts,
+                NULL), 0);
+    ASSERT_EQ(nr_elems, (size_t)nr_paras);
+    ASSERT_EQ(nr_texts, (size_t)nr_paras);
+
+    /* by index: forwards, backwards, then out of range */
+    for (int i = 0; i < nr_paras; i++) {
+        pcdoc_element_t p = pcdoc_element_get_child_element(doc, body, i);
+        ASSERT_EQ(attr_of(doc, p, "id"), "p" + std::to_string(i));
+    }
+    for (int i = nr_paras - 1; i >= 0; i--) {
+        pcdoc_text_node_t t = pcdoc_element_get_child_text_node(doc, body, i);
+        ASSERT_EQ(text_of(doc, t), "t" + std::to_string(i));
+    }
+    ASSERT_EQ(pcdoc_element_get_child_element(doc, body, nr_paras), nullptr);
+    ASSERT_EQ(pcdoc_element_get_child_text_node(doc, body, nr_paras),
+            nullptr);
+    ASSERT_EQ(pcdoc_element_get_child_data_node(doc, body, 0), nullptr);
+
+    /* by cursor */
+    int nr_visited[PCDOC_NODE_VOID] = { };
+    pcdoc_node node = pcdoc_element_first_child(doc, body);
+    while (node.type != PCDOC_NODE_VOID) {
+        nr_visited[node.type]++;
+        if (node.type == PCDOC_NODE_ELEMENT) {
+            ASSERT_EQ(pcdoc_node_get_parent(doc, node), body);
+        }
+        node = pcdoc_node_next_sibling(doc, node);
+    }
+    ASSERT_EQ(nr_visited[PCDOC_NODE_ELEMENT], nr_paras);
+    ASSERT_EQ(nr_visited[PCDOC_NODE_TEXT], nr_paras);
+    ASSERT_EQ(nr_visited[PCDOC_NODE_OTHERS], 1);
+
+    pcdoc_element_t p = pcdoc_element_get_child_element(doc, body, 20);
+    node = pcdoc_element_first_child(doc, p);
+    ASSERT_EQ(node.type, PCDOC_NODE_TEXT);
+    ASSERT_EQ(text_of(doc, node.text_node), "x");
+    node = pcdoc_node_next_sibling(doc, node);
+    ASSERT_EQ(node.type, PCDOC_NODE_VOID);
+
+    /* the indexed children must follow the changes */
+    pcdoc_element_erase(doc, p);
+    p = pcdoc_element_get_child_element(doc, body, 20);
+    ASSERT_EQ(attr_of(doc, p, "id"), "p21");
+
+    pcdoc_element_t new_p = pcdoc_element_new_element(doc, p,
+            PCDOC_OP_INSERTBEFORE, "p", false);
+    pcdoc_element_set_attribute(doc, new_p, PCDOC_OP_DISPLACE, "id",
+            "new", 0);
+    ASSERT_EQ(pcdoc_element_get_child_element(doc, body, 20), new_p);
+    ASSERT_EQ(attr_of(doc, pcdoc_element_get_child_element(doc, body, 21),
+                "id"), "p21");
+
+    pcdoc_element_new_content(doc, body, PCDOC_OP_APPEND,
+            "<p id=\"last\">y</p>", 0);
+    ASSERT_EQ(attr_of(doc, pcdoc_element_get_child_element(doc, body,
+                    nr_paras), "id"), "last");
+
+    pcdoc_element_new_text_content(doc, body, PCDOC_OP_PREPEND, "head", 0);
+    ASSERT_EQ(text_of(doc, pcdoc_element_get_child_text_node(doc, body, 0)),
+            "head");
+    ASSERT_EQ(text_of(doc, pcdoc_element_get_child_text_node(doc, body, 30)),
+            "t29");
+
+    pcdoc_element_clear(doc, body);
+    ASSERT_EQ(pcdoc_element_get_child_element(doc, body, 20), nullptr);
+    ASSERT_EQ(pcdoc_element_first_child(doc, body).type, PCDOC_NODE_VOID);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(html_children, perf)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hybridos.test",
+            "test_html_children", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const size_t nr_children = 100000;
+    std::string html = "<html><body><ul>";
+    for (size_t i = 0; i < nr_children; i++) {
+        html += "<li>x</li>";
+    }
+    html += "</ul></body></html>";
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html.c_str(), html.length());
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_element_t ul = pcdoc_element_get_child_element(doc,
+            purc_document_body(doc), 0);
+    ASSERT_NE(ul, nullptr);
+
+    struct timespec begin;
+    size_t n = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    pcdoc_node node = pcdoc_element_first_child(doc, ul);
+    while (node.type != PCDOC_NODE_VOID) {
+        if (node.type == PCDOC_NODE_ELEMENT)
+            n++;
+        node = pcdoc_node_next_sibling(doc, node);
+    }
+    PRINTF("iterating over %zu children by cursor: %fs\n", n,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(n, nr_children);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (n = 0; ; n++) {
+        if (pcdoc_element_get_child_element(doc, ul, n) == NULL)
+            break;
+    }
+    PRINTF("iterating over %zu children by index: %fs\n", n,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(n, nr_children);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
@@ -0,0 +1,333 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc.h"
+#include "purc-document.h"
+#include "private/document.h"
+
+#include "../helpers.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <time.h>
+
+static const char *sample =
+    "<html><head><title>Selectors</title></head>"
+    "<body>"
+    "<h1 id=\"title\" class=\"big header\">Title</h1>"
+    "<p class=\"intro\" lang=\"en-US\">Intro</p>"
+    "<p lang=\"en\">Second</p>"
+    "<ul id=\"list\">"
+    "<li class=\"item first\" data-x=\"1\">One</li>"
+    "<li class=\"item\" data-x=\"2\">Two</li>"
+    "<li class=\"item\">Three</li>"
+    "<li class=\"item last\"><a href=\"http://example.com/doc.pdf\""
+        " title=\"Foo Bar\">Four</a></li>"
+    "</ul>"
+    "<div class=\"item\"><span>Alone</span></div>"
+    "</body></html>";
+
+static ssize_t
+count(purc_document_t doc, const char *selector)
+{
+    pcdoc_elem_coll_t coll = pcdoc_elem_coll_new_from_document(doc, selector);
+    if (coll == NULL)
+        return -1;
+
+    ssize_t n = pcutils_arrlist_length(coll->elems);
+    pcdoc_elem_coll_delete(doc, coll);
+    return n;
+}
+
+static const char *
+first_text(purc_document_t doc, const char *selector)
+{
+    static char buf[64];
+
+    pcdoc_element_t elem = pcdoc_find_element_in_document(doc, selector);
+    if (elem == NULL)
+        return NULL;
+
+    const char *id;
+    size_t len;
+    id = pcdoc_element_id(doc, elem, &len);
+    snprintf(buf, sizeof(buf), "%.*s", (int)len, id ? id : "");
+    return buf;
+}
+
+TEST(html_selector, select)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hybridos.test",
+            "test_html_selector", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML, sample, 0);
+    ASSERT_NE(doc, nullptr);
+
+    static const struct {
+        const char *selector;
+        ssize_t     count;
+    } cases[] = {
+        { "*", 15 },
+        { "#list", 1 },
+        { "#none", 0 },
+        { ".item", 5 },
+        { "li.item", 4 },
+        { ".item.last", 1 },
+        { ".item.none", 0 },
+        { "ul > li", 4 },
+        { "body > li", 0 },
+        { "body li", 4 },
+        { "html   body  >  ul#list li.first", 1 },
+        { "li:nth-child(odd)", 2 },
+        { "li:nth-child(2n)", 2 },
+        { "li:nth-child(-n+3)", 3 },
+        { "li:nth-child(3)", 1 },
+        { "li:nth-last-child(1)", 1 },
+        { "li:first-child", 1 },
+        { "li:last-child", 1 },
+        { "span:only-child", 1 },
+        { ":root", 1 },
+        { "[data-x]", 2 },
+        { "[data-x=\"2\"]", 1 },
+        { "[lang|=en]", 2 },
+        { "a[href^=http]", 1 },
+        { "a[href$='.pdf']", 1 },
+        { "[title*=\"foo\" i]", 1 },
+        { "[title*=foo]", 0 },
+        { "[class~=header]", 1 },
+        { "h1 + p", 1 },
+        { "h1 ~ p", 2 },
+        { "h1, ul, #list", 2 },
+        { "> body > p", 2 },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        EXPECT_EQ(count(doc, cases[i].selector), cases[i].count)
+            << "selector: " << cases[i].selector;
+    }
+
+    /* the results are in the document order */
+    pcdoc_elem_coll_t coll = pcdoc_elem_coll_new_from_document(doc, "li");
+    ASSERT_NE(coll, nullptr);
+    pcdoc_elem_coll_t filtered = pcdoc_elem_coll_select(doc, coll,
+            "[data-x], :last-child");
+    ASSERT_NE(filtered, nullptr);
+    ASSERT_EQ(pcutils_arrlist_length(filtered->elems), 3);
+    ASSERT_EQ(pcutils_arrlist_get_idx(filtered->elems, 0),
+            pcutils_arrlist_get_idx(coll->elems, 0));
+    ASSERT_EQ(pcutils_arrlist_get_idx(filtered->elems, 2),
+            pcutils_arrlist_get_idx(coll->elems, 3));
+    pcdoc_elem_coll_delete(doc, filtered);
+    pcdoc_elem_coll_delete(doc, coll);
+
+    ASSERT_STREQ(first_text(doc, "body > *"), "title");
+    ASSERT_EQ(first_text(doc, "table"), nullptr);
+
+    /* bad or unsupported selectors */
+    ASSERT_EQ(count(doc, ""), -1);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_INVALID_VALUE);
+    ASSERT_EQ(count(doc, "ul >"), -1);
+    ASSERT_EQ(count(doc, "li:nth-child(x)"), -1);
+    ASSERT_EQ(count(doc, "[data-x"), -1);
+    ASSERT_EQ(count(doc, "a, "), -1);
+    ASSERT_EQ(count(doc, "p:hover"), -1);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NOT_SUPPORTED);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(html_selector, index)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hybridos.test",
+            "test_html_selector", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML, sample, 0);
+    ASSERT_NE(doc, nullptr);
+
+    /* build the index */
+    ASSERT_EQ(count(doc, "#list"), 1);
+    ASSERT_NE(doc->elem_index, nullptr);
+
+    pcdoc_element_t body = purc_document_body(doc);
+    pcdoc_element_t elem;
+
+    /* changing the identifier and the class */
+    elem = pcdoc_find_element_in_document(doc, "#title");
+    ASSERT_NE(elem, nullptr);
+    ASSERT_EQ(pcdoc_element_set_attribute(doc, elem, PCDOC_OP_DISPLACE,
+                "id", "heading", 0), 0);
+    ASSERT_EQ(count(doc, "#title"), 0);
+    ASSERT_EQ(count(doc, "#heading"), 1);
+    ASSERT_EQ(pcdoc_element_set_attribute(doc, elem, PCDOC_OP_DISPLACE,
+                "class", "item  item", 0), 0);
+    ASSERT_EQ(count(doc, ".big"), 0);
+    ASSERT_EQ(count(doc, ".item"), 6);
+    ASSERT_EQ(pcdoc_element_remove_attribute(doc, elem, "class"), 0);
+    ASSERT_EQ(count(doc, ".item"), 5);
+
+    /* new elements and contents */
+    elem = pcdoc_element_new_element(doc, body, PCDOC_OP_PREPEND, "p", false);
+    ASSERT_NE(elem, nullptr);
+    ASSERT_EQ(pcdoc_element_set_attribute(doc, elem, PCDOC_OP_DISPLACE,
+                "class", "item", 0), 0);
+    ASSERT_EQ(first_text(doc, ".item"), std::string(""));
+    ASSERT_EQ(pcdoc_element_set_attribute(doc, elem, PCDOC_OP_DISPLACE,
+                "id", "zero", 0), 0);
+    ASSERT_STREQ(first_text(doc, ".item"), "zero");
+
+    pcdoc_element_new_content(doc, body, PCDOC_OP_APPEND,
+            "<div id=\"more\"><p class=\"item\" id=\"p1\"></p>"
+            "<p class=\"item\" id=\"p2\"></p></div>", 0);
+    ASSERT_EQ(count(doc, ".item"), 8);
+    ASSERT_EQ(count(doc, "#more > .item"), 2);
+
+    /* erasing and clearing */
+    elem = pcdoc_find_element_in_document(doc, "#list");
+    ASSERT_NE(elem, nullptr);
+    pcdoc_element_erase(doc, elem);
+    ASSERT_EQ(count(doc, "#list"), 0);
+    ASSERT_EQ(count(doc, ".item"), 4);
+    ASSERT_EQ(count(doc, ".first"), 0);
+
+    elem = pcdoc_find_element_in_document(doc, "#more");
+    ASSERT_NE(elem, nullptr);
+    pcdoc_element_clear(doc, elem);
+    ASSERT_EQ(count(doc, "#more"), 1);
+    ASSERT_EQ(count(doc, "#p1"), 0);
+    ASSERT_EQ(count(doc, ".item"), 2);
+
+    pcdoc_element_new_text_content(doc, body, PCDOC_OP_DISPLACE, "gone", 0);
+    ASSERT_EQ(count(doc, ".item"), 0);
+    ASSERT_EQ(count(doc, "#more"), 0);
+    ASSERT_EQ(count(doc, "*"), 4);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+struct walk_args {
+    const char *klass;
+    size_t      found;
+};
+
+static int
+match_by_class(purc_document_t doc, pcdoc_element_t element, void *ctxt)
+{
+    struct walk_args *args = (struct walk_args *)ctxt;
+    bool found = false;
+
+    pcdoc_element_has_class(doc, element, args->klass, &found);
+    if (found)
+        args->found++;
+    return 0;
+}
+
+TEST(html_selector, perf)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hybridos.test",
+            "test_html_selector", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    /* 500 sections with 99 paragraphs each: 50000 elements in body */
+    const int nr_sections = 500;
+    const int nr_paras = 99;
+    std::string html = "<html><body>";
+    for (int i = 0; i < nr_sections; i++) {
+        html += "<section id=\"s" + std::to_string(i) + "\" class=\"sec\">";
+        for (int j = 0; j < nr_paras; j++) {
+            html += "<p class=\"para c" + std::to_string(j % 10) + "\">x</p>";
+        }
+        html += "</section>";
+    }
+    html += "</body></html>";
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html.c_str(), html.length());
+    ASSERT_NE(doc, nullptr);
+
+    struct timespec begin;
+    const int nr_queries = 200;
+
+    /* what every query did before: walk the whole document */
+    struct walk_args args = { "c3", 0 };
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int i = 0; i < nr_queries; i++) {
+        pcdoc_travel_descendant_elements(doc, NULL, match_by_class,
+                &args, NULL);
+    }
+    PRINTF("%d walks matching .c3: %fs\n", nr_queries,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(args.found, (size_t)(nr_queries * nr_sections * 10));
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int i = 0; i < nr_queries; i++) {
+        ASSERT_EQ(count(doc, ".c3"), nr_sections * 10);
+    }
+    PRINTF("%d queries of .c3: %fs\n", nr_queries,
+            purc_get_elapsed_seconds(&begin, NULL));
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int i = 0; i < nr_queries * 100; i++) {
+        std::string id = "#s" + std::to_string(i % nr_sections);
+        ASSERT_EQ(count(doc, id.c_str()), 1);
+    }
+    PRINTF("%d queries of #id: %fs\n", nr_queries * 100,
+            purc_get_elapsed_seconds(&begin, NULL));
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int i = 0; i < nr_queries / 10; i++) {
+        ASSERT_EQ(count(doc, "section.sec > p:nth-child(10n+1)"),
+                nr_sections * 10);
+    }
+    PRINTF("%d queries of section.sec > p:nth-child(10n+1): %fs\n",
+            nr_queries / 10, purc_get_elapsed_seconds(&begin, NULL));
+
+    /* the new elements go to their places in the buckets by document order,
+       from the last section to the first one */
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int i = 0; i < nr_sections; i++) {
+        std::string id = "#s" + std::to_string(nr_sections - 1 - i);
+        pcdoc_element_t sec = pcdoc_find_element_in_document(doc, id.c_str());
+        ASSERT_NE(sec, nullptr);
+
+        pcdoc_element_t elem = pcdoc_element_new_element(doc, sec,
+                PCDOC_OP_PREPEND, "p", false);
+        ASSERT_NE(elem, nullptr);
+        id = "f" + std::to_string(i);
+        ASSERT_EQ(pcdoc_element_set_attribute(doc, elem, PCDOC_OP_DISPLACE,
+                    "id", id.c_str(), 0), 0);
+        ASSERT_EQ(pcdoc_element_set_attribute(doc, elem, PCDOC_OP_DISPLACE,
+                    "class", "para fresh", 0), 0);
+
+        ASSERT_EQ(count(doc, ".fresh"), i + 1);
+        ASSERT_EQ(first_text(doc, ".fresh"), id);
+    }
+    PRINTF("%d insertions and queries of .fresh: %fs\n", nr_sections,
+            purc_get_elapsed_seconds(&begin, NULL));
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
@@ -0,0 +1,112 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "purc.h"
+#include "private/msg-queue.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <gtest/gtest.h>
+
+static pcrdr_msg *
+make_event(const char *event, const char *element, const char *data,
+        pcrdr_msg_event_reduce_opt reduce_opt)
+{
+    pcrdr_msg *msg = pcrdr_make_event_message(
+            PCRDR_MSG_TARGET_COROUTINE, 1, event, NULL,
+            PCRDR_MSG_ELEMENT_TYPE_ID, element, NULL,
+            PCRDR_MSG_DATA_TYPE_PLAIN, data, strlen(data));
+    if (msg)
+        msg->reduceOpt = reduce_opt;
+    return msg;
+}
+
+TEST(instance, msg_queue_reduce)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, NULL, NULL, NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    struct pcinst_msg_queue *queue = pcinst_msg_queue_create();
+    ASSERT_NE(queue, nullptr);
+
+    pcinst_msg_queue_append(queue, make_event("change:attached", "a",
+                "first", PCRDR_MSG_EVENT_REDUCE_OPT_KEEP));
+    pcinst_msg_queue_append(queue, make_event("change:attached", "b",
+                "second", PCRDR_MSG_EVENT_REDUCE_OPT_KEEP));
+    pcinst_msg_queue_append(queue, make_event("change:attached", "a",
+                "third", PCRDR_MSG_EVENT_REDUCE_OPT_KEEP));
+
+    /* reduced to the first queued event having the same key */
+    pcinst_msg_queue_append(queue, make_event("change:attached", "a",
+                "ignored", PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE));
+    pcinst_msg_queue_append(queue, make_event("change:attached", "b",
+                "overlaid", PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY));
+
+    /* not matched: a different event name */
+    pcinst_msg_queue_append(queue, make_event("change:detached", "a",
+                "fourth", PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY));
+
+    struct pcinst_msg_queue_stats stats;
+    pcinst_msg_queue_get_stats(queue, &stats);
+    ASSERT_EQ(stats.nr_msgs, 4);
+    ASSERT_EQ(stats.nr_event_keys, 3);
+    ASSERT_EQ(stats.max_msgs, 4);
+    ASSERT_EQ(stats.nr_coalesced, 2);
+
+    const char *expected[] = { "first", "overlaid", "third", "fourth" };
+    for (size_t i = 0; i < PCA_TABLESIZE(expected); i++) {
+        pcrdr_msg *msg = pcinst_msg_queue_get_msg(queue);
+        ASSERT_NE(msg, nullptr);
+        ASSERT_STREQ(purc_variant_get_string_const(msg->data), expected[i]);
+        pcrdr_release_message(msg);
+
+        if (i == 0) {
+            /* the next event having the key takes over */
+            pcinst_msg_queue_append(queue, make_event("change:attached",
+                        "a", "ignored", PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE));
+        }
+    }
+
+    pcinst_msg_queue_get_stats(queue, &stats);
+    ASSERT_EQ(stats.nr_msgs, 0);
+    ASSERT_EQ(stats.nr_event_keys, 0);
+    ASSERT_EQ(stats.nr_coalesced, 3);
+
+    /* a prepended event is the first one having the key */
+    pcinst_msg_queue_append(queue, make_event("change:attached", "a",
+                "fifth", PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY));
+    pcinst_msg_queue_prepend(queue, make_event("change:attached", "a",
+                "sixth", PCRDR_MSG_EVENT_REDUCE_OPT_KEEP));
+    pcinst_msg_queue_append(queue, make_event("change:attached", "a",
+                "seventh", PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY));
+
+    pcrdr_msg *msg = pcinst_msg_queue_get_msg(queue);
+    ASSERT_NE(msg, nullptr);
+    ASSERT_STREQ(purc_variant_get_string_const(msg->data), "seventh");
+    pcrdr_release_message(msg);
+
+    pcinst_msg_queue_get_stats(queue, &stats);
+    ASSERT_EQ(stats.nr_msgs, 1);
+    ASSERT_EQ(stats.nr_event_keys, 1);
+
+    ASSERT_EQ(pcinst_msg_queue_destroy(queue), 1);
+
+    purc_cleanup();
+}
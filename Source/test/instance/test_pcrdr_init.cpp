@@ -23,6 +23,13 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+
 
 TEST(interpreter, purc_init)
 {
@@ -59,3 +66,313 @@ TEST(interpreter, purc_init)
 
 
 
+#define NR_REQUESTS     100
+
+struct reversed_responses {
+    int nr_sent;
+    int nr_handled;
+    int handled[NR_REQUESTS];
+};
+
+/* the extra message source answers the requests in the reversed order */
+static pcrdr_msg *
+reversed_source(pcrdr_conn* conn, void *ctxt)
+{
+    (void)conn;
+    struct reversed_responses *rr = (struct reversed_responses *)ctxt;
+    if (rr->nr_sent == 0)
+        return NULL;
+
+    char request_id[16];
+    sprintf(request_id, "REQ-%d", --rr->nr_sent);
+    return pcrdr_make_response_message(request_id, NULL,
+            PCRDR_SC_OK, rr->nr_sent, PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+}
+
+static int
+reversed_handler(pcrdr_conn* conn, const char *request_id, int state,
+        void *context, const pcrdr_msg *response_msg)
+{
+    (void)conn;
+    struct reversed_responses *rr = (struct reversed_responses *)context;
+    if (state == PCRDR_RESPONSE_RESULT) {
+        int n = atoi(request_id + 4);
+        if ((uint64_t)n == response_msg->resultValue)
+            rr->handled[n]++;
+        rr->nr_handled++;
+    }
+    return 0;
+}
+
+TEST(pcrdr, out_of_order_responses)
+{
+    const purc_instance_extra_info extra_info = {};
+
+    int r = purc_init_ex(PURC_MODULE_PCRDR, "cn.fmsoft.hybridos.test",
+            "out_of_order", &extra_info);
+    ASSERT_EQ(r, 0);
+
+    pcrdr_conn *conn = purc_get_conn_to_renderer();
+    ASSERT_NE(conn, nullptr);
+
+    struct reversed_responses rr = { };
+    for (int i = 0; i < NR_REQUESTS; i++) {
+        char request_id[16];
+        sprintf(request_id, "REQ-%d", i);
+        purc_variant_t v = purc_variant_make_string(request_id, false);
+        r = pcrdr_set_handler_for_response_from_extra_source(conn, v,
+                i % 7 + 1, &rr, reversed_handler);
+        purc_variant_unref(v);
+        ASSERT_EQ(r, 0);
+    }
+    ASSERT_EQ(pcrdr_conn_pending_requests_count(conn), NR_REQUESTS);
+
+    rr.nr_sent = NR_REQUESTS;
+    pcrdr_conn_set_extra_message_source(conn, reversed_source, &rr, NULL);
+    while (rr.nr_sent > 0) {
+        pcrdr_wait_and_dispatch_message(conn, 0);
+    }
+    pcrdr_conn_set_extra_message_source(conn, NULL, NULL, NULL);
+
+    ASSERT_EQ(rr.nr_handled, NR_REQUESTS);
+    for (int i = 0; i < NR_REQUESTS; i++) {
+        ASSERT_EQ(rr.handled[i], 1);
+    }
+    ASSERT_EQ(pcrdr_conn_pending_requests_count(conn), 0);
+
+    purc_cleanup();
+}
+
+#define NR_MESSAGES     10000
+
+/* a renderer speaking PURCMC over a Unix socket, which answers the
+   messages from the client with a burst of events */
+struct mock_renderer {
+    int listen_fd;
+    std::string initial;        // the initial response
+    std::string events;         // the frames of the events in the burst
+    size_t nr_received;
+    size_t max_received;        // the length of the largest message
+    bool bad_frame;
+};
+
+static bool
+read_all(int fd, void *buf, size_t sz)
+{
+    char *p = (char *)buf;
+    while (sz > 0) {
+        ssize_t n = read(fd, p, sz);
+        if (n <= 0)
+            return false;
+        p += n;
+        sz -= n;
+    }
+    return true;
+}
+
+static bool
+write_all(int fd, const void *buf, size_t sz)
+{
+    const char *p = (const char *)buf;
+    while (sz > 0) {
+        ssize_t n = write(fd, p, sz);
+        if (n <= 0)
+            return false;
+        p += n;
+        sz -= n;
+    }
+    return true;
+}
+
+static std::string
+make_frame(const std::string &text)
+{
+    USFrameHeader header;
+    header.op = US_OPCODE_TEXT;
+    header.fragmented = 0;
+    header.sz_payload = text.length();
+    return std::string((const char *)&header, sizeof(header)) + text;
+}
+
+static void *
+mock_renderer_main(void *arg)
+{
+    struct mock_renderer *rdr = (struct mock_renderer *)arg;
+
+    int fd = accept(rdr->listen_fd, NULL, NULL);
+    if (fd < 0)
+        return NULL;
+
+    std::string frame = make_frame(rdr->initial);
+    write_all(fd, frame.c_str(), frame.length());
+
+    std::string payload;
+    size_t total = 0;
+    USFrameHeader header;
+    while (read_all(fd, &header, sizeof(header))) {
+        if (header.op == US_OPCODE_CLOSE)
+            break;
+
+        if (header.op == US_OPCODE_TEXT) {
+            if (!payload.empty())
+                rdr->bad_frame = true;
+            total = header.fragmented ? header.fragmented : header.sz_payload;
+        }
+        else if (header.op != US_OPCODE_CONTINUATION &&
+                header.op != US_OPCODE_END) {
+            rdr->bad_frame = true;
+            break;
+        }
+
+        size_t offset = payload.length();
+        payload.resize(offset + header.sz_payload);
+        if (!read_all(fd, &payload[offset], header.sz_payload))
+            break;
+
+        if (payload.length() < total)
+            continue;
+        if (payload.length() > total || header.op == US_OPCODE_CONTINUATION)
+            rdr->bad_frame = true;
+
+        if (payload.length() > rdr->max_received)
+            rdr->max_received = payload.length();
+        payload.clear();
+
+        if (++rdr->nr_received == NR_MESSAGES) {
+            write_all(fd, rdr->events.c_str(), rdr->events.length());
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+static std::string
+serialize_message(pcrdr_msg *msg)
+{
+    char buf[4096];
+    size_t n = pcrdr_serialize_message_to_buffer(msg, buf, sizeof(buf));
+    pcrdr_release_message(msg);
+    return std::string(buf, n < sizeof(buf) ? n : 0);
+}
+
+static void
+count_event(pcrdr_conn* conn, const pcrdr_msg *msg)
+{
+    size_t *nr_events = (size_t *)pcrdr_conn_get_user_data(conn);
+    if (strcmp(purc_variant_get_string_const(msg->eventName), "change") == 0)
+        (*nr_events)++;
+}
+
+static double
+send_messages(pcrdr_conn *conn, pcrdr_msg *msg, size_t nr)
+{
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t i = 0; i < nr; i++) {
+        if (pcrdr_send_request(conn, msg, PCRDR_DEF_TIME_EXPECTED,
+                    NULL, NULL))
+            return -1;
+    }
+    return purc_get_elapsed_seconds(&begin, NULL);
+}
+
+TEST(pcrdr, purcmc_throughput)
+{
+    const purc_instance_extra_info extra_info = {};
+
+    int r = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "purcmc", &extra_info);
+    ASSERT_EQ(r, 0);
+
+    struct mock_renderer rdr = { };
+    rdr.initial = serialize_message(pcrdr_make_response_message("0", NULL,
+            PCRDR_SC_OK, 0, PCRDR_MSG_DATA_TYPE_PLAIN, "mock", 4));
+    std::string event = make_frame(serialize_message(
+                pcrdr_make_event_message(PCRDR_MSG_TARGET_DOM, 1, "change",
+                    NULL, PCRDR_MSG_ELEMENT_TYPE_HANDLE, "80", NULL,
+                    PCRDR_MSG_DATA_TYPE_PLAIN, "checked", 7)));
+    for (size_t i = 0; i < NR_MESSAGES; i++) {
+        rdr.events += event;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/purcmc-test-%d.sock", getpid());
+    unlink(path);
+
+    struct sockaddr_un addr = { };
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    rdr.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(rdr.listen_fd, 0);
+    ASSERT_EQ(bind(rdr.listen_fd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(rdr.listen_fd, 1), 0);
+
+    pthread_t th;
+    ASSERT_EQ(pthread_create(&th, NULL, mock_renderer_main, &rdr), 0);
+
+    std::string uri = std::string("unix://") + path;
+    pcrdr_conn *conn;
+    pcrdr_msg *msg = pcrdr_purcmc_connect(uri.c_str(),
+            "cn.fmsoft.hybridos.test", "purcmc", &conn);
+    ASSERT_NE(msg, nullptr);
+    pcrdr_release_message(msg);
+
+    // a message of several frames
+    std::string large(PCRDR_MAX_FRAME_PAYLOAD_SIZE * 5, 'x');
+    msg = pcrdr_make_request_message(PCRDR_MSG_TARGET_DOM, 1,
+            PCRDR_OPERATION_UPDATE, PCRDR_REQUESTID_NORETURN, NULL,
+            PCRDR_MSG_ELEMENT_TYPE_HANDLE, "80", "textContent",
+            PCRDR_MSG_DATA_TYPE_PLAIN, large.c_str(), large.length());
+    ASSERT_GE(send_messages(conn, msg, 1), 0);
+    pcrdr_release_message(msg);
+
+    // the small messages like the DOM updates
+    pcrdr_msg *req = pcrdr_make_request_message(PCRDR_MSG_TARGET_DOM, 1,
+            PCRDR_OPERATION_UPDATE, PCRDR_REQUESTID_NORETURN, NULL,
+            PCRDR_MSG_ELEMENT_TYPE_HANDLE, "80", "textContent",
+            PCRDR_MSG_DATA_TYPE_PLAIN, "hello", 5);
+
+    size_t nr_events = 0;
+    pcrdr_conn_set_user_data(conn, &nr_events);
+    pcrdr_conn_set_event_handler(conn, count_event);
+
+    double t = send_messages(conn, req, NR_MESSAGES - 1);
+    ASSERT_GE(t, 0);
+    PRINTF("sending %d messages via PURCMC: %.0f msgs/s\n", NR_MESSAGES - 1,
+            (NR_MESSAGES - 1) / t);
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    while (nr_events < NR_MESSAGES) {
+        ASSERT_EQ(pcrdr_wait_and_dispatch_message(conn, 1000), 0);
+    }
+    t = purc_get_elapsed_seconds(&begin, NULL);
+    PRINTF("receiving %d events via PURCMC: %.0f msgs/s\n", NR_MESSAGES,
+            NR_MESSAGES / t);
+    ASSERT_FALSE(pcrdr_conn_has_buffered_input(conn));
+
+    pcrdr_disconnect(conn);
+    pthread_join(th, NULL);
+    close(rdr.listen_fd);
+    unlink(path);
+
+    ASSERT_FALSE(rdr.bad_frame);
+    ASSERT_GT(rdr.max_received, large.length());
+    ASSERT_GE(rdr.nr_received, (size_t)NR_MESSAGES);
+
+    // the same messages to the headless renderer
+    msg = pcrdr_headless_connect("file:///dev/null",
+            "cn.fmsoft.hybridos.test", "purcmc", &conn);
+    ASSERT_NE(msg, nullptr);
+    pcrdr_release_message(msg);
+
+    t = send_messages(conn, req, NR_MESSAGES - 1);
+    ASSERT_GE(t, 0);
+    PRINTF("sending %d messages via HEADLESS: %.0f msgs/s\n",
+            NR_MESSAGES - 1, (NR_MESSAGES - 1) / t);
+    pcrdr_disconnect(conn);
+
+    pcrdr_release_message(req);
+    purc_cleanup();
+}
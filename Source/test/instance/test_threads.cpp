@@ -19,12 +19,14 @@
 
 
 #include "purc.h"
+#include "../helpers.h"
 
 #include <stdio.h>
 #include <errno.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include <time.h>
 #include <fcntl.h>           /* For O_* constants */
 #include <gtest/gtest.h>
 #include <wtf/Compiler.h>
@@ -288,3 +290,144 @@ TEST(instance, threads)
     purc_cleanup();
 }
 
+
+#define NR_ECHO_MSGS        16
+#define NR_PAYLOAD_ITEMS    500
+
+static volatile purc_atom_t echo_inst;
+
+static void* echo_thread_entry(void* arg)
+{
+    (void)arg;
+
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.purc.test",
+            "echo", NULL);
+    assert(ret == PURC_ERROR_OK);
+    (void)ret;
+
+    purc_atom_t atom = purc_inst_create_move_buffer(0, NR_ECHO_MSGS);
+    echo_inst = atom;
+
+    bool quit = false;
+    while (!quit) {
+        size_t n;
+        if (purc_inst_holding_messages_count(&n) || n == 0) {
+            usleep(100);
+            continue;
+        }
+
+        pcrdr_msg *msg = purc_inst_take_away_message(0);
+        const char *name = purc_variant_get_string_const(msg->eventName);
+        if (strcmp(name, "quit") == 0) {
+            quit = true;
+        }
+        else {
+            // send the data back
+            pcrdr_msg *echo = pcrdr_make_event_message(
+                    PCRDR_MSG_TARGET_INSTANCE, 1,
+                    "echo", NULL,
+                    PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+                    PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+            echo->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+            echo->data = purc_variant_ref(msg->data);
+            purc_inst_move_message(main_inst, echo);
+            pcrdr_release_message(echo);
+        }
+        pcrdr_release_message(msg);
+    }
+
+    purc_inst_destroy_move_buffer();
+    purc_cleanup();
+    return NULL;
+}
+
+static double echo_payload(purc_variant_t payload, bool *shared)
+{
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    for (int i = 0; i < NR_ECHO_MSGS; i++) {
+        pcrdr_msg *msg = pcrdr_make_event_message(
+                PCRDR_MSG_TARGET_INSTANCE, 1,
+                "test", NULL,
+                PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+                PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+        msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+        msg->data = purc_variant_ref(payload);
+        purc_inst_move_message(echo_inst, msg);
+        pcrdr_release_message(msg);
+    }
+
+    *shared = true;
+    int nr_got = 0;
+    while (nr_got < NR_ECHO_MSGS) {
+        size_t n;
+        if (purc_inst_holding_messages_count(&n) || n == 0) {
+            usleep(100);
+            continue;
+        }
+
+        pcrdr_msg *msg = purc_inst_take_away_message(0);
+        if (msg->data != payload)
+            *shared = false;
+        pcrdr_release_message(msg);
+        nr_got++;
+    }
+
+    return purc_get_elapsed_seconds(&begin, NULL);
+}
+
+TEST(instance, frozen_throughput)
+{
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.purc.test",
+            "threads", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    main_inst = purc_inst_create_move_buffer(0, NR_ECHO_MSGS);
+    ASSERT_NE(main_inst, 0);
+
+    pthread_t th;
+    echo_inst = 0;
+    ASSERT_EQ(pthread_create(&th, NULL, echo_thread_entry, NULL), 0);
+    while (echo_inst == 0)
+        usleep(1000);
+
+    purc_variant_t payload = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    for (int i = 0; i < NR_PAYLOAD_ITEMS; i++) {
+        char buf[64];
+        snprintf(buf, sizeof(buf),
+                "{ id: %d, name: 'item %d', tags: ['a', 'b', null] }", i, i);
+        purc_variant_t item = purc_variant_make_from_json_string(buf,
+                strlen(buf));
+        ASSERT_NE(item, PURC_VARIANT_INVALID);
+        purc_variant_array_append(payload, item);
+        purc_variant_unref(item);
+    }
+
+    // every hop clones the payload referred by the sender
+    bool shared;
+    double t_copied = echo_payload(payload, &shared);
+    ASSERT_FALSE(shared);
+
+    // the frozen payload is shared without copying
+    ASSERT_TRUE(purc_variant_freeze(payload));
+    double t_frozen = echo_payload(payload, &shared);
+    ASSERT_TRUE(shared);
+    ASSERT_EQ(purc_variant_ref_count(payload), 1);
+
+    PRINTF("echo %d messages of %d items: copied %fs, frozen %fs\n",
+            NR_ECHO_MSGS, NR_PAYLOAD_ITEMS, t_copied, t_frozen);
+
+    pcrdr_msg *msg = pcrdr_make_event_message(
+            PCRDR_MSG_TARGET_INSTANCE, 1,
+            "quit", NULL,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+    purc_inst_move_message(echo_inst, msg);
+    pcrdr_release_message(msg);
+    pthread_join(th, NULL);
+
+    purc_variant_unref(payload);
+    purc_inst_destroy_move_buffer();
+    purc_cleanup();
+}
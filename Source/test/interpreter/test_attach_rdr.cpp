@@ -21,6 +21,7 @@
 #include "purc.h"
 #include "private/utils.h"
 #include "private/debug.h"
+#include "private/pcrdr.h"
 #include "../helpers.h"
 
 #include <gtest/gtest.h>
@@ -639,3 +640,109 @@ TEST(interpreter, basic)
     purc_run(NULL);
 }
 
+
+static const char *list_items =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"html\">"
+    "    <body>"
+    "        <ul id=\"list\"></ul>"
+    "        <update on=\"$TIMERS\" to=\"displace\">"
+    "            [ { \"id\" : \"go\", \"interval\" : 10, \"active\" : \"yes\" } ]"
+    "        </update>"
+    "        <observe on=\"$TIMERS\" for=\"expired:go\">"
+    "            <iterate on 0L onlyif $L.lt($0<, 500L)"
+    "                    with $EJSON.arith('+', $0<, 1) nosetotail>"
+    "                <update on=\"#list\" to=\"append\" with=\"<li>$?</li>\" />"
+    "            </iterate>"
+    "            <exit with \"done\" />"
+    "        </observe>"
+    "    </body>"
+    "</hvml>";
+
+/* the most DOM requests seen waiting for their responses */
+static size_t max_pending_requests;
+
+static int
+sample_pending_requests(purc_cond_t event, void *arg, void *data)
+{
+    UNUSED_PARAM(arg);
+    UNUSED_PARAM(data);
+
+    if (event == PURC_COND_COR_ONE_RUN || event == PURC_COND_COR_EXITED) {
+        pcrdr_conn *conn = purc_get_conn_to_renderer();
+        if (conn) {
+            size_t nr = pcrdr_conn_pending_requests_count(conn);
+            if (nr > max_pending_requests)
+                max_pending_requests = nr;
+        }
+    }
+
+    return 0;
+}
+
+static double
+run_list_items(size_t *nr_pending)
+{
+    unsigned int modules = (PURC_MODULE_HVML | PURC_MODULE_PCRDR) & ~PURC_HAVE_FETCHER;
+
+    struct purc_instance_extra_info info = { };
+    info.renderer_prot = PURC_RDRPROT_HEADLESS;
+    info.workspace_name = "main";
+
+    PurCInstance purc(modules, "cn.fmsoft.hybridos.test", "test_dom_pipeline",
+            &info);
+    if (!purc)
+        return -1;
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(list_items);
+    if (vdom == NULL)
+        return -1;
+
+    purc_renderer_extra_info extra_info = {};
+    extra_info.title = "def_page_title";
+    purc_coroutine_t co = purc_schedule_vdom(vdom,
+            0, PURC_VARIANT_INVALID, PCRDR_PAGE_TYPE_PLAINWIN,
+            "main",         /* target_workspace */
+            NULL,           /* target_group */
+            "def_page",     /* page_name */
+            &extra_info, NULL, NULL);
+    if (co == NULL)
+        return -1;
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    max_pending_requests = 0;
+    purc_run(sample_pending_requests);
+    *nr_pending = max_pending_requests;
+    return purc_get_elapsed_seconds(&begin, NULL);
+}
+
+TEST(interpreter, perf_dom_pipeline)
+{
+    /* every response of the headless renderer is delayed for 1ms */
+    setenv(PURC_ENVV_HEADLESS_LATENCY, "1", 1);
+
+    size_t sync_pending, pipelined_pending;
+
+    setenv(PURC_ENVV_RDR_PIPELINE, "false", 1);
+    double sync_elapsed = run_list_items(&sync_pending);
+    ASSERT_GT(sync_elapsed, 0);
+
+    setenv(PURC_ENVV_RDR_PIPELINE, "true", 1);
+    double pipelined_elapsed = run_list_items(&pipelined_pending);
+    ASSERT_GT(pipelined_elapsed, 0);
+
+    unsetenv(PURC_ENVV_RDR_PIPELINE);
+    unsetenv(PURC_ENVV_HEADLESS_LATENCY);
+
+    PRINTF("DOM requests: %.3fs synchronously, %.3fs pipelined; "
+            "at most %zu and %zu requests outstanding\n",
+            sync_elapsed, pipelined_elapsed, sync_pending, pipelined_pending);
+
+    /* a synchronous request is done before the next one is sent,
+       whereas the pipelined ones are outstanding when the run ends;
+       this does not depend on the latency: the responses are only
+       read in between the steps of the coroutine */
+    ASSERT_EQ(sync_pending, 0);
+    ASSERT_GT(pipelined_pending, 1);
+}
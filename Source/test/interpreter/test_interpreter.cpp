@@ -23,6 +23,7 @@
 #include "../helpers.h"
 
 #include <gtest/gtest.h>
+#include <time.h>
 
 
 static const char *calculator_1 =
@@ -895,3 +896,220 @@ TEST(interpreter, basic)
     purc_run(NULL);
 }
 
+
+static double
+run_sort_records(size_t nr, const char *sort)
+{
+    std::string hvml = "<hvml><head><init as=\"recs\">[";
+    char buf[128];
+    srandom(1);
+    for (size_t i = 0; i < nr; i++) {
+        snprintf(buf, sizeof(buf), "%s{\"id\":%ld,\"name\":\"Name%05ld\"}",
+                i ? "," : "", random() % 1000, random() % 100000);
+        hvml += buf;
+    }
+    hvml += "]</init></head><body>";
+    hvml += sort;
+    hvml += "</body></hvml>";
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml.c_str());
+    if (vdom == NULL)
+        return -1;
+    purc_schedule_vdom_null(vdom);
+    purc_run(NULL);
+    return purc_get_elapsed_seconds(&begin, NULL);
+}
+
+TEST(interpreter, sort_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "interpreter", false);
+    ASSERT_TRUE(purc);
+
+    const size_t nr = 20000;
+    double base = run_sort_records(nr, "");
+    ASSERT_GE(base, 0);
+
+    const char *sorts[] = {
+        "<sort on=\"$recs\" against=\"id\" />",
+        "<sort on=\"$recs\" against=\"name id\" />",
+        "<sort on=\"$recs\" against=\"name\" caseless descendingly />",
+    };
+    for (size_t i = 0; i < PCA_TABLESIZE(sorts); i++) {
+        double t = run_sort_records(nr, sorts[i]);
+        ASSERT_GE(t, 0);
+        PRINTF("%s on %zu records: %fs\n", sorts[i], nr, t - base);
+    }
+}
+
+static purc_variant_t sorted_result;
+
+static int
+sorted_handler(purc_cond_t event, void *arg, void *data)
+{
+    (void)arg;
+
+    if (event == PURC_COND_COR_EXITED) {
+        struct purc_cor_exit_info *info = (struct purc_cor_exit_info *)data;
+        if (info->result)
+            sorted_result = purc_variant_ref(info->result);
+    }
+
+    return 0;
+}
+
+/* runs the opening tag of <sort> on the records and returns its result
+   in the sorted order: the ids of the objects or the stringified scalars */
+static std::string
+sort_records(const char *init, const char *sort)
+{
+    std::string hvml = "<hvml target=\"void\"><body>";
+    hvml += init;
+    hvml += sort;
+    hvml += "<exit with $? /></sort></body></hvml>";
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml.c_str());
+    if (vdom == NULL)
+        return "<bad hvml>";
+
+    sorted_result = PURC_VARIANT_INVALID;
+    purc_schedule_vdom_null(vdom);
+    purc_run(sorted_handler);
+    if (sorted_result == PURC_VARIANT_INVALID)
+        return "<no result>";
+
+    std::string ids;
+    size_t nr = purc_variant_linear_container_get_size(sorted_result);
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t v;
+        v = purc_variant_linear_container_get(sorted_result, i);
+        if (purc_variant_is_object(v))
+            v = purc_variant_object_get_by_ckey(v, "id");
+
+        char *buf = NULL;
+        if (v && purc_variant_stringify_alloc(&buf, v) >= 0) {
+            if (i)
+                ids += " ";
+            ids += buf;
+            free(buf);
+        }
+    }
+
+    purc_variant_unref(sorted_result);
+    sorted_result = PURC_VARIANT_INVALID;
+    return ids;
+}
+
+TEST(interpreter, sort_order)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "interpreter", false);
+    ASSERT_TRUE(purc);
+
+    static const char *numbers =
+        "<init as=\"recs\">[3, 10, 2, 1]</init>";
+    static const char *strings =
+        "<init as=\"recs\">[\"3\", \"10\", \"2\", \"1\"]</init>";
+    static const char *records =
+        "<init as=\"recs\">["
+        "{\"id\":1, \"grp\":2, \"name\":\"b\"},"
+        "{\"id\":2, \"grp\":1, \"name\":\"A\"},"
+        "{\"id\":3, \"grp\":2, \"name\":\"B\"},"
+        "{\"id\":4, \"grp\":1, \"name\":\"a\"},"
+        "{\"id\":5, \"grp\":10, \"name\":\"c\"}"
+        "]</init>";
+    static const char *set =
+        "<init as=\"recs\" uniquely against=\"id\">["
+        "{\"id\":1, \"grp\":2, \"name\":\"b\"},"
+        "{\"id\":2, \"grp\":1, \"name\":\"A\"},"
+        "{\"id\":3, \"grp\":2, \"name\":\"B\"},"
+        "{\"id\":4, \"grp\":1, \"name\":\"a\"},"
+        "{\"id\":5, \"grp\":10, \"name\":\"c\"}"
+        "]</init>";
+
+    static const struct {
+        const char *init;
+        const char *sort;
+        const char *expected;
+    } cases[] = {
+        /* numbers are compared as numbers, strings as strings */
+        { numbers, "<sort on=\"$recs\">", "1 2 3 10" },
+        { numbers, "<sort on=\"$recs\" descendingly>", "10 3 2 1" },
+        { strings, "<sort on=\"$recs\">", "1 10 2 3" },
+        { strings, "<sort on=\"$recs\" desc>", "3 2 10 1" },
+        { records, "<sort on=\"$recs\" against=\"grp\">", "2 4 1 3 5" },
+
+        /* the members with equal keys keep their order in both orders */
+        { records, "<sort on=\"$recs\" against=\"grp\" desc>",
+            "5 1 3 2 4" },
+        { records, "<sort on=\"$recs\" against=\"name\">", "2 3 4 1 5" },
+        { records, "<sort on=\"$recs\" against=\"name\" caseless>",
+            "2 4 1 3 5" },
+        { records, "<sort on=\"$recs\" against=\"name\" caseless desc>",
+            "5 1 3 2 4" },
+
+        /* the later keys order the members with equal earlier keys */
+        { records, "<sort on=\"$recs\" against=\"grp name\">",
+            "2 4 3 1 5" },
+        { records, "<sort on=\"$recs\" against=\"grp name\" caseless>",
+            "2 4 1 3 5" },
+        { records, "<sort on=\"$recs\" against=\"grp name\" desc>",
+            "5 1 3 4 2" },
+
+        /* the members chosen by the executor are sorted */
+        { records,
+            "<sort on=\"$recs\" by=\"RANGE: FROM 1\" against=\"grp name\">",
+            "2 4 3 5" },
+        { set, "<sort on=\"$recs\" by=\"RANGE: FROM 1\" against=\"grp\" desc>",
+            "5 3 2 4" },
+
+        { set, "<sort on=\"$recs\" against=\"name\">", "2 3 4 1 5" },
+        { set, "<sort on=\"$recs\" against=\"grp name\" caseless desc>",
+            "5 1 3 2 4" },
+        { set, "<sort on=\"$recs\" against=\"grp\" desc>", "5 1 3 2 4" },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        std::string ids = sort_records(cases[i].init, cases[i].sort);
+        ASSERT_EQ(ids, cases[i].expected) << cases[i].sort;
+    }
+}
+
+TEST(interpreter, sort_stable)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "interpreter", false);
+    ASSERT_TRUE(purc);
+
+    /* enough records to be merged in many passes */
+    const size_t nr = 1000;
+    const size_t nr_grps = 7;
+    std::string init = "<init as=\"recs\">[";
+    char buf[128];
+    for (size_t i = 0; i < nr; i++) {
+        snprintf(buf, sizeof(buf), "%s{\"id\":%zu,\"grp\":%zu}",
+                i ? "," : "", i, (i * 13) % nr_grps);
+        init += buf;
+    }
+    init += "]</init>";
+
+    const char *sorts[] = {
+        "<sort on=\"$recs\" against=\"grp\">",
+        "<sort on=\"$recs\" against=\"grp\" desc>",
+    };
+    for (size_t i = 0; i < PCA_TABLESIZE(sorts); i++) {
+        std::string expected;
+        for (size_t j = 0; j < nr_grps; j++) {
+            size_t grp = i ? nr_grps - 1 - j : j;
+            for (size_t id = 0; id < nr; id++) {
+                if ((id * 13) % nr_grps != grp)
+                    continue;
+                if (!expected.empty())
+                    expected += " ";
+                expected += std::to_string(id);
+            }
+        }
+
+        std::string ids = sort_records(init.c_str(), sorts[i]);
+        ASSERT_EQ(ids, expected) << sorts[i];
+    }
+}
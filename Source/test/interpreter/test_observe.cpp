@@ -21,6 +21,9 @@
 #include "purc.h"
 
 #include "private/vdom.h"
+#include "private/utils.h"
+#include "../helpers.h"
+
 #include <gtest/gtest.h>
 
 TEST(observe, basic)
@@ -93,3 +96,55 @@ TEST(observe, basic)
     ASSERT_EQ (cleanup, true);
 }
 
+
+TEST(observe, perf_event_latency)
+{
+    /* every expiry of the timer re-arms it from its observer, so the time
+       spent beyond the interval is the latency of the event path */
+    const char *hvml =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <init as=\"rounds\" with=[] />"
+    "    <update on=\"$TIMERS\" to=\"displace\">"
+    "        [ { \"id\" : \"tick\", \"interval\" : 1, \"active\" : \"yes\" } ]"
+    "    </update>"
+    "    <observe on=\"$TIMERS\" for=\"expired:tick\">"
+    "        <update on=\"$rounds\" to=\"append\" with=1 />"
+    "        <test with=\"$L.lt($EJSON.count($rounds), 200)\">"
+    "            <update on=\"$TIMERS\" to=\"overwrite\">"
+    "                { \"id\" : \"tick\", \"active\" : \"yes\" }"
+    "            </update>"
+    "            <differ>"
+    "                <update on=\"$TIMERS\" to=\"overwrite\">"
+    "                    { \"id\" : \"tick\", \"active\" : \"no\" }"
+    "                </update>"
+    "                <forget on=\"$TIMERS\" for=\"expired:tick\"/>"
+    "            </differ>"
+    "        </test>"
+    "    </observe>"
+    "</hvml>";
+
+    const int nr_rounds = 200;
+    const double interval = 0.001;
+
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "test_perf_event_latency", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml);
+    ASSERT_NE(vdom, nullptr);
+    purc_schedule_vdom_null(vdom);
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    purc_run(NULL);
+    double elapsed = purc_get_elapsed_seconds(&begin, NULL);
+
+    PRINTF("%d timer events observed in %.3fs: %.3fms latency per event\n",
+            nr_rounds, elapsed,
+            (elapsed / nr_rounds - interval) * 1000);
+
+    bool cleanup = purc_cleanup();
+    ASSERT_EQ(cleanup, true);
+}
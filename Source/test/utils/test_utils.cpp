@@ -34,6 +34,8 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <pthread.h>
+#include <time.h>
 #include <gtest/gtest.h>
 
 #define ATOM_BUCKET     1
@@ -353,6 +355,93 @@ TEST(utils, atom_buckets)
     purc_cleanup ();
 }
 
+#define NR_ATOM_THREADS         4
+#define NR_SHARED_ATOMS         256
+#define NR_ATOM_LOOKUP_LOOPS    2000
+
+struct atom_thread_arg {
+    int             id;
+    purc_atom_t    *shared;
+    int             errors;
+};
+
+static void *atom_thread_entry(void *data)
+{
+    struct atom_thread_arg *arg = (struct atom_thread_arg *)data;
+    char buf[64];
+
+    for (int n = 0; n < NR_ATOM_LOOKUP_LOOPS; n++) {
+        for (int i = 0; i < NR_SHARED_ATOMS; i++) {
+            snprintf(buf, sizeof(buf), "shared-atom-%d", i);
+            if (purc_atom_try_string_ex(ATOM_BUCKET, buf) != arg->shared[i])
+                arg->errors++;
+
+            const char *str = purc_atom_to_string(arg->shared[i]);
+            if (str == NULL || strcmp(str, buf))
+                arg->errors++;
+        }
+
+        /* create and remove private atoms while the others are reading */
+        snprintf(buf, sizeof(buf), "private-atom-%d-%d", arg->id, n);
+        purc_atom_t atom = purc_atom_from_string_ex(ATOM_BUCKET, buf);
+        if (atom == 0 || purc_atom_try_string_ex(ATOM_BUCKET, buf) != atom)
+            arg->errors++;
+        if ((n & 1) && !purc_atom_remove_string_ex(ATOM_BUCKET, buf))
+            arg->errors++;
+    }
+
+    return NULL;
+}
+
+// to test concurrent lookup of atoms and the throughput of the readers
+TEST(utils, atom_concurrent)
+{
+    int ret = purc_init_ex(PURC_MODULE_UTILS, "cn.fmsoft.hybridos.test",
+            "utils", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    purc_atom_t shared[NR_SHARED_ATOMS];
+    char buf[64];
+    for (int i = 0; i < NR_SHARED_ATOMS; i++) {
+        snprintf(buf, sizeof(buf), "shared-atom-%d", i);
+        shared[i] = purc_atom_from_string_ex(ATOM_BUCKET, buf);
+        ASSERT_NE(shared[i], 0);
+    }
+
+    pthread_t threads[NR_ATOM_THREADS];
+    struct atom_thread_arg args[NR_ATOM_THREADS];
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    for (int i = 0; i < NR_ATOM_THREADS; i++) {
+        args[i].id = i;
+        args[i].shared = shared;
+        args[i].errors = 0;
+        ASSERT_EQ(pthread_create(threads + i, NULL,
+                    atom_thread_entry, args + i), 0);
+    }
+
+    for (int i = 0; i < NR_ATOM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        ASSERT_EQ(args[i].errors, 0);
+    }
+
+    double elapsed = purc_get_elapsed_seconds(&begin, NULL);
+    PRINTF("%d threads looked up %d atoms %d times each: %.3fs\n",
+            NR_ATOM_THREADS, NR_SHARED_ATOMS * 2, NR_ATOM_LOOKUP_LOOPS,
+            elapsed);
+
+    for (int i = 0; i < NR_ATOM_THREADS; i++) {
+        snprintf(buf, sizeof(buf), "private-atom-%d-%d", i, 0);
+        ASSERT_NE(purc_atom_try_string_ex(ATOM_BUCKET, buf), 0);
+        snprintf(buf, sizeof(buf), "private-atom-%d-%d", i, 1);
+        ASSERT_EQ(purc_atom_try_string_ex(ATOM_BUCKET, buf), 0);
+    }
+
+    purc_cleanup ();
+}
+
 // to test sorted array
 static int sortv[10] = { 1, 8, 7, 5, 4, 6, 9, 0, 2, 3 };
 
@@ -1308,6 +1397,148 @@ TEST(utils, snprintf)
 #undef FMT
 }
 
+// a plain byte-by-byte validator as the reference (RFC 3629)
+static bool
+ref_check_utf8(const char *str, size_t len, size_t *nr_chars,
+        const char **end)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    size_t i = 0, n = 0;
+
+    while (i < len && s[i]) {
+        unsigned char c = s[i];
+        size_t need;
+        unsigned char lo = 0x80, hi = 0xbf;
+
+        if (c < 0x80)
+            need = 0;
+        else if (c >= 0xc2 && c <= 0xdf)
+            need = 1;
+        else if (c >= 0xe0 && c <= 0xef) {
+            need = 2;
+            if (c == 0xe0) lo = 0xa0;
+            if (c == 0xed) hi = 0x9f;
+        }
+        else if (c >= 0xf0 && c <= 0xf4) {
+            need = 3;
+            if (c == 0xf0) lo = 0x90;
+            if (c == 0xf4) hi = 0x8f;
+        }
+        else
+            break;
+
+        if (len - i <= need)
+            break;
+
+        size_t j;
+        for (j = 1; j <= need; j++) {
+            unsigned char min = (j == 1) ? lo : 0x80;
+            unsigned char max = (j == 1) ? hi : 0xbf;
+            if (s[i + j] < min || s[i + j] > max)
+                break;
+        }
+        if (j <= need)
+            break;
+
+        i += need + 1;
+        n++;
+    }
+
+    *nr_chars = n;
+    *end = str + i;
+    return i == len;
+}
+
+static void
+append_random_utf8(std::string &str, size_t nr, int mode)
+{
+    static const char *chars[] = {
+        "a", "Z", "0", " ", "\xc3\xa9", "\xd0\x96", "\xe4\xb8\xad",
+        "\xe6\x96\x87", "\xef\xbf\xbd", "\xf0\x9f\x98\x80", "\xf4\x8f\xbf\xbf",
+    };
+
+    for (size_t i = 0; i < nr; i++) {
+        switch (mode) {
+        case 0:     // ASCII
+            str += (char)('a' + random() % 26);
+            break;
+        case 1:     // CJK
+            str += chars[6 + random() % 2];
+            break;
+        default:    // mixed
+            str += chars[random() % PCA_TABLESIZE(chars)];
+            break;
+        }
+    }
+}
+
+TEST(utils, check_utf8)
+{
+    static const char *bad[] = {
+        "\x80", "\xc0\x80", "\xc1\xbf", "\xe0\x80\x80", "\xed\xa0\x80",
+        "\xf0\x80\x80\x80", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80",
+        "\xff", "\xe4\xb8", "\xf0\x9f\x98", "\xc3", "\0",
+    };
+
+    srandom(1);
+    for (int round = 0; round < 20000; round++) {
+        std::string str;
+        append_random_utf8(str, random() % 100, random() % 3);
+        if (random() % 2) {
+            // corrupt or cut the string at a random position
+            size_t pos = str.empty() ? 0 : random() % str.size();
+            const char *b = bad[random() % PCA_TABLESIZE(bad)];
+            str.insert(pos, b, strlen(b) ? strlen(b) : 1);
+            append_random_utf8(str, random() % 40, random() % 3);
+        }
+        if (random() % 4 == 0 && !str.empty())
+            str.resize(random() % str.size());
+
+        size_t ref_chars, nr_chars = 0;
+        const char *ref_end, *end = NULL;
+        bool ref = ref_check_utf8(str.c_str(), str.size(), &ref_chars,
+                &ref_end);
+        bool ok = pcutils_string_check_utf8_len(str.c_str(), str.size(),
+                &nr_chars, &end);
+        ASSERT_EQ(ok, ref) << "round " << round;
+        ASSERT_EQ(end, ref_end) << "round " << round;
+        ASSERT_EQ(nr_chars, ref_chars) << "round " << round;
+
+        // the null-terminated form stops at the first null byte
+        ref_check_utf8(str.c_str(), strlen(str.c_str()), &ref_chars,
+                &ref_end);
+        ok = pcutils_string_check_utf8(str.c_str(), -1, &nr_chars, &end);
+        ASSERT_EQ(ok, *ref_end == '\0') << "round " << round;
+        ASSERT_EQ(end, ref_end) << "round " << round;
+        ASSERT_EQ(nr_chars, ref_chars) << "round " << round;
+    }
+}
+
+TEST(utils, check_utf8_perf)
+{
+    static const char *names[] = { "ASCII", "CJK", "mixed" };
+    const size_t nr_chars = 1024 * 1024;
+
+    srandom(1);
+    for (int mode = 0; mode < 3; mode++) {
+        std::string str;
+        append_random_utf8(str, nr_chars, mode);
+
+        struct timespec begin;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        const int rounds = 20;
+        for (int i = 0; i < rounds; i++) {
+            size_t n;
+            ASSERT_TRUE(pcutils_string_check_utf8_len(str.c_str(),
+                        str.size(), &n, NULL));
+            ASSERT_EQ(n, nr_chars);
+        }
+        double t = purc_get_elapsed_seconds(&begin, NULL);
+        PRINTF("check_utf8 on %s: %.1f MB/s\n", names[mode],
+                str.size() * rounds / t / 1024 / 1024);
+    }
+}
+
 TEST(utils, error)
 {
     PurCInstance purc;
@@ -31,6 +31,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <math.h>
+#include <time.h>
 #include <gtest/gtest.h>
 
 #include <dirent.h>
@@ -544,3 +546,177 @@ TEST(variant, clone)
     PURC_VARIANT_SAFE_CLEAR(set);
 }
 
+
+static purc_variant_t
+make_remove_member(int i)
+{
+    char buf[32];
+
+    switch (i % 4) {
+    case 0:
+        snprintf(buf, sizeof(buf), "item-%d", i);
+        return purc_variant_make_string(buf, false);
+    case 1:
+        return purc_variant_make_number(i);
+    case 2:
+        return purc_variant_make_longint(i);
+    default:
+        snprintf(buf, sizeof(buf), "%d", i);
+        return purc_variant_make_string(buf, false);
+    }
+}
+
+// removes the members one by one, as the unindexed implementation does
+static void
+naive_remove(purc_variant_t dst, purc_variant_t src)
+{
+    purc_variant_t member;
+    size_t i;
+    foreach_value_in_variant_array(src, member, i) {
+        (void)i;
+        ssize_t nr = purc_variant_array_get_size(dst);
+        for (ssize_t j = 0; j < nr; j++) {
+            purc_variant_t v = purc_variant_array_get(dst, j);
+            if (purc_variant_compare_ex(v, member,
+                        PCVARIANT_COMPARE_OPT_AUTO) == 0) {
+                purc_variant_array_remove(dst, j);
+                break;
+            }
+        }
+    } end_foreach;
+}
+
+TEST(variant, container_remove_semantics)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "purc_variant", false);
+
+    purc_variant_t dst = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    purc_variant_t src = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(dst, nullptr);
+    ASSERT_NE(src, nullptr);
+
+    // duplicates, numbers equal to strings, signed zeros and infinities
+    for (int i = 0; i < 200; i++) {
+        purc_variant_t v = make_remove_member(i % 50);
+        purc_variant_array_append(dst, v);
+        purc_variant_unref(v);
+    }
+    const double specials[] = { -0.0, 0.0, INFINITY, -INFINITY, NAN, 0.1 };
+    for (size_t i = 0; i < PCA_TABLESIZE(specials); i++) {
+        purc_variant_t v = purc_variant_make_number(specials[i]);
+        purc_variant_array_append(dst, v);
+        purc_variant_unref(v);
+    }
+    for (int i = 0; i < 120; i += 3) {
+        purc_variant_t v = make_remove_member(i);
+        purc_variant_array_append(src, v);
+        purc_variant_unref(v);
+    }
+    for (size_t i = 0; i < PCA_TABLESIZE(specials); i += 2) {
+        purc_variant_t v = purc_variant_make_number(specials[i]);
+        purc_variant_array_append(src, v);
+        purc_variant_unref(v);
+    }
+    purc_variant_t s = purc_variant_make_string("0.1", false);
+    purc_variant_array_append(src, s);
+    purc_variant_unref(s);
+
+    purc_variant_t expected = purc_variant_container_clone(dst);
+    naive_remove(expected, src);
+
+    ASSERT_TRUE(purc_variant_container_remove(dst, src, false));
+    ASSERT_EQ(purc_variant_array_get_size(dst),
+            purc_variant_array_get_size(expected));
+
+    char *got = variant_to_string(dst);
+    char *exp = variant_to_string(expected);
+    ASSERT_STREQ(got, exp);
+    free(got);
+    free(exp);
+
+    purc_variant_unref(expected);
+    purc_variant_unref(src);
+    purc_variant_unref(dst);
+}
+
+static purc_variant_t
+make_keyed_record(int id)
+{
+    purc_variant_t k = purc_variant_make_string("id", false);
+    purc_variant_t v = purc_variant_make_longint(id);
+    purc_variant_t obj = purc_variant_make_object(1, k, v);
+    purc_variant_unref(k);
+    purc_variant_unref(v);
+    return obj;
+}
+
+static purc_variant_t
+make_keyed_set(int from, int to)
+{
+    purc_variant_t set = purc_variant_make_set_by_ckey(0, "id",
+            PURC_VARIANT_INVALID);
+    for (int i = from; i < to; i++) {
+        purc_variant_t rec = make_keyed_record(i);
+        purc_variant_set_add(set, rec, false);
+        purc_variant_unref(rec);
+    }
+    return set;
+}
+
+TEST(variant, container_ops_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "purc_variant", false);
+
+    const int nr = 20000;
+    struct timespec begin;
+
+    purc_variant_t dst = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    purc_variant_t src = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    for (int i = 0; i < nr; i++) {
+        purc_variant_t v = make_remove_member(i);
+        purc_variant_array_append(dst, v);
+        purc_variant_unref(v);
+    }
+    for (int i = 0; i < nr; i += 2) {
+        purc_variant_t v = make_remove_member(i);
+        purc_variant_array_append(src, v);
+        purc_variant_unref(v);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ASSERT_TRUE(purc_variant_container_remove(dst, src, false));
+    PRINTF("array remove %d of %d: %fs\n", nr / 2, nr,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(purc_variant_array_get_size(dst), nr / 2);
+    purc_variant_unref(src);
+    purc_variant_unref(dst);
+
+    purc_variant_t set, other;
+
+    set = make_keyed_set(0, nr);
+    other = make_keyed_set(nr / 2, nr + nr / 2);
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ASSERT_TRUE(purc_variant_set_intersect(set, other, false));
+    PRINTF("set intersect %d with %d: %fs\n", nr, nr,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(purc_variant_set_get_size(set), nr / 2);
+    purc_variant_unref(set);
+
+    set = make_keyed_set(0, nr);
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ASSERT_TRUE(purc_variant_set_subtract(set, other, false));
+    PRINTF("set subtract %d from %d: %fs\n", nr, nr,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(purc_variant_set_get_size(set), nr / 2);
+    purc_variant_unref(set);
+
+    set = make_keyed_set(0, nr);
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ASSERT_TRUE(purc_variant_set_xor(set, other, false));
+    PRINTF("set xor %d with %d: %fs\n", nr, nr,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(purc_variant_set_get_size(set), nr);
+    purc_variant_unref(set);
+
+    purc_variant_unref(other);
+}
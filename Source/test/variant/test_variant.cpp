@@ -21,9 +21,13 @@
 #include "private/debug.h"
 #include "private/errors.h"
 #include "private/variant.h"
+#include "private/slab.h"
+
+#include "../helpers.h"
 
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
 #include <gtest/gtest.h>
 
 #ifndef MAX
@@ -1579,3 +1583,167 @@ TEST(variant, reuse_buff)
     purc_cleanup ();
 }
 
+
+/* run it with USE_SLAB_ALLOCATOR off to compare with glib or malloc */
+TEST(variant, alloc_perf)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsfot.hvml.test",
+            "variant", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const size_t nr_rounds = 20;
+    const size_t nr_items = 50000;
+    struct timespec begin;
+    char key[32];
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t r = 0; r < nr_rounds; r++) {
+        purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+        purc_variant_t obj = purc_variant_make_object(0,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+        ASSERT_NE(arr, PURC_VARIANT_INVALID);
+        ASSERT_NE(obj, PURC_VARIANT_INVALID);
+
+        for (size_t i = 0; i < nr_items; i++) {
+            purc_variant_t v = purc_variant_make_longint(i);
+            purc_variant_array_append(arr, v);
+
+            snprintf(key, sizeof(key), "k%zu", i);
+            purc_variant_t k = purc_variant_make_string(key, false);
+            purc_variant_object_set(obj, k, v);
+            purc_variant_unref(k);
+            purc_variant_unref(v);
+        }
+
+        purc_variant_unref(arr);
+        purc_variant_unref(obj);
+    }
+    PRINTF("%zu rounds of making and releasing %zu items: %fs\n",
+            nr_rounds, nr_items, purc_get_elapsed_seconds(&begin, NULL));
+
+    const struct purc_variant_stat *stat = purc_variant_usage_stat();
+    ASSERT_NE(stat, nullptr);
+    PRINTF("slab: cached %zu, chunks %zu, free %zu bytes\n",
+            stat->sz_slab_cached, stat->sz_slab_chunks, stat->sz_slab_free);
+
+#if USE(SLAB_ALLOCATOR)
+    ASSERT_GT(stat->sz_slab_chunks, 0);
+    ASSERT_LE(stat->sz_slab_cached + stat->sz_slab_free,
+            stat->sz_slab_chunks);
+    size_t sz_cached = stat->sz_slab_cached;
+
+    // a smaller cap gives the cached objects back to the shared depot;
+    // the old cap may come from PURC_ENVV_SLAB_MAX_CACHED, so keep it
+    size_t old_cap = pcslab_set_max_cached(0);
+    ASSERT_LE(sz_cached, old_cap * PCSLAB_MAX_SIZE * PCSLAB_NR_CLASSES);
+    stat = purc_variant_usage_stat();
+    ASSERT_EQ(stat->sz_slab_cached, 0);
+    pcslab_set_max_cached(old_cap);
+#endif
+
+    purc_cleanup ();
+}
+
+static bool on_grown(purc_variant_t source, pcvar_op_t msg_type,
+        void* ctxt, size_t nr_args, purc_variant_t* argv)
+{
+    (void)source;
+    (void)msg_type;
+    (void)ctxt;
+    (void)nr_args;
+    (void)argv;
+    return true;
+}
+
+TEST(variant, frozen)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsfot.hvml.test",
+            "variant", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const struct purc_variant_stat *stat = purc_variant_usage_stat();
+    size_t nr_init = stat->nr_total_values;
+
+    const char *json = "{ name: 'PurC', nil: null, ok: true, "
+        "os: ['Linux', 'macOS', 'HybridOS', 'Windows'], "
+        "color: { r: 0, g: 0, b: 0 } }";
+    purc_variant_t obj = purc_variant_make_from_json_string(json,
+            strlen(json));
+    ASSERT_NE(obj, PURC_VARIANT_INVALID);
+
+    // a descendant referred elsewhere will be replaced by its clone
+    purc_variant_t os = purc_variant_object_get_by_ckey(obj, "os");
+    purc_variant_ref(os);
+
+    stat = purc_variant_usage_stat();
+    size_t nr_values = stat->nr_total_values;
+
+    ASSERT_FALSE(purc_variant_is_frozen(obj));
+    ASSERT_TRUE(purc_variant_freeze(obj));
+    ASSERT_TRUE(purc_variant_is_frozen(obj));
+
+    // the frozen values are accounted in the move heap
+    stat = purc_variant_usage_stat();
+    ASSERT_LT(stat->nr_total_values, nr_values);
+
+    purc_variant_t v = purc_variant_object_get_by_ckey(obj, "color");
+    ASSERT_TRUE(purc_variant_is_frozen(v));
+    v = purc_variant_object_get_by_ckey(obj, "nil");
+    ASSERT_TRUE(purc_variant_is_null(v));
+    ASSERT_TRUE(purc_variant_is_frozen(v));
+
+    v = purc_variant_object_get_by_ckey(obj, "os");
+    ASSERT_NE(v, os);
+    ASSERT_TRUE(purc_variant_is_frozen(v));
+    ASSERT_TRUE(purc_variant_is_equal_to(v, os));
+    ASSERT_FALSE(purc_variant_is_frozen(os));
+
+    purc_variant_t s = purc_variant_make_string("Android", false);
+    ASSERT_TRUE(purc_variant_array_append(os, s));
+    ASSERT_FALSE(purc_variant_array_append(v, s));
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_ACCESS_DENIED);
+    ASSERT_FALSE(purc_variant_object_set(obj, s, s));
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_ACCESS_DENIED);
+    ASSERT_EQ(purc_variant_register_post_listener(obj,
+                PCVAR_OPERATION_GROW, on_grown, NULL), nullptr);
+
+    // a clone of a frozen container is mutable
+    purc_variant_t cloned = purc_variant_container_clone_recursively(obj);
+    ASSERT_FALSE(purc_variant_is_frozen(cloned));
+    ASSERT_TRUE(purc_variant_object_set(cloned, s, s));
+    purc_variant_unref(cloned);
+
+    ASSERT_EQ(purc_variant_ref_count(obj), 1);
+    purc_variant_ref(obj);
+    ASSERT_EQ(purc_variant_unref(obj), 1);
+    purc_variant_unref(obj);
+    purc_variant_unref(os);
+    purc_variant_unref(s);
+
+    // native entities may not be thread-safe
+    purc_variant_t native = purc_variant_make_native((void *)&info, NULL);
+    purc_variant_t arr = purc_variant_make_array(1, native);
+    ASSERT_FALSE(purc_variant_freeze(arr));
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NOT_SUPPORTED);
+    ASSERT_FALSE(purc_variant_is_frozen(arr));
+    purc_variant_unref(arr);
+    purc_variant_unref(native);
+
+    // the listeners of a frozen container would never be fired
+    arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    struct pcvar_listener *listener = purc_variant_register_post_listener(arr,
+                PCVAR_OPERATION_GROW, on_grown, NULL);
+    ASSERT_NE(listener, nullptr);
+    ASSERT_FALSE(purc_variant_freeze(arr));
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_ACCESS_DENIED);
+    purc_variant_revoke_listener(arr, listener);
+    ASSERT_TRUE(purc_variant_freeze(arr));
+    purc_variant_unref(arr);
+
+    stat = purc_variant_usage_stat();
+    ASSERT_EQ(stat->nr_total_values, nr_init);
+
+    purc_cleanup ();
+}
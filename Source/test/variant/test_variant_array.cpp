@@ -24,8 +24,11 @@
 #include "purc-variant.h"
 #include "private/variant.h"
 
+#include "../helpers.h"
+
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
 #include <gtest/gtest.h>
 
 TEST(variant_array, init_with_1_str)
@@ -533,3 +536,154 @@ TEST(variant_array, sort)
     ASSERT_STREQ(inbuf, outbuf);
 }
 
+static void
+check_longints(purc_variant_t arr, const int64_t *vals, size_t nr)
+{
+    ASSERT_EQ(purc_variant_array_get_size(arr), nr);
+    for (size_t i = 0; i < nr; i++) {
+        int64_t i64;
+        ASSERT_TRUE(purc_variant_cast_to_longint(
+                    purc_variant_array_get(arr, i), &i64, false));
+        ASSERT_EQ(i64, vals[i]);
+    }
+}
+
+static bool
+array_set_longint(purc_variant_t arr, size_t idx, int64_t i64)
+{
+    purc_variant_t v = purc_variant_make_longint(i64);
+    bool ok = purc_variant_array_set(arr, idx, v);
+    purc_variant_unref(v);
+    return ok;
+}
+
+// the members are stored contiguously until the array belongs to a set
+TEST(variant_array, contiguous_then_nodes)
+{
+    PurCInstance purc;
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(arr, nullptr);
+
+    for (int64_t i = 0; i < 10; i++) {
+        purc_variant_t v = purc_variant_make_longint(i);
+        ASSERT_TRUE(purc_variant_array_insert_before(arr, 0, v));
+        purc_variant_unref(v);
+    }
+    ASSERT_TRUE(purc_variant_array_remove(arr, 3));
+    ASSERT_TRUE(purc_variant_array_remove(arr, 8));
+    ASSERT_TRUE(array_set_longint(arr, 0, 10));
+    const int64_t flat[] = { 10, 8, 7, 5, 4, 3, 2, 1 };
+    check_longints(arr, flat, PCA_TABLESIZE(flat));
+
+    ASSERT_EQ(pcvariant_array_sort(arr, NULL, cmp), 0);
+    const int64_t sorted[] = { 1, 2, 3, 4, 5, 7, 8, 10 };
+    check_longints(arr, sorted, PCA_TABLESIZE(sorted));
+
+    ASSERT_EQ(pcvariant_array_swap(arr, 0, 7), 0);
+    const int64_t swapped[] = { 10, 2, 3, 4, 5, 7, 8, 1 };
+    check_longints(arr, swapped, PCA_TABLESIZE(swapped));
+
+    // the arrays as the unique keys of a set are moved into the nodes
+    purc_variant_t k1 = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    purc_variant_t k2 = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(k1, nullptr);
+    ASSERT_NE(k2, nullptr);
+    for (int64_t i = 0; i < 6; i++) {
+        purc_variant_t v = purc_variant_make_longint(i);
+        ASSERT_TRUE(purc_variant_array_append(k1, v));
+        ASSERT_TRUE(purc_variant_array_append(k2, v));
+        purc_variant_unref(v);
+    }
+    ASSERT_TRUE(array_set_longint(k2, 5, 6));
+
+    purc_variant_t o1 = purc_variant_make_object_by_static_ckey(1,
+            "name", k1);
+    purc_variant_t o2 = purc_variant_make_object_by_static_ckey(1,
+            "name", k2);
+    ASSERT_NE(o1, nullptr);
+    ASSERT_NE(o2, nullptr);
+
+    purc_variant_t set = purc_variant_make_set_by_ckey(2, "name", o1, o2);
+    ASSERT_NE(set, nullptr);
+
+    purc_variant_t elem;
+    elem = purc_variant_set_get_member_by_key_values(set, k2, true);
+    ASSERT_NE(elem, nullptr);
+    purc_variant_t name = purc_variant_object_get_by_ckey(elem, "name");
+    ASSERT_NE(name, nullptr);
+
+    // would duplicate the key of the other member
+    ASSERT_FALSE(array_set_longint(name, 5, 5));
+    const int64_t kept[] = { 0, 1, 2, 3, 4, 6 };
+    check_longints(name, kept, PCA_TABLESIZE(kept));
+
+    ASSERT_TRUE(array_set_longint(name, 5, 7));
+    ASSERT_TRUE(purc_variant_array_remove(name, 0));
+    const int64_t changed[] = { 1, 2, 3, 4, 7 };
+    check_longints(name, changed, PCA_TABLESIZE(changed));
+
+    purc_variant_unref(set);
+    purc_variant_unref(o2);
+    purc_variant_unref(o1);
+    purc_variant_unref(k2);
+    purc_variant_unref(k1);
+    purc_variant_unref(arr);
+}
+
+TEST(variant_array, perf)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const size_t nr = 1000000;
+    struct timespec begin;
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(arr, nullptr);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t v = purc_variant_make_longint(i);
+        ASSERT_TRUE(purc_variant_array_append(arr, v));
+        purc_variant_unref(v);
+    }
+    PRINTF("append %zu elements: %fs\n", nr,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(purc_variant_array_get_size(arr), nr);
+
+    int64_t sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    purc_variant_t v;
+    size_t idx;
+    foreach_value_in_variant_array(arr, v, idx) {
+        int64_t i64;
+        purc_variant_cast_to_longint(v, &i64, false);
+        sum += i64;
+        (void)idx;
+    } end_foreach;
+    PRINTF("iterate %zu elements: %fs\n", nr,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(sum, (int64_t)(nr * (nr - 1) / 2));
+
+    sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t i = 0; i < nr; i++) {
+        int64_t i64;
+        purc_variant_cast_to_longint(purc_variant_array_get(arr, i),
+                &i64, false);
+        sum += i64;
+    }
+    PRINTF("index %zu elements: %fs\n", nr,
+            purc_get_elapsed_seconds(&begin, NULL));
+    ASSERT_EQ(sum, (int64_t)(nr * (nr - 1) / 2));
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    purc_variant_unref(arr);
+    PRINTF("release %zu elements: %fs\n", nr,
+            purc_get_elapsed_seconds(&begin, NULL));
+
+    ASSERT_TRUE(purc_cleanup());
+}
@@ -27,6 +27,10 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 static inline void
@@ -466,3 +470,102 @@ TEST(object, compare)
     purc_variant_unref(obj2);
 }
 
+
+TEST(object, hashed_members)
+{
+    PurCInstance purc;
+
+    std::map<std::string, int64_t> ref;
+    purc_variant_t obj = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    ASSERT_NE(obj, PURC_VARIANT_INVALID);
+
+    srand(1);
+    for (int i = 0; i < 20000; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%d", rand() % 2000);
+        int op = rand() % 4;
+        if (op == 0) {
+            ASSERT_TRUE(purc_variant_object_remove_by_static_ckey(obj,
+                        key, true));
+            ref.erase(key);
+        }
+        else if (op == 1) {
+            purc_variant_t v = purc_variant_object_get_by_ckey(obj, key);
+            if (ref.count(key)) {
+                int64_t i64 = 0;
+                ASSERT_NE(v, PURC_VARIANT_INVALID);
+                ASSERT_TRUE(purc_variant_cast_to_longint(v, &i64, false));
+                ASSERT_EQ(i64, ref[key]);
+            }
+            else {
+                ASSERT_EQ(v, PURC_VARIANT_INVALID);
+            }
+        }
+        else {
+            purc_variant_t k = purc_variant_make_string(key, true);
+            purc_variant_t v = purc_variant_make_longint(i);
+            ASSERT_TRUE(purc_variant_object_set(obj, k, v));
+            purc_variant_unref(k);
+            purc_variant_unref(v);
+            ref[key] = i;
+        }
+    }
+
+    // members are still iterated in the order of the keys
+    size_t sz = 0;
+    ASSERT_TRUE(purc_variant_object_size(obj, &sz));
+    ASSERT_EQ(sz, ref.size());
+
+    auto it = ref.begin();
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(obj, k, v) {
+        int64_t i64 = 0;
+        ASSERT_TRUE(it != ref.end());
+        ASSERT_STREQ(purc_variant_get_string_const(k), it->first.c_str());
+        ASSERT_TRUE(purc_variant_cast_to_longint(v, &i64, false));
+        ASSERT_EQ(i64, it->second);
+        ++it;
+    } end_foreach;
+    ASSERT_TRUE(it == ref.end());
+
+    purc_variant_unref(obj);
+}
+
+TEST(object, get_perf)
+{
+    PurCInstance purc;
+
+    static const size_t sizes[] = { 4, 64, 10000 };
+    const size_t nr_gets = 1000000;
+
+    for (size_t s = 0; s < PCA_TABLESIZE(sizes); s++) {
+        purc_variant_t obj = purc_variant_make_object(0,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+        ASSERT_NE(obj, PURC_VARIANT_INVALID);
+
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < sizes[s]; i++) {
+            keys.push_back("property_" + std::to_string(i));
+            purc_variant_t k = purc_variant_make_string(keys[i].c_str(), true);
+            purc_variant_t v = purc_variant_make_ulongint(i);
+            ASSERT_TRUE(purc_variant_object_set(obj, k, v));
+            purc_variant_unref(k);
+            purc_variant_unref(v);
+        }
+
+        struct timespec begin;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        size_t found = 0;
+        for (size_t i = 0; i < nr_gets; i++) {
+            const char *key = keys[i % sizes[s]].c_str();
+            if (purc_variant_object_get_by_ckey(obj, key))
+                found++;
+        }
+        PRINTF("%zu gets on an object with %zu members: %fs\n",
+                nr_gets, sizes[s], purc_get_elapsed_seconds(&begin, NULL));
+        ASSERT_EQ(found, nr_gets);
+
+        purc_variant_unref(obj);
+    }
+}
@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 #include <gtest/gtest.h>
 
 static inline bool
@@ -412,6 +413,82 @@ TEST(variant_set, dup)
     ASSERT_EQ (cleanup, true);
 }
 
+static purc_variant_t
+make_record(int id)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "record-%d", id);
+
+    purc_variant_t v_id = purc_variant_make_longint(id);
+    purc_variant_t v_name = purc_variant_make_string(name, false);
+    purc_variant_t rec = purc_variant_make_object_by_static_ckey(2,
+            "id", v_id, "name", v_name);
+    purc_variant_unref(v_id);
+    purc_variant_unref(v_name);
+    return rec;
+}
+
+TEST(variant_set, perf_insert)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "test_init", false);
+
+    const int nr_records = 20000;
+    purc_variant_t set = purc_variant_make_set_by_ckey(0, "id",
+            PURC_VARIANT_INVALID);
+    ASSERT_NE(set, nullptr);
+
+    struct timespec begin;
+    double elapsed[3];
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int i = 0; i < nr_records; i++) {
+        // insert in a scrambled order
+        purc_variant_t rec = make_record((i * 7919) % nr_records);
+        ASSERT_TRUE(purc_variant_set_add(set, rec, false));
+        purc_variant_unref(rec);
+    }
+    elapsed[0] = purc_get_elapsed_seconds(&begin, NULL);
+    ASSERT_EQ(purc_variant_set_get_size(set), nr_records);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int i = 0; i < nr_records; i++) {
+        purc_variant_t rec = make_record(i);
+        ASSERT_TRUE(purc_variant_set_add(set, rec, true));
+        purc_variant_unref(rec);
+    }
+    elapsed[1] = purc_get_elapsed_seconds(&begin, NULL);
+    ASSERT_EQ(purc_variant_set_get_size(set), nr_records);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int i = 0; i < nr_records; i += 2) {
+        purc_variant_t rec = make_record(i);
+        ASSERT_TRUE(purc_variant_set_remove(set, rec, false));
+        purc_variant_unref(rec);
+    }
+    elapsed[2] = purc_get_elapsed_seconds(&begin, NULL);
+    ASSERT_EQ(purc_variant_set_get_size(set), nr_records / 2);
+
+    // the elements are still ordered by the unique key
+    struct purc_variant_set_iterator *it;
+    it = purc_variant_set_make_iterator_begin(set);
+    ASSERT_NE(it, nullptr);
+    purc_variant_t prev = purc_variant_set_iterator_get_value(it);
+    while (purc_variant_set_iterator_next(it)) {
+        purc_variant_t v = purc_variant_set_iterator_get_value(it);
+        ASSERT_LT(purc_variant_compare_ex(
+                    purc_variant_object_get_by_ckey(prev, "id"),
+                    purc_variant_object_get_by_ckey(v, "id"),
+                    PCVARIANT_COMPARE_OPT_CASE), 0);
+        prev = v;
+    }
+    purc_variant_set_release_iterator(it);
+
+    PRINTF("%d records: insert %.3fs, overwrite %.3fs, remove half %.3fs\n",
+            nr_records, elapsed[0], elapsed[1], elapsed[2]);
+
+    purc_variant_unref(set);
+}
+
 static inline purc_variant_t
 make_set(const int *vals, size_t nr)
 {
@@ -20,6 +20,8 @@
 #include "purc.h"
 #include "private/vcm.h"
 
+#include "../helpers.h"
+
 #include <gtest/gtest.h>
 
 purc_variant_t find_var(void* ctxt, const char* name)
@@ -117,3 +119,80 @@ TEST_P(test_vcm_eval, eval_silently)
 
 INSTANTIATE_TEST_SUITE_P(vcm_eval, test_vcm_eval,
         testing::ValuesIn(test_cases));
+
+static purc_variant_t
+make_button(void)
+{
+    const char *object = "{ \"title\" : \"Object title\" }";
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(object, strlen(object));
+    purc_variant_t obj = purc_variant_ejson_parse_tree_evalute(ptree, NULL,
+            PURC_VARIANT_INVALID, false);
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    return obj;
+}
+
+/* more params than a frame keeps inline and more frames than a
+   context keeps inline */
+TEST(vcm_eval_frames, wide_and_deep)
+{
+    PurCInstance purc(false);
+
+    purc_variant_t obj = make_button();
+    ASSERT_NE(obj, nullptr);
+
+    const char *jsonee = "[1, 2, 3, 4, 5, 6, "
+        "[[[[[[[[[[[[$BUTTON.title]]]]]]]]]]]]]";
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(jsonee, strlen(jsonee));
+    ASSERT_NE(ptree, nullptr);
+
+    for (int n = 0; n < 3; n++) {
+        purc_variant_t result = purc_variant_ejson_parse_tree_evalute(ptree,
+                find_var, obj, false);
+        ASSERT_NE(result, nullptr);
+        ASSERT_EQ(purc_variant_array_get_size(result), 7);
+
+        purc_variant_t v = purc_variant_array_get(result, 6);
+        for (int i = 0; i < 12; i++) {
+            ASSERT_TRUE(purc_variant_is_array(v));
+            v = purc_variant_array_get(v, 0);
+        }
+        ASSERT_STREQ(purc_variant_get_string_const(v), "Object title");
+        purc_variant_unref(result);
+    }
+
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    purc_variant_unref(obj);
+}
+
+TEST(vcm_eval_frames, perf_get_element)
+{
+    PurCInstance purc(false);
+
+    purc_variant_t obj = make_button();
+    ASSERT_NE(obj, nullptr);
+
+    const char *jsonee = "$BUTTON.title";
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(jsonee, strlen(jsonee));
+    ASSERT_NE(ptree, nullptr);
+
+    const int nr_loops = 200000;
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    for (int i = 0; i < nr_loops; i++) {
+        purc_variant_t result = purc_variant_ejson_parse_tree_evalute(ptree,
+                find_var, obj, false);
+        ASSERT_NE(result, nullptr);
+        purc_variant_unref(result);
+    }
+
+    double elapsed = purc_get_elapsed_seconds(&begin, NULL);
+    PRINTF("evaluated `%s` %d times in %.3f seconds: %.1f ns per evaluation\n",
+            jsonee, nr_loops, elapsed, elapsed * 1e9 / nr_loops);
+
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    purc_variant_unref(obj);
+}
@@ -19,6 +19,7 @@
 
 #include "purc.h"
 #include "private/vdom.h"
+#include "private/atom-buckets.h"
 
 #include "../helpers.h"
 
@@ -101,6 +102,9 @@ TEST(vdom, basic)
     attr32 = pcvdom_attr_create("on", PCHVML_ATTRIBUTE_OPERATOR, NULL);
     ASSERT_NE(attr32, nullptr);
     ASSERT_EQ(0, pcvdom_element_append_attr(elem3, attr32));
+    EXPECT_EQ(pcvdom_attr_get_keyword(attr32),
+            purc_atom_try_string_ex(ATOM_BUCKET_HVML, "on"));
+    EXPECT_NE(pcvdom_attr_get_keyword(attr32), 0);
 
     struct pcvdom_comment *comment41 = pcvdom_comment_create("hello world");
     ASSERT_NE(comment41, nullptr);